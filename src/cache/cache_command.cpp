@@ -0,0 +1,64 @@
+#include "cache/cache_command.h"
+#include "cache/cache_gc.h"
+#include "cache/cache_store.h"
+#include "jpm_config.h"
+#include <iostream>
+
+namespace jpm {
+
+namespace {
+
+void print_usage() {
+    std::cerr << "Usage: jpm [-v|--verbose] cache gc [--max-size <size>]   (size like 500M or 10G)" << std::endl;
+}
+
+} // namespace
+
+CacheCommand::CacheCommand() {
+    if (g_verbose_output) {
+        std::cout << "CacheCommand initialized." << std::endl;
+    }
+}
+
+bool CacheCommand::execute(const std::vector<std::string>& args) {
+    if (args.empty() || args[0] != "gc") {
+        print_usage();
+        return false;
+    }
+
+    uint64_t budget = CacheGc::default_budget();
+    for (size_t i = 1; i < args.size(); ++i) {
+        std::string value;
+        if (args[i] == "--max-size" && i + 1 < args.size()) {
+            value = args[++i];
+        } else if (args[i].compare(0, 11, "--max-size=") == 0) {
+            value = args[i].substr(11);
+        } else {
+            print_usage();
+            return false;
+        }
+        std::optional<uint64_t> parsed = CacheGc::parse_size(value);
+        if (!parsed) {
+            std::cerr << "Invalid size: " << value << std::endl;
+            return false;
+        }
+        budget = *parsed;
+    }
+
+    std::string root = CacheStore::default_root();
+    CacheGc gc(root);
+    CacheGcResult result = gc.collect(budget);
+    if (!result.ran) {
+        std::cout << "Another cache gc is already running on " << root << std::endl;
+        return true;
+    }
+    std::cout << "Cache " << root << ": " << result.entries << " entries, " << result.bytes_before
+              << " bytes; evicted " << result.evicted << ", now " << result.bytes_after << " bytes (budget "
+              << budget << ")" << std::endl;
+    if (result.bytes_after > budget && result.skipped_in_use > 0) {
+        std::cout << "  " << result.skipped_in_use << " entries over budget were in use and kept" << std::endl;
+    }
+    return true;
+}
+
+} // namespace jpm
@@ -0,0 +1,20 @@
+#ifndef JPM_CACHE_COMMAND_H
+#define JPM_CACHE_COMMAND_H
+
+#include <string>
+#include <vector>
+
+namespace jpm {
+
+// `jpm cache gc [--max-size <size>]`: evicts least-recently-used entries from the
+// shared cache until it fits the budget (see CacheGc)
+class CacheCommand {
+public:
+    CacheCommand();
+    // Returns false on bad arguments
+    bool execute(const std::vector<std::string>& args);
+};
+
+} // namespace jpm
+
+#endif // JPM_CACHE_COMMAND_H
@@ -0,0 +1,270 @@
+#include "cache/cache_gc.h"
+#include "cache/cache_index.h"
+#include "cache/cache_store.h"
+#include "utils/file_utils.h"
+#include "jpm_config.h"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <vector>
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace jpm {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr uint64_t kDefaultBudget = 10ULL * 1024 * 1024 * 1024;
+// Entries used this recently may be about to be read by a running install
+constexpr std::time_t kMinIdleSeconds = 10 * 60;
+// Abandoned temp files from crashed downloads are removed after this long
+constexpr std::time_t kStaleTempSeconds = 24 * 60 * 60;
+constexpr std::time_t kBackgroundInterval = 60 * 60;
+
+struct CacheEntry {
+    std::string key;   // Relative to the cache root
+    fs::path path;
+    uint64_t bytes = 0;
+    std::time_t last_access = 0;
+    bool directory = false;
+    fs::path install_dir; // x/<spec> holding this version tree; empty for other entries
+};
+
+std::time_t modified_time(const fs::path& path) {
+    std::error_code ec;
+    auto modified = fs::last_write_time(path, ec);
+    if (ec) return 0;
+    auto system_time = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+        modified - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
+    return std::chrono::system_clock::to_time_t(system_time);
+}
+
+bool is_temp_name(const std::string& name) {
+    return name.find(".tmp-") != std::string::npos;
+}
+
+// True if a `jpm x` install directory still holds a version tree
+bool has_version_trees(const fs::path& install_dir) {
+    std::error_code ec;
+    for (fs::directory_iterator trees(install_dir, ec), end; !ec && trees != end; trees.increment(ec)) {
+        std::error_code entry_ec;
+        if (trees->is_directory(entry_ec) && !is_temp_name(trees->path().filename().string())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+CacheGc::CacheGc(std::string root) : root_(std::move(root)) {
+    if (g_verbose_output) {
+        std::cout << "CacheGc initialized for " << root_ << std::endl;
+    }
+}
+
+std::optional<uint64_t> CacheGc::parse_size(const std::string& text) {
+    if (text.empty()) return std::nullopt;
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || value < 0 || !std::isfinite(value)) return std::nullopt;
+    std::string unit(end);
+    if (!unit.empty() && (unit.back() == 'b' || unit.back() == 'B') && unit.size() > 1) unit.pop_back();
+    double multiplier = 1;
+    if (unit.empty() || unit == "b" || unit == "B") multiplier = 1;
+    else if (unit == "k" || unit == "K") multiplier = 1024.0;
+    else if (unit == "m" || unit == "M") multiplier = 1024.0 * 1024;
+    else if (unit == "g" || unit == "G") multiplier = 1024.0 * 1024 * 1024;
+    else if (unit == "t" || unit == "T") multiplier = 1024.0 * 1024 * 1024 * 1024;
+    else return std::nullopt;
+    return static_cast<uint64_t>(value * multiplier);
+}
+
+uint64_t CacheGc::default_budget() {
+    if (const char* configured = std::getenv("JPM_CACHE_MAX_SIZE"); configured && *configured) {
+        if (std::optional<uint64_t> budget = parse_size(configured)) {
+            return *budget;
+        }
+        std::cerr << "Ignoring invalid JPM_CACHE_MAX_SIZE=" << configured << std::endl;
+    }
+    return kDefaultBudget;
+}
+
+CacheGcResult CacheGc::collect(uint64_t max_bytes) {
+    CacheGcResult result;
+    // Only one gc per cache at a time; a second one has nothing to add
+    CacheEntryLock gc_lock(root_ + "/gc", false);
+    if (!gc_lock.locked()) {
+        if (g_verbose_output) {
+            std::cout << "Another cache gc is running on " << root_ << std::endl;
+        }
+        return result;
+    }
+    result.ran = true;
+
+    std::shared_ptr<CacheIndex> index = CacheIndex::open(root_);
+    std::time_t now = std::time(nullptr);
+    std::vector<CacheEntry> entries;
+    std::error_code ec;
+
+    // packuments/<name>/<version>.json and tarballs/<name>/<version>.tgz
+    for (const char* kind : {"packuments", "tarballs"}) {
+        fs::path kind_dir = fs::path(root_) / kind;
+        for (fs::directory_iterator names(kind_dir, ec), end; !ec && names != end; names.increment(ec)) {
+            std::error_code entry_ec;
+            if (!names->is_directory(entry_ec)) continue;
+            for (fs::directory_iterator files(names->path(), entry_ec); !entry_ec && files != end; files.increment(entry_ec)) {
+                std::string file_name = files->path().filename().string();
+                std::error_code file_ec;
+                if (!files->is_regular_file(file_ec) ||
+                    (file_name.size() > 5 && file_name.compare(file_name.size() - 5, 5, ".lock") == 0)) {
+                    continue;
+                }
+                if (is_temp_name(file_name)) {
+                    if (now - modified_time(files->path()) > kStaleTempSeconds) {
+                        fs::remove(files->path(), file_ec);
+                    }
+                    continue;
+                }
+                CacheEntry entry;
+                entry.key = std::string(kind) + "/" + names->path().filename().string() + "/" + file_name;
+                entry.path = files->path();
+                entry.bytes = files->file_size(file_ec);
+                entries.push_back(std::move(entry));
+            }
+        }
+        ec.clear();
+    }
+    // x/<spec>/<version>: `jpm x` installs, one entry per version tree so that a tree a
+    // running bin still pins is left alone. Recency is tracked per spec.
+    for (fs::directory_iterator installs(fs::path(root_) / "x", ec), end; !ec && installs != end; installs.increment(ec)) {
+        std::error_code entry_ec;
+        std::string name = installs->path().filename().string();
+        if (!installs->is_directory(entry_ec) || is_temp_name(name)) continue;
+        for (fs::directory_iterator trees(installs->path(), entry_ec); !entry_ec && trees != end; trees.increment(entry_ec)) {
+            std::error_code tree_ec;
+            if (!trees->is_directory(tree_ec) || is_temp_name(trees->path().filename().string())) continue;
+            CacheEntry entry;
+            entry.key = "x/" + name;
+            entry.path = trees->path();
+            entry.bytes = FileUtils::directory_stats(trees->path().string()).total_bytes;
+            entry.directory = true;
+            entry.install_dir = installs->path();
+            entries.push_back(std::move(entry));
+        }
+    }
+
+    for (auto& entry : entries) {
+        std::optional<std::time_t> accessed = index->last_access(entry.key);
+        entry.last_access = accessed ? *accessed : modified_time(entry.path);
+        result.bytes_before += entry.bytes;
+    }
+    result.entries = entries.size();
+    result.bytes_after = result.bytes_before;
+
+    std::sort(entries.begin(), entries.end(),
+              [](const CacheEntry& a, const CacheEntry& b) { return a.last_access < b.last_access; });
+    for (const auto& entry : entries) {
+        if (result.bytes_after <= max_bytes) break;
+        if (now - entry.last_access < kMinIdleSeconds) {
+            ++result.skipped_in_use;
+            continue;
+        }
+        // A `jpm x` install may be about to point its manifest at this version tree
+        std::optional<CacheEntryLock> install_lock;
+        if (!entry.install_dir.empty()) {
+            install_lock.emplace(entry.install_dir.string(), false);
+            if (!install_lock->locked()) {
+                ++result.skipped_in_use;
+                continue;
+            }
+        }
+        // Held by an install that is producing or waiting on this entry right now, or
+        // shared by the `jpm x` runs of a version tree
+        CacheEntryLock entry_lock(entry.path.string(), false);
+        if (!entry_lock.locked()) {
+            ++result.skipped_in_use;
+            continue;
+        }
+        std::error_code remove_ec;
+        if (entry.directory) {
+            fs::remove_all(entry.path, remove_ec);
+        } else {
+            fs::remove(entry.path, remove_ec);
+        }
+        if (remove_ec) {
+            std::cerr << "cache gc: cannot remove " << entry.path.string() << ": " << remove_ec.message() << std::endl;
+            continue;
+        }
+        if (entry.install_dir.empty()) {
+            index->forget(entry.key);
+        } else {
+            fs::remove(entry.path.string() + ".lock", remove_ec);
+            // The manifest and locks go with the last version tree
+            if (!has_version_trees(entry.install_dir)) {
+                fs::remove_all(entry.install_dir, remove_ec);
+                index->forget(entry.key);
+            }
+        }
+        result.bytes_after -= entry.bytes;
+        ++result.evicted;
+        if (g_verbose_output) {
+            std::cout << "cache gc: evicted " << (entry.install_dir.empty() ? entry.key : entry.key + "/" + entry.path.filename().string()) << " (" << entry.bytes << " bytes)" << std::endl;
+        }
+    }
+
+    FileUtils::write_file(root_ + "/gc.stamp", std::to_string(now) + "\n");
+    return result;
+}
+
+void CacheGc::collect_in_background(const std::string& root) {
+    uint64_t budget = default_budget();
+    if (budget == 0) {
+        return;
+    }
+#ifdef _WIN32
+    (void)root;
+#else
+    // One stat decides whether a gc is due at all
+    struct stat st {};
+    std::string stamp = root + "/gc.stamp";
+    if (stat(stamp.c_str(), &st) == 0 && std::time(nullptr) - st.st_mtime < kBackgroundInterval) {
+        return;
+    }
+    FileUtils::create_directory_recursively(root);
+    FileUtils::write_file(stamp, "running\n"); // Keeps concurrent installs from starting more gcs
+
+    std::cout.flush();
+    std::cerr.flush();
+    // Double fork: the gc is reparented to init and never becomes a zombie of this process
+    pid_t child = fork();
+    if (child < 0) {
+        return;
+    }
+    if (child == 0) {
+        setsid();
+        if (fork() != 0) {
+            _exit(0);
+        }
+        if (nice(10) == -1) {
+            // Lower priority is best effort
+        }
+        g_verbose_output = false;
+        CacheGc gc(root);
+        gc.collect(budget);
+        _exit(0);
+    }
+    waitpid(child, nullptr, 0);
+#endif
+}
+
+} // namespace jpm
@@ -0,0 +1,47 @@
+#ifndef JPM_CACHE_GC_H
+#define JPM_CACHE_GC_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace jpm {
+
+struct CacheGcResult {
+    bool ran = false;             // false if another gc held the cache
+    uint64_t entries = 0;         // packuments, tarballs and `jpm x` version trees found
+    uint64_t bytes_before = 0;
+    uint64_t bytes_after = 0;
+    uint64_t evicted = 0;
+    uint64_t skipped_in_use = 0;  // Over budget but locked or used too recently to remove
+};
+
+// Evicts least-recently-used cache entries until the cache fits a size budget.
+// Recency comes from CacheIndex (falling back to mtime for entries it never saw).
+// Installs are never blocked: an entry is only removed if its entry lock can be
+// taken without waiting and it has not been used in the last few minutes, and a
+// gc that finds another gc running simply returns.
+class CacheGc {
+public:
+    explicit CacheGc(std::string root);
+
+    CacheGcResult collect(uint64_t max_bytes);
+
+    // Budget for the automatic gc after installs: $JPM_CACHE_MAX_SIZE, or 10G.
+    // "0" turns the automatic gc off.
+    static uint64_t default_budget();
+
+    // "500M", "10G", "1.5g", "2048" (bytes); std::nullopt if malformed
+    static std::optional<uint64_t> parse_size(const std::string& text);
+
+    // At most once an hour, collects in a detached background process so the
+    // calling command exits right away. Call when no other threads are running.
+    static void collect_in_background(const std::string& root);
+
+private:
+    std::string root_;
+};
+
+} // namespace jpm
+
+#endif // JPM_CACHE_GC_H
@@ -0,0 +1,148 @@
+#include "cache/cache_index.h"
+#include "utils/file_utils.h"
+#include "jpm_config.h"
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <cstring>
+#include <cerrno>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace jpm {
+
+namespace {
+
+constexpr char kMagic[8] = {'J', 'P', 'M', 'I', 'D', 'X', '0', '1'};
+constexpr size_t kHeaderSize = 64;
+// Longest probe sequence; past it an access simply isn't recorded
+constexpr size_t kMaxProbes = 64;
+
+uint64_t hash_key(const std::string& key) {
+    uint64_t hash = 1469598103934665603ULL; // FNV-1a
+    for (char c : key) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash == 0 ? 1 : hash; // 0 marks an empty slot
+}
+
+} // namespace
+
+std::shared_ptr<CacheIndex> CacheIndex::open(const std::string& root) {
+    static std::mutex mutex;
+    static std::map<std::string, std::shared_ptr<CacheIndex>> open_indexes;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& index = open_indexes[root];
+    if (index) {
+        return index;
+    }
+    index.reset(new CacheIndex());
+
+#ifndef _WIN32
+    const size_t size = kHeaderSize + kSlotCount * 2 * sizeof(uint64_t);
+    std::string path = root + "/index.bin";
+    if (!FileUtils::create_directory_recursively(root)) {
+        return index;
+    }
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        if (g_verbose_output) {
+            std::cerr << "CacheIndex: cannot open " << path << ": " << strerror(errno) << std::endl;
+        }
+        return index;
+    }
+    struct stat st {};
+    // Growing a new (or truncated) file to the fixed size is idempotent, so racing creators agree
+    if (fstat(fd, &st) != 0 || (static_cast<size_t>(st.st_size) < size && ::ftruncate(fd, static_cast<off_t>(size)) != 0)) {
+        ::close(fd);
+        return index;
+    }
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return index;
+    }
+
+    auto* header = static_cast<char*>(mapping);
+    if (std::memcmp(header, kMagic, sizeof(kMagic)) != 0) {
+        bool fresh = true;
+        for (size_t i = 0; i < kHeaderSize; ++i) {
+            fresh = fresh && header[i] == 0;
+        }
+        if (!fresh) {
+            std::cerr << "CacheIndex: " << path << " has an unknown format; access times are not recorded." << std::endl;
+            munmap(mapping, size);
+            return index;
+        }
+        std::memcpy(header, kMagic, sizeof(kMagic));
+    }
+    index->mapping_ = mapping;
+    index->mapping_size_ = size;
+    index->slots_ = reinterpret_cast<uint64_t*>(header + kHeaderSize);
+#endif
+    return index;
+}
+
+CacheIndex::~CacheIndex() {
+#ifndef _WIN32
+    if (mapping_) {
+        munmap(mapping_, mapping_size_);
+    }
+#endif
+}
+
+uint64_t* CacheIndex::find_slot(uint64_t key_hash, bool create) const {
+    if (!slots_) {
+        return nullptr;
+    }
+    size_t start = static_cast<size_t>(key_hash) & (kSlotCount - 1);
+    for (size_t probe = 0; probe < kMaxProbes; ++probe) {
+        uint64_t* slot = slots_ + 2 * ((start + probe) & (kSlotCount - 1));
+        uint64_t current = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+        if (current == key_hash) {
+            return slot;
+        }
+        if (current == 0) {
+            if (!create) {
+                return nullptr;
+            }
+            uint64_t expected = 0;
+            if (__atomic_compare_exchange_n(slot, &expected, key_hash, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+                || expected == key_hash) {
+                return slot; // Claimed it, or another process just claimed it for the same key
+            }
+        }
+    }
+    return nullptr;
+}
+
+void CacheIndex::touch(const std::string& key, std::time_t now) {
+    if (uint64_t* slot = find_slot(hash_key(key), true)) {
+        __atomic_store_n(slot + 1, static_cast<uint64_t>(now), __ATOMIC_RELEASE);
+    }
+}
+
+std::optional<std::time_t> CacheIndex::last_access(const std::string& key) const {
+    uint64_t* slot = find_slot(hash_key(key), false);
+    if (!slot) {
+        return std::nullopt;
+    }
+    uint64_t time = __atomic_load_n(slot + 1, __ATOMIC_ACQUIRE);
+    if (time == 0) {
+        return std::nullopt;
+    }
+    return static_cast<std::time_t>(time);
+}
+
+void CacheIndex::forget(const std::string& key) {
+    if (uint64_t* slot = find_slot(hash_key(key), false)) {
+        __atomic_store_n(slot + 1, uint64_t(0), __ATOMIC_RELEASE);
+    }
+}
+
+} // namespace jpm
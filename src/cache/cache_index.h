@@ -0,0 +1,55 @@
+#ifndef JPM_CACHE_INDEX_H
+#define JPM_CACHE_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace jpm {
+
+// Last-access times of cache entries, kept in <cache root>/index.bin so eviction
+// does not depend on atime (often disabled with noatime/relatime).
+//
+// The file is a fixed-size open-addressing hash table mapped MAP_SHARED by every
+// jpm process: a header followed by kSlotCount slots of { u64 key hash, u64 time }.
+// Slots are claimed with compare-and-swap and times are plain atomic stores, so
+// lookups and updates are O(1), lock-free, and never wait on another process.
+// Keys are entry paths relative to the cache root ("tarballs/lodash/4.17.21.tgz").
+class CacheIndex {
+public:
+    static constexpr size_t kSlotCount = size_t(1) << 17; // 2 MiB file; ~130k entries
+
+    // One mapping per root per process. Never null; if the file cannot be mapped the
+    // returned index simply records nothing and callers fall back to file mtimes.
+    static std::shared_ptr<CacheIndex> open(const std::string& root);
+
+    ~CacheIndex();
+    CacheIndex(const CacheIndex&) = delete;
+    CacheIndex& operator=(const CacheIndex&) = delete;
+
+    // Records an access to key at time now
+    void touch(const std::string& key, std::time_t now = std::time(nullptr));
+
+    // Last recorded access, or std::nullopt if the key was never touched or was forgotten
+    std::optional<std::time_t> last_access(const std::string& key) const;
+
+    // Clears the access time of an evicted entry (its slot stays reserved for the key)
+    void forget(const std::string& key);
+
+private:
+    CacheIndex() = default;
+
+    // Slot holding key, claiming an empty one when create is set; nullptr if none
+    uint64_t* find_slot(uint64_t key_hash, bool create) const;
+
+    uint64_t* slots_ = nullptr; // kSlotCount pairs of { hash, time }
+    void* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+};
+
+} // namespace jpm
+
+#endif // JPM_CACHE_INDEX_H
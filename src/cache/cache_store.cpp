@@ -0,0 +1,242 @@
+#include "cache/cache_store.h"
+#include "cache/cache_index.h"
+#include "utils/file_utils.h"
+#include "jpm_config.h"
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include <sys/stat.h>
+#include <fcntl.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/file.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
+
+namespace jpm {
+
+namespace {
+
+std::atomic<unsigned long> g_temp_counter{0};
+
+// How long a packument fetched for a dist-tag or range stays valid
+constexpr std::chrono::seconds kMutableMetadataMaxAge{300};
+
+std::string parent_directory(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+}
+
+} // namespace
+
+/*---------------------------------------------------------
+ | CacheEntryLock
+ *--------------------------------------------------------*/
+CacheEntryLock::CacheEntryLock(const std::string& entry_path, bool wait, bool shared) {
+#ifndef _WIN32
+    std::string lock_path = entry_path + ".lock";
+    fd_ = ::open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "CacheEntryLock: cannot open " << lock_path << ": " << strerror(errno) << std::endl;
+        return;
+    }
+    const int operation = shared ? LOCK_SH : LOCK_EX;
+    while (flock(fd_, wait ? operation : operation | LOCK_NB) != 0) {
+        if (!wait && errno == EWOULDBLOCK) {
+            ::close(fd_);
+            fd_ = -1;
+            return;
+        }
+        if (errno != EINTR) {
+            std::cerr << "CacheEntryLock: flock failed on " << lock_path << ": " << strerror(errno) << std::endl;
+            ::close(fd_);
+            fd_ = -1;
+            return;
+        }
+    }
+#else
+    (void)entry_path; // No cross-process locking on Windows; rename still keeps entries whole
+    (void)wait;
+    (void)shared;
+#endif
+}
+
+void CacheEntryLock::keep_across_exec() {
+#ifndef _WIN32
+    if (fd_ >= 0) {
+        int flags = fcntl(fd_, F_GETFD);
+        if (flags >= 0) {
+            fcntl(fd_, F_SETFD, flags & ~FD_CLOEXEC);
+        }
+    }
+#endif
+}
+
+CacheEntryLock::~CacheEntryLock() {
+#ifndef _WIN32
+    if (fd_ >= 0) {
+        flock(fd_, LOCK_UN);
+        ::close(fd_);
+    }
+#endif
+}
+
+/*---------------------------------------------------------
+ | CacheStore
+ *--------------------------------------------------------*/
+CacheStore::CacheStore() : CacheStore(default_root()) {}
+
+CacheStore::CacheStore(std::string root) : root_(std::move(root)), index_(CacheIndex::open(root_)) {
+    if (g_verbose_output) {
+        std::cout << "CacheStore initialized at " << root_ << std::endl;
+    }
+}
+
+std::string CacheStore::default_root() {
+    if (const char* explicit_dir = std::getenv("JPM_CACHE_DIR"); explicit_dir && *explicit_dir) {
+        return explicit_dir;
+    }
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        return std::string(xdg) + "/jpm";
+    }
+#ifdef _WIN32
+    if (const char* local_app_data = std::getenv("LOCALAPPDATA"); local_app_data && *local_app_data) {
+        return std::string(local_app_data) + "/jpm-cache";
+    }
+#endif
+    if (const char* home = std::getenv("HOME"); home && *home) {
+        return std::string(home) + "/.cache/jpm";
+    }
+    return "./.jpm-cache";
+}
+
+std::string CacheStore::escape_name(const std::string& name) {
+    std::string escaped = name;
+    for (auto& c : escaped) {
+        if (c == '/' || c == '\\') c = '+';
+    }
+    return escaped;
+}
+
+std::string CacheStore::packument_path(const std::string& name, const std::string& version) const {
+    return root_ + "/packuments/" + escape_name(name) + "/" + escape_name(version) + ".json";
+}
+
+std::string CacheStore::tarball_path(const std::string& name, const std::string& version) const {
+    return root_ + "/tarballs/" + escape_name(name) + "/" + escape_name(version) + ".tgz";
+}
+
+std::string CacheStore::exec_path(const std::string& spec) const {
+    return root_ + "/x/" + escape_name(spec);
+}
+
+std::string CacheStore::temp_path_for(const std::string& entry_path) {
+    // Unique per process and per call, and on the same filesystem so rename() is atomic
+    return entry_path + ".tmp-" + std::to_string(getpid()) + "-" + std::to_string(++g_temp_counter);
+}
+
+std::chrono::seconds CacheStore::packument_max_age(const std::string& version) {
+    // A plain "1.2.3" / "1.2.3-beta.1" version names an immutable manifest
+    bool exact = !version.empty() && std::isdigit(static_cast<unsigned char>(version[0]))
+        && version.find_first_not_of("0123456789.-+abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ") == std::string::npos
+        && version.find('x') == std::string::npos && version.find('X') == std::string::npos
+        && std::count(version.begin(), version.end(), '.') >= 2;
+    return exact ? std::chrono::seconds(0) : kMutableMetadataMaxAge;
+}
+
+bool CacheStore::is_fresh(const std::string& path, std::chrono::seconds max_age) {
+    struct stat st {};
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    if (max_age.count() == 0) {
+        return true;
+    }
+    auto modified = std::chrono::system_clock::from_time_t(st.st_mtime);
+    return std::chrono::system_clock::now() - modified <= max_age;
+}
+
+std::optional<std::string> CacheStore::get_or_create(
+    const std::string& entry_path,
+    const std::function<bool(const std::string& temp_path)>& producer,
+    std::chrono::seconds max_age) {
+
+    // Offline, any cached copy is better than none
+    if (g_offline_mode) {
+        max_age = std::chrono::seconds(0);
+    }
+
+    // Fast path: published entries are immutable until replaced by another rename
+    if (is_fresh(entry_path, max_age)) {
+        if (g_verbose_output) {
+            std::cout << "CacheStore hit: " << entry_path << std::endl;
+        }
+        record_access(entry_path);
+        return entry_path;
+    }
+
+    if (!FileUtils::create_directory_recursively(parent_directory(entry_path))) {
+        return std::nullopt;
+    }
+
+    CacheEntryLock lock(entry_path);
+
+    // Another process may have produced the entry while this one waited for the lock
+    if (is_fresh(entry_path, max_age)) {
+        if (g_verbose_output) {
+            std::cout << "CacheStore hit after wait: " << entry_path << std::endl;
+        }
+        record_access(entry_path);
+        return entry_path;
+    }
+
+    std::string temp_path = temp_path_for(entry_path);
+    if (!producer(temp_path)) {
+        std::remove(temp_path.c_str());
+        return std::nullopt;
+    }
+    if (std::rename(temp_path.c_str(), entry_path.c_str()) != 0) {
+        std::cerr << "CacheStore: failed to publish " << entry_path << ": " << strerror(errno) << std::endl;
+        std::remove(temp_path.c_str());
+        return std::nullopt;
+    }
+    if (g_verbose_output) {
+        std::cout << "CacheStore stored: " << entry_path << std::endl;
+    }
+    record_access(entry_path);
+    return entry_path;
+}
+
+void CacheStore::record_access(const std::string& entry_path) const {
+    if (entry_path.compare(0, root_.size() + 1, root_ + "/") == 0) {
+        index_->touch(entry_path.substr(root_.size() + 1));
+    }
+}
+
+bool CacheStore::write_atomic(const std::string& path, const std::string& data) {
+    if (!FileUtils::create_directory_recursively(parent_directory(path))) {
+        return false;
+    }
+    std::string temp_path = temp_path_for(path);
+    if (!FileUtils::write_file(temp_path, data)) {
+        std::cerr << "CacheStore: cannot write " << temp_path << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "CacheStore: failed to rename " << temp_path << " to " << path << ": " << strerror(errno) << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace jpm
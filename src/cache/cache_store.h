@@ -0,0 +1,87 @@
+#ifndef JPM_CACHE_STORE_H
+#define JPM_CACHE_STORE_H
+
+#include <string>
+#include <optional>
+#include <functional>
+#include <chrono>
+#include <memory>
+
+namespace jpm {
+
+class CacheIndex;
+
+// Exclusive advisory lock (flock) on "<entry>.lock", held for the object's lifetime.
+// Works across processes; other jpm invocations block until it is released.
+// With wait == false the lock is only taken if it is free right now (see locked()).
+// A shared lock only excludes exclusive holders.
+class CacheEntryLock {
+public:
+    explicit CacheEntryLock(const std::string& entry_path, bool wait = true, bool shared = false);
+    ~CacheEntryLock();
+    CacheEntryLock(const CacheEntryLock&) = delete;
+    CacheEntryLock& operator=(const CacheEntryLock&) = delete;
+
+    bool locked() const { return fd_ >= 0; }
+
+    // Lets a program started with exec() inherit the lock, which then lasts until it exits
+    void keep_across_exec();
+
+private:
+    int fd_ = -1;
+};
+
+// On-disk cache of packuments and tarballs shared by every jpm process on the host.
+// Entries are only ever published by renaming a fully written temp file, so readers
+// never observe partial data, and a per-entry lock makes sure only one process
+// downloads a given entry while the others wait for it.
+class CacheStore {
+public:
+    // Uses default_root()
+    CacheStore();
+    explicit CacheStore(std::string root);
+
+    // $JPM_CACHE_DIR, else $XDG_CACHE_HOME/jpm, else $HOME/.cache/jpm
+    static std::string default_root();
+
+    const std::string& root() const { return root_; }
+
+    // <root>/packuments/<name>/<version>.json ("/" in scoped names becomes "+")
+    std::string packument_path(const std::string& name, const std::string& version) const;
+    // <root>/tarballs/<name>/<version>.tgz
+    std::string tarball_path(const std::string& name, const std::string& version) const;
+    // <root>/x/<spec>: a package installed for `jpm x <spec>`
+    std::string exec_path(const std::string& spec) const;
+
+    // Returns entry_path once it holds a valid entry. If the entry is missing or older
+    // than max_age (zero = never stale), producer is called with a temp path to fill;
+    // on success the temp file is renamed over the entry. Returns std::nullopt if the
+    // producer fails.
+    std::optional<std::string> get_or_create(
+        const std::string& entry_path,
+        const std::function<bool(const std::string& temp_path)>& producer,
+        std::chrono::seconds max_age = std::chrono::seconds(0));
+
+    // Freshness of a cached packument: exact versions never change, while dist-tags
+    // and ranges like "latest" are refetched after a few minutes
+    static std::chrono::seconds packument_max_age(const std::string& version);
+
+    // Records a use of an entry under root() in the access index. get_or_create does
+    // this itself; entries used some other way (a `jpm x` install) call it directly.
+    void record_access(const std::string& entry_path) const;
+
+    // Writes data to a temp file next to path, then renames it into place
+    static bool write_atomic(const std::string& path, const std::string& data);
+
+private:
+    std::string root_;
+    std::shared_ptr<CacheIndex> index_; // Last-access times for `jpm cache gc`
+
+    static bool is_fresh(const std::string& path, std::chrono::seconds max_age);
+    static std::string temp_path_for(const std::string& entry_path);
+    static std::string escape_name(const std::string& name);
+};
+
+} // namespace jpm
+
+#endif // JPM_CACHE_STORE_H
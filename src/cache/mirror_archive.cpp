@@ -0,0 +1,281 @@
+#include "cache/mirror_archive.h"
+#include "utils/file_utils.h"
+#include "jpm_config.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
+
+namespace jpm {
+
+namespace {
+
+constexpr char kMagic[8] = {'J', 'P', 'M', 'M', 'I', 'R', 'R', '1'};
+constexpr uint32_t kFormatVersion = 1;
+constexpr size_t kHeaderSize = 32;
+constexpr size_t kIndexRecordSize = 40;
+
+uint64_t hash_key(std::string_view key) {
+    // FNV-1a: cheap, stable across platforms and builds
+    uint64_t hash = 1469598103934665603ULL;
+    for (char c : key) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void put_u32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+void put_u64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+uint32_t get_u32(const unsigned char* p) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) value = (value << 8) | p[i];
+    return value;
+}
+
+uint64_t get_u64(const unsigned char* p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) value = (value << 8) | p[i];
+    return value;
+}
+
+struct IndexRecord {
+    uint64_t key_hash;
+    std::string_view key;
+    uint64_t data_offset;
+    uint64_t data_length;
+};
+
+bool index_less(const IndexRecord& a, const IndexRecord& b) {
+    return a.key_hash != b.key_hash ? a.key_hash < b.key_hash : a.key < b.key;
+}
+
+} // namespace
+
+MirrorArchive::~MirrorArchive() {
+#ifndef _WIN32
+    if (base_ && owned_.empty()) {
+        munmap(const_cast<unsigned char*>(base_), mapped_size_);
+    }
+#endif
+}
+
+std::string MirrorArchive::key_for_url(const std::string& url) {
+    size_t start = 0;
+    size_t scheme = url.find("://");
+    if (scheme != std::string::npos) {
+        start = url.find('/', scheme + 3);
+        if (start == std::string::npos) return "/";
+    }
+    size_t end = url.find_first_of("?#", start);
+    return url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+bool MirrorArchive::write(const std::string& path, const std::vector<Item>& items) {
+    std::string temp_path = path + ".tmp-" + std::to_string(getpid());
+    std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "MirrorArchive: cannot open " << temp_path << " for writing." << std::endl;
+        return false;
+    }
+
+    // Header is rewritten once the index position is known
+    out.write(std::string(kHeaderSize, '\0').data(), kHeaderSize);
+
+    std::vector<IndexRecord> records;
+    records.reserve(items.size());
+    uint64_t offset = kHeaderSize;
+    for (const auto& item : items) {
+        uint64_t length = 0;
+        if (item.source_path.empty()) {
+            out.write(item.data.data(), static_cast<std::streamsize>(item.data.size()));
+            length = item.data.size();
+        } else {
+            std::ifstream in(item.source_path, std::ios::binary);
+            if (!in) {
+                std::cerr << "MirrorArchive: cannot read " << item.source_path << std::endl;
+                out.close();
+                std::remove(temp_path.c_str());
+                return false;
+            }
+            std::streampos before = out.tellp();
+            out << in.rdbuf();
+            length = static_cast<uint64_t>(out.tellp() - before);
+        }
+        records.push_back({hash_key(item.key), item.key, offset, length});
+        offset += length;
+    }
+
+    std::sort(records.begin(), records.end(), index_less);
+    auto duplicate = std::adjacent_find(records.begin(), records.end(),
+        [](const IndexRecord& a, const IndexRecord& b) { return a.key == b.key; });
+    if (duplicate != records.end()) {
+        std::cerr << "MirrorArchive: duplicate key " << duplicate->key << std::endl;
+        out.close();
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    uint64_t index_offset = offset;
+    uint64_t keys_offset = index_offset + records.size() * kIndexRecordSize;
+    std::string index;
+    index.reserve(records.size() * kIndexRecordSize);
+    std::string keys;
+    for (const auto& record : records) {
+        put_u64(index, record.key_hash);
+        put_u64(index, keys.size());
+        put_u64(index, record.data_offset);
+        put_u64(index, record.data_length);
+        put_u32(index, static_cast<uint32_t>(record.key.size()));
+        put_u32(index, 0);
+        keys.append(record.key);
+    }
+    out.write(index.data(), static_cast<std::streamsize>(index.size()));
+    out.write(keys.data(), static_cast<std::streamsize>(keys.size()));
+
+    std::string header(kMagic, sizeof(kMagic));
+    put_u32(header, kFormatVersion);
+    put_u32(header, static_cast<uint32_t>(records.size()));
+    put_u64(header, index_offset);
+    put_u64(header, keys_offset);
+    out.seekp(0);
+    out.write(header.data(), static_cast<std::streamsize>(header.size()));
+    out.close();
+    if (!out) {
+        std::cerr << "MirrorArchive: failed writing " << temp_path << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "MirrorArchive: failed to rename " << temp_path << " to " << path << ": " << strerror(errno) << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    if (g_verbose_output) {
+        std::cout << "MirrorArchive wrote " << records.size() << " entries to " << path << std::endl;
+    }
+    return true;
+}
+
+std::unique_ptr<MirrorArchive> MirrorArchive::open(const std::string& path) {
+    std::unique_ptr<MirrorArchive> archive(new MirrorArchive());
+
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "MirrorArchive: cannot open " << path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kHeaderSize)) {
+        std::cerr << "MirrorArchive: " << path << " is not a mirror archive." << std::endl;
+        ::close(fd);
+        return nullptr;
+    }
+    void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file alive
+    if (mapped == MAP_FAILED) {
+        std::cerr << "MirrorArchive: mmap failed for " << path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    archive->base_ = static_cast<const unsigned char*>(mapped);
+    archive->mapped_size_ = static_cast<size_t>(st.st_size);
+#else
+    std::optional<std::string> contents = FileUtils::read_file(path);
+    if (!contents || contents->size() < kHeaderSize) {
+        std::cerr << "MirrorArchive: " << path << " is not a mirror archive." << std::endl;
+        return nullptr;
+    }
+    archive->owned_ = std::move(*contents);
+    archive->base_ = reinterpret_cast<const unsigned char*>(archive->owned_.data());
+    archive->mapped_size_ = archive->owned_.size();
+#endif
+
+    const unsigned char* header = archive->base_;
+    uint64_t index_offset = get_u64(header + 16);
+    uint64_t keys_offset = get_u64(header + 24);
+    archive->entry_count_ = get_u32(header + 12);
+    if (std::memcmp(header, kMagic, sizeof(kMagic)) != 0 || get_u32(header + 8) != kFormatVersion ||
+        index_offset > archive->mapped_size_ || keys_offset > archive->mapped_size_ ||
+        keys_offset - index_offset != static_cast<uint64_t>(archive->entry_count_) * kIndexRecordSize) {
+        std::cerr << "MirrorArchive: " << path << " is not a supported mirror archive." << std::endl;
+        return nullptr;
+    }
+    archive->index_ = archive->base_ + index_offset;
+    archive->keys_ = archive->base_ + keys_offset;
+    archive->keys_size_ = archive->mapped_size_ - keys_offset;
+
+    if (g_verbose_output) {
+        std::cout << "MirrorArchive mapped " << path << " (" << archive->entry_count_ << " entries, "
+                  << archive->mapped_size_ << " bytes)" << std::endl;
+    }
+    return archive;
+}
+
+std::optional<std::string_view> MirrorArchive::find(std::string_view key) const {
+    uint64_t wanted_hash = hash_key(key);
+    size_t lo = 0;
+    size_t hi = entry_count_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const unsigned char* record = index_ + mid * kIndexRecordSize;
+        uint64_t record_hash = get_u64(record);
+        uint64_t key_offset = get_u64(record + 8);
+        uint32_t key_length = get_u32(record + 32);
+        if (key_offset + key_length > keys_size_) {
+            return std::nullopt; // Corrupt index
+        }
+        std::string_view record_key(reinterpret_cast<const char*>(keys_ + key_offset), key_length);
+
+        if (record_hash == wanted_hash && record_key == key) {
+            uint64_t data_offset = get_u64(record + 16);
+            uint64_t data_length = get_u64(record + 24);
+            if (data_offset + data_length > mapped_size_) {
+                return std::nullopt;
+            }
+            return std::string_view(reinterpret_cast<const char*>(base_ + data_offset), data_length);
+        }
+        bool record_before = record_hash != wanted_hash ? record_hash < wanted_hash : record_key < key;
+        if (record_before) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return std::nullopt;
+}
+
+void MirrorArchive::for_each(const std::function<void(std::string_view, std::string_view)>& visit) const {
+    for (size_t i = 0; i < entry_count_; ++i) {
+        const unsigned char* record = index_ + i * kIndexRecordSize;
+        uint64_t key_offset = get_u64(record + 8);
+        uint64_t data_offset = get_u64(record + 16);
+        uint64_t data_length = get_u64(record + 24);
+        uint32_t key_length = get_u32(record + 32);
+        if (key_offset + key_length > keys_size_ || data_offset + data_length > mapped_size_) {
+            return; // Corrupt index
+        }
+        visit(std::string_view(reinterpret_cast<const char*>(keys_ + key_offset), key_length),
+              std::string_view(reinterpret_cast<const char*>(base_ + data_offset), data_length));
+    }
+}
+
+} // namespace jpm
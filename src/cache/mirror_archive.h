@@ -0,0 +1,69 @@
+#ifndef JPM_MIRROR_ARCHIVE_H
+#define JPM_MIRROR_ARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jpm {
+
+// Single-file bundle of packuments and tarballs for air-gapped installs.
+//
+// Layout (little-endian):
+//   header   "JPMMIRR1", u32 version, u32 entry_count, u64 index_offset, u64 keys_offset
+//   blobs    entry payloads, stored as-is (tarballs stay gzip-compressed)
+//   index    entry_count x { u64 key_hash, u64 key_offset, u64 data_offset, u64 data_length, u32 key_length, u32 pad }
+//            sorted by (key_hash, key) for binary search
+//   keys     concatenated key bytes
+//
+// Readers mmap the whole file, so lookups touch only the index pages and
+// payloads are handed out as views into the mapping with no copies.
+class MirrorArchive {
+public:
+    struct Item {
+        std::string key;          // e.g. "/lodash/4.17.21" or "/lodash/-/lodash-4.17.21.tgz"
+        std::string data;         // inline payload, used when source_path is empty
+        std::string source_path;  // file to copy the payload from
+    };
+
+    ~MirrorArchive();
+    MirrorArchive(const MirrorArchive&) = delete;
+    MirrorArchive& operator=(const MirrorArchive&) = delete;
+
+    // Writes items to path (via a temp file and rename). Returns false on I/O error.
+    static bool write(const std::string& path, const std::vector<Item>& items);
+
+    // Maps an archive read-only. Returns nullptr if it is missing or malformed.
+    static std::unique_ptr<MirrorArchive> open(const std::string& path);
+
+    // View of the payload stored under key; valid as long as the archive is alive
+    std::optional<std::string_view> find(std::string_view key) const;
+
+    // Calls visit(key, payload) for every entry, in index order
+    void for_each(const std::function<void(std::string_view, std::string_view)>& visit) const;
+
+    size_t entry_count() const { return entry_count_; }
+
+    // Archive key for a registry URL: its path, without scheme, host and query
+    static std::string key_for_url(const std::string& url);
+
+private:
+    MirrorArchive() = default;
+
+    const unsigned char* base_ = nullptr;
+    size_t mapped_size_ = 0;
+    std::string owned_; // file contents on platforms without mmap
+    uint32_t entry_count_ = 0;
+    const unsigned char* index_ = nullptr;
+    const unsigned char* keys_ = nullptr;
+    size_t keys_size_ = 0;
+};
+
+} // namespace jpm
+
+#endif // JPM_MIRROR_ARCHIVE_H
@@ -0,0 +1,372 @@
+#include "exec/exec.h"
+#include "cache/cache_store.h"
+#include "install/install.h"
+#include "package/dependency_resolver.h"
+#include "package/package_spec.h"
+#include "parsing/json_parser.h"
+#include "utils/file_utils.h"
+#include "jpm_config.h"
+#ifdef USE_JAVASCRIPTCORE
+#include "js/js.h"
+#endif
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
+
+namespace jpm {
+
+namespace {
+
+constexpr const char* kManifestName = ".jpm-x-manifest";
+constexpr const char* kManifestHeader = "jpm-x 2";
+// An install for a tag or range ("tsc", "eslint@8") is reused for this long before re-resolving
+constexpr std::chrono::hours kMutableSpecMaxAge{24};
+
+bool is_javascript_bin(const std::string& path) {
+    for (const char* extension : {".js", ".cjs", ".mjs"}) {
+        size_t length = std::strlen(extension);
+        if (path.size() >= length && path.compare(path.size() - length, length, extension) == 0) {
+            return true;
+        }
+    }
+    // Most bins are extensionless files starting with "#!/usr/bin/env node"
+    std::ifstream file(path);
+    std::string first_line;
+    std::getline(file, first_line);
+    return first_line.compare(0, 2, "#!") == 0 && first_line.find("node") != std::string::npos;
+}
+
+// Takes a shared lock on a version tree so that a newer install does not prune it while
+// its bin runs. False if the tree was pruned between reading the manifest and locking it.
+bool pin_version(const std::string& version_dir, std::optional<CacheEntryLock>& lock) {
+#ifndef _WIN32
+    lock.emplace(version_dir, false, true);
+    struct stat st {};
+    if (!lock->locked() || stat(version_dir.c_str(), &st) != 0) {
+        lock.reset();
+        return false;
+    }
+    lock->keep_across_exec(); // A native bin replaces this process and keeps holding it
+#else
+    (void)version_dir;
+    (void)lock;
+#endif
+    return true;
+}
+
+// Removes the version trees the manifest no longer points to unless a running bin still
+// pins them, and temp trees of interrupted installs. Called with the install lock held.
+void prune_versions(const std::string& install_dir, const std::string& current_dir) {
+#ifndef _WIN32
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    std::vector<fs::path> trees;
+    for (fs::directory_iterator entries(install_dir, ec), end; !ec && entries != end; entries.increment(ec)) {
+        std::error_code entry_ec;
+        // node_modules is the unversioned layout of older jpm releases, which do not pin it
+        if (entries->is_directory(entry_ec) && entries->path().string() != current_dir &&
+            entries->path().filename() != "node_modules") {
+            trees.push_back(entries->path());
+        }
+    }
+    for (const auto& tree : trees) {
+        std::error_code remove_ec;
+        if (tree.filename().string().compare(0, 5, ".tmp-") == 0) {
+            fs::remove_all(tree, remove_ec);
+            continue;
+        }
+        CacheEntryLock lock(tree.string(), false);
+        if (!lock.locked()) {
+            continue;
+        }
+        fs::remove_all(tree, remove_ec);
+        if (!remove_ec) {
+            fs::remove(tree.string() + ".lock", remove_ec);
+        }
+        if (g_verbose_output) {
+            std::cout << "jpm x: removed superseded " << tree.string() << std::endl;
+        }
+    }
+#else
+    (void)install_dir;
+    (void)current_dir;
+#endif
+}
+
+void print_usage() {
+    std::cerr << "Usage: jpm [-v|--verbose] x [--package <spec>] <spec|bin> [args...]" << std::endl;
+}
+
+} // namespace
+
+ExecCommand::ExecCommand() {
+    if (g_verbose_output) {
+        std::cout << "ExecCommand initialized." << std::endl;
+    }
+}
+
+int ExecCommand::execute(const std::vector<std::string>& args) {
+    auto start = std::chrono::steady_clock::now();
+
+    // `--package <spec> <bin>` runs a bin whose name differs from its package (typescript -> tsc)
+    std::string spec;
+    std::string bin_name;
+    size_t next = 0;
+    if (!args.empty() && args[0] == "--package") {
+        if (args.size() < 3) {
+            print_usage();
+            return 1;
+        }
+        spec = args[1];
+        bin_name = args[2];
+        next = 3;
+    } else if (!args.empty()) {
+        spec = args[0];
+        next = 1;
+    } else {
+        print_usage();
+        return 1;
+    }
+    std::vector<std::string> bin_args(args.begin() + static_cast<long>(next), args.end());
+
+    // Warm path: nothing but the manifest is touched; no resolver, no HTTP client
+    CacheStore cache;
+    std::string install_dir = cache.exec_path(spec);
+    std::optional<ExecManifest> manifest = load_manifest(install_dir, spec);
+    std::optional<CacheEntryLock> in_use;
+    if (manifest && !pin_version(manifest->directory, in_use)) {
+        manifest.reset();
+    }
+    if (manifest) {
+        cache.record_access(install_dir); // Keeps `jpm cache gc` from evicting tools in use
+    } else {
+        if (!FileUtils::create_directory_recursively(cache.root() + "/x")) {
+            std::cerr << "Cannot create " << cache.root() << "/x" << std::endl;
+            return 1;
+        }
+        // Concurrent `jpm x` runs of the same spec install it once
+        CacheEntryLock lock(install_dir);
+        manifest = load_manifest(install_dir, spec);
+        if (!manifest) {
+            manifest = install(spec, install_dir);
+        }
+        if (!manifest) {
+            return 1;
+        }
+        pin_version(manifest->directory, in_use); // Nothing prunes while the install lock is held
+        cache.record_access(install_dir);
+    }
+
+    PackageSpec package = PackageSpec::from_string(spec);
+    if (bin_name.empty()) {
+        bin_name = package.name.substr(package.name.find('/') == std::string::npos ? 0 : package.name.find('/') + 1);
+        if (manifest->bins.size() == 1) {
+            bin_name = manifest->bins.begin()->first;
+        }
+    }
+    auto bin_it = manifest->bins.find(bin_name);
+    if (bin_it == manifest->bins.end()) {
+        std::cerr << package.name << "@" << manifest->version << " has no bin named " << bin_name << ".";
+        if (!manifest->bins.empty()) {
+            std::cerr << " Available:";
+            for (const auto& [name, entry] : manifest->bins) {
+                (void)entry;
+                std::cerr << " " << name;
+            }
+            std::cerr << " (use --package " << spec << " <bin>)";
+        }
+        std::cerr << std::endl;
+        return 1;
+    }
+
+    if (g_verbose_output) {
+        std::chrono::duration<double, std::milli> overhead = std::chrono::steady_clock::now() - start;
+        std::cout << "jpm x: starting " << bin_it->second.path << " after " << overhead.count() << "ms" << std::endl;
+    }
+    return run_bin(bin_it->second, bin_args);
+}
+
+std::optional<ExecCommand::ExecManifest> ExecCommand::load_manifest(const std::string& install_dir, const std::string& spec) {
+    std::string manifest_path = install_dir + "/" + kManifestName;
+    struct stat st {};
+    if (stat(manifest_path.c_str(), &st) != 0) {
+        return std::nullopt;
+    }
+    // Exact versions never change; tags and ranges are re-resolved now and then unless offline
+    PackageSpec package = PackageSpec::from_string(spec);
+    if (!g_offline_mode && CacheStore::packument_max_age(package.version_requirement).count() != 0) {
+        auto modified = std::chrono::system_clock::from_time_t(st.st_mtime);
+        if (std::chrono::system_clock::now() - modified > kMutableSpecMaxAge) {
+            if (g_verbose_output) {
+                std::cout << "jpm x: " << spec << " was installed over a day ago; resolving again" << std::endl;
+            }
+            return std::nullopt;
+        }
+    }
+
+    std::ifstream file(manifest_path);
+    std::string line;
+    if (!std::getline(file, line) || line != kManifestHeader) {
+        return std::nullopt;
+    }
+    ExecManifest manifest;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string kind;
+        fields >> kind;
+        if (kind == "version") {
+            fields >> manifest.version;
+        } else if (kind == "dir") {
+            std::getline(fields >> std::ws, manifest.directory);
+        } else if (kind == "bin") {
+            std::string name, type;
+            fields >> name >> type;
+            std::string path;
+            std::getline(fields >> std::ws, path);
+            manifest.bins[name] = BinEntry{path, type == "js"};
+        }
+    }
+    if (manifest.directory.empty()) {
+        return std::nullopt;
+    }
+    return manifest;
+}
+
+ExecCommand::ExecManifest ExecCommand::read_bins(const std::string& package_dir, const std::string& package_name) {
+    ExecManifest manifest;
+    std::optional<std::string> content = FileUtils::read_file(package_dir + "/package.json");
+    JsonData package_json = content ? JsonParser::try_parse(*content) : JsonData();
+    if (!package_json.is_object()) {
+        return manifest;
+    }
+    manifest.version = package_json.value("version", "");
+
+    auto add_bin = [&](const std::string& name, const std::string& relative_path) {
+        std::string path = package_dir + "/" + (relative_path.compare(0, 2, "./") == 0 ? relative_path.substr(2) : relative_path);
+        manifest.bins[name] = BinEntry{path, is_javascript_bin(path)};
+    };
+    if (package_json.contains("bin")) {
+        const JsonData& bin = package_json["bin"];
+        if (bin.is_string()) {
+            add_bin(package_name.substr(package_name.find('/') == std::string::npos ? 0 : package_name.find('/') + 1),
+                    bin.get<std::string>());
+        } else if (bin.is_object()) {
+            for (auto it = bin.begin(); it != bin.end(); ++it) {
+                if (it.value().is_string()) {
+                    add_bin(it.key(), it.value().get<std::string>());
+                }
+            }
+        }
+    }
+    return manifest;
+}
+
+std::optional<ExecCommand::ExecManifest> ExecCommand::install(const std::string& spec, const std::string& install_dir) {
+    PackageSpec package = PackageSpec::from_string(spec);
+    DependencyResolver resolver;
+    ResolutionResult result = resolver.resolve(package);
+    if (!result.success) {
+        std::cerr << "Failed to resolve " << spec << ". " << result.error_message << std::endl;
+        return std::nullopt;
+    }
+
+    auto root = result.dependency_edges[""].find(package.name);
+    if (root == result.dependency_edges[""].end()) {
+        std::cerr << "Failed to resolve " << spec << ". No version of " << package.name << " was selected." << std::endl;
+        return std::nullopt;
+    }
+    std::string version = root->second.substr(root->second.rfind('@') + 1);
+    if (!FileUtils::create_directory_recursively(install_dir)) {
+        std::cerr << "Cannot create " << install_dir << std::endl;
+        return std::nullopt;
+    }
+
+    // Each version gets its own tree, built in a temp directory and renamed into place, so
+    // a half-finished install is never mistaken for a usable one. A tag that resolves to
+    // the version already there only gets a fresh manifest.
+    std::error_code ec;
+    std::string version_dir = install_dir + "/" + version;
+    std::string package_dir = version_dir + "/node_modules/" + package.name;
+    if (!std::filesystem::exists(package_dir, ec)) {
+        std::string temp_dir = install_dir + "/.tmp-" + std::to_string(getpid());
+        std::filesystem::remove_all(temp_dir, ec);
+
+        InstallCommand installer;
+        InstallOptions options;
+        if (!installer.install_resolution(result, temp_dir + "/node_modules", options)) {
+            std::filesystem::remove_all(temp_dir, ec);
+            return std::nullopt;
+        }
+        if (std::rename(temp_dir.c_str(), version_dir.c_str()) != 0) {
+            std::cerr << "Cannot move " << temp_dir << " to " << version_dir << ": " << strerror(errno) << std::endl;
+            std::filesystem::remove_all(temp_dir, ec);
+            return std::nullopt;
+        }
+    }
+
+    ExecManifest manifest = read_bins(package_dir, package.name);
+    manifest.directory = version_dir;
+    std::string manifest_text = std::string(kManifestHeader) + "\nversion " + manifest.version + "\ndir " + version_dir + "\n";
+    for (const auto& [name, entry] : manifest.bins) {
+        manifest_text += "bin " + name + (entry.javascript ? " js " : " exec ") + entry.path + "\n";
+    }
+    // Replacing the manifest is what moves later runs to this version; runs already
+    // started keep the tree they pinned
+    if (!CacheStore::write_atomic(install_dir + "/" + kManifestName, manifest_text)) {
+        std::cerr << "Cannot write " << kManifestName << " for " << spec << std::endl;
+        return std::nullopt;
+    }
+    prune_versions(install_dir, version_dir);
+    return manifest;
+}
+
+int ExecCommand::run_bin(const BinEntry& bin, const std::vector<std::string>& bin_args) {
+    if (bin.javascript) {
+#ifdef USE_JAVASCRIPTCORE
+        // Same process: no interpreter start-up on top of jpm's own
+        std::vector<std::string> js_args = {bin.path};
+        js_args.insert(js_args.end(), bin_args.begin(), bin_args.end());
+        JSCommand js_command;
+        return js_command.execute(js_args);
+#endif
+    }
+
+#ifndef _WIN32
+    std::vector<std::string> arguments;
+    if (bin.javascript) {
+        arguments.push_back("node"); // No embedded engine in this build
+    }
+    arguments.push_back(bin.path);
+    arguments.insert(arguments.end(), bin_args.begin(), bin_args.end());
+    std::vector<char*> argv;
+    for (auto& argument : arguments) argv.push_back(argument.data());
+    argv.push_back(nullptr);
+
+    std::cout.flush();
+    execvp(argv[0], argv.data());
+    std::cerr << "Cannot run " << bin.path << ": " << strerror(errno) << std::endl;
+    return 127;
+#else
+    std::string command = (bin.javascript ? "node \"" : "\"") + bin.path + "\"";
+    for (const auto& argument : bin_args) {
+        command += " \"" + argument + "\"";
+    }
+    return std::system(command.c_str());
+#endif
+}
+
+} // namespace jpm
@@ -0,0 +1,51 @@
+#ifndef JPM_EXEC_COMMAND_H
+#define JPM_EXEC_COMMAND_H
+
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace jpm {
+
+// `jpm x [--package <spec>] <spec|bin> [args...]`: runs a package's bin without
+// adding it to the project. Each resolved version is installed once into
+// <cache>/x/<spec>/<version>; a manifest written last records its bins, so later
+// runs cost one stat and one small read before the bin starts. A running bin holds
+// a shared lock on its version tree, so a newer install never removes it from under
+// it. JavaScript bins run inside this process through JSCommand; anything else
+// replaces this process via exec.
+class ExecCommand {
+public:
+    ExecCommand();
+    // Returns the exit status for jpm
+    int execute(const std::vector<std::string>& args);
+
+private:
+    struct BinEntry {
+        std::string path;      // Absolute path of the bin file
+        bool javascript = false;
+    };
+
+    struct ExecManifest {
+        std::string version;
+        std::string directory; // Version tree the bins live in
+        std::map<std::string, BinEntry> bins; // bin name -> entry
+    };
+
+    // Reads <install_dir>/.jpm-x-manifest if it exists and is still fresh for spec
+    static std::optional<ExecManifest> load_manifest(const std::string& install_dir, const std::string& spec);
+
+    // Resolves spec and installs it into a version tree under install_dir (via a temp
+    // directory renamed into place), then switches the manifest to it
+    static std::optional<ExecManifest> install(const std::string& spec, const std::string& install_dir);
+
+    // Bins declared by the installed package's package.json
+    static ExecManifest read_bins(const std::string& package_dir, const std::string& package_name);
+
+    static int run_bin(const BinEntry& bin, const std::vector<std::string>& bin_args);
+};
+
+} // namespace jpm
+
+#endif // JPM_EXEC_COMMAND_H
@@ -0,0 +1,99 @@
+#include "fetch/fetch.h"
+#include "package/lockfile.h"
+#include "cache/cache_store.h"
+#include "utils/thread_pool.h"
+#include "utils/ui_utils.h"
+#include "jpm_config.h"
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
+namespace jpm {
+
+namespace {
+// Downloads in flight at once; requests are network-bound, not CPU-bound
+constexpr size_t kFetchConcurrency = 16;
+}
+
+FetchCommand::FetchCommand() {
+    if (g_verbose_output) {
+        std::cout << "FetchCommand initialized." << std::endl;
+    }
+}
+
+bool FetchCommand::execute(const std::vector<std::string>& args) {
+    std::string lockfile_path = Lockfile::kFileName;
+    bool all_platforms = false;
+    for (const auto& arg : args) {
+        if (arg == "--all-platforms") {
+            all_platforms = true;
+        } else {
+            lockfile_path = arg;
+        }
+    }
+    std::optional<ResolutionResult> locked = Lockfile::load(lockfile_path);
+    if (!locked) {
+        std::cerr << "Could not read lockfile " << lockfile_path << ". Run `jpm install` first to create it." << std::endl;
+        return false;
+    }
+    // By default only what an install on this host would download
+    if (!all_platforms) {
+        locked = DependencyResolver::filter_for_host(*locked);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    UIUtils::ProgressSpinner spinner;
+    spinner.start("Fetching " + std::to_string(locked->packages_to_install.size()) + " packages...");
+
+    std::atomic<size_t> completed{0};
+    std::atomic<bool> done{false};
+    std::thread spinner_thread([&]() {
+        while (!done) {
+            spinner.update_message("Fetching packages (" + std::to_string(completed.load()) + "/" +
+                                   std::to_string(locked->packages_to_install.size()) + ")...");
+            spinner.tick();
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    });
+
+    // Packument and tarball of each package are independent of every other package,
+    // so the whole lockfile is fetched in parallel.
+    std::vector<std::future<bool>> results;
+    {
+        ThreadPool pool(kFetchConcurrency);
+        for (const auto& info : locked->packages_to_install) {
+            results.push_back(pool.submit([this, &info, &completed]() {
+                PackageInfo manifest = resolver_.fetch_and_parse_package_info(
+                    PackageSpec(info.name, info.resolved_version));
+                bool ok = !manifest.resolved_version.empty();
+                ok = tarball_handler_.fetch(info.tarball_url, info.name, info.resolved_version).has_value() && ok;
+                ++completed;
+                return ok;
+            }));
+        }
+    }
+
+    size_t failures = 0;
+    for (auto& result : results) {
+        if (!result.get()) ++failures;
+    }
+    done = true;
+    spinner_thread.join();
+
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    if (failures > 0) {
+        spinner.stop(false, "Failed to fetch " + std::to_string(failures) + " of " +
+                            std::to_string(results.size()) + " packages");
+        return false;
+    }
+    spinner.stop(true, "Fetched " + std::to_string(results.size()) + " packages into " +
+                       CacheStore::default_root());
+    if (g_verbose_output) {
+        std::cout << "Fetch took: " << elapsed.count() << "s" << std::endl;
+    }
+    return true;
+}
+
+} // namespace jpm
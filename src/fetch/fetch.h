@@ -0,0 +1,28 @@
+#ifndef JPM_FETCH_COMMAND_H
+#define JPM_FETCH_COMMAND_H
+
+#include <string>
+#include <vector>
+#include "package/dependency_resolver.h"
+#include "package/tarball_handler.h"
+
+namespace jpm {
+
+// `jpm fetch [--all-platforms] [<lockfile>]`: downloads every packument and tarball
+// listed in the lockfile into the shared cache without touching node_modules, so a
+// later `jpm install --offline` only has to extract. Optional packages built for
+// another os/cpu/libc are skipped unless --all-platforms is given.
+class FetchCommand {
+public:
+    FetchCommand();
+    // Returns true if every package is now in the cache
+    bool execute(const std::vector<std::string>& args);
+
+private:
+    DependencyResolver resolver_;
+    TarballHandler tarball_handler_;
+};
+
+} // namespace jpm
+
+#endif // JPM_FETCH_COMMAND_H
@@ -3,6 +3,13 @@
 #include "package/dependency_resolver.h"
 #include "utils/file_utils.h"
 #include "utils/ui_utils.h"
+#include "package/lockfile.h"
+#include "package/workspaces.h"
+#include "package/resolution_manifest.h"
+#include "cache/mirror_archive.h"
+#include "cache/cache_gc.h"
+#include "parsing/json_parser.h"
+#include "utils/thread_pool.h"
 #include "jpm_config.h"
 #include <iostream>
 #include <vector>
@@ -10,24 +17,66 @@
 #include <future>
 #include <thread>
 #include <algorithm>
+#include <filesystem>
 #include <chrono> // For timing
 
 namespace jpm {
 
+namespace {
+// Concurrent tarball downloads during the fetch phase
+constexpr size_t kFetchConcurrency = 16;
+}
+
 InstallCommand::InstallCommand() {
     if (g_verbose_output) {
         std::cout << "InstallCommand initialized." << std::endl;
     }
 }
 
-void InstallCommand::execute(const std::vector<std::string>& packages_to_install_args) {
-    if (packages_to_install_args.empty()) {
-        std::cerr << "No packages specified for install command." << std::endl;
-        return;
+bool InstallCommand::execute(const std::vector<std::string>& args) {
+    InstallOptions options;
+    std::vector<std::string> packages_to_install_args;
+    std::string mirror_path;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (arg == "--production") {
+            options.production = true;
+        } else if (arg == "--offline") {
+            g_offline_mode = true;
+        } else if (arg == "--ignore-scripts") {
+            options.ignore_scripts = true;
+        } else if (arg == "--mirror" || arg.compare(0, 9, "--mirror=") == 0) {
+            if (arg.size() > 9) {
+                mirror_path = arg.substr(9);
+            } else if (i + 1 < args.size()) {
+                mirror_path = args[++i];
+            } else {
+                std::cerr << "--mirror needs an archive path" << std::endl;
+                return false;
+            }
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            // jpm's own options (-v, --registry) go before the command word
+            std::cerr << "Unknown install option: " << arg << std::endl;
+            return false;
+        } else {
+            packages_to_install_args.push_back(arg);
+        }
     }
 
     auto overall_start_time = std::chrono::high_resolution_clock::now();
 
+    if (!mirror_path.empty()) {
+        std::shared_ptr<const MirrorArchive> mirror = MirrorArchive::open(mirror_path);
+        if (!mirror) {
+            return false;
+        }
+        if (g_verbose_output) {
+            std::cout << "Installing from mirror " << mirror_path << " (" << mirror->entry_count() << " entries)" << std::endl;
+        }
+        HttpClient::use_mirror(std::move(mirror));
+        g_offline_mode = true; // Nothing may reach the network or depend on cache freshness
+    }
+
     if (g_verbose_output) {
         std::cout << "Install command executing for: ";
         for (size_t i = 0; i < packages_to_install_args.size(); ++i) {
@@ -36,44 +85,200 @@ void InstallCommand::execute(const std::vector<std::string>& packages_to_install
         std::cout << std::endl;
     }
 
-    UIUtils::ProgressSpinner spinner;
+    if (packages_to_install_args.empty() && !FileUtils::path_exists("./package.json")) {
+        std::cerr << "No package.json found in the current directory." << std::endl;
+        std::cerr << "Usage: jpm [-v|--verbose] install [--production] [--offline] [--ignore-scripts] [--mirror <file>] [<package_name>[@<version>]...]" << std::endl;
+        return false;
+    }
 
     // Ensure base dir
     std::string destination_base = "./node_modules";
-    if (!jpm::FileUtils::path_exists(destination_base)) {
+    const bool fresh_node_modules = !jpm::FileUtils::path_exists(destination_base);
+    if (fresh_node_modules) {
         if (g_verbose_output) {
             std::cout << "Creating directory: " << destination_base << std::endl;
         }
         if (!jpm::FileUtils::create_directory_recursively(destination_base)) {
             std::cerr << "Failed to create installation directory: " << destination_base << ". Aborting installation." << std::endl;
-            return;
+            return false;
         }
     }
 
+    if (packages_to_install_args.empty()) {
+        bool installed = install_project(options, destination_base);
+        if (g_verbose_output) {
+            std::chrono::duration<double> tot = std::chrono::high_resolution_clock::now() - overall_start_time;
+            std::cout << "Total jpm execution time: " << tot.count() << "s" << std::endl;
+        }
+        collect_cache_garbage();
+        return installed;
+    }
+
+    // All arguments are one root set: resolved, planned and extracted together, so two
+    // of them needing different versions of a shared dependency get separate copies
+    std::vector<PackageSpec> root_specs;
+    std::string roots_label;
     for (const auto& pkg_arg : packages_to_install_args) {
-        auto single_pkg_start = std::chrono::high_resolution_clock::now();
+        root_specs.push_back(PackageSpec::from_string(pkg_arg));
+        roots_label += (roots_label.empty() ? "" : ", ") + root_specs.back().to_string();
+    }
+
+    UIUtils::ProgressSpinner spinner;
+    spinner.start("Resolving " + roots_label + "...");
+    if (g_verbose_output) {
+        std::cout << "-----------------------------------------------------\n"
+                  << "Resolving dependencies for: " << roots_label << std::endl;
+    }
 
-        // parse name/version
-        std::string package_name = pkg_arg;
-        std::string version_requirement = "latest";
-        size_t at = pkg_arg.find('@');
-        if (at != std::string::npos && at > 0) {
-            version_requirement = pkg_arg.substr(at + 1);
-            if (version_requirement.empty()) version_requirement = "latest";
-            package_name = pkg_arg.substr(0, at);
+    // resolution spinner thread
+    std::atomic<bool> resolve_done{false};
+    std::thread resolve_spinner([&](){
+        while (!resolve_done) {
+            spinner.tick();
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
+    });
+
+    auto resolve_start = std::chrono::high_resolution_clock::now();
+    ResolutionResult result = resolver_.resolve(root_specs);
+    resolve_done = true;
+    resolve_spinner.join();
+    if (g_verbose_output) {
+        std::chrono::duration<double> d = std::chrono::high_resolution_clock::now() - resolve_start;
+        std::cout << "Resolution took: " << d.count() << "s\n";
+    }
 
-        spinner.start("Preparing " + package_name + "...");
+    if (!result.success) {
+        std::cerr << "Failed to resolve " << roots_label << ". "
+                  << (!result.error_message.empty() ? result.error_message : "") << std::endl;
+        spinner.stop(false, "Resolution failed for " + roots_label);
+        collect_cache_garbage();
+        return false;
+    }
 
-        PackageSpec spec(package_name, version_requirement);
+    bool all_installed = true;
+    std::vector<ResolutionManifest::Entry> manifest_entries;
+    if (result.packages_to_install.empty()) {
+        spinner.stop(true, "Already up-to-date: " + roots_label);
+    } else {
         if (g_verbose_output) {
-            std::cout << "-----------------------------------------------------\n"
-                      << "Resolving dependencies for: " << spec.to_string() << std::endl;
+            std::cout << "Installing " << result.packages_to_install.size() << " packages for "
+                      << roots_label << "...\n";
         } else {
-            spinner.update_message("Resolving " + spec.to_string() + "...");
+            spinner.update_message("Installing " + roots_label + "...");
         }
 
-        // resolution spinner thread
+        InstallStats install_stats;
+        all_installed = install_resolved_packages(result, destination_base, options, spinner, install_stats,
+                                                  manifest_entries);
+        if (all_installed) {
+            spinner.stop(true, "Installed " + roots_label);
+        } else {
+            spinner.stop(false, "Installation failed for " + roots_label);
+        }
+        report_stats(install_stats);
+    }
+
+    // Only a fresh node_modules holds nothing but these packages; otherwise the entries
+    // join the existing manifest, as a partial one would shadow packages it omits
+    if (!manifest_entries.empty()) {
+        if (fresh_node_modules) {
+            ResolutionManifest::write(destination_base, manifest_entries);
+        } else {
+            ResolutionManifest::merge(destination_base, manifest_entries);
+        }
+    }
+
+    auto overall_end = std::chrono::high_resolution_clock::now();
+    if (g_verbose_output) {
+        std::chrono::duration<double> tot = overall_end - overall_start_time;
+        std::cout << "Total jpm execution time: " << tot.count() << "s" << std::endl;
+    }
+    collect_cache_garbage();
+    return all_installed;
+}
+
+void InstallCommand::collect_cache_garbage() {
+    // A mirror install never writes to the cache
+    if (!HttpClient::has_mirror()) {
+        CacheGc::collect_in_background(CacheStore::default_root());
+    }
+}
+
+bool InstallCommand::install_project(const InstallOptions& options, const std::string& destination_base) {
+    const std::string manifest_path = "./package.json";
+    std::optional<std::string> manifest_content = FileUtils::read_file(manifest_path);
+    if (!manifest_content) {
+        std::cerr << "Could not read " << manifest_path << "." << std::endl;
+        return false;
+    }
+
+    JsonData manifest = JsonParser::try_parse(*manifest_content);
+    if (!manifest.is_object()) {
+        std::cerr << "Failed to parse " << manifest_path << "." << std::endl;
+        return false;
+    }
+
+    // Workspace packages are installed together with the root as one project
+    std::vector<WorkspacePackage> workspaces = Workspaces::discover(".", manifest);
+    std::set<std::string> workspace_names;
+    for (const auto& workspace : workspaces) {
+        workspace_names.insert(workspace.name);
+    }
+
+    // dependencies first; a devDependencies entry for the same name is ignored, as is a
+    // second workspace asking for a name already requested (ranges are not merged).
+    // devDependencies are resolved and locked even with --production, so the lockfile
+    // always describes the whole project; they are only left out when linking.
+    std::vector<PackageSpec> root_specs;
+    std::set<std::string> root_names;
+    std::set<std::string> dev_root_names;
+    auto collect = [&](const JsonData& package_manifest, const char* field, bool dev) {
+        if (!package_manifest.contains(field) || !package_manifest[field].is_object()) {
+            return;
+        }
+        for (auto& [dep_name, dep_ver_req_json] : package_manifest[field].items()) {
+            if (!dep_ver_req_json.is_string() || workspace_names.count(dep_name) ||
+                !root_names.insert(dep_name).second) {
+                continue; // Workspace packages are linked, not fetched
+            }
+            root_specs.emplace_back(dep_name, dep_ver_req_json.get<std::string>());
+            if (dev) {
+                dev_root_names.insert(dep_name);
+            }
+        }
+    };
+    collect(manifest, "dependencies", false);
+    for (const auto& workspace : workspaces) {
+        collect(workspace.manifest, "dependencies", false);
+    }
+    collect(manifest, "devDependencies", true);
+    for (const auto& workspace : workspaces) {
+        collect(workspace.manifest, "devDependencies", true);
+    }
+
+    if (root_specs.empty() && workspaces.empty()) {
+        std::cout << "No dependencies to install." << std::endl;
+        return true;
+    }
+
+    UIUtils::ProgressSpinner spinner;
+    ResolutionResult result;
+
+    // A lockfile written for the same roots makes resolution unnecessary
+    std::optional<ResolutionResult> locked = root_specs.empty() ? std::nullopt : Lockfile::load(Lockfile::kFileName);
+    if (root_specs.empty()) {
+        result.success = true; // Only workspaces to link
+        spinner.start("Linking " + std::to_string(workspaces.size()) + " workspace packages...");
+    } else if (locked && Lockfile::matches_roots(*locked, root_specs)) {
+        result = std::move(*locked);
+        spinner.start("Using " + std::string(Lockfile::kFileName) + "...");
+    } else {
+        if (locked && g_verbose_output) {
+            std::cout << Lockfile::kFileName << " does not match package.json; resolving again" << std::endl;
+        }
+        spinner.start("Resolving " + std::to_string(root_specs.size()) + " dependencies from package.json...");
+
         std::atomic<bool> resolve_done{false};
         std::thread resolve_spinner([&](){
             while (!resolve_done) {
@@ -83,83 +288,240 @@ void InstallCommand::execute(const std::vector<std::string>& packages_to_install
         });
 
         auto resolve_start = std::chrono::high_resolution_clock::now();
-        ResolutionResult result = resolver_.resolve(spec);
+        result = resolver_.resolve(root_specs);
         resolve_done = true;
         resolve_spinner.join();
-        auto resolve_end = std::chrono::high_resolution_clock::now();
         if (g_verbose_output) {
-            std::chrono::duration<double> d = resolve_end - resolve_start;
-            std::cout << "Resolution took: " << d.count() << "s\n";
+            std::chrono::duration<double> d = std::chrono::high_resolution_clock::now() - resolve_start;
+            std::cout << "Resolution of " << root_specs.size() << " roots took: " << d.count() << "s\n";
         }
 
         if (!result.success) {
-            std::cerr << "Failed to resolve " << spec.to_string() << ". "
-                      << (!result.error_message.empty() ? result.error_message : "") << std::endl;
-            spinner.stop(false, "Resolution failed for " + spec.to_string());
-            continue;
+            spinner.stop(false, "Resolution failed: " + result.error_message);
+            return false;
         }
+        Lockfile::save(Lockfile::kFileName, result);
+    }
 
-        if (result.packages_to_install.empty()) {
-            spinner.stop(true, "Already up-to-date: " + spec.to_string());
-        } else {
-            if (g_verbose_output) {
-                std::cout << "Installing " << result.packages_to_install.size() << " packages for "
-                          << spec.to_string() << "...\n";
-            } else {
-                spinner.update_message("Installing " + spec.to_string() + "...");
+    // With the dev roots gone, filter_for_host() drops every package only they reach
+    if (options.production) {
+        auto roots_it = result.dependency_edges.find("");
+        if (roots_it != result.dependency_edges.end()) {
+            for (const auto& name : dev_root_names) {
+                roots_it->second.erase(name);
             }
+        }
+    }
 
-            // **Install-phase spinner thread**
-            std::atomic<bool> install_done{false};
-            std::thread install_spinner([&](){
-                while (!install_done) {
-                    spinner.tick();
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
-            });
-
-            // launch async downloads
-            std::vector<std::future<bool>> futures;
-            for (auto& pkg_info : result.packages_to_install) {
-                futures.push_back(std::async(std::launch::async, [=]() {
-                    return tarball_handler_.download_and_extract(
-                        pkg_info.tarball_url,
-                        pkg_info.name,
-                        pkg_info.resolved_version,
-                        destination_base
-                    );
-                }));
+    spinner.update_message("Installing " + std::to_string(result.packages_to_install.size()) + " packages...");
+    auto install_start = std::chrono::high_resolution_clock::now();
+    InstallStats install_stats;
+    std::vector<ResolutionManifest::Entry> manifest_entries;
+    bool all_ok = install_resolved_packages(result, destination_base, options, spinner, install_stats,
+                                            manifest_entries);
+    if (!workspaces.empty()) {
+        all_ok = Workspaces::link(workspaces, ".", destination_base) && all_ok;
+        // require() of a workspace finds its node_modules link, but loads the file from the
+        // real directory so the module has the same identity as when required relatively
+        for (const auto& workspace : workspaces) {
+            if (std::optional<std::string> entry = ResolutionManifest::entry_point(workspace.directory)) {
+                manifest_entries.push_back({"node_modules/" + workspace.name,
+                                            std::filesystem::path(workspace.directory + "/" + *entry)
+                                                .lexically_normal().generic_string()});
             }
+        }
+    }
+    ResolutionManifest::write(destination_base, manifest_entries);
+    if (all_ok && !options.ignore_scripts) {
+        spinner.update_message("Running project scripts...");
+        for (const auto& workspace : workspaces) {
+            all_ok = all_ok && lifecycle_runner_.run_project(workspace.directory, install_stats.scripts);
+        }
+        all_ok = all_ok && lifecycle_runner_.run_project(".", install_stats.scripts);
+    }
+    std::chrono::duration<double> install_time = std::chrono::high_resolution_clock::now() - install_start;
 
-            // wait for all
-            bool all_ok = true;
-            for (auto& f : futures) {
-                if (!f.get()) all_ok = false;
-            }
+    if (all_ok) {
+        spinner.stop(true, "Installed " + std::to_string(result.packages_to_install.size()) + " packages" +
+                           (workspaces.empty() ? "" : " and linked " + std::to_string(workspaces.size()) + " workspaces"));
+    } else {
+        spinner.stop(false, "Installation failed for one or more packages");
+    }
+    report_stats(install_stats);
+    if (g_verbose_output) {
+        std::cout << "Install phase took: " << install_time.count() << "s\n";
+    }
+    return all_ok;
+}
+
+bool InstallCommand::install_resolution(const ResolutionResult& result,
+                                        const std::string& node_modules_dir,
+                                        const InstallOptions& options) {
+    if (!FileUtils::create_directory_recursively(node_modules_dir)) {
+        std::cerr << "Failed to create installation directory: " << node_modules_dir << std::endl;
+        return false;
+    }
+    UIUtils::ProgressSpinner spinner;
+    spinner.start("Installing " + std::to_string(result.packages_to_install.size()) + " packages...");
+    InstallStats install_stats;
+    std::vector<ResolutionManifest::Entry> manifest_entries;
+    bool all_ok = install_resolved_packages(result, node_modules_dir, options, spinner, install_stats,
+                                            manifest_entries);
+    ResolutionManifest::write(node_modules_dir, manifest_entries);
+    if (all_ok) {
+        spinner.stop(true, "Installed " + std::to_string(result.packages_to_install.size()) + " packages");
+    } else {
+        spinner.stop(false, "Installation failed for one or more packages");
+    }
+    if (g_verbose_output) {
+        report_stats(install_stats);
+    }
+    return all_ok;
+}
 
-            // stop spinner
-            install_done = true;
-            install_spinner.join();
+bool InstallCommand::install_resolved_packages(const ResolutionResult& result,
+                                               const std::string& destination_base,
+                                               const InstallOptions& options,
+                                               UIUtils::ProgressSpinner& spinner,
+                                               InstallStats& stats,
+                                               std::vector<ResolutionManifest::Entry>& manifest_entries) {
+    // The resolved graph holds every platform's optional variants; only this host's are installed
+    const ResolutionResult host_result = DependencyResolver::filter_for_host(result);
+    LayoutPlanner planner;
+    InstallLayout layout = planner.plan(host_result, destination_base);
+    stats.layout = layout.stats;
 
-            if (all_ok) {
-                spinner.stop(true, "Installed " + spec.to_string());
-            } else {
-                spinner.stop(false, "Installation failed for " + spec.to_string());
+    FileUtils::DirectoryStats tree_before;
+    if (g_verbose_output) {
+        tree_before = FileUtils::directory_stats(destination_base);
+    }
+
+    // **Install-phase spinner thread**
+    std::atomic<bool> install_done{false};
+    std::thread install_spinner([&](){
+        while (!install_done) {
+            spinner.tick();
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    });
+
+    // Fetch phase: every distinct tarball into the cache (network-bound, so more
+    // workers than cores). With --offline this only checks the cache.
+    auto fetch_start = std::chrono::high_resolution_clock::now();
+    std::map<std::string, const PackageInfo*> unique_packages;
+    for (const auto& planned : layout.packages) {
+        unique_packages.emplace(planned.info.name + "@" + planned.info.resolved_version, &planned.info);
+    }
+    std::map<std::string, std::future<std::optional<TarballLocation>>> fetches;
+    {
+        ThreadPool fetch_pool(kFetchConcurrency);
+        for (const auto& [key, info] : unique_packages) {
+            fetches[key] = fetch_pool.submit([this, info]() {
+                return tarball_handler_.fetch(info->tarball_url, info->name, info->resolved_version);
+            });
+        }
+    }
+    std::map<std::string, TarballLocation> local_tarballs;
+    bool all_ok = true;
+    for (auto& [key, future] : fetches) {
+        std::optional<TarballLocation> location = future.get();
+        if (location) {
+            local_tarballs[key] = *location;
+        } else {
+            all_ok = false;
+        }
+    }
+    auto fetch_end = std::chrono::high_resolution_clock::now();
+
+    // Extraction phase: each planned copy from its cached tarball (CPU/disk-bound).
+    // The entry file of a fresh copy is looked up right away, while its package.json is hot.
+    std::vector<std::future<bool>> extractions;
+    std::vector<std::optional<std::string>> entry_points(layout.packages.size());
+    {
+        ThreadPool extract_pool;
+        for (size_t i = 0; i < layout.packages.size(); ++i) {
+            const PlannedPackage& planned = layout.packages[i];
+            auto local_it = local_tarballs.find(planned.info.name + "@" + planned.info.resolved_version);
+            if (local_it == local_tarballs.end()) {
+                continue;
             }
+            extractions.push_back(extract_pool.submit([this, &planned, &location = local_it->second,
+                                                       &entry_point = entry_points[i]]() {
+                if (!tarball_handler_.extract(location, planned.info.name, planned.parent_directory)) {
+                    return false;
+                }
+                entry_point = ResolutionManifest::entry_point(planned.install_path);
+                return true;
+            }));
+        }
+    }
+    for (auto& f : extractions) {
+        if (!f.get()) all_ok = false;
+    }
+    const std::filesystem::path project_root = std::filesystem::path(destination_base).parent_path();
+    for (size_t i = 0; i < layout.packages.size(); ++i) {
+        if (entry_points[i]) {
+            std::string package_path =
+                std::filesystem::path(layout.packages[i].install_path).lexically_relative(project_root).generic_string();
+            manifest_entries.push_back({package_path, package_path + "/" + *entry_points[i]});
         }
+    }
 
-        if (g_verbose_output) {
-            auto single_pkg_end = std::chrono::high_resolution_clock::now();
-            std::chrono::duration<double> total = single_pkg_end - single_pkg_start;
-            std::cout << "Total time for " << spec.to_string() << ": " << total.count() << "s\n"
-                      << "-----------------------------------------------------" << std::endl;
+    if (g_verbose_output) {
+        std::chrono::duration<double> fetch_time = fetch_end - fetch_start;
+        std::chrono::duration<double> extract_time = std::chrono::high_resolution_clock::now() - fetch_end;
+        std::cout << "Fetch phase (" << unique_packages.size() << " tarballs): " << fetch_time.count()
+                  << "s, extraction phase (" << extractions.size() << " copies): " << extract_time.count() << "s\n";
+    }
+
+    // Scripts phase: dependencies' scripts before their dependents', independent ones in parallel
+    if (all_ok && !options.ignore_scripts) {
+        spinner.update_message("Running lifecycle scripts...");
+        all_ok = lifecycle_runner_.run(layout, host_result.dependency_edges, stats.scripts);
+    }
+
+    // stop spinner
+    install_done = true;
+    install_spinner.join();
+
+    if (g_verbose_output) {
+        FileUtils::DirectoryStats tree_after = FileUtils::directory_stats(destination_base);
+        std::cout << destination_base << " before: " << tree_before.file_count << " files, "
+                  << tree_before.total_bytes << " bytes; after: " << tree_after.file_count << " files, "
+                  << tree_after.total_bytes << " bytes" << std::endl;
+    }
+    return all_ok;
+}
+
+void InstallCommand::report_stats(const InstallStats& stats) {
+    const LayoutStats& layout = stats.layout;
+    if (layout.planned_copies > 0) {
+        std::cout << "  " << layout.unique_packages << " unique packages, " << layout.planned_copies
+                  << " copies on disk";
+        if (layout.conflicts > 0) {
+            std::cout << " (" << layout.conflicts << " nested for version conflicts)";
         }
+        std::cout << "; an unhoisted tree would need " << layout.nested_copies << std::endl;
     }
 
-    auto overall_end = std::chrono::high_resolution_clock::now();
+    const LifecycleStats& scripts = stats.scripts;
+    if (scripts.scripts.empty()) {
+        return;
+    }
+    auto slowest = std::max_element(scripts.scripts.begin(), scripts.scripts.end(),
+        [](const ScriptTiming& a, const ScriptTiming& b) { return a.seconds < b.seconds; });
+    std::cout << "  " << scripts.scripts.size() << " lifecycle scripts in " << scripts.wall_seconds
+              << "s (" << scripts.script_seconds() << "s of script time); slowest: " << slowest->package
+              << " " << slowest->event << " " << slowest->seconds << "s";
+    if (scripts.failures > 0) {
+        std::cout << "; " << scripts.failures << " failed";
+    }
+    std::cout << std::endl;
     if (g_verbose_output) {
-        std::chrono::duration<double> tot = overall_end - overall_start_time;
-        std::cout << "Total jpm execution time: " << tot.count() << "s" << std::endl;
+        for (const auto& timing : scripts.scripts) {
+            std::cout << "    " << timing.package << " " << timing.event << ": " << timing.seconds << "s"
+                      << (timing.success ? "" : " (failed)") << std::endl;
+        }
     }
 }
 
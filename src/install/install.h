@@ -5,19 +5,62 @@
 #include <vector>
 #include "package/dependency_resolver.h" // For DependencyResolver member
 #include "package/tarball_handler.h" // For TarballHandler member
+#include "package/layout_planner.h"
+#include "package/resolution_manifest.h"
+#include "install/lifecycle_runner.h"
+#include "utils/ui_utils.h"
 
 namespace jpm {
 
+struct InstallOptions {
+    bool production = false;     // --production: skip devDependencies of the project
+    bool ignore_scripts = false; // --ignore-scripts: don't run preinstall/install/postinstall
+};
+
+// What an install did, printed once the spinner has stopped
+struct InstallStats {
+    LayoutStats layout;
+    LifecycleStats scripts;
+};
+
 class InstallCommand {
 public:
     InstallCommand();
-    // Takes a list of package specifications like "lodash" or "react@17.0.0"
-    void execute(const std::vector<std::string>& packages_to_install_args);
+    // Takes a list of package specifications like "lodash" or "react@17.0.0".
+    // With no specifications, installs every dependency listed in ./package.json.
+    // Returns true only if everything was resolved and installed.
+    bool execute(const std::vector<std::string>& packages_to_install_args);
+
+    // Installs an already resolved graph into node_modules_dir, e.g. a `jpm x` cache
+    // directory. Returns true only if every package was installed.
+    bool install_resolution(const ResolutionResult& result,
+                            const std::string& node_modules_dir,
+                            const InstallOptions& options);
 
 private:
     DependencyResolver resolver_;
     TarballHandler tarball_handler_;
+    LifecycleRunner lifecycle_runner_;
+
+    // Resolves ./package.json dependencies as one root set and installs the resulting graph
+    bool install_project(const InstallOptions& options, const std::string& destination_base);
+
+    // Plans a hoisted node_modules layout for the resolved graph, downloads and
+    // extracts every planned copy concurrently, then runs their lifecycle scripts.
+    // The entry point of each extracted copy is appended to manifest_entries.
+    // Returns true only if all were installed.
+    bool install_resolved_packages(const ResolutionResult& result,
+                                   const std::string& destination_base,
+                                   const InstallOptions& options,
+                                   UIUtils::ProgressSpinner& spinner,
+                                   InstallStats& stats,
+                                   std::vector<ResolutionManifest::Entry>& manifest_entries);
+
+    // Starts the automatic cache gc in the background once all install threads are done
+    static void collect_cache_garbage();
 
+    // Prints the copies-on-disk summary of a planned layout and lifecycle script timings
+    static void report_stats(const InstallStats& stats);
 };
 
 } // namespace jpm
@@ -0,0 +1,445 @@
+#include "install/lifecycle_runner.h"
+#include "parsing/json_parser.h"
+#include "utils/file_utils.h"
+#include "utils/thread_pool.h"
+#include "jpm_config.h"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+// posix_spawn can change the child's directory itself on glibc >= 2.29 and macOS;
+// elsewhere the command is wrapped in "cd <dir> && ..." and run by the shell.
+#if defined(__APPLE__) || (defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29)))
+#define JPM_HAVE_SPAWN_CHDIR 1
+#endif
+
+// pipe2() creates the output pipe close-on-exec atomically; elsewhere spawns are
+// serialized around the window between pipe() and fcntl()
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#define JPM_HAVE_PIPE2 1
+#endif
+
+namespace jpm {
+
+namespace {
+
+// npm's order; "install" defaults to "node-gyp rebuild" for packages with a binding.gyp
+const char* const kLifecycleEvents[] = {"preinstall", "install", "postinstall"};
+
+#ifndef _WIN32
+#ifndef JPM_HAVE_PIPE2
+// Held from pipe() until the write end is closed in the parent, so no script spawned
+// by another pool thread can inherit a pipe before it is marked close-on-exec
+std::mutex g_spawn_mutex;
+#endif
+
+#ifdef JPM_HAVE_SPAWN_CHDIR
+// Characters that need /bin/sh to interpret the command
+bool needs_shell(const std::string& command) {
+    return command.find_first_of("|&;<>()$`\\\"'*?[]#~=%{}!\n") != std::string::npos;
+}
+#endif
+
+std::vector<std::string> split_arguments(const std::string& command) {
+    std::vector<std::string> argv;
+    size_t pos = 0;
+    while ((pos = command.find_first_not_of(" \t", pos)) != std::string::npos) {
+        size_t end = command.find_first_of(" \t", pos);
+        argv.push_back(command.substr(pos, end == std::string::npos ? std::string::npos : end - pos));
+        pos = end;
+    }
+    return argv;
+}
+
+#ifndef JPM_HAVE_SPAWN_CHDIR
+std::string shell_quote(const std::string& text) {
+    std::string quoted = "'";
+    for (char c : text) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "'";
+}
+#endif
+
+// The package's own node_modules/.bin and every enclosing one, nearest first
+std::string bin_path_for(const std::string& directory) {
+    // Absolute: the script runs in directory, where relative entries would mean something else
+    std::string current = std::filesystem::absolute(directory).lexically_normal().string();
+    if (current.size() > 1 && current.back() == '/') {
+        current.pop_back();
+    }
+    std::string path = current + "/node_modules/.bin";
+    size_t marker;
+    while ((marker = current.rfind("/node_modules/")) != std::string::npos) {
+        current = current.substr(0, marker);
+        path += ":" + current + "/node_modules/.bin";
+    }
+    return path;
+}
+
+#ifdef JPM_HAVE_SPAWN_CHDIR
+// What execvp() would run for program under the script's own PATH, which lists the
+// package .bin directories first; posix_spawnp() would search jpm's PATH instead.
+// Relative entries and names with a slash are relative to directory, where the script
+// runs. Empty if there is no such executable.
+std::string find_program(const std::string& program, const std::string& path_value, const std::string& directory) {
+    auto is_executable = [&directory](const std::string& candidate) {
+        std::string checked = candidate[0] == '/' ? candidate : directory + "/" + candidate;
+        struct stat st {};
+        return stat(checked.c_str(), &st) == 0 && S_ISREG(st.st_mode) && access(checked.c_str(), X_OK) == 0;
+    };
+    if (program.find('/') != std::string::npos) {
+        return is_executable(program) ? program : std::string();
+    }
+    size_t start = 0;
+    while (true) {
+        size_t end = path_value.find(':', start);
+        std::string entry = path_value.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        std::string candidate = (entry.empty() ? "." : entry) + "/" + program;
+        if (is_executable(candidate)) {
+            return candidate;
+        }
+        if (end == std::string::npos) {
+            return std::string();
+        }
+        start = end + 1;
+    }
+}
+#endif
+#endif // _WIN32
+
+} // namespace
+
+double LifecycleStats::script_seconds() const {
+    double total = 0.0;
+    for (const auto& timing : scripts) {
+        total += timing.seconds;
+    }
+    return total;
+}
+
+LifecycleRunner::LifecycleRunner(size_t max_parallel)
+    : max_parallel_(max_parallel == 0 ? std::max(1u, std::thread::hardware_concurrency()) : max_parallel) {
+    if (g_verbose_output) {
+        std::cout << "LifecycleRunner initialized (" << max_parallel_ << " scripts at a time)." << std::endl;
+    }
+}
+
+std::vector<std::pair<std::string, std::string>> LifecycleRunner::read_scripts(const std::string& directory) {
+    std::vector<std::pair<std::string, std::string>> scripts;
+    std::optional<std::string> manifest_content = FileUtils::read_file(directory + "/package.json");
+    if (!manifest_content) {
+        return scripts;
+    }
+    JsonData manifest = JsonParser::try_parse(*manifest_content);
+    const JsonData empty = JsonData::object();
+    const JsonData& declared = manifest.is_object() && manifest.contains("scripts") && manifest["scripts"].is_object()
+        ? manifest["scripts"] : empty;
+
+    for (const char* event : kLifecycleEvents) {
+        if (declared.contains(event) && declared[event].is_string() && !declared[event].get<std::string>().empty()) {
+            scripts.emplace_back(event, declared[event].get<std::string>());
+        } else if (std::string(event) == "install" && !declared.contains("preinstall")
+                   && FileUtils::path_exists(directory + "/binding.gyp")) {
+            scripts.emplace_back(event, "node-gyp rebuild");
+        }
+    }
+    return scripts;
+}
+
+bool LifecycleRunner::run(const InstallLayout& layout, const DependencyEdges& edges, LifecycleStats& stats) {
+    // One node per copy on disk: native builds write into the package directory,
+    // so every copy needs its own run.
+    std::vector<ScriptNode> nodes;
+    std::map<std::string, std::vector<size_t>> copies_by_key;
+    size_t nodes_with_scripts = 0;
+    for (const auto& planned : layout.packages) {
+        ScriptNode node;
+        node.name = planned.info.name;
+        node.version = planned.info.resolved_version;
+        node.label = node.name + "@" + node.version;
+        node.directory = planned.install_path;
+        node.scripts = read_scripts(planned.install_path);
+        if (!node.scripts.empty()) ++nodes_with_scripts;
+        copies_by_key[node.label].push_back(nodes.size());
+        nodes.push_back(std::move(node));
+    }
+    if (nodes_with_scripts == 0) {
+        return true;
+    }
+
+    // A node waits for every copy of each package it depends on. Packages without
+    // scripts stay in the graph so ordering through them is kept.
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        auto edge_it = edges.find(nodes[i].label);
+        if (edge_it == edges.end()) continue;
+        for (const auto& [dep_name, dep_key] : edge_it->second) {
+            (void)dep_name;
+            auto copies_it = copies_by_key.find(dep_key);
+            if (copies_it == copies_by_key.end() || dep_key == nodes[i].label) continue;
+            for (size_t dependency : copies_it->second) {
+                nodes[dependency].dependents.push_back(i);
+                ++nodes[i].pending_dependencies;
+            }
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::mutex mutex;
+    std::mutex stats_mutex;
+    std::condition_variable finished_cv;
+    std::deque<size_t> ready;
+    std::vector<bool> started(nodes.size(), false);
+    size_t finished = 0;
+    size_t running = 0;
+    bool failed = false;
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].pending_dependencies == 0) ready.push_back(i);
+    }
+    // Called with mutex held
+    auto complete = [&](size_t i) {
+        ++finished;
+        for (size_t dependent : nodes[i].dependents) {
+            if (--nodes[dependent].pending_dependencies == 0) ready.push_back(dependent);
+        }
+    };
+
+    ThreadPool pool(max_parallel_);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (finished < nodes.size()) {
+            while (!ready.empty()) {
+                size_t i = ready.front();
+                ready.pop_front();
+                if (started[i]) continue;
+                started[i] = true;
+                if (nodes[i].scripts.empty() || failed) {
+                    complete(i);
+                    continue;
+                }
+                ++running;
+                pool.submit([&, i]() {
+                    bool ok = run_node(nodes[i], stats, stats_mutex);
+                    std::lock_guard<std::mutex> done_lock(mutex);
+                    --running;
+                    failed = failed || !ok;
+                    complete(i);
+                    finished_cv.notify_one();
+                });
+            }
+            if (finished == nodes.size()) break;
+            if (running == 0 && ready.empty()) {
+                // Everything left is part of a dependency cycle: start one of them anyway
+                for (size_t i = 0; i < nodes.size(); ++i) {
+                    if (!started[i]) {
+                        ready.push_back(i);
+                        break;
+                    }
+                }
+                continue;
+            }
+            finished_cv.wait(lock);
+        }
+    }
+
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+    stats.wall_seconds += wall.count();
+    return !failed;
+}
+
+bool LifecycleRunner::run_project(const std::string& project_dir, LifecycleStats& stats) {
+    ScriptNode node;
+    node.label = project_dir;
+    node.directory = project_dir;
+    node.scripts = read_scripts(project_dir);
+    if (node.scripts.empty()) {
+        return true;
+    }
+    if (std::optional<std::string> content = FileUtils::read_file(project_dir + "/package.json")) {
+        JsonData manifest = JsonParser::try_parse(*content);
+        if (manifest.is_object()) {
+            node.name = manifest.value("name", "");
+            node.version = manifest.value("version", "");
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::mutex stats_mutex;
+    bool ok = run_node(node, stats, stats_mutex);
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+    stats.wall_seconds += wall.count();
+    return ok;
+}
+
+bool LifecycleRunner::run_node(const ScriptNode& node, LifecycleStats& stats, std::mutex& stats_mutex) {
+    for (const auto& [event, command] : node.scripts) {
+        auto start = std::chrono::steady_clock::now();
+        bool ok = run_command(node, event, command);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            stats.scripts.push_back({node.label, event, elapsed.count(), ok});
+            if (!ok) ++stats.failures;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LifecycleRunner::run_command(const ScriptNode& node, const std::string& event, const std::string& command) {
+    if (g_verbose_output) {
+        std::cout << "[" << node.label << "] " << event << ": " << command << std::endl;
+    }
+
+#ifdef _WIN32
+    std::string full_command = "cd /d \"" + node.directory + "\" && " + command;
+    int status = std::system(full_command.c_str());
+    if (status != 0) {
+        std::cerr << node.label << " " << event << " script failed with exit code " << status << std::endl;
+        return false;
+    }
+    return true;
+#else
+    // Direct exec when the command is a plain argument list; the shell otherwise
+    std::vector<std::string> arguments;
+#ifdef JPM_HAVE_SPAWN_CHDIR
+    bool use_shell = needs_shell(command);
+    std::string shell_command = command;
+#else
+    bool use_shell = true;
+    std::string shell_command = "cd " + shell_quote(node.directory) + " && " + command;
+#endif
+    if (!use_shell) {
+        arguments = split_arguments(command);
+        if (arguments.empty()) return true;
+    } else {
+        arguments = {"/bin/sh", "-c", shell_command};
+    }
+    std::vector<char*> argv;
+    for (auto& argument : arguments) argv.push_back(argument.data());
+    argv.push_back(nullptr);
+
+    // Inherited environment plus what npm exposes to scripts
+    std::vector<std::string> environment;
+    std::string path_value = bin_path_for(node.directory);
+    for (char** entry = environ; entry && *entry; ++entry) {
+        if (std::strncmp(*entry, "PATH=", 5) == 0) {
+            path_value += ":" + std::string(*entry + 5);
+        } else if (std::strncmp(*entry, "npm_", 4) != 0) {
+            environment.push_back(*entry);
+        }
+    }
+    environment.push_back("PATH=" + path_value);
+    environment.push_back("npm_lifecycle_event=" + event);
+    environment.push_back("npm_lifecycle_script=" + command);
+    environment.push_back("npm_package_name=" + node.name);
+    environment.push_back("npm_package_version=" + node.version);
+    std::vector<char*> envp;
+    for (auto& entry : environment) envp.push_back(entry.data());
+    envp.push_back(nullptr);
+
+    // A script spawned concurrently must never inherit this write end: the read() loop
+    // below would then wait until that unrelated child exited
+    int output_pipe[2];
+#ifdef JPM_HAVE_PIPE2
+    if (pipe2(output_pipe, O_CLOEXEC) != 0) {
+#else
+    std::unique_lock<std::mutex> spawn_lock(g_spawn_mutex);
+    if (pipe(output_pipe) != 0) {
+#endif
+        std::cerr << "Cannot create pipe for " << node.label << " " << event << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+#ifndef JPM_HAVE_PIPE2
+    fcntl(output_pipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(output_pipe[1], F_SETFD, FD_CLOEXEC);
+#endif
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, output_pipe[1], 1);
+    posix_spawn_file_actions_adddup2(&actions, output_pipe[1], 2);
+#ifdef JPM_HAVE_SPAWN_CHDIR
+    posix_spawn_file_actions_addchdir_np(&actions, node.directory.c_str());
+#endif
+
+    pid_t pid = 0;
+    int spawn_error = 0;
+    if (use_shell) {
+        spawn_error = posix_spawn(&pid, "/bin/sh", &actions, nullptr, argv.data(), envp.data());
+    } else {
+#ifdef JPM_HAVE_SPAWN_CHDIR
+        std::string program = find_program(arguments[0], path_value, node.directory);
+        spawn_error = program.empty()
+            ? ENOENT
+            : posix_spawn(&pid, program.c_str(), &actions, nullptr, argv.data(), envp.data());
+#endif
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    close(output_pipe[1]);
+#ifndef JPM_HAVE_PIPE2
+    spawn_lock.unlock();
+#endif
+    if (spawn_error != 0) {
+        close(output_pipe[0]);
+        std::cerr << node.label << " " << event << ": cannot run `" << command << "`: " << strerror(spawn_error) << std::endl;
+        return false;
+    }
+
+    std::string output;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(output_pipe[0], buffer, sizeof(buffer))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        output.append(buffer, static_cast<size_t>(n));
+    }
+    close(output_pipe[0]);
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+    if (!ok || g_verbose_output) {
+        std::ostream& out = ok ? std::cout : std::cerr;
+        if (!ok) {
+            out << node.label << " " << event << " script `" << command << "` failed"
+                << (WIFEXITED(status) ? " with exit code " + std::to_string(WEXITSTATUS(status))
+                                      : std::string(" (killed by a signal)")) << std::endl;
+        }
+        if (!output.empty()) {
+            out << output << (output.back() == '\n' ? "" : "\n") << std::flush;
+        }
+    }
+    return ok;
+#endif
+}
+
+} // namespace jpm
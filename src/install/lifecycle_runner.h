@@ -0,0 +1,72 @@
+#ifndef JPM_LIFECYCLE_RUNNER_H
+#define JPM_LIFECYCLE_RUNNER_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include "package/dependency_resolver.h"
+#include "package/layout_planner.h"
+
+namespace jpm {
+
+struct ScriptTiming {
+    std::string package;   // "name@version", or the directory of the project or a workspace
+    std::string event;     // "preinstall", "install" or "postinstall"
+    double seconds = 0.0;
+    bool success = false;
+};
+
+struct LifecycleStats {
+    std::vector<ScriptTiming> scripts; // In completion order
+    double wall_seconds = 0.0;         // Time from the first script starting to the last finishing
+    size_t failures = 0;
+
+    double script_seconds() const; // Sum over all scripts; above wall_seconds when they overlapped
+};
+
+// Runs preinstall/install/postinstall scripts of installed packages. A package's
+// scripts start only after the scripts of everything it depends on have finished,
+// but packages that don't depend on each other run in parallel, up to a fixed
+// number at a time. Commands are started with posix_spawn directly when they are
+// a plain argument list, and only go through /bin/sh when they use shell syntax.
+class LifecycleRunner {
+public:
+    // max_parallel == 0 uses std::thread::hardware_concurrency()
+    explicit LifecycleRunner(size_t max_parallel = 0);
+
+    // Runs the scripts of every planned copy in topological order of edges.
+    // After a failure no new packages are started. Returns true if every script succeeded.
+    bool run(const InstallLayout& layout, const DependencyEdges& edges, LifecycleStats& stats);
+
+    // Runs the project's own scripts in project_dir, after its dependencies are installed
+    bool run_project(const std::string& project_dir, LifecycleStats& stats);
+
+private:
+    struct ScriptNode {
+        std::string label;                                       // "name@version"
+        std::string directory;                                   // Package directory, the scripts' cwd
+        std::string name;
+        std::string version;
+        std::vector<std::pair<std::string, std::string>> scripts; // event -> command, in run order
+        std::vector<size_t> dependents;
+        size_t pending_dependencies = 0;
+    };
+
+    size_t max_parallel_;
+
+    // Reads the lifecycle scripts from directory/package.json
+    static std::vector<std::pair<std::string, std::string>> read_scripts(const std::string& directory);
+
+    // Runs a node's scripts in order, stopping at the first failure
+    static bool run_node(const ScriptNode& node, LifecycleStats& stats, std::mutex& stats_mutex);
+
+    // Spawns one command and waits for it; output is captured and shown only on failure
+    // or in verbose mode
+    static bool run_command(const ScriptNode& node, const std::string& event, const std::string& command);
+};
+
+} // namespace jpm
+
+#endif // JPM_LIFECYCLE_RUNNER_H
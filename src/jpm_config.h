@@ -1,8 +1,21 @@
 #ifndef JPM_CONFIG_H
 #define JPM_CONFIG_H
 
+#include <string>
+
+// Registry used when neither --registry nor $JPM_REGISTRY is given
+#define JPM_DEFAULT_REGISTRY_URL "https://registry.npmjs.org/"
+
 // Declare a global verbosity flag
 // It will be defined in main.cpp
 extern bool g_verbose_output;
 
+// When set (--offline), nothing is fetched from the network; only the local cache is used.
+// Also defined in main.cpp
+extern bool g_offline_mode;
+
+// Base URL packuments are requested from, always ending in "/" (--registry or $JPM_REGISTRY).
+// Also defined in main.cpp
+extern std::string g_registry_url;
+
 #endif // JPM_CONFIG_H
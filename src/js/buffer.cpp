@@ -0,0 +1,638 @@
+#include "js/buffer.h"
+#include "js/module.h"
+#include "js/source_loader.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace jpm::js {
+
+namespace {
+
+constexpr size_t kPoolSize = 8 * 1024;
+
+// Per context: Buffer.prototype and the slab small buffers are cut from
+struct BufferState {
+    JSObjectRef prototype = nullptr;
+    JSObjectRef slab = nullptr; // ArrayBuffer, protected while it is the current slab
+    char* slabData = nullptr;
+    size_t slabUsed = 0;
+};
+
+BufferState state;
+
+// The characters of a JS string, released with it
+class StringChars {
+public:
+    StringChars(JSContextRef ctx, JSValueRef value) : string_(JSValueToStringCopy(ctx, value, nullptr)) {}
+    ~StringChars() {
+        if (string_) {
+            JSStringRelease(string_);
+        }
+    }
+    StringChars(const StringChars&) = delete;
+    StringChars& operator=(const StringChars&) = delete;
+
+    const uint16_t* data() const { return string_ ? JSStringGetCharactersPtr(string_) : nullptr; }
+    size_t length() const { return string_ ? JSStringGetLength(string_) : 0; }
+
+private:
+    JSStringRef string_;
+};
+
+void free_bytes(void* bytes, void*) {
+    std::free(bytes);
+}
+
+void free_string(void*, void* string) {
+    delete static_cast<std::string*>(string);
+}
+
+JSValueRef make_string(JSContextRef ctx, const std::string& text) {
+    JSStringRef str = JSStringCreateWithUTF8CString(text.c_str());
+    JSValueRef value = JSValueMakeString(ctx, str);
+    JSStringRelease(str);
+    return value;
+}
+
+void set_property(JSContextRef ctx, JSObjectRef object, const char* name, JSValueRef value,
+                  JSPropertyAttributes attributes = kJSPropertyAttributeNone) {
+    JSStringRef key = JSStringCreateWithUTF8CString(name);
+    JSObjectSetProperty(ctx, object, key, value, attributes, nullptr);
+    JSStringRelease(key);
+}
+
+JSValueRef get_property(JSContextRef ctx, JSObjectRef object, const char* name) {
+    JSStringRef key = JSStringCreateWithUTF8CString(name);
+    JSValueRef value = JSObjectGetProperty(ctx, object, key, nullptr);
+    JSStringRelease(key);
+    return value;
+}
+
+void set_function(JSContextRef ctx, JSObjectRef object, const char* name, JSObjectCallAsFunctionCallback callback) {
+    JSStringRef key = JSStringCreateWithUTF8CString(name);
+    JSObjectSetProperty(ctx, object, key, JSObjectMakeFunctionWithCallback(ctx, key, callback),
+                        kJSPropertyAttributeNone, nullptr);
+    JSStringRelease(key);
+}
+
+JSObjectRef make_named_error(JSContextRef ctx, const char* name, const std::string& message) {
+    JSValueRef argument = make_string(ctx, message);
+    JSObjectRef error = JSObjectMakeError(ctx, 1, &argument, nullptr);
+    set_property(ctx, error, "name", make_string(ctx, name), kJSPropertyAttributeDontEnum);
+    return error;
+}
+
+JSObjectRef allocation_failed(JSContextRef ctx) {
+    return make_named_error(ctx, "RangeError", "Array buffer allocation failed");
+}
+
+JSObjectRef as_buffer(JSContextRef ctx, JSObjectRef view) {
+    if (view && state.prototype) {
+        JSObjectSetPrototype(ctx, view, state.prototype);
+    }
+    return view;
+}
+
+// A Buffer over its own malloc()ed storage, which JSC frees with the ArrayBuffer
+JSObjectRef make_unpooled(JSContextRef ctx, char* bytes, size_t size) {
+    JSObjectRef arrayBuffer = JSObjectMakeArrayBufferWithBytesNoCopy(ctx, bytes, size, free_bytes, nullptr, nullptr);
+    if (!arrayBuffer) {
+        std::free(bytes);
+        return nullptr;
+    }
+    return as_buffer(ctx, JSObjectMakeTypedArrayWithArrayBuffer(ctx, kJSTypedArrayTypeUint8Array, arrayBuffer, nullptr));
+}
+
+// Zero-filled and never pooled, like Buffer.alloc()
+JSObjectRef make_zeroed_buffer(JSContextRef ctx, size_t size) {
+    char* bytes = static_cast<char*>(std::calloc(std::max<size_t>(size, 1), 1));
+    return bytes ? make_unpooled(ctx, bytes, size) : nullptr;
+}
+
+bool get_encoding(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], size_t index,
+                  TextEncoding& encoding, JSValueRef* exception) {
+    encoding = TextEncoding::Utf8;
+    if (index >= argumentCount || JSValueIsUndefined(ctx, arguments[index]) || JSValueIsNull(ctx, arguments[index])) {
+        return true;
+    }
+    JSStringRef name = JSValueToStringCopy(ctx, arguments[index], nullptr);
+    std::string text;
+    if (name) {
+        size_t bufSize = JSStringGetMaximumUTF8CStringSize(name);
+        text.resize(bufSize);
+        text.resize(JSStringGetUTF8CString(name, &text[0], bufSize) - 1);
+        JSStringRelease(name);
+    }
+    if (!parse_text_encoding(text, encoding)) {
+        *exception = make_named_error(ctx, "TypeError", "Unknown encoding: " + text);
+        return false;
+    }
+    return true;
+}
+
+size_t get_index(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], size_t index, size_t fallback) {
+    if (index >= argumentCount || !JSValueIsNumber(ctx, arguments[index])) {
+        return fallback;
+    }
+    double value = JSValueToNumber(ctx, arguments[index], nullptr);
+    return value > 0 ? static_cast<size_t>(value) : 0;
+}
+
+// Natives behind the JS half of Buffer below; it validates and normalizes arguments
+
+JSValueRef native_alloc(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t argumentCount,
+                        const JSValueRef arguments[], JSValueRef* exception) {
+    JSObjectRef buffer = make_zeroed_buffer(ctx, get_index(ctx, argumentCount, arguments, 0, 0));
+    if (!buffer) {
+        *exception = allocation_failed(ctx);
+        return JSValueMakeUndefined(ctx);
+    }
+    return buffer;
+}
+
+JSValueRef native_alloc_unsafe(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t argumentCount,
+                               const JSValueRef arguments[], JSValueRef* exception) {
+    char* data = nullptr;
+    JSObjectRef buffer = make_buffer(ctx, get_index(ctx, argumentCount, arguments, 0, 0), &data);
+    if (!buffer) {
+        *exception = allocation_failed(ctx);
+        return JSValueMakeUndefined(ctx);
+    }
+    return buffer;
+}
+
+// fromString(string, encoding): encoded straight into the new buffer's storage
+JSValueRef native_from_string(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t argumentCount,
+                              const JSValueRef arguments[], JSValueRef* exception) {
+    TextEncoding encoding;
+    if (argumentCount < 1 || !get_encoding(ctx, argumentCount, arguments, 1, encoding, exception)) {
+        return JSValueMakeUndefined(ctx);
+    }
+    StringChars text(ctx, arguments[0]);
+    const size_t bound = encoded_length(text.data(), text.length(), encoding);
+    JSObjectRef buffer = nullptr;
+    if (encoding == TextEncoding::Base64 || encoding == TextEncoding::Base64url || encoding == TextEncoding::Hex) {
+        // The length is only a bound: decode first, then size the buffer
+        std::string bytes(bound, '\0');
+        bytes.resize(encode_text(text.data(), text.length(), encoding, &bytes[0], bound));
+        buffer = make_buffer(ctx, std::move(bytes));
+    } else {
+        char* data = nullptr;
+        buffer = make_buffer(ctx, bound, &data);
+        if (buffer) {
+            encode_text(text.data(), text.length(), encoding, data, bound);
+        }
+    }
+    if (!buffer) {
+        *exception = allocation_failed(ctx);
+        return JSValueMakeUndefined(ctx);
+    }
+    return buffer;
+}
+
+JSValueRef native_byte_length(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t argumentCount,
+                              const JSValueRef arguments[], JSValueRef* exception) {
+    TextEncoding encoding;
+    if (argumentCount < 1 || !get_encoding(ctx, argumentCount, arguments, 1, encoding, exception)) {
+        return JSValueMakeUndefined(ctx);
+    }
+    StringChars text(ctx, arguments[0]);
+    return JSValueMakeNumber(ctx, static_cast<double>(encoded_length(text.data(), text.length(), encoding)));
+}
+
+// toString(buffer, encoding, start, end), start <= end <= length
+JSValueRef native_to_string(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t argumentCount,
+                            const JSValueRef arguments[], JSValueRef* exception) {
+    char* data = nullptr;
+    size_t size = 0;
+    TextEncoding encoding;
+    if (argumentCount < 1 || !get_buffer_bytes(ctx, arguments[0], data, size) ||
+        !get_encoding(ctx, argumentCount, arguments, 1, encoding, exception)) {
+        return JSValueMakeUndefined(ctx);
+    }
+    size_t end = std::min(get_index(ctx, argumentCount, arguments, 3, size), size);
+    size_t start = std::min(get_index(ctx, argumentCount, arguments, 2, 0), end);
+    return decode_text(ctx, data + start, end - start, encoding);
+}
+
+// write(buffer, string, offset, length, encoding): bytes written, whole characters only
+JSValueRef native_write(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t argumentCount,
+                        const JSValueRef arguments[], JSValueRef* exception) {
+    char* data = nullptr;
+    size_t size = 0;
+    TextEncoding encoding;
+    if (argumentCount < 2 || !get_buffer_bytes(ctx, arguments[0], data, size) ||
+        !get_encoding(ctx, argumentCount, arguments, 4, encoding, exception)) {
+        return JSValueMakeUndefined(ctx);
+    }
+    size_t offset = std::min(get_index(ctx, argumentCount, arguments, 2, 0), size);
+    size_t length = std::min(get_index(ctx, argumentCount, arguments, 3, size - offset), size - offset);
+    StringChars text(ctx, arguments[1]);
+    size_t written = encode_text(text.data(), text.length(), encoding, data + offset, length);
+    return JSValueMakeNumber(ctx, static_cast<double>(written));
+}
+
+JSValueRef native_compare(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t argumentCount,
+                          const JSValueRef arguments[], JSValueRef* exception) {
+    char* a = nullptr;
+    char* b = nullptr;
+    size_t aSize = 0;
+    size_t bSize = 0;
+    if (argumentCount < 2 || !get_buffer_bytes(ctx, arguments[0], a, aSize) ||
+        !get_buffer_bytes(ctx, arguments[1], b, bSize)) {
+        *exception = make_named_error(ctx, "TypeError", "The arguments must be instances of Buffer or Uint8Array");
+        return JSValueMakeUndefined(ctx);
+    }
+    int result = std::memcmp(a, b, std::min(aSize, bSize));
+    if (result == 0) {
+        result = aSize < bSize ? -1 : aSize > bSize ? 1 : 0;
+    }
+    return JSValueMakeNumber(ctx, result < 0 ? -1 : result > 0 ? 1 : 0);
+}
+
+// indexOf(buffer, needle, offset): needle is a byte value or a byte sequence
+JSValueRef native_index_of(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t argumentCount,
+                           const JSValueRef arguments[], JSValueRef*) {
+    char* data = nullptr;
+    size_t size = 0;
+    if (argumentCount < 2 || !get_buffer_bytes(ctx, arguments[0], data, size)) {
+        return JSValueMakeNumber(ctx, -1);
+    }
+    size_t offset = std::min(get_index(ctx, argumentCount, arguments, 2, 0), size);
+    const char* found = nullptr;
+    char* needle = nullptr;
+    size_t needleSize = 0;
+    if (JSValueIsNumber(ctx, arguments[1])) {
+        int byte = static_cast<int>(JSValueToNumber(ctx, arguments[1], nullptr)) & 0xFF;
+        found = static_cast<const char*>(std::memchr(data + offset, byte, size - offset));
+    } else if (get_buffer_bytes(ctx, arguments[1], needle, needleSize)) {
+        if (needleSize == 0) {
+            return JSValueMakeNumber(ctx, static_cast<double>(offset));
+        }
+        found = std::search(data + offset, data + size, needle, needle + needleSize);
+        if (found == data + size) {
+            found = nullptr;
+        }
+    }
+    return JSValueMakeNumber(ctx, found ? static_cast<double>(found - data) : -1.0);
+}
+
+// The JS half: argument handling and the methods that are plain typed array work.
+// `native` carries the functions above.
+constexpr const char* kBufferFactory = R"JS((function (native) {
+'use strict';
+const kMaxLength = 2 ** 32;
+
+function checkSize(size) {
+  if (typeof size !== 'number') throw new TypeError('The "size" argument must be of type number');
+  if (!(size >= 0 && size <= kMaxLength)) throw new RangeError('The value of "size" is out of range');
+  return Math.floor(size);
+}
+
+function clamp(value, fallback, length) {
+  if (value === undefined) return fallback;
+  value = Math.trunc(+value) || 0;
+  if (value < 0) value = Math.max(length + value, 0);
+  return Math.min(value, length);
+}
+
+function fillPattern(target, pattern, offset, end) {
+  if (end <= offset) return target;
+  const first = Math.min(pattern.length, end - offset);
+  target.set(first < pattern.length ? pattern.subarray(0, first) : pattern, offset);
+  let filled = first;
+  while (offset + filled < end) {
+    const count = Math.min(filled, end - offset - filled);
+    target.copyWithin(offset + filled, offset, offset + count);
+    filled += count;
+  }
+  return target;
+}
+
+class Buffer extends Uint8Array {
+  static from(value, encodingOrOffset, length) {
+    if (typeof value === 'string') return native.fromString(value, encodingOrOffset);
+    if (value instanceof ArrayBuffer) {
+      const offset = encodingOrOffset === undefined ? 0 : encodingOrOffset >>> 0;
+      if (offset > value.byteLength) throw new RangeError('"offset" is outside of buffer bounds');
+      const count = length === undefined ? value.byteLength - offset : length >>> 0;
+      if (offset + count > value.byteLength) throw new RangeError('"length" is outside of buffer bounds');
+      return new Buffer(value, offset, count);
+    }
+    if (ArrayBuffer.isView(value)) {
+      const buffer = native.allocUnsafe(value.length);
+      buffer.set(value);
+      return buffer;
+    }
+    if (value !== null && typeof value === 'object') {
+      if (value.type === 'Buffer' && Array.isArray(value.data)) return Buffer.from(value.data);
+      if (typeof value.length === 'number') {
+        const buffer = native.allocUnsafe(value.length >>> 0);
+        for (let i = 0; i < buffer.length; ++i) buffer[i] = value[i] & 255;
+        return buffer;
+      }
+      const primitive = typeof value.valueOf === 'function' ? value.valueOf() : undefined;
+      if (primitive != null && primitive !== value) return Buffer.from(primitive, encodingOrOffset, length);
+    }
+    throw new TypeError('The first argument must be of type string or an instance of Buffer, ArrayBuffer, or Array or an Array-like Object');
+  }
+
+  static alloc(size, fill, encoding) {
+    const buffer = native.alloc(checkSize(size));
+    if (fill !== undefined && fill !== 0 && buffer.length > 0) buffer.fill(fill, encoding);
+    return buffer;
+  }
+
+  static allocUnsafe(size) { return native.allocUnsafe(checkSize(size)); }
+  static allocUnsafeSlow(size) { return native.alloc(checkSize(size)); }
+
+  static byteLength(value, encoding) {
+    if (typeof value === 'string') return native.byteLength(value, encoding);
+    if (ArrayBuffer.isView(value) || value instanceof ArrayBuffer) return value.byteLength;
+    throw new TypeError('The "string" argument must be of type string or an instance of Buffer or ArrayBuffer');
+  }
+
+  static isBuffer(value) { return value instanceof Buffer; }
+
+  static isEncoding(encoding) {
+    if (typeof encoding !== 'string' || encoding.length === 0) return false;
+    try { native.byteLength('', encoding); return true; } catch (error) { return false; }
+  }
+
+  static compare(a, b) { return native.compare(a, b); }
+
+  static concat(list, totalLength) {
+    if (!Array.isArray(list)) throw new TypeError('The "list" argument must be an instance of Array');
+    if (totalLength === undefined) {
+      totalLength = 0;
+      for (const item of list) totalLength += item.length;
+    }
+    const result = native.allocUnsafe(checkSize(totalLength));
+    let position = 0;
+    for (const item of list) {
+      if (!(item instanceof Uint8Array)) throw new TypeError('The "list" argument must contain only Buffer or Uint8Array instances');
+      const count = Math.min(item.length, result.length - position);
+      if (count <= 0) break;
+      result.set(count < item.length ? item.subarray(0, count) : item, position);
+      position += count;
+    }
+    if (position < result.length) result.fill(0, position);
+    return result;
+  }
+
+  toString(encoding, start, end) {
+    // Unlike subarray(), negative positions count as 0
+    const length = this.length;
+    start = start < 0 ? 0 : clamp(start, 0, length);
+    end = end < 0 ? 0 : clamp(end, length, length);
+    if (end <= start) return '';
+    return native.toString(this, encoding, start, end);
+  }
+
+  toLocaleString(encoding, start, end) { return this.toString(encoding, start, end); }
+
+  write(string, offset, length, encoding) {
+    if (typeof string !== 'string') throw new TypeError('The "string" argument must be of type string');
+    if (typeof offset === 'string') {
+      encoding = offset;
+      offset = 0;
+      length = undefined;
+    } else if (typeof length === 'string') {
+      encoding = length;
+      length = undefined;
+    }
+    offset = offset === undefined ? 0 : offset >>> 0;
+    if (offset > this.length) throw new RangeError('The value of "offset" is out of range');
+    const remaining = this.length - offset;
+    length = length === undefined ? remaining : Math.min(length >>> 0, remaining);
+    return native.write(this, string, offset, length, encoding);
+  }
+
+  fill(value, offset, end, encoding) {
+    if (typeof offset === 'string') {
+      encoding = offset;
+      offset = undefined;
+      end = undefined;
+    } else if (typeof end === 'string') {
+      encoding = end;
+      end = undefined;
+    }
+    offset = clamp(offset, 0, this.length);
+    end = clamp(end, this.length, this.length);
+    if (typeof value === 'string') {
+      if (value.length === 0) return super.fill(0, offset, end);
+      const bytes = native.fromString(value, encoding);
+      if (bytes.length === 0) throw new TypeError('The argument "value" is invalid');
+      if (bytes.length === 1) return super.fill(bytes[0], offset, end);
+      return fillPattern(this, bytes, offset, end);
+    }
+    if (value instanceof Uint8Array) return fillPattern(this, value, offset, end);
+    return super.fill(Number(value) & 255, offset, end);
+  }
+
+  equals(other) {
+    if (!(other instanceof Uint8Array)) throw new TypeError('The "otherBuffer" argument must be an instance of Buffer or Uint8Array');
+    return native.compare(this, other) === 0;
+  }
+
+  compare(target, targetStart, targetEnd, sourceStart, sourceEnd) {
+    if (!(target instanceof Uint8Array)) throw new TypeError('The "target" argument must be an instance of Buffer or Uint8Array');
+    const a = this.subarray(clamp(sourceStart, 0, this.length), clamp(sourceEnd, this.length, this.length));
+    const b = target.subarray(clamp(targetStart, 0, target.length), clamp(targetEnd, target.length, target.length));
+    return native.compare(a, b);
+  }
+
+  copy(target, targetStart, sourceStart, sourceEnd) {
+    targetStart = clamp(targetStart, 0, target.length);
+    sourceStart = clamp(sourceStart, 0, this.length);
+    sourceEnd = clamp(sourceEnd, this.length, this.length);
+    const count = Math.min(sourceEnd - sourceStart, target.length - targetStart);
+    if (count <= 0) return 0;
+    target.set(this.subarray(sourceStart, sourceStart + count), targetStart);
+    return count;
+  }
+
+  // A view on the same memory, as in Node (Uint8Array's slice copies)
+  slice(start, end) { return this.subarray(start, end); }
+
+  indexOf(value, byteOffset, encoding) {
+    if (typeof byteOffset === 'string') {
+      encoding = byteOffset;
+      byteOffset = undefined;
+    }
+    const offset = clamp(byteOffset, 0, this.length);
+    if (typeof value === 'number') return native.indexOf(this, value, offset);
+    if (typeof value === 'string') return native.indexOf(this, native.fromString(value, encoding), offset);
+    if (value instanceof Uint8Array) return native.indexOf(this, value, offset);
+    throw new TypeError('The "value" argument must be one of type number or string or an instance of Buffer or Uint8Array');
+  }
+
+  includes(value, byteOffset, encoding) { return this.indexOf(value, byteOffset, encoding) !== -1; }
+
+  toJSON() { return { type: 'Buffer', data: Array.from(this) }; }
+}
+
+Buffer.poolSize = 8192;
+return Buffer;
+}))JS";
+
+} // namespace
+
+JSObjectRef make_buffer(JSContextRef ctx, size_t size, char** data) {
+    if (size >= kPoolSize / 2) {
+        char* bytes = static_cast<char*>(std::malloc(size));
+        if (!bytes) {
+            return nullptr;
+        }
+        *data = bytes;
+        return make_unpooled(ctx, bytes, size);
+    }
+    size_t offset = (state.slabUsed + 7) & ~size_t{7};
+    if (!state.slab || offset + size > kPoolSize) {
+        char* bytes = static_cast<char*>(std::malloc(kPoolSize));
+        if (!bytes) {
+            return nullptr;
+        }
+        JSObjectRef slab = JSObjectMakeArrayBufferWithBytesNoCopy(ctx, bytes, kPoolSize, free_bytes, nullptr, nullptr);
+        if (!slab) {
+            std::free(bytes);
+            return nullptr;
+        }
+        // The old slab stays alive as long as buffers cut from it do
+        if (state.slab) {
+            JSValueUnprotect(ctx, state.slab);
+        }
+        JSValueProtect(ctx, slab);
+        state.slab = slab;
+        state.slabData = bytes;
+        offset = 0;
+    }
+    JSObjectRef view = as_buffer(ctx, JSObjectMakeTypedArrayWithArrayBufferAndOffset(
+        ctx, kJSTypedArrayTypeUint8Array, state.slab, offset, size, nullptr));
+    if (!view) {
+        return nullptr;
+    }
+    state.slabUsed = offset + size;
+    *data = state.slabData + offset;
+    return view;
+}
+
+JSObjectRef make_buffer(JSContextRef ctx, std::string bytes) {
+    if (bytes.size() < kPoolSize / 2) {
+        // Copying into a slab is cheaper than an ArrayBuffer of its own
+        char* data = nullptr;
+        JSObjectRef buffer = make_buffer(ctx, bytes.size(), &data);
+        if (buffer) {
+            std::memcpy(data, bytes.data(), bytes.size());
+        }
+        return buffer;
+    }
+    auto* owned = new std::string(std::move(bytes));
+    JSObjectRef arrayBuffer = JSObjectMakeArrayBufferWithBytesNoCopy(ctx, owned->data(), owned->size(), free_string,
+                                                                     owned, nullptr);
+    if (!arrayBuffer) {
+        delete owned;
+        return nullptr;
+    }
+    return as_buffer(ctx, JSObjectMakeTypedArrayWithArrayBuffer(ctx, kJSTypedArrayTypeUint8Array, arrayBuffer, nullptr));
+}
+
+bool get_buffer_bytes(JSContextRef ctx, JSValueRef value, char*& data, size_t& size) {
+    JSTypedArrayType type = JSValueGetTypedArrayType(ctx, value, nullptr);
+    if (type == kJSTypedArrayTypeNone) {
+        return false;
+    }
+    JSObjectRef object = JSValueToObject(ctx, value, nullptr);
+    if (type == kJSTypedArrayTypeArrayBuffer) {
+        data = static_cast<char*>(JSObjectGetArrayBufferBytesPtr(ctx, object, nullptr));
+        size = JSObjectGetArrayBufferByteLength(ctx, object, nullptr);
+    } else {
+        // The pointer is to the start of the underlying buffer, not of the view
+        data = static_cast<char*>(JSObjectGetTypedArrayBytesPtr(ctx, object, nullptr)) +
+               JSObjectGetTypedArrayByteOffset(ctx, object, nullptr);
+        size = JSObjectGetTypedArrayByteLength(ctx, object, nullptr);
+    }
+    return true;
+}
+
+JSValueRef decode_text(JSContextRef ctx, const char* data, size_t size, TextEncoding encoding) {
+    JSStringRef string;
+    switch (encoding) {
+    case TextEncoding::Utf8:
+        string = create_string(std::string_view(data, size));
+        break;
+    case TextEncoding::Utf16le:
+    case TextEncoding::Latin1:
+    case TextEncoding::Ascii: {
+        std::vector<JSChar> units(utf16_length(size, encoding));
+        decode_to_utf16(data, size, encoding, units.data());
+        string = JSStringCreateWithCharacters(units.data(), units.size());
+        break;
+    }
+    default: {
+        std::string text(ascii_length(size, encoding), '\0');
+        encode_ascii(data, size, encoding, &text[0]);
+        string = JSStringCreateWithUTF8CString(text.c_str());
+        break;
+    }
+    }
+    JSValueRef value = JSValueMakeString(ctx, string);
+    JSStringRelease(string);
+    return value;
+}
+
+void encode_string(JSContextRef ctx, JSValueRef string, TextEncoding encoding, std::string& out) {
+    StringChars text(ctx, string);
+    const size_t start = out.size();
+    const size_t bound = encoded_length(text.data(), text.length(), encoding);
+    out.resize(start + bound);
+    out.resize(start + encode_text(text.data(), text.length(), encoding, &out[start], bound));
+}
+
+void setup_buffer(JSContextRef ctx, JSObjectRef globalObject) {
+    if (state.prototype) {
+        JSValueUnprotect(ctx, state.prototype);
+    }
+    if (state.slab) {
+        JSValueUnprotect(ctx, state.slab);
+    }
+    state = BufferState();
+
+    JSObjectRef natives = JSObjectMake(ctx, nullptr, nullptr);
+    set_function(ctx, natives, "alloc", native_alloc);
+    set_function(ctx, natives, "allocUnsafe", native_alloc_unsafe);
+    set_function(ctx, natives, "fromString", native_from_string);
+    set_function(ctx, natives, "byteLength", native_byte_length);
+    set_function(ctx, natives, "toString", native_to_string);
+    set_function(ctx, natives, "write", native_write);
+    set_function(ctx, natives, "compare", native_compare);
+    set_function(ctx, natives, "indexOf", native_index_of);
+
+    JSStringRef factorySource = JSStringCreateWithUTF8CString(kBufferFactory);
+    JSValueRef factory = JSEvaluateScript(ctx, factorySource, nullptr, nullptr, 1, nullptr);
+    JSStringRelease(factorySource);
+    if (!factory || !JSValueIsObject(ctx, factory)) {
+        return;
+    }
+    JSValueRef argument = natives;
+    JSValueRef bufferClass = JSObjectCallAsFunction(ctx, JSValueToObject(ctx, factory, nullptr), nullptr, 1, &argument, nullptr);
+    if (!bufferClass || !JSValueIsObject(ctx, bufferClass)) {
+        return;
+    }
+    JSObjectRef constructor = JSValueToObject(ctx, bufferClass, nullptr);
+    JSValueRef prototype = get_property(ctx, constructor, "prototype");
+    if (JSValueIsObject(ctx, prototype)) {
+        state.prototype = JSValueToObject(ctx, prototype, nullptr);
+        JSValueProtect(ctx, state.prototype);
+    }
+    set_property(ctx, globalObject, "Buffer", constructor, kJSPropertyAttributeDontEnum);
+
+    JSObjectRef bufferModule = JSObjectMake(ctx, nullptr, nullptr);
+    set_property(ctx, bufferModule, "Buffer", constructor);
+    set_property(ctx, bufferModule, "kMaxLength", JSValueMakeNumber(ctx, 4294967296.0));
+    ModuleSystem::getInstance().registerBuiltinModule("buffer", bufferModule);
+}
+
+} // namespace jpm::js
@@ -0,0 +1,41 @@
+#ifndef JPM_BUFFER_H
+#define JPM_BUFFER_H
+
+#include <JavaScriptCore/JavaScript.h>
+#include <cstddef>
+#include <string>
+#include "js/text_codec.h"
+
+namespace jpm::js {
+
+// Installs Node's Buffer as a global and as the built-in "buffer" module. A Buffer
+// is a Uint8Array with Buffer.prototype, and jpm allocates its storage and wraps
+// it with JSObjectMakeArrayBufferWithBytesNoCopy:
+// - buffers under 4 KB are cut from shared 8 KB slabs (Buffer.poolSize), as in Node;
+// - larger ones get their own allocation, and native results such as a file's
+//   contents become a Buffer without being copied.
+// Natives fill buffers in place (make_buffer()) and read any typed array without
+// converting it to a string (get_buffer_bytes()).
+void setup_buffer(JSContextRef ctx, JSObjectRef globalObject);
+
+// A Buffer of size bytes for native code to fill through *data; contents undefined.
+// nullptr if the memory cannot be allocated.
+JSObjectRef make_buffer(JSContextRef ctx, size_t size, char** data);
+
+// A Buffer holding bytes. Large inputs are adopted, not copied.
+JSObjectRef make_buffer(JSContextRef ctx, std::string bytes);
+
+// The bytes of a Buffer, other typed array, DataView or ArrayBuffer; false for any
+// other value. Taking the pointer pins the storage, so it stays valid for as long
+// as the object is alive.
+bool get_buffer_bytes(JSContextRef ctx, JSValueRef value, char*& data, size_t& size);
+
+// size bytes decoded as a JS string, like buf.toString(encoding)
+JSValueRef decode_text(JSContextRef ctx, const char* data, size_t size, TextEncoding encoding);
+
+// Appends string's bytes in encoding to out, like Buffer.from(string, encoding)
+void encode_string(JSContextRef ctx, JSValueRef string, TextEncoding encoding, std::string& out);
+
+} // namespace jpm::js
+
+#endif // JPM_BUFFER_H
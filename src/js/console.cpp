@@ -0,0 +1,662 @@
+#include "js/console.h"
+#include "js/buffer.h"
+#include "js/output_stream.h"
+#include "js/text_codec.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace jpm::js {
+
+namespace {
+
+constexpr size_t kMaxDepth = 2;
+constexpr size_t kMaxArrayItems = 100;
+constexpr size_t kMaxBufferBytes = 50;
+constexpr size_t kBreakLength = 80;
+// A line buffer one huge message grew past this is given back afterwards
+constexpr size_t kMaxRetained = 1024 * 1024;
+
+// Per context: the built-ins the formatter recognizes objects by
+struct ConsoleState {
+    JSGlobalContextRef context = nullptr;
+    JSObjectRef string = nullptr; // String(), for symbols and BigInts
+    JSObjectRef error = nullptr;
+    JSObjectRef regExp = nullptr;
+    JSObjectRef map = nullptr;
+    JSObjectRef set = nullptr;
+    JSObjectRef arrayFrom = nullptr; // Lists a Map's or Set's contents
+};
+
+ConsoleState state;
+
+// Each console call formats into this buffer, which keeps its capacity between calls
+thread_local std::string line_buffer;
+thread_local bool formatting = false;
+
+JSValueRef get_property(JSContextRef ctx, JSObjectRef object, const char* name) {
+    JSStringRef key = JSStringCreateWithUTF8CString(name);
+    JSValueRef value = JSObjectGetProperty(ctx, object, key, nullptr);
+    JSStringRelease(key);
+    return value;
+}
+
+JSObjectRef get_object(JSContextRef ctx, JSObjectRef object, const char* name) {
+    JSValueRef value = get_property(ctx, object, name);
+    return value && JSValueIsObject(ctx, value) ? JSValueToObject(ctx, value, nullptr) : nullptr;
+}
+
+void set_function(JSContextRef ctx, JSObjectRef object, const char* name, JSObjectCallAsFunctionCallback callback) {
+    JSStringRef key = JSStringCreateWithUTF8CString(name);
+    JSObjectSetProperty(ctx, object, key, JSObjectMakeFunctionWithCallback(ctx, key, callback),
+                        kJSPropertyAttributeNone, nullptr);
+    JSStringRelease(key);
+}
+
+// Transcodes straight from the string's UTF-16 into out
+void append_js_string(JSStringRef string, std::string& out) {
+    const size_t length = JSStringGetLength(string);
+    const size_t start = out.size();
+    out.resize(start + length * 3);
+    const uint16_t* text = reinterpret_cast<const uint16_t*>(JSStringGetCharactersPtr(string));
+    out.resize(start + encode_text(text, length, TextEncoding::Utf8, &out[start], length * 3));
+}
+
+bool append_string_value(JSContextRef ctx, JSValueRef value, std::string& out) {
+    JSStringRef string = value ? JSValueToStringCopy(ctx, value, nullptr) : nullptr;
+    if (!string) {
+        return false;
+    }
+    append_js_string(string, out);
+    JSStringRelease(string);
+    return true;
+}
+
+std::string string_property(JSContextRef ctx, JSObjectRef object, const char* name) {
+    std::string text;
+    JSValueRef value = get_property(ctx, object, name);
+    if (value && JSValueIsString(ctx, value)) {
+        append_string_value(ctx, value, text);
+    }
+    return text;
+}
+
+void append_number(double number, std::string& out) {
+    if (number == 0) {
+        out += std::signbit(number) ? "-0" : "0";
+        return;
+    }
+    char digits[32];
+    if (std::abs(number) < 1e15 && number == std::trunc(number)) {
+        out.append(digits, static_cast<size_t>(std::snprintf(digits, sizeof(digits), "%lld", static_cast<long long>(number))));
+    } else if (std::isnan(number)) {
+        out += "NaN";
+    } else if (std::isinf(number)) {
+        out += number > 0 ? "Infinity" : "-Infinity";
+    } else {
+        // %.17g round-trips but is not always the shortest form; JS's own conversion is
+        JSContextRef ctx = state.context;
+        if (!ctx || !append_string_value(ctx, JSValueMakeNumber(ctx, number), out)) {
+            out.append(digits, static_cast<size_t>(std::snprintf(digits, sizeof(digits), "%.17g", number)));
+        }
+    }
+}
+
+// As Node quotes strings: single quotes unless the text has them, then double
+// quotes, then backticks; control characters are escaped
+void append_quoted(const std::string& text, std::string& out) {
+    char quote = '\'';
+    if (text.find('\'') != std::string::npos) {
+        quote = text.find('"') == std::string::npos ? '"' : text.find('`') == std::string::npos ? '`' : '\'';
+    }
+    out += quote;
+    for (char c : text) {
+        switch (c) {
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        case '\r': out += "\\r"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\v': out += "\\v"; break;
+        case '\\': out += "\\\\"; break;
+        default:
+            if (c == quote) {
+                out += '\\';
+                out += c;
+            } else if (static_cast<unsigned char>(c) < 0x20 || c == 0x7F) {
+                char escape[8];
+                out.append(escape, static_cast<size_t>(std::snprintf(escape, sizeof(escape), "\\x%02X", static_cast<unsigned char>(c))));
+            } else {
+                out += c;
+            }
+        }
+    }
+    out += quote;
+}
+
+bool is_identifier(const std::string& key) {
+    if (key.empty() || std::isdigit(static_cast<unsigned char>(key[0]))) {
+        return false;
+    }
+    return std::all_of(key.begin(), key.end(), [](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+    });
+}
+
+// util.inspect() over the JSC C API. Output is appended to out as it is produced;
+// an object's entries are laid out on one line first and moved onto lines of
+// their own when that line gets too long or an entry spans several lines.
+class Formatter {
+public:
+    Formatter(JSContextRef ctx, std::string& out, size_t maxDepth = kMaxDepth)
+        : ctx_(ctx), out_(out), max_depth_(maxDepth) {}
+
+    void inspect(JSValueRef value, size_t level) {
+        switch (JSValueGetType(ctx_, value)) {
+        case kJSTypeUndefined:
+            out_ += "undefined";
+            break;
+        case kJSTypeNull:
+            out_ += "null";
+            break;
+        case kJSTypeBoolean:
+            out_ += JSValueToBoolean(ctx_, value) ? "true" : "false";
+            break;
+        case kJSTypeNumber:
+            append_number(JSValueToNumber(ctx_, value, nullptr), out_);
+            break;
+        case kJSTypeString: {
+            std::string text;
+            append_string_value(ctx_, value, text);
+            append_quoted(text, out_);
+            break;
+        }
+        case kJSTypeObject:
+            inspect_object(JSValueToObject(ctx_, value, nullptr), level);
+            break;
+        case kJSTypeSymbol:
+            append_converted(value);
+            break;
+        default:
+            append_converted(value); // BigInt
+            out_ += 'n';
+            break;
+        }
+    }
+
+private:
+    struct Seen {
+        JSObjectRef object;
+        int ref; // Its <ref *n> number once something points back at it, else 0
+    };
+
+    // String(value), which works for symbols where JSValueToStringCopy throws
+    void append_converted(JSValueRef value) {
+        if (!state.string) {
+            return;
+        }
+        JSValueRef string = JSObjectCallAsFunction(ctx_, state.string, nullptr, 1, &value, nullptr);
+        append_string_value(ctx_, string, out_);
+    }
+
+    bool is_instance(JSObjectRef object, JSObjectRef constructor) {
+        return constructor && JSValueIsInstanceOfConstructor(ctx_, object, constructor, nullptr);
+    }
+
+    // "" for an object without a prototype
+    std::string constructor_name(JSObjectRef object) {
+        if (JSValueIsNull(ctx_, JSObjectGetPrototype(ctx_, object))) {
+            return std::string();
+        }
+        JSObjectRef constructor = get_object(ctx_, object, "constructor");
+        std::string name = constructor ? string_property(ctx_, constructor, "name") : std::string();
+        return name.empty() ? "Object" : name;
+    }
+
+    std::string prefix(const std::string& name, const char* plain) {
+        if (name.empty()) {
+            return std::string("[") + plain + ": null prototype] ";
+        }
+        return name == plain ? std::string() : name + " ";
+    }
+
+    void inspect_object(JSObjectRef object, size_t level) {
+        for (Seen& seen : seen_) {
+            if (seen.object == object) {
+                if (seen.ref == 0) {
+                    seen.ref = next_ref_++;
+                }
+                out_ += "[Circular *" + std::to_string(seen.ref) + "]";
+                return;
+            }
+        }
+        if (JSObjectIsFunction(ctx_, object)) {
+            std::string name = string_property(ctx_, object, "name");
+            out_ += name.empty() ? "[Function (anonymous)]" : "[Function: " + name + "]";
+            return;
+        }
+        if (is_instance(object, state.error)) {
+            inspect_error(object, level);
+            return;
+        }
+        const bool isArray = JSValueIsArray(ctx_, object);
+        const JSTypedArrayType arrayType = JSValueGetTypedArrayType(ctx_, object, nullptr);
+        const std::string name = constructor_name(object);
+        if (level > max_depth_) {
+            out_ += "[" + (isArray ? std::string("Array") : name.empty() ? std::string("Object") : name) + "]";
+            return;
+        }
+        if (JSValueIsDate(ctx_, object)) {
+            inspect_date(object);
+            return;
+        }
+        if (is_instance(object, state.regExp)) {
+            append_string_value(ctx_, object, out_);
+            return;
+        }
+        if (arrayType == kJSTypedArrayTypeUint8Array && name == "Buffer") {
+            inspect_buffer(object);
+            return;
+        }
+
+        const size_t start = out_.size();
+        seen_.push_back({object, 0});
+        if (isArray) {
+            inspect_array(object, name, level);
+        } else if (arrayType == kJSTypedArrayTypeArrayBuffer) {
+            out_ += "ArrayBuffer { byteLength: ";
+            append_number(static_cast<double>(JSObjectGetArrayBufferByteLength(ctx_, object, nullptr)), out_);
+            out_ += " }";
+        } else if (arrayType != kJSTypedArrayTypeNone) {
+            inspect_typed_array(object, name, level);
+        } else if (is_instance(object, state.map)) {
+            inspect_collection(object, name, true, level);
+        } else if (is_instance(object, state.set)) {
+            inspect_collection(object, name, false, level);
+        } else {
+            inspect_properties(object, name, level);
+        }
+        const int ref = seen_.back().ref;
+        seen_.pop_back();
+        if (ref != 0) {
+            out_.insert(start, "<ref *" + std::to_string(ref) + "> ");
+        }
+    }
+
+    // Starts an entry: a space after the opening bracket, then ", " between entries
+    void next_entry(std::vector<size_t>& entries) {
+        out_ += entries.empty() ? " " : ", ";
+        entries.push_back(out_.size());
+    }
+
+    // Closes the entries started at body (the opening bracket), moving them onto
+    // lines of their own, indented for level, when they do not fit on one
+    void close_entries(size_t start, size_t body, const std::vector<size_t>& entries, const char* close, size_t level) {
+        if (entries.empty()) {
+            out_ += close;
+            return;
+        }
+        const bool multiline = out_.size() - start + 2 + 2 * level > kBreakLength ||
+                               std::memchr(out_.data() + body, '\n', out_.size() - body) != nullptr;
+        if (!multiline) {
+            out_ += ' ';
+            out_ += close;
+            return;
+        }
+        std::vector<std::string> parts;
+        parts.reserve(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const size_t end = i + 1 < entries.size() ? entries[i + 1] - 2 : out_.size();
+            parts.push_back(out_.substr(entries[i], end - entries[i]));
+        }
+        out_.resize(body + 1); // Keeps the opening bracket
+        const std::string indent(2 * (level + 1), ' ');
+        for (size_t i = 0; i < parts.size(); ++i) {
+            out_ += '\n';
+            out_ += indent;
+            out_ += parts[i];
+            if (i + 1 < parts.size()) {
+                out_ += ',';
+            }
+        }
+        out_ += '\n';
+        out_.append(2 * level, ' ');
+        out_ += close;
+    }
+
+    void append_more_items(std::vector<size_t>& entries, size_t hidden) {
+        if (hidden > 0) {
+            next_entry(entries);
+            out_ += "... " + std::to_string(hidden) + (hidden == 1 ? " more item" : " more items");
+        }
+    }
+
+    size_t length_of(JSObjectRef object, const char* property) {
+        double length = JSValueToNumber(ctx_, get_property(ctx_, object, property), nullptr);
+        return length > 0 ? static_cast<size_t>(length) : 0;
+    }
+
+    void inspect_array(JSObjectRef object, const std::string& name, size_t level) {
+        const size_t start = out_.size();
+        const size_t length = length_of(object, "length");
+        if (name != "Array") {
+            out_ += name.empty() ? "[Array(" : name + "(";
+            out_ += std::to_string(length) + (name.empty() ? "): null prototype] " : ") ");
+        }
+        const size_t body = out_.size();
+        out_ += '[';
+        std::vector<size_t> entries;
+        const size_t shown = std::min(length, kMaxArrayItems);
+        for (size_t i = 0; i < shown; ++i) {
+            next_entry(entries);
+            inspect(JSObjectGetPropertyAtIndex(ctx_, object, static_cast<unsigned>(i), nullptr), level + 1);
+        }
+        append_more_items(entries, length - shown);
+        close_entries(start, body, entries, "]", level);
+    }
+
+    void inspect_typed_array(JSObjectRef object, const std::string& name, size_t level) {
+        const size_t start = out_.size();
+        const size_t length = JSObjectGetTypedArrayLength(ctx_, object, nullptr);
+        out_ += name + "(" + std::to_string(length) + ") ";
+        const size_t body = out_.size();
+        out_ += '[';
+        std::vector<size_t> entries;
+        const size_t shown = std::min(length, kMaxArrayItems);
+        for (size_t i = 0; i < shown; ++i) {
+            next_entry(entries);
+            inspect(JSObjectGetPropertyAtIndex(ctx_, object, static_cast<unsigned>(i), nullptr), level + 1);
+        }
+        append_more_items(entries, length - shown);
+        close_entries(start, body, entries, "]", level);
+    }
+
+    void inspect_buffer(JSObjectRef object) {
+        char* data = nullptr;
+        size_t size = 0;
+        get_buffer_bytes(ctx_, object, data, size);
+        static constexpr char kHex[] = "0123456789abcdef";
+        out_ += "<Buffer";
+        const size_t shown = std::min(size, kMaxBufferBytes);
+        for (size_t i = 0; i < shown; ++i) {
+            const unsigned char byte = static_cast<unsigned char>(data[i]);
+            out_ += ' ';
+            out_ += kHex[byte >> 4];
+            out_ += kHex[byte & 0x0F];
+        }
+        if (size > shown) {
+            out_ += " ... " + std::to_string(size - shown) + " more byte" + (size - shown == 1 ? "" : "s");
+        }
+        out_ += size == 0 ? " >" : ">";
+    }
+
+    void inspect_collection(JSObjectRef object, const std::string& name, bool isMap, size_t level) {
+        const size_t start = out_.size();
+        const size_t size = length_of(object, "size");
+        out_ += (name.empty() ? std::string(isMap ? "Map" : "Set") : name) + "(" + std::to_string(size) + ") ";
+        const size_t body = out_.size();
+        out_ += '{';
+        std::vector<size_t> entries;
+        JSValueRef argument = object;
+        JSValueRef list = state.arrayFrom ? JSObjectCallAsFunction(ctx_, state.arrayFrom, nullptr, 1, &argument, nullptr) : nullptr;
+        if (list && JSValueIsObject(ctx_, list)) {
+            JSObjectRef items = JSValueToObject(ctx_, list, nullptr);
+            const size_t count = length_of(items, "length");
+            const size_t shown = std::min(count, kMaxArrayItems);
+            for (size_t i = 0; i < shown; ++i) {
+                JSValueRef item = JSObjectGetPropertyAtIndex(ctx_, items, static_cast<unsigned>(i), nullptr);
+                next_entry(entries);
+                if (isMap && JSValueIsObject(ctx_, item)) {
+                    JSObjectRef pair = JSValueToObject(ctx_, item, nullptr);
+                    inspect(JSObjectGetPropertyAtIndex(ctx_, pair, 0, nullptr), level + 1);
+                    out_ += " => ";
+                    inspect(JSObjectGetPropertyAtIndex(ctx_, pair, 1, nullptr), level + 1);
+                } else {
+                    inspect(item, level + 1);
+                }
+            }
+            append_more_items(entries, count - shown);
+        }
+        close_entries(start, body, entries, "}", level);
+    }
+
+    void inspect_properties(JSObjectRef object, const std::string& name, size_t level) {
+        const size_t start = out_.size();
+        out_ += prefix(name, "Object");
+        const size_t body = out_.size();
+        out_ += '{';
+        std::vector<size_t> entries;
+        JSPropertyNameArrayRef names = JSObjectCopyPropertyNames(ctx_, object);
+        const size_t count = JSPropertyNameArrayGetCount(names);
+        std::string key;
+        for (size_t i = 0; i < count; ++i) {
+            JSStringRef keyString = JSPropertyNameArrayGetNameAtIndex(names, i);
+            key.clear();
+            append_js_string(keyString, key);
+            next_entry(entries);
+            if (is_identifier(key)) {
+                out_ += key;
+            } else {
+                append_quoted(key, out_);
+            }
+            out_ += ": ";
+            inspect(JSObjectGetProperty(ctx_, object, keyString, nullptr), level + 1);
+        }
+        JSPropertyNameArrayRelease(names);
+        close_entries(start, body, entries, "}", level);
+    }
+
+    void inspect_date(JSObjectRef date) {
+        JSObjectRef toISOString = get_object(ctx_, date, "toISOString");
+        JSValueRef exception = nullptr;
+        JSValueRef text = toISOString ? JSObjectCallAsFunction(ctx_, toISOString, date, 0, nullptr, &exception) : nullptr;
+        if (exception || !text) {
+            out_ += "Invalid Date";
+            return;
+        }
+        append_string_value(ctx_, text, out_);
+    }
+
+    // "Name: message" and the stack, one "at" line per frame; nested errors print
+    // in brackets without the stack
+    void inspect_error(JSObjectRef error, size_t level) {
+        std::string summary;
+        append_string_value(ctx_, error, summary);
+        if (level > 0) {
+            out_ += "[" + summary + "]";
+            return;
+        }
+        out_ += summary;
+        const std::string stack = string_property(ctx_, error, "stack");
+        size_t begin = 0;
+        while (begin < stack.size()) {
+            size_t end = stack.find('\n', begin);
+            if (end == std::string::npos) {
+                end = stack.size();
+            }
+            if (end > begin) {
+                out_ += "\n    at ";
+                out_.append(stack, begin, end - begin);
+            }
+            begin = end + 1;
+        }
+    }
+
+    JSContextRef ctx_;
+    std::string& out_;
+    const size_t max_depth_;
+    std::vector<Seen> seen_;
+    int next_ref_ = 1;
+};
+
+// Expands %s %d %i %f %j %o %O %c and %% in format; returns how many of the
+// arguments after it were used
+size_t apply_format(JSContextRef ctx, const std::string& format, size_t argumentCount, const JSValueRef arguments[],
+                    Formatter& formatter, std::string& out) {
+    size_t used = 0;
+    for (size_t i = 0; i < format.size(); ++i) {
+        const char c = format[i];
+        if (c != '%' || i + 1 == format.size()) {
+            out += c;
+            continue;
+        }
+        const char spec = format[i + 1];
+        if (spec == '%') {
+            out += '%';
+            ++i;
+            continue;
+        }
+        if (used >= argumentCount || !std::strchr("sdifjoOc", spec)) {
+            out += c;
+            continue;
+        }
+        JSValueRef argument = arguments[used++];
+        ++i;
+        switch (spec) {
+        case 's':
+            if (JSValueIsString(ctx, argument)) {
+                append_string_value(ctx, argument, out);
+            } else {
+                Formatter(ctx, out, 0).inspect(argument, 0); // Nested objects collapse, as in Node
+            }
+            break;
+        case 'd':
+        case 'i':
+        case 'f': {
+            double number = JSValueIsObject(ctx, argument) ? std::nan("") : JSValueToNumber(ctx, argument, nullptr);
+            append_number(spec == 'i' ? std::trunc(number) : number, out);
+            break;
+        }
+        case 'j': {
+            JSValueRef exception = nullptr;
+            JSStringRef json = JSValueCreateJSONString(ctx, argument, 0, &exception);
+            if (json) {
+                append_js_string(json, out);
+                JSStringRelease(json);
+            } else {
+                out += exception ? "[Circular]" : "undefined";
+            }
+            break;
+        }
+        case 'o':
+        case 'O':
+            formatter.inspect(argument, 0);
+            break;
+        default: // %c: CSS, which a terminal ignores
+            break;
+        }
+    }
+    return used;
+}
+
+void format_arguments(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], std::string& out) {
+    Formatter formatter(ctx, out);
+    size_t next = 0;
+    if (argumentCount > 0 && JSValueIsString(ctx, arguments[0])) {
+        const size_t start = out.size();
+        append_string_value(ctx, arguments[0], out);
+        next = 1;
+        if (std::memchr(out.data() + start, '%', out.size() - start)) {
+            const std::string format = out.substr(start);
+            out.resize(start);
+            next += apply_format(ctx, format, argumentCount - 1, arguments + 1, formatter, out);
+        }
+    }
+    for (; next < argumentCount; ++next) {
+        if (next > 0) {
+            out += ' ';
+        }
+        if (JSValueIsString(ctx, arguments[next])) {
+            append_string_value(ctx, arguments[next], out);
+        } else {
+            formatter.inspect(arguments[next], 0);
+        }
+    }
+}
+
+// Formats a call into the thread's line buffer and writes it to stream in one
+// piece. A getter or toString() that logs while its owner is being formatted gets
+// a buffer of its own.
+template <typename Format>
+void print(OutputStream& stream, Format format) {
+    std::string nested;
+    const bool outermost = !formatting;
+    std::string& line = outermost ? line_buffer : nested;
+    formatting = true;
+    line.clear();
+    format(line);
+    line += '\n';
+    formatting = !outermost;
+    stream.write(line.data(), line.size());
+    if (line.capacity() > kMaxRetained) {
+        std::string().swap(line);
+    }
+}
+
+template <bool ToStderr>
+JSValueRef console_print(JSContextRef ctx, JSObjectRef, JSObjectRef,
+                         size_t argumentCount, const JSValueRef arguments[], JSValueRef*) {
+    print(ToStderr ? OutputStream::for_stderr() : OutputStream::for_stdout(),
+          [&](std::string& line) { format_arguments(ctx, argumentCount, arguments, line); });
+    return JSValueMakeUndefined(ctx);
+}
+
+JSValueRef console_dir(JSContextRef ctx, JSObjectRef, JSObjectRef,
+                       size_t argumentCount, const JSValueRef arguments[], JSValueRef*) {
+    print(OutputStream::for_stdout(), [&](std::string& line) {
+        inspect_value(ctx, argumentCount > 0 ? arguments[0] : JSValueMakeUndefined(ctx), line);
+    });
+    return JSValueMakeUndefined(ctx);
+}
+
+JSObjectRef protect(JSContextRef ctx, JSObjectRef object) {
+    if (object) {
+        JSValueProtect(ctx, object);
+    }
+    return object;
+}
+
+void unprotect(JSObjectRef object) {
+    if (object) {
+        JSValueUnprotect(state.context, object);
+    }
+}
+
+} // namespace
+
+void inspect_value(JSContextRef ctx, JSValueRef value, std::string& out) {
+    Formatter(ctx, out).inspect(value, 0);
+}
+
+void setup_console(JSContextRef ctx, JSObjectRef globalObject) {
+    for (JSObjectRef object : {state.string, state.error, state.regExp, state.map, state.set, state.arrayFrom}) {
+        unprotect(object);
+    }
+    state = ConsoleState();
+    state.context = JSContextGetGlobalContext(ctx);
+    state.string = protect(ctx, get_object(ctx, globalObject, "String"));
+    state.error = protect(ctx, get_object(ctx, globalObject, "Error"));
+    state.regExp = protect(ctx, get_object(ctx, globalObject, "RegExp"));
+    state.map = protect(ctx, get_object(ctx, globalObject, "Map"));
+    state.set = protect(ctx, get_object(ctx, globalObject, "Set"));
+    if (JSObjectRef array = get_object(ctx, globalObject, "Array")) {
+        state.arrayFrom = protect(ctx, get_object(ctx, array, "from"));
+    }
+
+    JSObjectRef console = JSObjectMake(ctx, nullptr, nullptr);
+    set_function(ctx, console, "log", console_print<false>);
+    set_function(ctx, console, "info", console_print<false>);
+    set_function(ctx, console, "debug", console_print<false>);
+    set_function(ctx, console, "warn", console_print<true>);
+    set_function(ctx, console, "error", console_print<true>);
+    set_function(ctx, console, "dir", console_dir);
+
+    JSStringRef name = JSStringCreateWithUTF8CString("console");
+    JSObjectSetProperty(ctx, globalObject, name, console, kJSPropertyAttributeDontEnum, nullptr);
+    JSStringRelease(name);
+}
+
+} // namespace jpm::js
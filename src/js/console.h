@@ -0,0 +1,26 @@
+#ifndef JPM_CONSOLE_H
+#define JPM_CONSOLE_H
+
+#include <JavaScriptCore/JavaScript.h>
+#include <string>
+
+namespace jpm::js {
+
+// Installs the global console: log, info and debug write to process.stdout's
+// OutputStream, warn and error to stderr's, and dir inspects its argument. A call's
+// arguments are formatted natively into a thread-local buffer that is reused from
+// call to call, then written as one chunk.
+//
+// Formatting follows Node: a leading format string takes %s %d %i %f %j %o %O %c;
+// strings print as they are and everything else as inspect_value() shows it.
+void setup_console(JSContextRef ctx, JSObjectRef globalObject);
+
+// Appends value as util.inspect() shows it, with Node's defaults: objects nested
+// more than 2 levels deep print as [Object], arrays show their first 100 items and
+// Buffers their first 50 bytes, and a reference back to an object being printed
+// shows as [Circular *n], with <ref *n> marking the object.
+void inspect_value(JSContextRef ctx, JSValueRef value, std::string& out);
+
+} // namespace jpm::js
+
+#endif // JPM_CONSOLE_H
@@ -0,0 +1,204 @@
+#include "js/event_loop.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace jpm::js {
+
+namespace {
+
+bool make_pipe(int fds[2]) {
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    for (int i = 0; i < 2; ++i) {
+        fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+    }
+    return true;
+}
+
+} // namespace
+
+EventLoop::EventLoop() {
+    int fds[2];
+    if (make_pipe(fds)) {
+        wake_read_ = fds[0];
+        wake_write_ = fds[1];
+    } else {
+        std::cerr << "Warning: could not create the event loop wakeup pipe; posted work is only noticed on timers" << std::endl;
+    }
+}
+
+EventLoop::~EventLoop() {
+    if (wake_read_ >= 0) {
+        close(wake_read_);
+        close(wake_write_);
+    }
+}
+
+uint64_t EventLoop::now_ms() const {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - epoch_).count());
+}
+
+uint64_t EventLoop::add_timer(std::chrono::milliseconds delay, std::chrono::milliseconds repeat, Callback callback) {
+    return timers_.schedule(now_ms() + static_cast<uint64_t>(delay.count()), static_cast<uint64_t>(repeat.count()),
+                            std::move(callback));
+}
+
+bool EventLoop::cancel_timer(uint64_t id) {
+    return timers_.cancel(id);
+}
+
+uint64_t EventLoop::add_immediate(Callback callback) {
+    uint64_t id = next_id_++;
+    immediates_.push_back({id, std::move(callback)});
+    pending_immediates_.insert(id);
+    return id;
+}
+
+bool EventLoop::cancel_immediate(uint64_t id) {
+    return pending_immediates_.erase(id) != 0;
+}
+
+void EventLoop::next_tick(Callback callback) {
+    ticks_.push_back(std::move(callback));
+}
+
+void EventLoop::post(Callback callback) {
+    bool was_empty;
+    {
+        std::lock_guard<std::mutex> lock(posted_mutex_);
+        was_empty = posted_.empty();
+        posted_.push_back(std::move(callback));
+    }
+    // One byte per batch: the loop takes everything queued when it wakes
+    if (was_empty && wake_write_ >= 0) {
+        char byte = 1;
+        ssize_t written = write(wake_write_, &byte, 1);
+        (void)written; // A full pipe already wakes the loop
+    }
+}
+
+bool EventLoop::alive() const {
+    if (timers_.size() > 0 || !pending_immediates_.empty() || !ticks_.empty() || refs_ > 0) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(posted_mutex_);
+    return !posted_.empty();
+}
+
+void EventLoop::run() {
+    stopped_ = false;
+    run_ticks();
+    while (!stopped_ && alive()) {
+        run_timers();
+        if (stopped_ || !alive()) {
+            break; // The last timer may have been all that was left
+        }
+        wait(pending_immediates_.empty() ? poll_timeout() : 0);
+        run_posted();
+        if (stopped_) {
+            break;
+        }
+        run_immediates();
+    }
+}
+
+void EventLoop::clear() {
+    timers_.clear();
+    immediates_.clear();
+    pending_immediates_.clear();
+    ticks_.clear();
+    refs_ = 0;
+    std::lock_guard<std::mutex> lock(posted_mutex_);
+    posted_.clear();
+}
+
+void EventLoop::run_ticks() {
+    // Ticks queued by a tick run in the same drain, as in Node
+    while (!ticks_.empty() && !stopped_) {
+        Callback tick = std::move(ticks_.front());
+        ticks_.pop_front();
+        ++stats_.ticks_run;
+        tick();
+    }
+}
+
+void EventLoop::run_timers() {
+    const uint64_t now = now_ms();
+    timers_.advance(now);
+    Callback callback;
+    while (!stopped_ && timers_.pop_expired(now, callback)) {
+        ++stats_.timers_fired;
+        callback();
+        run_ticks();
+    }
+}
+
+int EventLoop::poll_timeout() const {
+    if (!ticks_.empty()) {
+        return 0;
+    }
+    // -1 when there are no timers: only posted work can arrive, and alive() saw a reference for it
+    int64_t timeout = timers_.next_timeout(now_ms());
+    return static_cast<int>(std::min<int64_t>(timeout, std::numeric_limits<int>::max()));
+}
+
+void EventLoop::wait(int timeout_ms) {
+    if (timeout_ms == 0) {
+        return; // Only the wakeup pipe is polled, and run_posted() looks at the queue itself
+    }
+    ++stats_.polls;
+    if (before_wait_) {
+        before_wait_();
+    }
+    if (wake_read_ < 0) {
+        if (timeout_ms > 0) {
+            usleep(static_cast<useconds_t>(timeout_ms) * 1000);
+        }
+        return;
+    }
+    struct pollfd wake = {wake_read_, POLLIN, 0};
+    while (poll(&wake, 1, timeout_ms) < 0 && errno == EINTR) {
+    }
+    char buffer[64];
+    while (read(wake_read_, buffer, sizeof(buffer)) > 0) {
+    }
+}
+
+void EventLoop::run_posted() {
+    std::vector<Callback> batch;
+    {
+        std::lock_guard<std::mutex> lock(posted_mutex_);
+        batch.swap(posted_);
+    }
+    for (Callback& callback : batch) {
+        if (stopped_) {
+            return;
+        }
+        ++stats_.posted_run;
+        callback();
+        run_ticks();
+    }
+}
+
+void EventLoop::run_immediates() {
+    // Immediates queued while this phase runs wait for the next iteration
+    for (size_t count = immediates_.size(); count > 0 && !stopped_; --count) {
+        Immediate immediate = std::move(immediates_.front());
+        immediates_.pop_front();
+        if (pending_immediates_.erase(immediate.id) == 0) {
+            continue; // Cancelled
+        }
+        ++stats_.immediates_run;
+        immediate.callback();
+        run_ticks();
+    }
+}
+
+} // namespace jpm::js
@@ -0,0 +1,121 @@
+#ifndef JPM_EVENT_LOOP_H
+#define JPM_EVENT_LOOP_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#include "js/timer_wheel.h"
+
+namespace jpm::js {
+
+// The single-threaded loop a script runs on once its top level has finished.
+// Every callback runs on the thread that calls run(); other threads hand work to
+// it with post(). Each iteration, as in Node:
+//   1. expired timers, in deadline order (see TimerWheel)
+//   2. work posted from other threads (I/O completions), waiting in poll() on a
+//      self-pipe when there is nothing else to do
+//   3. immediates queued before this phase started
+// The nextTick queue is drained after every callback. run() returns when no
+// timers, immediates, ticks, posted work or references (add_ref()) are left.
+//
+// This file knows nothing about JavaScriptCore; js/timers binds it to JS.
+class EventLoop {
+public:
+    using Callback = std::function<void()>;
+    using Clock = std::chrono::steady_clock;
+
+    static EventLoop& getInstance() {
+        static EventLoop instance;
+        return instance;
+    }
+
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Runs callback after delay, then every repeat if repeat > 0. Returns an id for cancel_timer().
+    uint64_t add_timer(std::chrono::milliseconds delay, std::chrono::milliseconds repeat, Callback callback);
+    // Returns false if the timer already fired (and does not repeat) or was cancelled
+    bool cancel_timer(uint64_t id);
+
+    uint64_t add_immediate(Callback callback);
+    bool cancel_immediate(uint64_t id);
+
+    // Runs callback as soon as the current callback returns
+    void next_tick(Callback callback);
+
+    // Thread-safe: runs callback on the loop thread and wakes the loop
+    void post(Callback callback);
+
+    // Pending work that will post() a result keeps the loop alive while it is referenced.
+    // Loop thread only.
+    void add_ref() { ++refs_; }
+    void remove_ref() {
+        if (refs_ > 0) --refs_;
+    }
+
+    // Runs until the loop has nothing left or stop() is called
+    void run();
+    // Makes run() return after the current callback (process.exit(), fatal errors)
+    void stop() { stopped_ = true; }
+    bool stopped() const { return stopped_; }
+    // Drops every pending callback, e.g. before the JS context they refer to is released
+    void clear();
+
+    // Runs hook whenever the loop is about to block waiting for timers or posted
+    // work, e.g. to flush buffered output
+    void set_before_wait(Callback hook) { before_wait_ = std::move(hook); }
+
+    struct Stats {
+        size_t timers_fired = 0;
+        size_t immediates_run = 0;
+        size_t ticks_run = 0;
+        size_t posted_run = 0;
+        size_t polls = 0;
+    };
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct Immediate {
+        uint64_t id;
+        Callback callback;
+    };
+
+    bool alive() const;
+    void run_timers();
+    void run_posted();
+    void run_immediates();
+    void run_ticks();
+    void wait(int timeout_ms);
+    int poll_timeout() const;
+
+    // Loop time in ms since the loop was created; the timer wheel counts in it
+    uint64_t now_ms() const;
+
+    const Clock::time_point epoch_ = Clock::now();
+    TimerWheel timers_;
+    uint64_t next_id_ = 1;
+    std::deque<Immediate> immediates_;
+    std::unordered_set<uint64_t> pending_immediates_; // Queued and not cancelled
+    std::deque<Callback> ticks_;
+    size_t refs_ = 0;
+    bool stopped_ = false;
+    Callback before_wait_;
+
+    mutable std::mutex posted_mutex_;
+    std::vector<Callback> posted_;
+    int wake_read_ = -1;  // Self-pipe: post() writes a byte so a blocked poll() returns
+    int wake_write_ = -1;
+
+    Stats stats_;
+};
+
+} // namespace jpm::js
+
+#endif // JPM_EVENT_LOOP_H
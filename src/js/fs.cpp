@@ -0,0 +1,640 @@
+#include "js/fs.h"
+#include "js/buffer.h"
+#include "js/fs_operations.h"
+#include "js/io_pool.h"
+#include "js/module.h"
+#include "js/process/events.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fcntl.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace jpm::js {
+
+namespace {
+
+JSObjectRef statsPrototype = nullptr;
+
+std::string to_utf8(JSContextRef ctx, JSValueRef value) {
+    JSStringRef str = JSValueToStringCopy(ctx, value, nullptr);
+    if (!str) {
+        return std::string();
+    }
+    size_t bufSize = JSStringGetMaximumUTF8CStringSize(str);
+    std::string result(bufSize, '\0');
+    result.resize(JSStringGetUTF8CString(str, &result[0], bufSize) - 1);
+    JSStringRelease(str);
+    return result;
+}
+
+JSValueRef make_string(JSContextRef ctx, const char* text) {
+    JSStringRef str = JSStringCreateWithUTF8CString(text);
+    JSValueRef value = JSValueMakeString(ctx, str);
+    JSStringRelease(str);
+    return value;
+}
+
+void set_property(JSContextRef ctx, JSObjectRef object, const char* name, JSValueRef value,
+                  JSPropertyAttributes attributes = kJSPropertyAttributeNone) {
+    JSStringRef key = JSStringCreateWithUTF8CString(name);
+    JSObjectSetProperty(ctx, object, key, value, attributes, nullptr);
+    JSStringRelease(key);
+}
+
+JSValueRef get_property(JSContextRef ctx, JSObjectRef object, const char* name) {
+    JSStringRef key = JSStringCreateWithUTF8CString(name);
+    JSValueRef value = JSObjectGetProperty(ctx, object, key, nullptr);
+    JSStringRelease(key);
+    return value;
+}
+
+void set_function(JSContextRef ctx, JSObjectRef object, const std::string& name, JSObjectCallAsFunctionCallback callback) {
+    JSStringRef key = JSStringCreateWithUTF8CString(name.c_str());
+    JSObjectSetProperty(ctx, object, key, JSObjectMakeFunctionWithCallback(ctx, key, callback),
+                        kJSPropertyAttributeNone, nullptr);
+    JSStringRelease(key);
+}
+
+JSObjectRef make_named_error(JSContextRef ctx, const char* name, const std::string& message) {
+    JSValueRef argument = make_string(ctx, message.c_str());
+    JSObjectRef error = JSObjectMakeError(ctx, 1, &argument, nullptr);
+    set_property(ctx, error, "name", make_string(ctx, name), kJSPropertyAttributeDontEnum);
+    return error;
+}
+
+JSObjectRef make_type_error(JSContextRef ctx, const std::string& message) {
+    return make_named_error(ctx, "TypeError", message);
+}
+
+// "ENOENT: no such file or directory, open 'missing.txt'" with code, errno,
+// syscall and path properties, as Node reports system errors
+JSObjectRef make_fs_error(JSContextRef ctx, const FsStatus& status, const std::string& path) {
+    std::string message = std::string(error_code_name(status.error)) + ": " + error_description(status.error) +
+                          ", " + status.syscall;
+    if (!path.empty()) {
+        message += " '" + path + "'";
+    }
+    JSValueRef argument = make_string(ctx, message.c_str());
+    JSObjectRef error = JSObjectMakeError(ctx, 1, &argument, nullptr);
+    set_property(ctx, error, "errno", JSValueMakeNumber(ctx, -status.error));
+    set_property(ctx, error, "code", make_string(ctx, error_code_name(status.error)));
+    set_property(ctx, error, "syscall", make_string(ctx, status.syscall));
+    if (!path.empty()) {
+        set_property(ctx, error, "path", make_string(ctx, path.c_str()));
+    }
+    return error;
+}
+
+bool is_function(JSContextRef ctx, JSValueRef value) {
+    return JSValueIsObject(ctx, value) && JSObjectIsFunction(ctx, JSValueToObject(ctx, value, nullptr));
+}
+
+bool is_absent(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], size_t index) {
+    return index >= argumentCount || JSValueIsUndefined(ctx, arguments[index]) || JSValueIsNull(ctx, arguments[index]);
+}
+
+bool get_path(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], std::string& path,
+              JSValueRef* exception) {
+    if (argumentCount < 1 || !JSValueIsString(ctx, arguments[0])) {
+        *exception = make_type_error(ctx, "The \"path\" argument must be of type string");
+        return false;
+    }
+    path = to_utf8(ctx, arguments[0]);
+    return true;
+}
+
+bool get_fd(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], int& fd, JSValueRef* exception) {
+    double value = argumentCount > 0 && JSValueIsNumber(ctx, arguments[0]) ? JSValueToNumber(ctx, arguments[0], nullptr) : -1;
+    if (!(value >= 0 && value <= 2147483647.0) || value != std::floor(value)) {
+        *exception = make_type_error(ctx, "The \"fd\" argument must be a non-negative integer");
+        return false;
+    }
+    fd = static_cast<int>(value);
+    return true;
+}
+
+// An optional non-negative integer argument; fallback when it is absent
+bool get_size(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], size_t index, const char* name,
+              size_t fallback, size_t& size, JSValueRef* exception) {
+    if (is_absent(ctx, argumentCount, arguments, index)) {
+        size = fallback;
+        return true;
+    }
+    double value = JSValueIsNumber(ctx, arguments[index]) ? JSValueToNumber(ctx, arguments[index], nullptr) : -1;
+    if (!(value >= 0 && value <= 9007199254740991.0) || value != std::floor(value)) {
+        *exception = make_named_error(ctx, "RangeError", std::string("The value of \"") + name + "\" is out of range");
+        return false;
+    }
+    size = static_cast<size_t>(value);
+    return true;
+}
+
+// null, undefined and -1 mean the current file position
+int64_t get_position(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], size_t index) {
+    if (is_absent(ctx, argumentCount, arguments, index) || !JSValueIsNumber(ctx, arguments[index])) {
+        return -1;
+    }
+    double value = JSValueToNumber(ctx, arguments[index], nullptr);
+    return value >= 0 && value <= 9007199254740991.0 ? static_cast<int64_t>(value) : -1;
+}
+
+// An encoding argument; absent leaves encoding empty (bytes, for readFile)
+bool parse_encoding(JSContextRef ctx, JSValueRef value, std::optional<TextEncoding>& encoding, JSValueRef* exception) {
+    if (JSValueIsUndefined(ctx, value) || JSValueIsNull(ctx, value)) {
+        return true;
+    }
+    std::string name = to_utf8(ctx, value);
+    TextEncoding parsed;
+    if (!parse_text_encoding(name, parsed)) {
+        *exception = make_type_error(ctx, "Unknown encoding: " + name);
+        return false;
+    }
+    encoding = parsed;
+    return true;
+}
+
+bool parse_flags(JSContextRef ctx, JSValueRef value, int& flags, JSValueRef* exception) {
+    if (JSValueIsUndefined(ctx, value) || JSValueIsNull(ctx, value)) {
+        return true;
+    }
+    if (JSValueIsNumber(ctx, value)) {
+        flags = static_cast<int>(JSValueToNumber(ctx, value, nullptr));
+        return true;
+    }
+    std::string text = to_utf8(ctx, value);
+    int parsed = parse_open_flags(text);
+    if (parsed < 0) {
+        *exception = make_type_error(ctx, "The value \"" + text + "\" is invalid for option \"flags\"");
+        return false;
+    }
+    flags = parsed;
+    return true;
+}
+
+void parse_mode(JSContextRef ctx, JSValueRef value, int& mode) {
+    if (JSValueIsNumber(ctx, value)) {
+        mode = static_cast<int>(JSValueToNumber(ctx, value, nullptr));
+    } else if (JSValueIsString(ctx, value)) {
+        mode = static_cast<int>(std::strtol(to_utf8(ctx, value).c_str(), nullptr, 8));
+    }
+}
+
+// readFile/writeFile options: an encoding name, or {encoding, flag, mode}
+bool parse_file_options(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], size_t index,
+                        std::optional<TextEncoding>& encoding, int& flags, int& mode, JSValueRef* exception) {
+    if (is_absent(ctx, argumentCount, arguments, index)) {
+        return true;
+    }
+    JSValueRef options = arguments[index];
+    if (!JSValueIsObject(ctx, options)) {
+        return parse_encoding(ctx, options, encoding, exception);
+    }
+    JSObjectRef object = JSValueToObject(ctx, options, nullptr);
+    parse_mode(ctx, get_property(ctx, object, "mode"), mode);
+    return parse_encoding(ctx, get_property(ctx, object, "encoding"), encoding, exception) &&
+           parse_flags(ctx, get_property(ctx, object, "flag"), flags, exception);
+}
+
+// A Buffer that adopts the bytes read, or the string they decode to
+JSValueRef make_contents(JSContextRef ctx, std::string contents, std::optional<TextEncoding> encoding) {
+    if (encoding) {
+        return decode_text(ctx, contents.data(), contents.size(), *encoding);
+    }
+    JSObjectRef buffer = make_buffer(ctx, std::move(contents));
+    return buffer ? buffer : JSValueMakeUndefined(ctx);
+}
+
+// One fs call. Arguments are read and results built on the JS thread; run() makes
+// the system calls and touches nothing but the operation's own fields, so it can
+// run on an IoPool thread. Values the call needs, such as the buffer read() fills,
+// are protected until the operation is destroyed, which happens on the JS thread.
+class Operation {
+public:
+    Operation() = default;
+    virtual ~Operation() {
+        for (JSValueRef value : retained_) {
+            JSValueUnprotect(context_, value);
+        }
+    }
+    Operation(const Operation&) = delete;
+    Operation& operator=(const Operation&) = delete;
+
+    // Reads the arguments (without the callback); false with *exception set if they are invalid
+    virtual bool parse(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) = 0;
+    virtual void run() = 0;
+    // What the sync form returns and the promise resolves to
+    virtual JSValueRef value(JSContextRef ctx) = 0;
+    virtual JSValueRef promise_value(JSContextRef ctx) { return value(ctx); }
+    // What the callback gets after its null error
+    virtual std::vector<JSValueRef> callback_values(JSContextRef ctx) { return {value(ctx)}; }
+
+    void retain(JSContextRef ctx, JSValueRef value) {
+        context_ = JSContextGetGlobalContext(ctx);
+        JSValueProtect(context_, value);
+        retained_.push_back(value);
+    }
+
+    JSObjectRef error(JSContextRef ctx) const { return make_fs_error(ctx, status_, path_); }
+    bool failed() const { return !status_.ok(); }
+
+protected:
+    FsStatus status_;
+    std::string path_; // Named in error messages; empty for calls on a descriptor
+
+private:
+    JSGlobalContextRef context_ = nullptr;
+    std::vector<JSValueRef> retained_;
+};
+
+class ReadFileOperation : public Operation {
+public:
+    bool parse(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) override {
+        int flags = O_RDONLY;
+        int mode = 0;
+        return get_path(ctx, argumentCount, arguments, path_, exception) &&
+               parse_file_options(ctx, argumentCount, arguments, 1, encoding_, flags, mode, exception);
+    }
+    void run() override { status_ = read_file(path_, contents_); }
+    JSValueRef value(JSContextRef ctx) override { return make_contents(ctx, std::move(contents_), encoding_); }
+
+private:
+    std::optional<TextEncoding> encoding_;
+    std::string contents_;
+};
+
+class WriteFileOperation : public Operation {
+public:
+    bool parse(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) override {
+        if (!get_path(ctx, argumentCount, arguments, path_, exception)) {
+            return false;
+        }
+        std::optional<TextEncoding> encoding;
+        if (!parse_file_options(ctx, argumentCount, arguments, 2, encoding, flags_, mode_, exception)) {
+            return false;
+        }
+        JSValueRef data = argumentCount > 1 ? arguments[1] : JSValueMakeUndefined(ctx);
+        if (get_buffer_bytes(ctx, data, data_, size_)) {
+            retain(ctx, data);
+        } else if (JSValueIsString(ctx, data)) {
+            encode_string(ctx, data, encoding.value_or(TextEncoding::Utf8), text_);
+            data_ = text_.data();
+            size_ = text_.size();
+        } else {
+            *exception = make_type_error(ctx, "The \"data\" argument must be of type string or an instance of a typed array");
+            return false;
+        }
+        return true;
+    }
+    void run() override { status_ = write_file(path_, data_, size_, flags_, mode_); }
+    JSValueRef value(JSContextRef ctx) override { return JSValueMakeUndefined(ctx); }
+    std::vector<JSValueRef> callback_values(JSContextRef) override { return {}; }
+
+private:
+    int flags_ = O_TRUNC | O_CREAT | O_WRONLY;
+    int mode_ = 0666;
+    std::string text_;
+    char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+class StatOperation : public Operation {
+public:
+    bool parse(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) override {
+        return get_path(ctx, argumentCount, arguments, path_, exception);
+    }
+    void run() override { status_ = stat_path(path_, info_); }
+    JSValueRef value(JSContextRef ctx) override {
+        JSObjectRef stats = JSObjectMake(ctx, nullptr, nullptr);
+        if (statsPrototype) {
+            JSObjectSetPrototype(ctx, stats, statsPrototype);
+        }
+        const struct { const char* name; double value; } fields[] = {
+            {"dev", static_cast<double>(info_.st_dev)},
+            {"mode", static_cast<double>(info_.st_mode)},
+            {"nlink", static_cast<double>(info_.st_nlink)},
+            {"uid", static_cast<double>(info_.st_uid)},
+            {"gid", static_cast<double>(info_.st_gid)},
+            {"rdev", static_cast<double>(info_.st_rdev)},
+            {"blksize", static_cast<double>(info_.st_blksize)},
+            {"ino", static_cast<double>(info_.st_ino)},
+            {"size", static_cast<double>(info_.st_size)},
+            {"blocks", static_cast<double>(info_.st_blocks)},
+            {"atimeMs", access_time_ms(info_)},
+            {"mtimeMs", modify_time_ms(info_)},
+            {"ctimeMs", change_time_ms(info_)},
+        };
+        for (const auto& field : fields) {
+            set_property(ctx, stats, field.name, JSValueMakeNumber(ctx, field.value));
+        }
+        const struct { const char* name; double ms; } dates[] = {
+            {"atime", access_time_ms(info_)}, {"mtime", modify_time_ms(info_)}, {"ctime", change_time_ms(info_)}};
+        for (const auto& date : dates) {
+            JSValueRef ms = JSValueMakeNumber(ctx, std::floor(date.ms));
+            set_property(ctx, stats, date.name, JSObjectMakeDate(ctx, 1, &ms, nullptr));
+        }
+        return stats;
+    }
+
+private:
+    struct stat info_ = {};
+};
+
+class ReaddirOperation : public Operation {
+public:
+    bool parse(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) override {
+        return get_path(ctx, argumentCount, arguments, path_, exception);
+    }
+    void run() override { status_ = read_directory(path_, names_); }
+    JSValueRef value(JSContextRef ctx) override {
+        std::vector<JSValueRef> values;
+        values.reserve(names_.size());
+        for (const std::string& name : names_) {
+            values.push_back(make_string(ctx, name.c_str()));
+        }
+        return JSObjectMakeArray(ctx, values.size(), values.data(), nullptr);
+    }
+
+private:
+    std::vector<std::string> names_;
+};
+
+class OpenOperation : public Operation {
+public:
+    bool parse(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) override {
+        if (!get_path(ctx, argumentCount, arguments, path_, exception)) {
+            return false;
+        }
+        if (argumentCount > 2) {
+            parse_mode(ctx, arguments[2], mode_);
+        }
+        return argumentCount < 2 || parse_flags(ctx, arguments[1], flags_, exception);
+    }
+    void run() override { status_ = open_file(path_, flags_, mode_, fd_); }
+    JSValueRef value(JSContextRef ctx) override { return JSValueMakeNumber(ctx, fd_); }
+
+private:
+    int flags_ = O_RDONLY;
+    int mode_ = 0666;
+    int fd_ = -1;
+};
+
+// read(fd, buffer, offset, length, position) into a typed array
+class ReadOperation : public Operation {
+public:
+    bool parse(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) override {
+        if (!get_fd(ctx, argumentCount, arguments, fd_, exception)) {
+            return false;
+        }
+        size_t size = 0;
+        if (argumentCount < 2 || !get_buffer_bytes(ctx, arguments[1], data_, size)) {
+            *exception = make_type_error(ctx, "The \"buffer\" argument must be an instance of a typed array");
+            return false;
+        }
+        buffer_ = arguments[1];
+        size_t offset = 0;
+        if (!get_size(ctx, argumentCount, arguments, 2, "offset", 0, offset, exception) ||
+            !get_size(ctx, argumentCount, arguments, 3, "length", size - std::min(offset, size), length_, exception)) {
+            return false;
+        }
+        if (offset > size || length_ > size - offset) {
+            *exception = make_named_error(ctx, "RangeError", "The value of \"length\" is out of range");
+            return false;
+        }
+        data_ += offset;
+        position_ = get_position(ctx, argumentCount, arguments, 4);
+        retain(ctx, buffer_);
+        return true;
+    }
+    void run() override { status_ = read_fd(fd_, data_, length_, position_, bytes_read_); }
+    JSValueRef value(JSContextRef ctx) override { return JSValueMakeNumber(ctx, static_cast<double>(bytes_read_)); }
+    JSValueRef promise_value(JSContextRef ctx) override {
+        JSObjectRef result = JSObjectMake(ctx, nullptr, nullptr);
+        set_property(ctx, result, "bytesRead", value(ctx));
+        set_property(ctx, result, "buffer", buffer_);
+        return result;
+    }
+    std::vector<JSValueRef> callback_values(JSContextRef ctx) override { return {value(ctx), buffer_}; }
+
+private:
+    int fd_ = -1;
+    JSValueRef buffer_ = nullptr;
+    char* data_ = nullptr;
+    size_t length_ = 0;
+    int64_t position_ = -1;
+    size_t bytes_read_ = 0;
+};
+
+// write(fd, buffer, offset, length, position) or write(fd, string, position, encoding)
+class WriteOperation : public Operation {
+public:
+    bool parse(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) override {
+        if (!get_fd(ctx, argumentCount, arguments, fd_, exception)) {
+            return false;
+        }
+        data_value_ = argumentCount > 1 ? arguments[1] : JSValueMakeUndefined(ctx);
+        size_t size = 0;
+        if (get_buffer_bytes(ctx, data_value_, data_, size)) {
+            size_t offset = 0;
+            if (!get_size(ctx, argumentCount, arguments, 2, "offset", 0, offset, exception) ||
+                !get_size(ctx, argumentCount, arguments, 3, "length", size - std::min(offset, size), length_, exception)) {
+                return false;
+            }
+            if (offset > size || length_ > size - offset) {
+                *exception = make_named_error(ctx, "RangeError", "The value of \"length\" is out of range");
+                return false;
+            }
+            data_ += offset;
+            position_ = get_position(ctx, argumentCount, arguments, 4);
+        } else if (JSValueIsString(ctx, data_value_)) {
+            std::optional<TextEncoding> encoding;
+            if (argumentCount > 3 && !parse_encoding(ctx, arguments[3], encoding, exception)) {
+                return false;
+            }
+            encode_string(ctx, data_value_, encoding.value_or(TextEncoding::Utf8), text_);
+            data_ = text_.data();
+            length_ = text_.size();
+            position_ = get_position(ctx, argumentCount, arguments, 2);
+        } else {
+            *exception = make_type_error(ctx, "The \"buffer\" argument must be of type string or an instance of a typed array");
+            return false;
+        }
+        retain(ctx, data_value_);
+        return true;
+    }
+    void run() override { status_ = write_fd(fd_, data_, length_, position_, bytes_written_); }
+    JSValueRef value(JSContextRef ctx) override { return JSValueMakeNumber(ctx, static_cast<double>(bytes_written_)); }
+    JSValueRef promise_value(JSContextRef ctx) override {
+        JSObjectRef result = JSObjectMake(ctx, nullptr, nullptr);
+        set_property(ctx, result, "bytesWritten", value(ctx));
+        set_property(ctx, result, "buffer", data_value_);
+        return result;
+    }
+    std::vector<JSValueRef> callback_values(JSContextRef ctx) override { return {value(ctx), data_value_}; }
+
+private:
+    int fd_ = -1;
+    JSValueRef data_value_ = nullptr;
+    std::string text_;
+    char* data_ = nullptr;
+    size_t length_ = 0;
+    int64_t position_ = -1;
+    size_t bytes_written_ = 0;
+};
+
+class CloseOperation : public Operation {
+public:
+    bool parse(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) override {
+        return get_fd(ctx, argumentCount, arguments, fd_, exception);
+    }
+    void run() override { status_ = close_fd(fd_); }
+    JSValueRef value(JSContextRef ctx) override { return JSValueMakeUndefined(ctx); }
+    std::vector<JSValueRef> callback_values(JSContextRef) override { return {}; }
+
+private:
+    int fd_ = -1;
+};
+
+template <typename Op>
+JSValueRef call_sync(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t argumentCount,
+                     const JSValueRef arguments[], JSValueRef* exception) {
+    Op operation;
+    if (!operation.parse(ctx, argumentCount, arguments, exception)) {
+        return JSValueMakeUndefined(ctx);
+    }
+    operation.run();
+    if (operation.failed()) {
+        *exception = operation.error(ctx);
+        return JSValueMakeUndefined(ctx);
+    }
+    return operation.value(ctx);
+}
+
+// fs.x(..., callback): invalid arguments throw, as in Node; I/O errors go to the callback
+template <typename Op>
+JSValueRef call_with_callback(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t argumentCount,
+                              const JSValueRef arguments[], JSValueRef* exception) {
+    if (argumentCount < 1 || !is_function(ctx, arguments[argumentCount - 1])) {
+        *exception = make_type_error(ctx, "The \"cb\" argument must be of type function");
+        return JSValueMakeUndefined(ctx);
+    }
+    auto operation = std::make_shared<Op>();
+    if (!operation->parse(ctx, argumentCount - 1, arguments, exception)) {
+        return JSValueMakeUndefined(ctx);
+    }
+    JSObjectRef callback = JSValueToObject(ctx, arguments[argumentCount - 1], nullptr);
+    operation->retain(ctx, callback);
+    JSGlobalContextRef context = JSContextGetGlobalContext(ctx);
+    Op* work = operation.get();
+    IoPool::getInstance().submit([work]() { work->run(); }, [operation, context, callback]() {
+        std::vector<JSValueRef> values;
+        if (operation->failed()) {
+            values.push_back(operation->error(context));
+        } else {
+            values = operation->callback_values(context);
+            values.insert(values.begin(), JSValueMakeNull(context));
+        }
+        JSValueRef error = nullptr;
+        JSObjectCallAsFunction(context, callback, nullptr, values.size(), values.data(), &error);
+        if (error) {
+            process::handle_uncaught_exception(context, error);
+        }
+    });
+    return JSValueMakeUndefined(ctx);
+}
+
+// fs.promises.x(...): invalid arguments reject too, as they do from Node's async functions
+template <typename Op>
+JSValueRef call_promise(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t argumentCount,
+                        const JSValueRef arguments[], JSValueRef* exception) {
+    JSObjectRef resolve = nullptr;
+    JSObjectRef reject = nullptr;
+    JSObjectRef promise = JSObjectMakeDeferredPromise(ctx, &resolve, &reject, exception);
+    if (!promise) {
+        return JSValueMakeUndefined(ctx);
+    }
+    auto operation = std::make_shared<Op>();
+    JSValueRef invalid = nullptr;
+    if (!operation->parse(ctx, argumentCount, arguments, &invalid)) {
+        JSObjectCallAsFunction(ctx, reject, nullptr, 1, &invalid, nullptr);
+        return promise;
+    }
+    operation->retain(ctx, resolve);
+    operation->retain(ctx, reject);
+    JSGlobalContextRef context = JSContextGetGlobalContext(ctx);
+    Op* work = operation.get();
+    IoPool::getInstance().submit([work]() { work->run(); }, [operation, context, resolve, reject]() {
+        JSValueRef result = operation->failed() ? operation->error(context) : operation->promise_value(context);
+        JSObjectCallAsFunction(context, operation->failed() ? reject : resolve, nullptr, 1, &result, nullptr);
+    });
+    return promise;
+}
+
+template <typename Op>
+void define_operation(JSContextRef ctx, JSObjectRef fs, JSObjectRef promises, const std::string& name) {
+    set_function(ctx, fs, name, call_with_callback<Op>);
+    set_function(ctx, fs, name + "Sync", call_sync<Op>);
+    set_function(ctx, promises, name, call_promise<Op>);
+}
+
+template <mode_t Type>
+JSValueRef stats_is(JSContextRef ctx, JSObjectRef, JSObjectRef thisObject, size_t, const JSValueRef[], JSValueRef*) {
+    double mode = JSValueToNumber(ctx, get_property(ctx, thisObject, "mode"), nullptr);
+    return JSValueMakeBoolean(ctx, !std::isnan(mode) && (static_cast<mode_t>(mode) & S_IFMT) == Type);
+}
+
+JSObjectRef make_stats_prototype(JSContextRef ctx) {
+    JSObjectRef prototype = JSObjectMake(ctx, nullptr, nullptr);
+    set_function(ctx, prototype, "isFile", stats_is<S_IFREG>);
+    set_function(ctx, prototype, "isDirectory", stats_is<S_IFDIR>);
+    set_function(ctx, prototype, "isSymbolicLink", stats_is<S_IFLNK>);
+    set_function(ctx, prototype, "isFIFO", stats_is<S_IFIFO>);
+    set_function(ctx, prototype, "isSocket", stats_is<S_IFSOCK>);
+    set_function(ctx, prototype, "isCharacterDevice", stats_is<S_IFCHR>);
+    set_function(ctx, prototype, "isBlockDevice", stats_is<S_IFBLK>);
+    return prototype;
+}
+
+JSObjectRef make_constants(JSContextRef ctx) {
+    JSObjectRef constants = JSObjectMake(ctx, nullptr, nullptr);
+    const struct { const char* name; int value; } values[] = {
+        {"O_RDONLY", O_RDONLY}, {"O_WRONLY", O_WRONLY}, {"O_RDWR", O_RDWR},     {"O_CREAT", O_CREAT},
+        {"O_EXCL", O_EXCL},     {"O_TRUNC", O_TRUNC},   {"O_APPEND", O_APPEND}, {"O_SYNC", O_SYNC},
+        {"S_IFMT", S_IFMT},     {"S_IFREG", S_IFREG},   {"S_IFDIR", S_IFDIR},   {"S_IFLNK", S_IFLNK},
+    };
+    for (const auto& value : values) {
+        set_property(ctx, constants, value.name, JSValueMakeNumber(ctx, value.value));
+    }
+    return constants;
+}
+
+} // namespace
+
+void setup_fs(JSContextRef ctx) {
+    if (statsPrototype) {
+        JSValueUnprotect(ctx, statsPrototype);
+    }
+    statsPrototype = make_stats_prototype(ctx);
+    JSValueProtect(ctx, statsPrototype);
+
+    JSObjectRef fs = JSObjectMake(ctx, nullptr, nullptr);
+    JSObjectRef promises = JSObjectMake(ctx, nullptr, nullptr);
+    define_operation<ReadFileOperation>(ctx, fs, promises, "readFile");
+    define_operation<WriteFileOperation>(ctx, fs, promises, "writeFile");
+    define_operation<StatOperation>(ctx, fs, promises, "stat");
+    define_operation<ReaddirOperation>(ctx, fs, promises, "readdir");
+    define_operation<OpenOperation>(ctx, fs, promises, "open");
+    define_operation<ReadOperation>(ctx, fs, promises, "read");
+    define_operation<WriteOperation>(ctx, fs, promises, "write");
+    define_operation<CloseOperation>(ctx, fs, promises, "close");
+    set_property(ctx, fs, "promises", promises);
+    set_property(ctx, fs, "constants", make_constants(ctx));
+
+    ModuleSystem::getInstance().registerBuiltinModule("fs", fs);
+    ModuleSystem::getInstance().registerBuiltinModule("fs/promises", promises);
+}
+
+} // namespace jpm::js
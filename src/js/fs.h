@@ -0,0 +1,24 @@
+#ifndef JPM_FS_H
+#define JPM_FS_H
+
+#include <JavaScriptCore/JavaScript.h>
+
+namespace jpm::js {
+
+// Registers the built-in "fs" and "fs/promises" modules. Each operation comes in
+// the three forms Node has:
+// - fs.readFileSync(...) returns the result or throws
+// - fs.readFile(..., callback) calls callback(error, result) from the event loop
+// - fs.promises.readFile(...) returns a promise
+// for readFile, writeFile, stat, readdir, open, read, write and close. The async
+// forms run on IoPool's threads, and their results are built and delivered on
+// the JS thread.
+// readFile returns a Buffer that adopts the bytes read, or a string when an
+// encoding is given. Differences from Node: paths must be strings, and
+// fs.promises.open resolves to a file descriptor, which read, write and close
+// take, instead of a FileHandle.
+void setup_fs(JSContextRef ctx);
+
+} // namespace jpm::js
+
+#endif // JPM_FS_H
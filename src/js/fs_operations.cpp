@@ -0,0 +1,231 @@
+#include "js/fs_operations.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace jpm::js {
+
+namespace {
+
+constexpr size_t kUnknownSizeChunk = 64 * 1024; // Read size for files fstat() cannot size (pipes, /proc)
+
+FsStatus failure(const char* syscall) {
+    return FsStatus{errno, syscall};
+}
+
+struct ErrorName {
+    int error;
+    const char* code;
+    const char* description;
+};
+
+// The descriptions are libuv's, which Node puts in its messages
+constexpr ErrorName kErrorNames[] = {
+    {ENOENT, "ENOENT", "no such file or directory"},
+    {EACCES, "EACCES", "permission denied"},
+    {EEXIST, "EEXIST", "file already exists"},
+    {EISDIR, "EISDIR", "illegal operation on a directory"},
+    {ENOTDIR, "ENOTDIR", "not a directory"},
+    {ENOTEMPTY, "ENOTEMPTY", "directory not empty"},
+    {EBADF, "EBADF", "bad file descriptor"},
+    {EPERM, "EPERM", "operation not permitted"},
+    {EINVAL, "EINVAL", "invalid argument"},
+    {EMFILE, "EMFILE", "too many open files"},
+    {ENFILE, "ENFILE", "file table overflow"},
+    {ENOSPC, "ENOSPC", "no space left on device"},
+    {EROFS, "EROFS", "read-only file system"},
+    {ELOOP, "ELOOP", "too many symbolic links encountered"},
+    {ENAMETOOLONG, "ENAMETOOLONG", "name too long"},
+    {EFBIG, "EFBIG", "file too large"},
+    {EAGAIN, "EAGAIN", "resource temporarily unavailable"},
+    {EIO, "EIO", "i/o error"},
+    {EBUSY, "EBUSY", "resource busy or locked"},
+    {ENXIO, "ENXIO", "no such device or address"},
+    {ESPIPE, "ESPIPE", "invalid seek"},
+};
+
+const ErrorName* find_error(int error) {
+    for (const ErrorName& name : kErrorNames) {
+        if (name.error == error) {
+            return &name;
+        }
+    }
+    return nullptr;
+}
+
+double to_ms(const struct timespec& time) {
+    return static_cast<double>(time.tv_sec) * 1000.0 + static_cast<double>(time.tv_nsec) / 1e6;
+}
+
+} // namespace
+
+FsStatus read_file(const std::string& path, std::string& contents) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return failure("open");
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        FsStatus status = failure("fstat");
+        ::close(fd);
+        return status;
+    }
+    // One byte past the size: a short read then proves end of file without a second read()
+    const bool sized = S_ISREG(info.st_mode) && info.st_size > 0;
+    size_t capacity = sized ? static_cast<size_t>(info.st_size) + 1 : kUnknownSizeChunk;
+    contents.resize(capacity);
+    size_t total = 0;
+    FsStatus status;
+    while (true) {
+        ssize_t count = ::read(fd, &contents[total], capacity - total);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            status = failure("read");
+            break;
+        }
+        total += static_cast<size_t>(count);
+        if (count == 0 || (sized && total == static_cast<size_t>(info.st_size) && total < capacity)) {
+            break;
+        }
+        if (total == capacity) {
+            capacity *= 2;
+            contents.resize(capacity);
+        }
+    }
+    ::close(fd);
+    contents.resize(status.ok() ? total : 0);
+    return status;
+}
+
+FsStatus write_file(const std::string& path, const char* data, size_t size, int flags, int mode) {
+    int fd = -1;
+    FsStatus status = open_file(path, flags, mode, fd);
+    if (!status.ok()) {
+        return status;
+    }
+    size_t written = 0;
+    status = write_fd(fd, data, size, -1, written);
+    if (::close(fd) != 0 && status.ok()) {
+        status = failure("close");
+    }
+    return status;
+}
+
+FsStatus stat_path(const std::string& path, struct stat& info) {
+    return ::stat(path.c_str(), &info) == 0 ? FsStatus{} : failure("stat");
+}
+
+FsStatus read_directory(const std::string& path, std::vector<std::string>& names) {
+    DIR* directory = opendir(path.c_str());
+    if (!directory) {
+        return failure("scandir");
+    }
+    names.clear();
+    errno = 0;
+    while (struct dirent* entry = readdir(directory)) {
+        const char* name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+        names.emplace_back(name);
+    }
+    FsStatus status = errno != 0 ? failure("scandir") : FsStatus{};
+    closedir(directory);
+    std::sort(names.begin(), names.end());
+    return status;
+}
+
+FsStatus open_file(const std::string& path, int flags, int mode, int& fd) {
+    do {
+        fd = ::open(path.c_str(), flags | O_CLOEXEC, mode);
+    } while (fd < 0 && errno == EINTR);
+    return fd >= 0 ? FsStatus{} : failure("open");
+}
+
+FsStatus read_fd(int fd, char* buffer, size_t length, int64_t position, size_t& bytes_read) {
+    ssize_t count;
+    do {
+        count = position < 0 ? ::read(fd, buffer, length) : ::pread(fd, buffer, length, static_cast<off_t>(position));
+    } while (count < 0 && errno == EINTR);
+    if (count < 0) {
+        bytes_read = 0;
+        return failure("read");
+    }
+    bytes_read = static_cast<size_t>(count);
+    return FsStatus{};
+}
+
+FsStatus write_fd(int fd, const char* data, size_t length, int64_t position, size_t& bytes_written) {
+    bytes_written = 0;
+    while (bytes_written < length) {
+        const char* from = data + bytes_written;
+        const size_t remaining = length - bytes_written;
+        ssize_t count = position < 0 ? ::write(fd, from, remaining)
+                                     : ::pwrite(fd, from, remaining, static_cast<off_t>(position + static_cast<int64_t>(bytes_written)));
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return failure("write");
+        }
+        bytes_written += static_cast<size_t>(count);
+    }
+    return FsStatus{};
+}
+
+FsStatus close_fd(int fd) {
+    return ::close(fd) == 0 ? FsStatus{} : failure("close");
+}
+
+int parse_open_flags(std::string_view flags) {
+    // "s" (synchronous) variants are accepted and map to O_SYNC
+    if (flags == "r") return O_RDONLY;
+    if (flags == "rs" || flags == "sr") return O_RDONLY | O_SYNC;
+    if (flags == "r+") return O_RDWR;
+    if (flags == "rs+" || flags == "sr+") return O_RDWR | O_SYNC;
+    if (flags == "w") return O_TRUNC | O_CREAT | O_WRONLY;
+    if (flags == "wx" || flags == "xw") return O_TRUNC | O_CREAT | O_WRONLY | O_EXCL;
+    if (flags == "w+") return O_TRUNC | O_CREAT | O_RDWR;
+    if (flags == "wx+" || flags == "xw+") return O_TRUNC | O_CREAT | O_RDWR | O_EXCL;
+    if (flags == "a") return O_APPEND | O_CREAT | O_WRONLY;
+    if (flags == "ax" || flags == "xa") return O_APPEND | O_CREAT | O_WRONLY | O_EXCL;
+    if (flags == "as" || flags == "sa") return O_APPEND | O_CREAT | O_WRONLY | O_SYNC;
+    if (flags == "a+") return O_APPEND | O_CREAT | O_RDWR;
+    if (flags == "ax+" || flags == "xa+") return O_APPEND | O_CREAT | O_RDWR | O_EXCL;
+    if (flags == "as+" || flags == "sa+") return O_APPEND | O_CREAT | O_RDWR | O_SYNC;
+    return -1;
+}
+
+const char* error_code_name(int error) {
+    const ErrorName* name = find_error(error);
+    return name ? name->code : "UNKNOWN";
+}
+
+std::string error_description(int error) {
+    if (const ErrorName* name = find_error(error)) {
+        return name->description;
+    }
+    std::string description = std::strerror(error);
+    if (!description.empty()) {
+        description[0] = static_cast<char>(std::tolower(static_cast<unsigned char>(description[0])));
+    }
+    return description;
+}
+
+#ifdef __APPLE__
+double access_time_ms(const struct stat& info) { return to_ms(info.st_atimespec); }
+double modify_time_ms(const struct stat& info) { return to_ms(info.st_mtimespec); }
+double change_time_ms(const struct stat& info) { return to_ms(info.st_ctimespec); }
+#else
+double access_time_ms(const struct stat& info) { return to_ms(info.st_atim); }
+double modify_time_ms(const struct stat& info) { return to_ms(info.st_mtim); }
+double change_time_ms(const struct stat& info) { return to_ms(info.st_ctim); }
+#endif
+
+} // namespace jpm::js
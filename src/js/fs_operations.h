@@ -0,0 +1,51 @@
+#ifndef JPM_FS_OPERATIONS_H
+#define JPM_FS_OPERATIONS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/stat.h>
+
+namespace jpm::js {
+
+// The file system calls behind the fs module, free of JavaScriptCore so they can
+// run on any thread. Each returns what failed instead of throwing, so the binding
+// can build a Node-style error ("ENOENT: no such file or directory, open 'x'").
+struct FsStatus {
+    int error = 0;                // errno value, 0 on success
+    const char* syscall = nullptr; // The call that failed, as Node names it
+
+    bool ok() const { return error == 0; }
+};
+
+// The whole file. Regular files are read in one read() of their size plus one
+// byte, so an unchanged file costs open, fstat, read and close.
+FsStatus read_file(const std::string& path, std::string& contents);
+FsStatus write_file(const std::string& path, const char* data, size_t size, int flags, int mode);
+FsStatus stat_path(const std::string& path, struct stat& info);
+// Entry names without "." and "..", sorted like libuv's scandir
+FsStatus read_directory(const std::string& path, std::vector<std::string>& names);
+
+FsStatus open_file(const std::string& path, int flags, int mode, int& fd);
+// position < 0 reads or writes at the file position and advances it
+FsStatus read_fd(int fd, char* buffer, size_t length, int64_t position, size_t& bytes_read);
+FsStatus write_fd(int fd, const char* data, size_t length, int64_t position, size_t& bytes_written);
+FsStatus close_fd(int fd);
+
+// open(2) flags for a Node flag string such as "r", "w+" or "ax"; -1 if unknown
+int parse_open_flags(std::string_view flags);
+
+// "ENOENT" and "no such file or directory" for ENOENT
+const char* error_code_name(int error);
+std::string error_description(int error);
+
+// Milliseconds since the epoch, with the fraction Node's *Ms fields have
+double access_time_ms(const struct stat& info);
+double modify_time_ms(const struct stat& info);
+double change_time_ms(const struct stat& info);
+
+} // namespace jpm::js
+
+#endif // JPM_FS_OPERATIONS_H
@@ -0,0 +1,745 @@
+#include "js/import_scanner.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <unordered_set>
+
+namespace jpm::js {
+
+namespace {
+
+enum class TokenType { End, Identifier, Number, String, Template, Regex, Punctuator };
+
+struct Token {
+    TokenType type = TokenType::End;
+    size_t begin = 0;
+    size_t end = 0;
+    bool newline_before = false;
+    std::string_view text;
+
+    bool is(std::string_view value) const {
+        return (type == TokenType::Identifier || type == TokenType::Punctuator) && text == value;
+    }
+};
+
+// Character classes, looked up once per byte on the hot path
+enum : uint8_t { kIdentifierStart = 1, kIdentifierPart = 2 };
+
+constexpr std::array<uint8_t, 256> make_char_classes() {
+    std::array<uint8_t, 256> classes{};
+    for (int c = 0; c < 256; ++c) {
+        bool start = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '$' || c == '\\' || c >= 0x80;
+        bool digit = c >= '0' && c <= '9';
+        classes[static_cast<size_t>(c)] = static_cast<uint8_t>((start ? kIdentifierStart | kIdentifierPart : 0) | (digit ? kIdentifierPart : 0));
+    }
+    return classes;
+}
+
+constexpr std::array<uint8_t, 256> kCharClasses = make_char_classes();
+
+bool is_identifier_start(unsigned char c) {
+    return kCharClasses[c] & kIdentifierStart;
+}
+
+bool is_identifier_part(unsigned char c) {
+    return kCharClasses[c] & kIdentifierPart;
+}
+
+// Keywords after which a "/" starts a regular expression rather than a division
+bool is_operator_keyword(std::string_view word) {
+    static const std::unordered_set<std::string_view> kKeywords = {
+        "return", "typeof", "instanceof", "in", "of", "new", "delete", "void",
+        "throw", "case", "do", "else", "yield", "await"};
+    return kKeywords.count(word) != 0;
+}
+
+// Just enough of a JavaScript tokenizer to find import/export statements reliably:
+// it knows where comments, strings, template literals and regular expressions end,
+// and how deeply (), [], {} and ${} are nested.
+class Lexer {
+public:
+    explicit Lexer(std::string_view source) : src_(source) {}
+
+    Token next() {
+        bool newline = skip_trivia();
+        Token token;
+        token.begin = pos_;
+        token.newline_before = newline;
+        if (pos_ >= src_.size()) {
+            token.begin = token.end = src_.size();
+            return token;
+        }
+
+        unsigned char c = static_cast<unsigned char>(src_[pos_]);
+        if (is_identifier_start(c)) {
+            token.type = TokenType::Identifier;
+            while (pos_ < src_.size() && is_identifier_part(static_cast<unsigned char>(src_[pos_]))) {
+                pos_ += src_[pos_] == '\\' ? size_t{2} : size_t{1};
+            }
+        } else if ((c >= '0' && c <= '9') || (c == '.' && pos_ + 1 < src_.size() && src_[pos_ + 1] >= '0' && src_[pos_ + 1] <= '9')) {
+            token.type = TokenType::Number;
+            while (pos_ < src_.size()) {
+                char d = src_[pos_];
+                if ((d == '+' || d == '-') && (src_[pos_ - 1] == 'e' || src_[pos_ - 1] == 'E') &&
+                    src_.compare(token.begin, 2, "0x") != 0 && src_.compare(token.begin, 2, "0X") != 0) {
+                    ++pos_;
+                } else if (is_identifier_part(static_cast<unsigned char>(d)) || d == '.') {
+                    ++pos_;
+                } else {
+                    break;
+                }
+            }
+        } else if (c == '"' || c == '\'') {
+            token.type = TokenType::String;
+            ++pos_;
+            while (pos_ < src_.size() && src_[pos_] != static_cast<char>(c) && src_[pos_] != '\n') {
+                pos_ += src_[pos_] == '\\' ? size_t{2} : size_t{1};
+            }
+            pos_ = std::min(pos_ + 1, src_.size());
+        } else if (c == '`') {
+            ++pos_;
+            scan_template(token);
+        } else if (c == '}' && !braces_.empty() && braces_.back() == '$') {
+            braces_.pop_back();
+            ++pos_;
+            scan_template(token);
+        } else if (c == '/' && regex_allowed()) {
+            token.type = TokenType::Regex;
+            bool in_class = false;
+            for (++pos_; pos_ < src_.size() && src_[pos_] != '\n'; ++pos_) {
+                char d = src_[pos_];
+                if (d == '\\') {
+                    ++pos_;
+                } else if (d == '[') {
+                    in_class = true;
+                } else if (d == ']') {
+                    in_class = false;
+                } else if (d == '/' && !in_class) {
+                    ++pos_;
+                    break;
+                }
+            }
+            while (pos_ < src_.size() && is_identifier_part(static_cast<unsigned char>(src_[pos_]))) {
+                ++pos_; // Flags
+            }
+        } else {
+            token.type = TokenType::Punctuator;
+            const char second = pos_ + 1 < src_.size() ? src_[pos_ + 1] : '\0';
+            if (c == '.' && second == '.' && pos_ + 2 < src_.size() && src_[pos_ + 2] == '.') {
+                pos_ += 3;
+            } else if (c == '?' && second == '.' && !(pos_ + 2 < src_.size() && src_[pos_ + 2] >= '0' && src_[pos_ + 2] <= '9')) {
+                pos_ += 2;
+            } else if (c == '=' && second == '>') {
+                pos_ += 2;
+            } else {
+                ++pos_;
+                if (c == '(' || c == '[' || c == '{') {
+                    braces_.push_back(static_cast<char>(c));
+                } else if ((c == ')' || c == ']' || c == '}') && !braces_.empty()) {
+                    braces_.pop_back();
+                }
+            }
+        }
+
+        pos_ = std::min(pos_, src_.size());
+        token.end = pos_;
+        token.text = src_.substr(token.begin, token.end - token.begin);
+        prev_ = token;
+        return token;
+    }
+
+    Token peek() const {
+        Lexer copy(*this);
+        return copy.next();
+    }
+
+    // Nesting of (), [], {} and ${} at the current position; 0 is the top level
+    size_t depth() const { return braces_.size(); }
+
+private:
+    std::string_view src_;
+    size_t pos_ = 0;
+    std::vector<char> braces_; // '(', '[', '{', or '$' for a template substitution
+    Token prev_;
+
+    bool skip_trivia() {
+        bool newline = false;
+        while (pos_ < src_.size()) {
+            char c = src_[pos_];
+            if (c == '\n') {
+                newline = true;
+                ++pos_;
+            } else if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v') {
+                ++pos_;
+            } else if (c == '/' && pos_ + 1 < src_.size() && src_[pos_ + 1] == '/') {
+                size_t eol = src_.find('\n', pos_);
+                pos_ = eol == std::string_view::npos ? src_.size() : eol;
+            } else if (c == '/' && pos_ + 1 < src_.size() && src_[pos_ + 1] == '*') {
+                size_t close = src_.find("*/", pos_ + 2);
+                size_t stop = close == std::string_view::npos ? src_.size() : close + 2;
+                newline = newline || src_.substr(pos_, stop - pos_).find('\n') != std::string_view::npos;
+                pos_ = stop;
+            } else if (static_cast<unsigned char>(c) == 0xC2 && pos_ + 1 < src_.size() &&
+                       static_cast<unsigned char>(src_[pos_ + 1]) == 0xA0) {
+                pos_ += 2; // No-break space
+            } else {
+                break;
+            }
+        }
+        return newline;
+    }
+
+    // From just after "`" or the "}" closing a substitution, to the closing "`" or the next "${"
+    void scan_template(Token& token) {
+        token.type = TokenType::Template;
+        while (pos_ < src_.size()) {
+            char c = src_[pos_];
+            if (c == '\\') {
+                pos_ += 2;
+            } else if (c == '`') {
+                ++pos_;
+                return;
+            } else if (c == '$' && pos_ + 1 < src_.size() && src_[pos_ + 1] == '{') {
+                pos_ += 2;
+                braces_.push_back('$');
+                return;
+            } else {
+                ++pos_;
+            }
+        }
+    }
+
+    bool regex_allowed() const {
+        switch (prev_.type) {
+            case TokenType::End:
+                return true;
+            case TokenType::Identifier:
+                return is_operator_keyword(prev_.text);
+            case TokenType::Number:
+            case TokenType::String:
+            case TokenType::Regex:
+                return false;
+            case TokenType::Template:
+                return prev_.text.size() >= 2 && prev_.text.substr(prev_.text.size() - 2) == "${";
+            case TokenType::Punctuator:
+                return !(prev_.text == ")" || prev_.text == "]");
+        }
+        return true;
+    }
+};
+
+// Value of a string literal token (or the text of an identifier)
+std::string token_value(const Token& token) {
+    if (token.type != TokenType::String || token.text.size() < 2) {
+        return std::string(token.text);
+    }
+    std::string_view body = token.text.substr(1, token.text.size() - 2);
+    std::string value;
+    value.reserve(body.size());
+    for (size_t i = 0; i < body.size(); ++i) {
+        if (body[i] != '\\' || i + 1 == body.size()) {
+            value.push_back(body[i]);
+            continue;
+        }
+        char escaped = body[++i];
+        switch (escaped) {
+            case 'n': value.push_back('\n'); break;
+            case 't': value.push_back('\t'); break;
+            case 'r': value.push_back('\r'); break;
+            case '0': value.push_back('\0'); break;
+            case 'x':
+                if (i + 2 < body.size() && std::isxdigit(static_cast<unsigned char>(body[i + 1])) &&
+                    std::isxdigit(static_cast<unsigned char>(body[i + 2]))) {
+                    value.push_back(static_cast<char>(std::stoi(std::string(body.substr(i + 1, 2)), nullptr, 16)));
+                    i += 2;
+                }
+                break;
+            default: value.push_back(escaped); break; // \\, \', \", and anything not worth decoding
+        }
+    }
+    return value;
+}
+
+bool ends_expression(const Token& token) {
+    switch (token.type) {
+        case TokenType::Identifier:
+            return !is_operator_keyword(token.text);
+        case TokenType::Number:
+        case TokenType::String:
+        case TokenType::Regex:
+            return true;
+        case TokenType::Template:
+            return token.text.back() == '`';
+        case TokenType::Punctuator:
+            return token.text == ")" || token.text == "]" || token.text == "}";
+        case TokenType::End:
+            return false;
+    }
+    return false;
+}
+
+bool starts_statement(const Token& token) {
+    return (token.type == TokenType::Identifier && !is_operator_keyword(token.text)) ||
+           token.type == TokenType::String || token.type == TokenType::Number;
+}
+
+// Skips an initializer or default value up to (not including) a ",", ";" or closing
+// bracket at the starting depth, or to where automatic semicolon insertion ends it
+void skip_expression(Lexer& lexer) {
+    const size_t depth = lexer.depth();
+    Token previous;
+    for (;;) {
+        Token token = lexer.peek();
+        if (token.type == TokenType::End) {
+            return;
+        }
+        if (lexer.depth() == depth) {
+            if (token.is(",") || token.is(";") || token.is(")") || token.is("]") || token.is("}")) {
+                return;
+            }
+            if (token.newline_before && ends_expression(previous) && starts_statement(token)) {
+                return;
+            }
+        }
+        previous = lexer.next();
+    }
+}
+
+// Skips to just after the bracket closing the one that was just consumed
+void skip_to_close(Lexer& lexer) {
+    const size_t depth = lexer.depth();
+    for (Token token = lexer.next(); token.type != TokenType::End; token = lexer.next()) {
+        if (lexer.depth() < depth) {
+            return;
+        }
+    }
+}
+
+// Names bound by a binding identifier or a destructuring pattern starting at token
+bool parse_binding(Lexer& lexer, const Token& token, std::vector<std::string>& names) {
+    if (token.type == TokenType::Identifier) {
+        names.emplace_back(token.text);
+        return true;
+    }
+    const bool object = token.is("{");
+    if (!object && !token.is("[")) {
+        return false;
+    }
+    const char* close = object ? "}" : "]";
+    for (;;) {
+        Token element = lexer.next();
+        if (element.is(close)) {
+            return true;
+        }
+        if (!object && element.is(",")) {
+            continue; // Array hole
+        }
+        if (element.is("...")) {
+            if (!parse_binding(lexer, lexer.next(), names)) {
+                return false;
+            }
+        } else if (object) {
+            if (element.is("[")) {
+                skip_to_close(lexer); // Computed key
+            } else if (element.type != TokenType::Identifier && element.type != TokenType::String &&
+                       element.type != TokenType::Number) {
+                return false;
+            }
+            if (lexer.peek().is(":")) {
+                lexer.next();
+                if (!parse_binding(lexer, lexer.next(), names)) {
+                    return false;
+                }
+            } else if (element.type == TokenType::Identifier) {
+                names.emplace_back(element.text); // Shorthand
+            } else {
+                return false;
+            }
+        } else if (!parse_binding(lexer, element, names)) {
+            return false;
+        }
+        if (lexer.peek().is("=")) {
+            lexer.next();
+            skip_expression(lexer);
+        }
+        Token separator = lexer.next();
+        if (separator.is(close)) {
+            return true;
+        }
+        if (!separator.is(",")) {
+            return false;
+        }
+    }
+}
+
+bool parse_declarations(Lexer& lexer, std::vector<std::string>& names) {
+    for (;;) {
+        if (!parse_binding(lexer, lexer.next(), names)) {
+            return false;
+        }
+        if (lexer.peek().is("=")) {
+            lexer.next();
+            skip_expression(lexer);
+        }
+        if (!lexer.peek().is(",")) {
+            return true;
+        }
+        lexer.next();
+    }
+}
+
+// Consumes `with {...}` / `assert {...}` and a ";" after a module specifier
+size_t finish_statement(Lexer& lexer, size_t end) {
+    Token next = lexer.peek();
+    if ((next.is("with") || next.is("assert")) && !next.newline_before) {
+        lexer.next();
+        if (lexer.next().is("{")) {
+            skip_to_close(lexer);
+        }
+        end = lexer.peek().begin;
+        next = lexer.peek();
+    }
+    if (next.is(";")) {
+        end = lexer.next().end;
+    }
+    return end;
+}
+
+// "{ a, b as c, "d" as e }" after the "{" was consumed
+bool parse_specifier_list(Lexer& lexer, std::vector<ModuleBinding>& bindings) {
+    for (Token token = lexer.next(); !token.is("}"); ) {
+        if (token.type != TokenType::Identifier && token.type != TokenType::String) {
+            return false;
+        }
+        ModuleBinding binding;
+        binding.imported = token_value(token);
+        binding.local = binding.imported;
+        token = lexer.next();
+        if (token.is("as")) {
+            binding.local = token_value(lexer.next());
+            token = lexer.next();
+        }
+        bindings.push_back(std::move(binding));
+        if (token.is(",")) {
+            token = lexer.next();
+        } else if (!token.is("}")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parse_import(Lexer& lexer, const Token& keyword, ModuleSyntax& syntax) {
+    ModuleStatement statement;
+    statement.kind = ModuleStatement::Kind::Import;
+    statement.begin = keyword.begin;
+
+    Token token = lexer.next();
+    if (token.type != TokenType::String) {
+        if (token.type == TokenType::Identifier) {
+            statement.bindings.push_back({"default", std::string(token.text)});
+            token = lexer.next();
+            if (token.is(",")) {
+                token = lexer.next();
+            }
+        }
+        if (token.is("*")) {
+            if (!lexer.next().is("as")) {
+                return false;
+            }
+            statement.bindings.push_back({"*", std::string(lexer.next().text)});
+            token = lexer.next();
+        } else if (token.is("{")) {
+            if (!parse_specifier_list(lexer, statement.bindings)) {
+                return false;
+            }
+            token = lexer.next();
+        }
+        if (!token.is("from")) {
+            return false;
+        }
+        token = lexer.next();
+        if (token.type != TokenType::String) {
+            return false;
+        }
+    }
+    statement.specifier = token_value(token);
+    statement.end = finish_statement(lexer, token.end);
+    syntax.statements.push_back(std::move(statement));
+    return true;
+}
+
+// Name declared by "function [*] name" / "class name" with the keyword next in lexer
+std::string declared_name(Lexer lexer) {
+    Token token = lexer.next();
+    if (token.is("async")) {
+        token = lexer.next();
+    }
+    if (token.is("function")) {
+        token = lexer.next();
+        if (token.is("*")) {
+            token = lexer.next();
+        }
+        return token.type == TokenType::Identifier ? std::string(token.text) : std::string();
+    }
+    if (token.is("class")) {
+        token = lexer.next();
+        return token.type == TokenType::Identifier && !token.is("extends") ? std::string(token.text) : std::string();
+    }
+    return std::string();
+}
+
+bool parse_export(Lexer& lexer, const Token& keyword, ModuleSyntax& syntax) {
+    ModuleStatement statement;
+    statement.begin = keyword.begin;
+
+    Token token = lexer.next();
+    if (token.is("default")) {
+        Token next = lexer.peek();
+        std::string name = next.is("function") || next.is("async") || next.is("class") ? declared_name(lexer) : "";
+        if (name.empty()) {
+            statement.kind = ModuleStatement::Kind::ExportDefaultExpression;
+        } else {
+            statement.kind = ModuleStatement::Kind::ExportDefaultDeclaration;
+            statement.names.push_back(name);
+        }
+        statement.end = token.end;
+    } else if (token.is("var") || token.is("let") || token.is("const")) {
+        statement.kind = ModuleStatement::Kind::ExportDeclaration;
+        statement.end = token.begin;
+        if (!parse_declarations(lexer, statement.names)) {
+            return false;
+        }
+    } else if (token.is("function") || token.is("async") || token.is("class")) {
+        statement.kind = ModuleStatement::Kind::ExportDeclaration;
+        statement.end = token.begin;
+        Lexer name_lexer = lexer;
+        if (token.is("async") && !name_lexer.next().is("function")) {
+            return false;
+        }
+        Token name = name_lexer.next();
+        if (name.is("*")) {
+            name = name_lexer.next();
+        }
+        if (name.type != TokenType::Identifier) {
+            return false;
+        }
+        statement.names.emplace_back(name.text);
+    } else if (token.is("{")) {
+        if (!parse_specifier_list(lexer, statement.bindings)) {
+            return false;
+        }
+        statement.end = token.end;
+        if (lexer.peek().is("from")) {
+            lexer.next();
+            Token specifier = lexer.next();
+            if (specifier.type != TokenType::String) {
+                return false;
+            }
+            statement.kind = ModuleStatement::Kind::ExportFrom;
+            statement.specifier = token_value(specifier);
+            statement.end = finish_statement(lexer, specifier.end);
+        } else {
+            statement.kind = ModuleStatement::Kind::ExportList;
+            statement.end = finish_statement(lexer, lexer.peek().begin);
+        }
+    } else if (token.is("*")) {
+        token = lexer.next();
+        statement.kind = ModuleStatement::Kind::ExportStar;
+        if (token.is("as")) {
+            statement.kind = ModuleStatement::Kind::ExportFrom;
+            statement.bindings.push_back({"*", token_value(lexer.next())});
+            token = lexer.next();
+        }
+        if (!token.is("from")) {
+            return false;
+        }
+        Token specifier = lexer.next();
+        if (specifier.type != TokenType::String) {
+            return false;
+        }
+        statement.specifier = token_value(specifier);
+        statement.end = finish_statement(lexer, specifier.end);
+    } else {
+        return false;
+    }
+    syntax.statements.push_back(std::move(statement));
+    return true;
+}
+
+std::string js_string(const std::string& value) {
+    std::string quoted = "\"";
+    for (char c : value) {
+        switch (c) {
+            case '"': quoted += "\\\""; break;
+            case '\\': quoted += "\\\\"; break;
+            case '\n': quoted += "\\n"; break;
+            case '\r': quoted += "\\r"; break;
+            case '\0': quoted += "\\0"; break;
+            default: quoted.push_back(c); break;
+        }
+    }
+    quoted.push_back('"');
+    return quoted;
+}
+
+std::string getter(const std::string& exported, const std::string& expression) {
+    return "Object.defineProperty(exports," + js_string(exported) +
+           ",{enumerable:true,get:function(){return " + expression + ";}});";
+}
+
+std::string member(const std::string& object, const std::string& name) {
+    return name == "*" ? object : object + "[" + js_string(name) + "]";
+}
+
+} // namespace
+
+std::vector<std::string> ModuleSyntax::static_specifiers() const {
+    std::vector<std::string> specifiers;
+    std::unordered_set<std::string> seen;
+    for (const ModuleStatement& statement : statements) {
+        if (!statement.specifier.empty() && seen.insert(statement.specifier).second) {
+            specifiers.push_back(statement.specifier);
+        }
+    }
+    return specifiers;
+}
+
+ModuleSyntax scan_module(std::string_view source) {
+    ModuleSyntax syntax;
+    // Most leaf modules have none of the keywords, and a substring search is far cheaper than lexing
+    if (source.find("import") == std::string_view::npos && source.find("export") == std::string_view::npos &&
+        source.find("require") == std::string_view::npos) {
+        return syntax;
+    }
+    Lexer lexer(source);
+    Token previous;
+    for (Token token = lexer.next(); token.type != TokenType::End; previous = token, token = lexer.next()) {
+        // Only the keywords matter, and not as property names (obj.import, x?.require)
+        if (token.type != TokenType::Identifier || (token.text[0] != 'i' && token.text[0] != 'e' && token.text[0] != 'r') ||
+            previous.is(".") || previous.is("?.")) {
+            continue;
+        }
+        const bool top_level = lexer.depth() == 0;
+        if (token.text == "import") {
+            Token next = lexer.peek();
+            if (next.is("(")) {
+                syntax.dynamic_imports.push_back(token.begin);
+            } else if (next.is(".")) {
+                if (source.compare(token.begin, 11, "import.meta") == 0) {
+                    syntax.import_metas.push_back(token.begin);
+                }
+            } else if (top_level) {
+                parse_import(lexer, token, syntax);
+            }
+        } else if (token.text == "export" && top_level) {
+            parse_export(lexer, token, syntax);
+        } else if (token.text == "require") {
+            Lexer call = lexer;
+            if (call.next().is("(")) {
+                Token argument = call.next();
+                if (argument.type == TokenType::String && call.next().is(")")) {
+                    std::string specifier = token_value(argument);
+                    if (std::find(syntax.required_specifiers.begin(), syntax.required_specifiers.end(), specifier) ==
+                        syntax.required_specifiers.end()) {
+                        syntax.required_specifiers.push_back(std::move(specifier));
+                    }
+                }
+            }
+        }
+    }
+    return syntax;
+}
+
+std::string transform_to_commonjs(std::string_view source, const ModuleSyntax& syntax) {
+    struct Edit {
+        size_t begin;
+        size_t end;
+        std::string text;
+    };
+    std::vector<Edit> edits;
+    std::string exports_prologue;
+    std::string imports_prologue;
+    size_t module_count = 0;
+
+    for (const ModuleStatement& statement : syntax.statements) {
+        using Kind = ModuleStatement::Kind;
+        std::string module;
+        if (!statement.specifier.empty()) {
+            module = "__jpm_m" + std::to_string(module_count++);
+            imports_prologue += "const " + module + "=__jpm_import(" + js_string(statement.specifier) + ");";
+        }
+        switch (statement.kind) {
+            case Kind::Import:
+                for (const ModuleBinding& binding : statement.bindings) {
+                    imports_prologue += "const " + binding.local + "=" + member(module, binding.imported) + ";";
+                }
+                edits.push_back({statement.begin, statement.end, ""});
+                break;
+            case Kind::ExportDeclaration:
+                for (const std::string& name : statement.names) {
+                    exports_prologue += getter(name, name);
+                }
+                edits.push_back({statement.begin, statement.end, ""});
+                break;
+            case Kind::ExportDefaultDeclaration:
+                exports_prologue += getter("default", statement.names.front());
+                edits.push_back({statement.begin, statement.end, ""});
+                break;
+            case Kind::ExportDefaultExpression:
+                exports_prologue += getter("default", "__jpm_default");
+                edits.push_back({statement.begin, statement.end, "__jpm_default ="});
+                break;
+            case Kind::ExportList:
+                for (const ModuleBinding& binding : statement.bindings) {
+                    exports_prologue += getter(binding.local, binding.imported);
+                }
+                edits.push_back({statement.begin, statement.end, ""});
+                break;
+            case Kind::ExportFrom:
+                for (const ModuleBinding& binding : statement.bindings) {
+                    imports_prologue += getter(binding.local, member(module, binding.imported));
+                }
+                edits.push_back({statement.begin, statement.end, ""});
+                break;
+            case Kind::ExportStar:
+                imports_prologue += "for(const k in " + module + ")if(k!==\"default\"&&!Object.prototype.hasOwnProperty.call(exports,k))"
+                                    "Object.defineProperty(exports,k,{enumerable:true,get:function(){return " + module + "[k];}});";
+                edits.push_back({statement.begin, statement.end, ""});
+                break;
+        }
+    }
+    for (size_t offset : syntax.dynamic_imports) {
+        edits.push_back({offset, offset + 6, "__jpm_dynamic_import"});
+    }
+    for (size_t offset : syntax.import_metas) {
+        edits.push_back({offset, offset + 11, "__jpm_meta"});
+    }
+    std::sort(edits.begin(), edits.end(), [](const Edit& a, const Edit& b) { return a.begin < b.begin; });
+
+    std::string output;
+    output.reserve(source.size() + exports_prologue.size() + imports_prologue.size() + 128);
+    if (syntax.has_module_syntax()) {
+        // Exports are defined before any dependency runs, so cycles see the getters
+        output += "\"use strict\";var __jpm_default;Object.defineProperty(exports,\"__esModule\",{value:true});";
+        output += exports_prologue;
+        output += imports_prologue;
+    }
+    size_t position = 0;
+    for (const Edit& edit : edits) {
+        if (edit.begin < position) {
+            continue; // Inside an edit already made
+        }
+        output.append(source.substr(position, edit.begin - position));
+        output += edit.text;
+        // Removed statements keep their line breaks so line numbers do not move
+        std::string_view removed = source.substr(edit.begin, edit.end - edit.begin);
+        output.append(static_cast<size_t>(std::count(removed.begin(), removed.end(), '\n')), '\n');
+        position = edit.end;
+    }
+    output.append(source.substr(position));
+    return output;
+}
+
+} // namespace jpm::js
@@ -0,0 +1,67 @@
+#ifndef JPM_IMPORT_SCANNER_H
+#define JPM_IMPORT_SCANNER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jpm::js {
+
+// One name bound by an import or export statement
+struct ModuleBinding {
+    std::string imported; // Name in the other module; "default", or "*" for the namespace
+    std::string local;    // Name in this module (for exports: the exported name)
+};
+
+// A top-level import or export statement, as found by scan_module()
+struct ModuleStatement {
+    enum class Kind {
+        Import,                   // import x, {a as b}, * as ns from "spec" / import "spec"
+        ExportDeclaration,        // export var|let|const|function|class ...
+        ExportDefaultDeclaration, // export default function f() {} / class C {}
+        ExportDefaultExpression,  // export default <expression>
+        ExportList,               // export {a, b as c}
+        ExportFrom,               // export {a as b} from "spec" / export * as ns from "spec"
+        ExportStar                // export * from "spec"
+    };
+
+    Kind kind = Kind::Import;
+    size_t begin = 0;       // Offset of "export" / "import"
+    size_t end = 0;         // End of the statement, or of the export keywords for declarations
+    std::string specifier;  // Import, ExportFrom, ExportStar
+    std::vector<ModuleBinding> bindings; // Import, ExportList, ExportFrom (local = exported name)
+    std::vector<std::string> names;      // Names declared by ExportDeclaration / ExportDefaultDeclaration
+};
+
+// Module syntax of one source file, found by a lexer-level scan (comments, strings,
+// template literals and regular expressions are skipped; nothing is parsed fully)
+struct ModuleSyntax {
+    std::vector<ModuleStatement> statements;
+    std::vector<size_t> dynamic_imports; // Offsets of "import" in import(...)
+    std::vector<size_t> import_metas;    // Offsets of "import.meta"
+    // Specifiers of require("...") calls with a string literal argument, anywhere in
+    // the file, without duplicates. Some may never run (conditional or shadowed requires).
+    std::vector<std::string> required_specifiers;
+
+    // True if the file uses static import/export, i.e. it is an ES module
+    bool has_module_syntax() const { return !statements.empty(); }
+    // True if the file needs transform_to_commonjs() before it can run
+    bool needs_transform() const { return !statements.empty() || !dynamic_imports.empty() || !import_metas.empty(); }
+    // Specifiers of static imports and re-exports, in source order, without duplicates
+    std::vector<std::string> static_specifiers() const;
+};
+
+ModuleSyntax scan_module(std::string_view source);
+
+// Rewrites an ES module into a function body that runs under the CommonJS loader with
+// the extra parameters __jpm_import (namespace of a dependency), __jpm_dynamic_import
+// (import()) and __jpm_meta (import.meta). Imports are hoisted into a prologue that is
+// kept on the first line, so line numbers are unchanged. Exports become enumerable
+// getters on exports, so importers always read the current value; imported bindings
+// are read once, when the prologue runs.
+std::string transform_to_commonjs(std::string_view source, const ModuleSyntax& syntax);
+
+} // namespace jpm::js
+
+#endif // JPM_IMPORT_SCANNER_H
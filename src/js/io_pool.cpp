@@ -0,0 +1,68 @@
+#include "js/io_pool.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace jpm::js {
+
+namespace {
+
+constexpr size_t kDefaultThreadCount = 4;
+constexpr size_t kMaxThreadCount = 128;
+
+size_t configured_thread_count() {
+    const char* value = std::getenv("JPM_THREADPOOL_SIZE");
+    if (value && *value) {
+        long count = std::strtol(value, nullptr, 10);
+        if (count >= 1) {
+            return std::min(static_cast<size_t>(count), kMaxThreadCount);
+        }
+    }
+    return kDefaultThreadCount;
+}
+
+} // namespace
+
+IoPool::IoPool(EventLoop& loop) : loop_(loop), thread_count_(configured_thread_count()) {}
+
+IoPool::~IoPool() {
+    shutdown();
+}
+
+void IoPool::submit(std::function<void()> work, EventLoop::Callback done) {
+    if (!pool_) {
+        cancelled_ = false;
+        pool_ = std::make_unique<ThreadPool>(thread_count_);
+    }
+    const uint64_t id = next_id_++;
+    pending_.emplace(id, std::move(done));
+    loop_.add_ref();
+    pool_->submit([this, id, work = std::move(work)]() {
+        if (cancelled_) {
+            return;
+        }
+        work();
+        loop_.post([this, id]() { complete(id); });
+    });
+}
+
+void IoPool::complete(uint64_t id) {
+    auto it = pending_.find(id);
+    if (it == pending_.end()) {
+        return; // Dropped by shutdown()
+    }
+    EventLoop::Callback done = std::move(it->second);
+    pending_.erase(it);
+    loop_.remove_ref();
+    done();
+}
+
+void IoPool::shutdown() {
+    cancelled_ = true;
+    pool_.reset(); // Queued jobs return at once; running ones finish first
+    for (size_t i = pending_.size(); i > 0; --i) {
+        loop_.remove_ref();
+    }
+    pending_.clear();
+}
+
+} // namespace jpm::js
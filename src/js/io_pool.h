@@ -0,0 +1,57 @@
+#ifndef JPM_IO_POOL_H
+#define JPM_IO_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include "js/event_loop.h"
+#include "utils/thread_pool.h"
+
+namespace jpm::js {
+
+// Runs blocking calls (file system operations) on a small fixed set of threads
+// and hands each completion back to the event loop, like libuv's threadpool. The
+// pool has 4 threads, or JPM_THREADPOOL_SIZE (1-128), and starts them on first use.
+class IoPool {
+public:
+    static IoPool& getInstance() {
+        static IoPool instance(EventLoop::getInstance());
+        return instance;
+    }
+
+    explicit IoPool(EventLoop& loop);
+    ~IoPool();
+    IoPool(const IoPool&) = delete;
+    IoPool& operator=(const IoPool&) = delete;
+
+    // Runs work on a pool thread, then done on the loop thread; the loop stays alive
+    // until done has run. Loop thread only.
+    // done (and whatever it owns, such as protected JS values) is only ever run or
+    // destroyed on the loop thread. work may be destroyed on a pool thread without
+    // running, so it should only borrow from done.
+    void submit(std::function<void()> work, EventLoop::Callback done);
+
+    // Skips queued work, waits for the calls in progress and drops the completions
+    // that have not run. Call before the JS context the completions refer to is released.
+    void shutdown();
+
+    size_t thread_count() const { return thread_count_; }
+    size_t pending() const { return pending_.size(); }
+
+private:
+    void complete(uint64_t id);
+
+    EventLoop& loop_;
+    size_t thread_count_;
+    std::atomic<bool> cancelled_{false};
+    uint64_t next_id_ = 1;
+    std::unordered_map<uint64_t, EventLoop::Callback> pending_; // Completions by id, loop thread only
+    std::unique_ptr<ThreadPool> pool_;
+};
+
+} // namespace jpm::js
+
+#endif // JPM_IO_POOL_H
@@ -3,6 +3,17 @@
 #ifdef USE_JAVASCRIPTCORE
 #include <JavaScriptCore/JavaScript.h>
 #include "js/module.h"
+#include "js/source_loader.h"
+#include "js/import_scanner.h"
+#include "js/event_loop.h"
+#include "js/timers.h"
+#include "js/buffer.h"
+#include "js/console.h"
+#include "js/fs.h"
+#include "js/readline.h"
+#include "js/io_pool.h"
+#include "js/output_stream.h"
+#include "js/stdin_reader.h"
 #include "js/process/argv.h"
 #include "js/process/exit.h"
 #include "js/process/stdout.h"
@@ -13,12 +24,12 @@
 #include "js/process/events.h"
 #endif
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <string>
 #include <vector>
+#include <memory>
 #include <cstring>
 #include <cstdlib>
+#include <filesystem>
 
 namespace jpm {
 
@@ -34,70 +45,44 @@ JSCommand::JSCommand() {
 #endif
 }
 
-void JSCommand::execute(const std::vector<std::string>& args) {
+int JSCommand::execute(const std::vector<std::string>& args) {
 #ifdef USE_JAVASCRIPTCORE
     if (args.empty()) {
         std::cerr << "No JavaScript file specified." << std::endl;
-        return;
+        return 1;
     }
-    execute_js_file(args[0]);
+    return execute_js_file(args[0], std::vector<std::string>(args.begin() + 1, args.end()));
 #else
     std::cerr << "Error: JavaScriptCore support is not enabled in this build." << std::endl;
+    return 1;
 #endif
 }
 
 #ifdef USE_JAVASCRIPTCORE
-void JSCommand::execute_js_file(const std::string& file_path) {
-    std::ifstream file(file_path);
-    if (!file.is_open()) {
+int JSCommand::execute_js_file(const std::string& file_path, const std::vector<std::string>& script_args) {
+    std::unique_ptr<js::SourceFile> source = js::SourceFile::open(file_path);
+    if (!source) {
         std::cerr << "Error: Could not open file " << file_path << std::endl;
-        return;
+        return 1;
     }
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string js_code = buffer.str();
-    if (js_code.empty()) {
+    if (source->text().empty()) {
         std::cerr << "Warning: JavaScript file is empty: " << file_path << std::endl;
-        return;
+        return 0;
     }
 
     JSGlobalContextRef ctx = JSGlobalContextCreate(nullptr);
     if (!ctx) {
         std::cerr << "Failed to create JavaScript context" << std::endl;
-        return;
+        return 1;
     }
 
     JSObjectRef globalObject = JSContextGetGlobalObject(ctx);
 
-    {
-        JSObjectRef consoleObj = JSObjectMake(ctx, nullptr, nullptr);
-        JSStringRef logName = JSStringCreateWithUTF8CString("log");
-        JSObjectRef logFunction = JSObjectMakeFunctionWithCallback(ctx, logName,
-            [](JSContextRef ctxInner, JSObjectRef, JSObjectRef,
-               size_t argumentCount, const JSValueRef arguments[], JSValueRef*) -> JSValueRef {
-                for (size_t i = 0; i < argumentCount; ++i) {
-                    JSStringRef strRef = JSValueToStringCopy(ctxInner, arguments[i], nullptr);
-                    size_t maxSize = JSStringGetMaximumUTF8CStringSize(strRef);
-                    std::string s(maxSize, '\0');
-                    JSStringGetUTF8CString(strRef, &s[0], maxSize);
-                    s.resize(strlen(s.c_str()));
-                    std::cout << s;
-                    if (i + 1 < argumentCount) std::cout << " ";
-                    JSStringRelease(strRef);
-                }
-                std::cout << std::endl;
-                return JSValueMakeUndefined(ctxInner);
-            });
-        JSObjectSetProperty(ctx, consoleObj, logName, logFunction, kJSPropertyAttributeNone, nullptr);
-        JSStringRelease(logName);
-        JSStringRef consoleName = JSStringCreateWithUTF8CString("console");
-        JSObjectSetProperty(ctx, globalObject, consoleName, consoleObj, kJSPropertyAttributeNone, nullptr);
-        JSStringRelease(consoleName);
-    }
+    js::setup_console(ctx, globalObject);
 
     JSObjectRef processObj = JSObjectMake(ctx, nullptr, nullptr);
 
-    js::process::setup_argv(ctx, processObj, file_path);
+    js::process::setup_argv(ctx, processObj, file_path, script_args);
     js::process::setup_exit(ctx, processObj);
     js::process::setup_stdout(ctx, processObj);
     js::process::setup_stderr(ctx, processObj);
@@ -113,6 +98,10 @@ void JSCommand::execute_js_file(const std::string& file_path) {
 
     // Initialize module system and register process as a built-in module
     js::setup_module_system(ctx, globalObject);
+    js::setup_timers(ctx, globalObject);
+    js::setup_buffer(ctx, globalObject);
+    js::setup_fs(ctx);
+    js::setup_readline(ctx);
 
     // Create the global events object for process events
     JSObjectRef eventsObj = JSObjectMake(ctx, nullptr, nullptr);
@@ -142,35 +131,53 @@ void JSCommand::execute_js_file(const std::string& file_path) {
 
     js::ModuleSystem::getInstance().registerBuiltinModule("process", processObj);
     js::ModuleSystem::getInstance().registerBuiltinModule("events", eventsObj);
+    js::ModuleSystem::getInstance().setMainScript(file_path);
 
-    JSStringRef script = JSStringCreateWithUTF8CString(js_code.c_str());
+    // An ES module entry point runs through the module loader; JSC's C API can only
+    // evaluate classic scripts
+    const std::string extension = std::filesystem::path(file_path).extension().string();
+    js::ModuleSyntax syntax = js::scan_module(source->text());
+    const bool is_module = extension == ".mjs" || (extension != ".cjs" && syntax.has_module_syntax());
     JSValueRef exception = nullptr;
-    JSValueRef result = JSEvaluateScript(ctx, script, nullptr, nullptr, 1, &exception);
-    JSStringRelease(script);
+    if (is_module) {
+        source.reset();
+        js::ModuleSystem::getInstance().runMainModule(ctx, file_path, &exception);
+    } else {
+        js::ModuleSystem::getInstance().readAheadMain(syntax.required_specifiers);
+        JSStringRef script = js::create_source_string(*source);
+        source.reset(); // JSC has its own copy, or adopted ours; the mapping is no longer needed
+        JSStringRef sourceURL = JSStringCreateWithUTF8CString(file_path.c_str());
+        JSEvaluateScript(ctx, script, nullptr, sourceURL, 1, &exception);
+        JSStringRelease(sourceURL);
+        JSStringRelease(script);
+    }
 
     if (exception) {
-        JSStringRef exceptionString = JSValueToStringCopy(ctx, exception, nullptr);
-        size_t maxSize = JSStringGetMaximumUTF8CStringSize(exceptionString);
-        std::string buf(maxSize, '\0');
-        JSStringGetUTF8CString(exceptionString, &buf[0], maxSize);
-        buf.resize(strlen(buf.c_str()));
-        std::cerr << "JavaScript Error: " << buf << std::endl;
-        JSStringRelease(exceptionString);
-
-        JSStringRef errorStr = JSStringCreateWithUTF8CString(buf.c_str());
-        JSValueRef errorValue = JSValueMakeString(ctx, errorStr);
-        std::vector<JSValueRef> args = {errorValue};
-        js::process::ProcessEventEmitter::getInstance().emit("uncaughtException", ctx, args);
-        JSStringRelease(errorStr);
-
-        std::vector<JSValueRef> exitArgs = {JSValueMakeNumber(ctx, 0)};
-        js::process::ProcessEventEmitter::getInstance().emit("exit", ctx, exitArgs);
+        js::process::handle_uncaught_exception(ctx, exception);
+    }
 
-        JSGlobalContextRelease(ctx);
-        return;
+    // Timers, immediates and I/O callbacks run until nothing is pending, then the process exits.
+    // Output buffered by then goes out before the loop sleeps.
+    js::EventLoop& loop = js::EventLoop::getInstance();
+    loop.set_before_wait(js::OutputStream::flush_all);
+    if (!loop.stopped()) {
+        loop.run();
+    }
+    if (!loop.stopped()) {
+        std::vector<JSValueRef> exitArgs = {JSValueMakeNumber(ctx, js::process::exit_status(ctx, processObj))};
+        js::process::ProcessEventEmitter::getInstance().emit("exit", ctx, exitArgs);
     }
+    // 'exit' listeners may still set process.exitCode
+    const int status = js::process::exit_status(ctx, processObj);
+    // fs calls still running on the I/O threads hold JS values; finish them while the context exists
+    js::IoPool::getInstance().shutdown();
+    js::StdinReader::getInstance().shutdown();
+    loop.clear();
+    js::process::ProcessEventEmitter::getInstance().removeAllListeners();
+    js::OutputStream::flush_all();
 
     JSGlobalContextRelease(ctx);
+    return status;
 }
 #endif // USE_JAVASCRIPTCORE
 
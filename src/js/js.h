@@ -9,10 +9,13 @@ namespace jpm {
 class JSCommand {
 public:
     JSCommand();
-    void execute(const std::vector<std::string>& args);
+    // args[0] is the script; the rest become process.argv[2...]. Returns the script's
+    // exit status: 1 after an uncaught exception or when it cannot run, otherwise
+    // process.exitCode (0 unless the script set it). process.exit() ends jpm itself.
+    int execute(const std::vector<std::string>& args);
 
 private:
-    void execute_js_file(const std::string& file_path);
+    int execute_js_file(const std::string& file_path, const std::vector<std::string>& script_args);
 };
 
 } // namespace jpm
@@ -1,195 +1,377 @@
 #include "js/module.h"
 #include "js/process/events.h"
+#include "js/source_loader.h"
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <filesystem>
+#include <cstdlib>
 #include <cstring>
+#include <thread>
 
 namespace jpm::js {
 
 namespace fs = std::filesystem;
 
+namespace {
+
+// Private data of a require function
+struct RequireData {
+    fs::path directory;
+};
+
+// The last three are only passed to modules that transform_to_commonjs() rewrote
+constexpr const char* kModuleParameters[] = {"exports", "require", "module", "__filename", "__dirname",
+                                             "__jpm_import", "__jpm_dynamic_import", "__jpm_meta"};
+constexpr unsigned kModuleParameterCount = 8;
+
+// Wraps a module's __jpm_import so that import() returns a promise, rejected if loading throws
+constexpr const char* kDynamicImportFactory =
+    "(function (load) { return function (specifier) {"
+    " return new Promise(function (resolve) { resolve(load(String(specifier))); }); }; })";
+
+std::string to_utf8(JSContextRef ctx, JSValueRef value) {
+    JSStringRef str = JSValueToStringCopy(ctx, value, nullptr);
+    if (!str) {
+        return std::string();
+    }
+    size_t bufSize = JSStringGetMaximumUTF8CStringSize(str);
+    std::string result(bufSize, '\0');
+    result.resize(JSStringGetUTF8CString(str, &result[0], bufSize) - 1);
+    JSStringRelease(str);
+    return result;
+}
+
+JSValueRef make_string(JSContextRef ctx, const std::string& text) {
+    JSStringRef str = JSStringCreateWithUTF8CString(text.c_str());
+    JSValueRef value = JSValueMakeString(ctx, str);
+    JSStringRelease(str);
+    return value;
+}
+
+JSObjectRef make_error(JSContextRef ctx, const std::string& message) {
+    JSValueRef argument = make_string(ctx, message);
+    return JSObjectMakeError(ctx, 1, &argument, nullptr);
+}
+
+void set_property(JSContextRef ctx, JSObjectRef object, const char* name, JSValueRef value,
+                  JSPropertyAttributes attributes = kJSPropertyAttributeNone) {
+    JSStringRef key = JSStringCreateWithUTF8CString(name);
+    JSObjectSetProperty(ctx, object, key, value, attributes, nullptr);
+    JSStringRelease(key);
+}
+
+JSValueRef get_property(JSContextRef ctx, JSObjectRef object, const char* name) {
+    JSStringRef key = JSStringCreateWithUTF8CString(name);
+    JSValueRef value = JSObjectGetProperty(ctx, object, key, nullptr);
+    JSStringRelease(key);
+    return value;
+}
+
+bool is_json_file(const std::string& filePath) {
+    return filePath.size() >= 5 && filePath.compare(filePath.size() - 5, 5, ".json") == 0;
+}
+
+JSValueRef call_require(JSContextRef ctx, JSObjectRef function, JSObjectRef,
+                        size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) {
+    if (argumentCount < 1 || !JSValueIsString(ctx, arguments[0])) {
+        *exception = make_error(ctx, "require() requires a module name");
+        return JSValueMakeUndefined(ctx);
+    }
+    auto* data = static_cast<RequireData*>(JSObjectGetPrivate(function));
+    JSValueRef exports = ModuleSystem::getInstance().require(ctx, data->directory, to_utf8(ctx, arguments[0]), exception);
+    return exports ? exports : JSValueMakeUndefined(ctx);
+}
+
+JSValueRef call_import(JSContextRef ctx, JSObjectRef function, JSObjectRef,
+                       size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) {
+    if (argumentCount < 1 || !JSValueIsString(ctx, arguments[0])) {
+        *exception = make_error(ctx, "import requires a module specifier");
+        return JSValueMakeUndefined(ctx);
+    }
+    auto* data = static_cast<RequireData*>(JSObjectGetPrivate(function));
+    JSValueRef ns = ModuleSystem::getInstance().importModule(ctx, data->directory, to_utf8(ctx, arguments[0]), exception);
+    return ns ? ns : JSValueMakeUndefined(ctx);
+}
+
+void finalize_require(JSObjectRef object) {
+    delete static_cast<RequireData*>(JSObjectGetPrivate(object));
+}
+
+} // namespace
+
 void ModuleSystem::init(JSContextRef ctx, JSObjectRef globalObject) {
     context = ctx;
     globalObj = globalObject;
     workingDir = fs::current_path();
+    resolver = std::make_unique<ModuleResolver>(workingDir);
+    // Reading ahead competes with the script for the only core on a single-CPU machine
+    const char* noReadAhead = std::getenv("JPM_NO_READAHEAD");
+    readAhead = std::thread::hardware_concurrency() > 1 &&
+                !(noReadAhead && *noReadAhead && std::strcmp(noReadAhead, "0") != 0);
+
+    if (!requireClass) {
+        JSClassDefinition definition = kJSClassDefinitionEmpty;
+        definition.className = "require";
+        definition.callAsFunction = call_require;
+        definition.finalize = finalize_require;
+        requireClass = JSClassCreate(&definition);
+
+        definition.className = "import";
+        definition.callAsFunction = call_import;
+        importClass = JSClassCreate(&definition);
+    }
     setup_require(ctx, globalObject);
+
+    JSStringRef factorySource = JSStringCreateWithUTF8CString(kDynamicImportFactory);
+    JSValueRef factory = JSEvaluateScript(ctx, factorySource, nullptr, nullptr, 1, nullptr);
+    JSStringRelease(factorySource);
+    if (factory && JSValueIsObject(ctx, factory)) {
+        dynamicImportFactory = JSValueToObject(ctx, factory, nullptr);
+        JSValueProtect(ctx, dynamicImportFactory);
+    }
 }
 
 void ModuleSystem::setup_require(JSContextRef ctx, JSObjectRef globalObject) {
-    JSStringRef requireName = JSStringCreateWithUTF8CString("require");
-
-    // Create the require function
-    JSObjectRef requireFunc = JSObjectMakeFunctionWithCallback(ctx, requireName,
-        [](JSContextRef ctxInner, JSObjectRef function, JSObjectRef thisObject,
+    // Shared prototype of every require function: Function.prototype plus require.resolve
+    requirePrototype = JSObjectMake(ctx, nullptr, nullptr);
+    JSValueRef functionCtor = get_property(ctx, globalObject, "Function");
+    if (JSValueIsObject(ctx, functionCtor)) {
+        JSObjectSetPrototype(ctx, requirePrototype,
+                             get_property(ctx, JSValueToObject(ctx, functionCtor, nullptr), "prototype"));
+    }
+    JSStringRef resolveName = JSStringCreateWithUTF8CString("resolve");
+    JSObjectRef resolveFunc = JSObjectMakeFunctionWithCallback(ctx, resolveName,
+        [](JSContextRef ctxInner, JSObjectRef, JSObjectRef thisObject,
            size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) -> JSValueRef {
-            if (argumentCount < 1) {
-                *exception = JSValueMakeString(ctxInner,
-                    JSStringCreateWithUTF8CString("require() requires a module name"));
+            ModuleSystem& modules = ModuleSystem::getInstance();
+            if (!JSValueIsObjectOfClass(ctxInner, thisObject, modules.requireClass) ||
+                argumentCount < 1 || !JSValueIsString(ctxInner, arguments[0])) {
+                *exception = make_error(ctxInner, "require.resolve() requires a module name");
                 return JSValueMakeUndefined(ctxInner);
             }
-
-            JSStringRef modulePathStr = JSValueToStringCopy(ctxInner, arguments[0], nullptr);
-            size_t bufSize = JSStringGetMaximumUTF8CStringSize(modulePathStr);
-            std::string modulePath(bufSize, '\0');
-            JSStringGetUTF8CString(modulePathStr, &modulePath[0], bufSize);
-            modulePath.resize(strlen(modulePath.c_str()));
-            JSStringRelease(modulePathStr);
-
-            return ModuleSystem::getInstance().require(ctxInner, modulePath);
+            auto* data = static_cast<RequireData*>(JSObjectGetPrivate(thisObject));
+            std::string request = to_utf8(ctxInner, arguments[0]);
+            if (modules.isBuiltinModule(request)) {
+                return arguments[0];
+            }
+            const std::string* resolved = modules.resolver->resolve(data->directory, request);
+            if (!resolved) {
+                *exception = make_error(ctxInner, "Cannot find module '" + request + "' from '" + data->directory.string() + "'");
+                return JSValueMakeUndefined(ctxInner);
+            }
+            return make_string(ctxInner, *resolved);
         });
+    JSObjectSetProperty(ctx, requirePrototype, resolveName, resolveFunc, kJSPropertyAttributeDontEnum, nullptr);
+    JSStringRelease(resolveName);
+    JSValueProtect(ctx, requirePrototype);
 
     // Set require in global scope
-    JSObjectSetProperty(ctx, globalObject, requireName, requireFunc,
-        kJSPropertyAttributeNone, nullptr);
-    JSStringRelease(requireName);
+    globalRequire = makeRequire(ctx, workingDir);
+    set_property(ctx, globalObject, "require", globalRequire);
 }
 
-JSObjectRef ModuleSystem::require(JSContextRef ctx, const std::string& modulePath) {
-    // Check if module is already cached
-    if (moduleCache.find(modulePath) != moduleCache.end()) {
-        return moduleCache[modulePath];
+void ModuleSystem::setMainScript(const std::string& filePath) {
+    if (globalRequire) {
+        std::error_code ec;
+        fs::path absolute = fs::absolute(filePath, ec);
+        static_cast<RequireData*>(JSObjectGetPrivate(globalRequire))->directory =
+            (ec ? fs::path(filePath) : absolute).lexically_normal().parent_path();
     }
+}
 
+JSObjectRef ModuleSystem::makeRequire(JSContextRef ctx, const fs::path& directory) {
+    JSObjectRef requireFunc = JSObjectMake(ctx, requireClass, new RequireData{directory});
+    JSObjectSetPrototype(ctx, requireFunc, requirePrototype);
+    return requireFunc;
+}
+
+JSValueRef ModuleSystem::require(JSContextRef ctx, const fs::path& fromDir,
+                                 const std::string& request, JSValueRef* exception) {
     // Check if it's a built-in module first
-    if (isBuiltinModule(modulePath)) {
-        return loadBuiltinModule(ctx, modulePath);
+    if (isBuiltinModule(request)) {
+        return loadBuiltinModule(ctx, request);
     }
 
     // Resolve the full module path
-    std::string resolvedPath = resolveModulePath(modulePath);
-    if (resolvedPath.empty()) {
-        JSStringRef errorMsg = JSStringCreateWithUTF8CString(
-            ("Module not found: " + modulePath).c_str());
-        throw std::runtime_error(
-            "Module not found: " + modulePath);
+    const std::string* resolvedPath = resolver->resolve(fromDir, request);
+    if (!resolvedPath) {
+        *exception = make_error(ctx, "Cannot find module '" + request + "' from '" + fromDir.string() + "'");
+        return nullptr;
     }
 
-    return loadNodeModule(ctx, resolvedPath);
-}
+    // Check if module is already cached
+    auto cached = moduleCache.find(*resolvedPath);
+    if (cached != moduleCache.end()) {
+        return get_property(ctx, cached->second, "exports");
+    }
 
-bool ModuleSystem::isBuiltinModule(const std::string& moduleName) const {
-    return builtinModules.find(moduleName) != builtinModules.end();
+    return loadNodeModule(ctx, *resolvedPath, exception);
 }
 
-void ModuleSystem::registerBuiltinModule(const std::string& name, JSObjectRef module) {
-    builtinModules[name] = module;
+JSValueRef ModuleSystem::importModule(JSContextRef ctx, const fs::path& fromDir,
+                                      const std::string& request, JSValueRef* exception) {
+    JSValueRef exports = require(ctx, fromDir, request, exception);
+    if (!exports) {
+        return nullptr;
+    }
+    if (JSValueIsObject(ctx, exports)) {
+        JSObjectRef object = JSValueToObject(ctx, exports, nullptr);
+        if (JSValueToBoolean(ctx, get_property(ctx, object, "__esModule"))) {
+            return exports;
+        }
+    }
+    // CommonJS interop: named imports read module.exports' properties through the prototype
+    JSObjectRef ns = JSObjectMake(ctx, nullptr, nullptr);
+    if (JSValueIsObject(ctx, exports)) {
+        JSObjectSetPrototype(ctx, ns, exports);
+    }
+    set_property(ctx, ns, "default", exports);
+    return ns;
 }
 
-JSObjectRef ModuleSystem::loadBuiltinModule(JSContextRef ctx, const std::string& moduleName) {
-    return builtinModules[moduleName];
+JSValueRef ModuleSystem::runMainModule(JSContextRef ctx, const std::string& filePath, JSValueRef* exception) {
+    std::error_code ec;
+    fs::path canonical = fs::canonical(filePath, ec);
+    std::string path = ec ? fs::absolute(filePath).lexically_normal().string() : canonical.string();
+    if (readAhead) {
+        getPrefetcher().prefetch(path);
+    }
+    return loadNodeModule(ctx, path, exception);
 }
 
-std::string ModuleSystem::resolveModulePath(const std::string& requestedModule) {
-    // If it starts with ./ or ../, resolve relative to current directory
-    if (requestedModule.substr(0, 2) == "./" || requestedModule.substr(0, 3) == "../") {
-        fs::path fullPath = workingDir / requestedModule;
-        if (fs::exists(fullPath)) {
-            return fullPath.string();
+void ModuleSystem::readAheadMain(const std::vector<std::string>& requests) {
+    if (!readAhead || !globalRequire || requests.empty()) {
+        return;
+    }
+    const fs::path& directory = static_cast<RequireData*>(JSObjectGetPrivate(globalRequire))->directory;
+    for (const std::string& request : requests) {
+        if (isBuiltinModule(request)) {
+            continue;
         }
-        // Try with .js extension
-        fullPath += ".js";
-        if (fs::exists(fullPath)) {
-            return fullPath.string();
+        if (const std::string* resolved = resolver->resolve(directory, request)) {
+            getPrefetcher().prefetch(*resolved);
         }
-    } else {
-        // Look in node_modules
-        return findPackageInNodeModules(requestedModule);
     }
-    return "";
 }
 
-std::string ModuleSystem::findPackageInNodeModules(const std::string& packageName) {
-    fs::path currentDir = workingDir;
-
-    while (true) {
-        fs::path nodeModulesDir = currentDir / "node_modules";
-        fs::path packageDir = nodeModulesDir / packageName;
-
-        // Check if package directory exists
-        if (fs::exists(packageDir)) {
-            // Look for package.json
-            fs::path packageJson = packageDir / "package.json";
-            if (fs::exists(packageJson)) {
-                std::string content = readFile(packageJson.string());
-                // Very basic package.json parsing - in real implementation, use proper JSON parser
-                if (content.find("\"main\"") != std::string::npos) {
-                    size_t start = content.find("\"main\"") + 7;
-                    start = content.find("\"", start) + 1;
-                    size_t end = content.find("\"", start);
-                    std::string mainFile = content.substr(start, end - start);
-                    fs::path mainPath = packageDir / mainFile;
-                    if (fs::exists(mainPath)) {
-                        return mainPath.string();
-                    }
-                }
-            }
-
-            // Default to index.js if no package.json or main not found
-            fs::path indexJs = packageDir / "index.js";
-            if (fs::exists(indexJs)) {
-                return indexJs.string();
-            }
-        }
-
-        // Move up one directory
-        fs::path parent = currentDir.parent_path();
-        if (parent == currentDir) {
-            break;  // Reached root
-        }
-        currentDir = parent;
+ModulePrefetcher& ModuleSystem::getPrefetcher() {
+    if (!prefetcher) {
+        prefetcher = std::make_unique<ModulePrefetcher>(*resolver);
     }
+    return *prefetcher;
+}
 
-    return "";
+// Built-in modules are also found under the "node:" scheme ("node:fs")
+static std::string builtinName(const std::string& moduleName) {
+    return moduleName.compare(0, 5, "node:") == 0 ? moduleName.substr(5) : moduleName;
 }
 
-JSObjectRef ModuleSystem::loadNodeModule(JSContextRef ctx, const std::string& filePath) {
-    // Create module object with exports
-    JSObjectRef moduleExports = createModuleExports(ctx);
-
-    // Cache the exports object before executing to handle circular dependencies
-    moduleCache[filePath] = moduleExports;
-
-    // Read and execute the module code
-    std::string code = readFile(filePath);
-    wrapModuleCode(code);
-
-    JSStringRef script = JSStringCreateWithUTF8CString(code.c_str());
-    JSValueRef exception = nullptr;
-    JSEvaluateScript(ctx, script, nullptr, nullptr, 1, &exception);
-    JSStringRelease(script);
-
-    if (exception) {
-        JSStringRef exStr = JSValueToStringCopy(ctx, exception, nullptr);
-        size_t bufSize = JSStringGetMaximumUTF8CStringSize(exStr);
-        std::string errorMsg(bufSize, '\0');
-        JSStringGetUTF8CString(exStr, &errorMsg[0], bufSize);
-        JSStringRelease(exStr);
-        throw std::runtime_error("Module execution failed: " + errorMsg);
-    }
+bool ModuleSystem::isBuiltinModule(const std::string& moduleName) const {
+    return builtinModules.find(builtinName(moduleName)) != builtinModules.end();
+}
 
-    return moduleExports;
+void ModuleSystem::registerBuiltinModule(const std::string& name, JSObjectRef module) {
+    JSObjectRef& slot = builtinModules[name];
+    if (slot) {
+        JSValueUnprotect(context, slot);
+    }
+    JSValueProtect(context, module);
+    slot = module;
 }
 
-JSObjectRef ModuleSystem::createModuleExports(JSContextRef ctx) {
-    return JSObjectMake(ctx, nullptr, nullptr);
+JSObjectRef ModuleSystem::loadBuiltinModule(JSContextRef ctx, const std::string& moduleName) {
+    return builtinModules[builtinName(moduleName)];
 }
 
-std::string ModuleSystem::readFile(const std::string& filePath) {
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
-        throw std::runtime_error("Cannot open file: " + filePath);
+JSValueRef ModuleSystem::loadNodeModule(JSContextRef ctx, const std::string& filePath, JSValueRef* exception) {
+    std::unique_ptr<PreparedModule> prepared =
+        prefetcher ? prefetcher->take(filePath) : ModulePrefetcher::prepare(filePath, *resolver);
+    if (!prepared->source) {
+        *exception = make_error(ctx, "Cannot open file: " + filePath);
+        return nullptr;
+    }
+    // Its dependencies are read and prepared on the pool while this module runs
+    if (readAhead && !prepared->dependencies.empty()) {
+        ModulePrefetcher& modulePrefetcher = getPrefetcher();
+        for (const std::string& dependency : prepared->dependencies) {
+            modulePrefetcher.prefetch(dependency);
+        }
+    }
+    const fs::path directory = fs::path(filePath).parent_path();
+
+    // Create module object with exports
+    JSObjectRef module = JSObjectMake(ctx, nullptr, nullptr);
+    JSObjectRef exports = JSObjectMake(ctx, nullptr, nullptr);
+    JSValueRef filename = make_string(ctx, filePath);
+    set_property(ctx, module, "exports", exports);
+    set_property(ctx, module, "id", filename);
+    set_property(ctx, module, "filename", filename);
+    set_property(ctx, module, "loaded", JSValueMakeBoolean(ctx, false));
+
+    // Cache the module before executing to handle circular dependencies
+    JSValueProtect(ctx, module);
+    moduleCache[filePath] = module;
+
+    const bool transformed = !prepared->transformed.empty();
+    JSStringRef body = transformed ? create_source_string(prepared->transformed)
+                                   : create_source_string(*prepared->source);
+    prepared.reset(); // JSC has its own copy, or adopted ours
+    JSValueRef error = nullptr;
+    if (is_json_file(filePath)) {
+        JSValueRef value = JSValueMakeFromJSONString(ctx, body);
+        if (value) {
+            set_property(ctx, module, "exports", value);
+        } else {
+            error = make_error(ctx, "Invalid JSON in " + filePath);
+        }
+    } else {
+        // Compiled straight from the source, so no wrapper text is ever concatenated,
+        // and JSC attributes errors and profiles to the real file and line numbers
+        JSStringRef parameterNames[kModuleParameterCount];
+        for (unsigned i = 0; i < kModuleParameterCount; ++i) {
+            parameterNames[i] = JSStringCreateWithUTF8CString(kModuleParameters[i]);
+        }
+        JSStringRef sourceURL = JSStringCreateWithUTF8CString(filePath.c_str());
+        JSObjectRef function = JSObjectMakeFunction(ctx, nullptr, kModuleParameterCount, parameterNames,
+                                                    body, sourceURL, 1, &error);
+        JSStringRelease(sourceURL);
+        for (JSStringRef name : parameterNames) {
+            JSStringRelease(name);
+        }
+        if (function) {
+            JSValueRef arguments[kModuleParameterCount] = {
+                exports, makeRequire(ctx, directory), module, filename, make_string(ctx, directory.string()),
+                JSValueMakeUndefined(ctx), JSValueMakeUndefined(ctx), JSValueMakeUndefined(ctx)};
+            if (transformed) {
+                JSObjectRef importFunc = JSObjectMake(ctx, importClass, new RequireData{directory});
+                JSObjectRef meta = JSObjectMake(ctx, nullptr, nullptr);
+                set_property(ctx, meta, "url", make_string(ctx, "file://" + filePath));
+                set_property(ctx, meta, "filename", filename);
+                set_property(ctx, meta, "dirname", arguments[4]);
+                arguments[5] = importFunc;
+                if (dynamicImportFactory) {
+                    JSValueRef factoryArgument = importFunc;
+                    if (JSValueRef dynamicImport = JSObjectCallAsFunction(ctx, dynamicImportFactory, nullptr, 1,
+                                                                          &factoryArgument, nullptr)) {
+                        arguments[6] = dynamicImport;
+                    }
+                }
+                arguments[7] = meta;
+            }
+            JSObjectCallAsFunction(ctx, function, exports, kModuleParameterCount, arguments, &error);
+        }
+    }
+    JSStringRelease(body);
+
+    if (error) {
+        // A later require() tries again instead of getting a half-initialized module
+        moduleCache.erase(filePath);
+        JSValueUnprotect(ctx, module);
+        *exception = error;
+        return nullptr;
     }
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
-}
 
-void ModuleSystem::wrapModuleCode(std::string& code) {
-    // Wrap the code in a function to create module scope
-    code = "(function(exports, require, module, __filename, __dirname) {\n" +
-           code + "\n})(exports, require, module, __filename, __dirname);";
+    set_property(ctx, module, "loaded", JSValueMakeBoolean(ctx, true));
+    return get_property(ctx, module, "exports");
 }
 
 static JSValueRef emitter_on(JSContextRef ctx, JSObjectRef function, JSObjectRef thisObject,
@@ -7,6 +7,8 @@
 #include <vector>
 #include <memory>
 #include <filesystem>
+#include "js/module_resolver.h"
+#include "js/module_prefetcher.h"
 
 namespace jpm::js {
 
@@ -19,12 +21,31 @@ public:
 
     // Initialize the module system
     void init(JSContextRef ctx, JSObjectRef globalObject);
-    
+
     // Setup the require function in global scope
     void setup_require(JSContextRef ctx, JSObjectRef globalObject);
-    
-    // Core require implementation
-    JSObjectRef require(JSContextRef ctx, const std::string& modulePath);
+
+    // Makes the global require() resolve relative to the entry script, as in Node
+    void setMainScript(const std::string& filePath);
+
+    // Core require implementation: module.exports of the module that request names
+    // from fromDir. On failure returns nullptr and sets *exception to a JS error.
+    JSValueRef require(JSContextRef ctx, const std::filesystem::path& fromDir,
+                       const std::string& request, JSValueRef* exception);
+
+    // What `import` binds for request: the exports of an ES module, or for CommonJS
+    // and built-in modules a namespace whose default is module.exports and which
+    // inherits its properties. nullptr with *exception set on failure.
+    JSValueRef importModule(JSContextRef ctx, const std::filesystem::path& fromDir,
+                            const std::string& request, JSValueRef* exception);
+
+    // Runs an ES module entry script through the module loader, after starting to
+    // prefetch its import graph
+    JSValueRef runMainModule(JSContextRef ctx, const std::string& filePath, JSValueRef* exception);
+
+    // Starts reading the modules a classic entry script require()s, found by
+    // scan_module(), while the script itself is compiled and run
+    void readAheadMain(const std::vector<std::string>& requests);
 
     // Register a built-in module (for process modules)
     void registerBuiltinModule(const std::string& name, JSObjectRef module);
@@ -35,27 +56,44 @@ private:
     ModuleSystem(const ModuleSystem&) = delete;
     ModuleSystem& operator=(const ModuleSystem&) = delete;
 
-    // Cache to prevent duplicate loading
+    // `module` objects by canonical path, so "./a" and "./a.js" share one instance.
+    // Protected from GC for the life of the context.
     std::unordered_map<std::string, JSObjectRef> moduleCache;
-    
+
     // Built-in modules registry (process modules)
     std::unordered_map<std::string, JSObjectRef> builtinModules;
-    
+
     // Working directory for relative paths
     std::filesystem::path workingDir;
-    
+
+    // Cached request -> file resolution for this run
+    std::unique_ptr<ModuleResolver> resolver;
+
+    // Reads and transforms the dependencies of loaded modules ahead of evaluation;
+    // created for the first module that has any, so single-file scripts start no threads.
+    // Off on single-CPU machines and with JPM_NO_READAHEAD=1; modules are then read in order.
+    std::unique_ptr<ModulePrefetcher> prefetcher;
+    bool readAhead{true};
+    ModulePrefetcher& getPrefetcher();
+
+    // require functions: callable objects that carry the directory they resolve from.
+    // The import functions given to ES modules use the same private data.
+    JSClassRef requireClass{nullptr};
+    JSClassRef importClass{nullptr};
+    JSObjectRef requirePrototype{nullptr}; // Holds require.resolve; inherits Function.prototype
+    JSObjectRef globalRequire{nullptr};
+    JSObjectRef makeRequire(JSContextRef ctx, const std::filesystem::path& directory);
+    JSObjectRef dynamicImportFactory{nullptr}; // (load) => specifier => Promise of load(specifier)
+
     // Module resolution
-    std::string resolveModulePath(const std::string& requestedModule);
     bool isBuiltinModule(const std::string& moduleName) const;
     JSObjectRef loadBuiltinModule(JSContextRef ctx, const std::string& moduleName);
-    JSObjectRef loadNodeModule(JSContextRef ctx, const std::string& filePath);
-    
-    // Utility functions
-    std::string findPackageInNodeModules(const std::string& packageName);
-    std::string readFile(const std::string& filePath);
-    JSObjectRef createModuleExports(JSContextRef ctx);
-    void wrapModuleCode(std::string& code);
-    
+    // Compiles the file as function(exports, require, module, __filename, __dirname,
+    // __jpm_import, __jpm_dynamic_import, __jpm_meta) (or parses it, for .json) and
+    // runs it. ES modules are rewritten to that form by transform_to_commonjs(). Returns module.exports, or nullptr with
+    // *exception set; a module that failed is dropped from the cache.
+    JSValueRef loadNodeModule(JSContextRef ctx, const std::string& filePath, JSValueRef* exception);
+
     // Context storage
     JSContextRef context{nullptr};
     JSObjectRef globalObj{nullptr};
@@ -66,4 +104,4 @@ void setup_module_system(JSContextRef ctx, JSObjectRef globalObject);
 
 } // namespace jpm::js
 
-#endif // JPM_MODULE_H
\ No newline at end of file
+#endif // JPM_MODULE_H
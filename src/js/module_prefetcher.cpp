@@ -0,0 +1,110 @@
+#include "js/module_prefetcher.h"
+#include "js/import_scanner.h"
+#include <algorithm>
+#include <filesystem>
+
+namespace jpm::js {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+bool has_extension(const std::string& path, const char* extension) {
+    return fs::path(path).extension() == extension;
+}
+
+} // namespace
+
+ModulePrefetcher::ModulePrefetcher(ModuleResolver& resolver, size_t thread_count)
+    : resolver_(resolver), pool_(thread_count) {}
+
+ModulePrefetcher::~ModulePrefetcher() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = true;
+}
+
+std::unique_ptr<PreparedModule> ModulePrefetcher::prepare(const std::string& path, ModuleResolver& resolver) {
+    auto module = std::make_unique<PreparedModule>();
+    module->source = SourceFile::open(path);
+    if (!module->source || has_extension(path, ".json")) {
+        return module;
+    }
+
+    ModuleSyntax syntax = scan_module(module->source->text());
+    if (has_extension(path, ".cjs")) {
+        syntax.statements.clear(); // import() and import.meta still work in CommonJS
+    }
+    module->esm = syntax.has_module_syntax() || has_extension(path, ".mjs");
+    if (syntax.needs_transform()) {
+        module->transformed = transform_to_commonjs(module->source->text(), syntax);
+    }
+
+    // Literal require() calls are read ahead too; one that never runs costs a read
+    const fs::path directory = fs::path(path).parent_path();
+    std::vector<std::string> specifiers = syntax.static_specifiers();
+    specifiers.insert(specifiers.end(), syntax.required_specifiers.begin(), syntax.required_specifiers.end());
+    for (const std::string& specifier : specifiers) {
+        if (const std::string* resolved = resolver.resolve(directory, specifier)) {
+            if (std::find(module->dependencies.begin(), module->dependencies.end(), *resolved) ==
+                module->dependencies.end()) {
+                module->dependencies.push_back(*resolved);
+            }
+        }
+    }
+    return module;
+}
+
+void ModulePrefetcher::prefetch(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cancelled_ || !entries_.try_emplace(path).second) {
+            return;
+        }
+    }
+    pool_.submit([this, path]() { run(path); });
+}
+
+void ModulePrefetcher::run(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cancelled_) {
+            return;
+        }
+    }
+    std::unique_ptr<PreparedModule> module = prepare(path, resolver_);
+    std::vector<std::string> dependencies = module->dependencies;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry& entry = entries_[path];
+        entry.module = std::move(module);
+        entry.state = State::Ready;
+        ++prefetched_;
+    }
+    ready_.notify_all();
+
+    for (const std::string& dependency : dependencies) {
+        prefetch(dependency);
+    }
+}
+
+std::unique_ptr<PreparedModule> ModulePrefetcher::take(const std::string& path) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto [it, inserted] = entries_.try_emplace(path);
+        if (!inserted && it->second.state != State::Taken) {
+            Entry& entry = it->second;
+            ready_.wait(lock, [&entry]() { return entry.state == State::Ready; });
+            entry.state = State::Taken;
+            return std::move(entry.module);
+        }
+        it->second.state = State::Taken;
+    }
+    return prepare(path, resolver_);
+}
+
+size_t ModulePrefetcher::prefetched() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return prefetched_;
+}
+
+} // namespace jpm::js
@@ -0,0 +1,77 @@
+#ifndef JPM_MODULE_PREFETCHER_H
+#define JPM_MODULE_PREFETCHER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "js/module_resolver.h"
+#include "js/source_loader.h"
+#include "utils/thread_pool.h"
+
+namespace jpm::js {
+
+// A module file read, scanned and, for ES modules, rewritten for the CommonJS
+// loader; everything that can happen before JSC is involved
+struct PreparedModule {
+    std::unique_ptr<SourceFile> source; // nullptr if the file could not be read
+    bool esm = false;                   // Static import/export, or .mjs
+    std::string transformed;            // transform_to_commonjs() output, if the file needed it
+    std::vector<std::string> dependencies; // Resolved paths of its static imports and literal require()s
+
+    // The text to compile
+    std::string_view text() const { return transformed.empty() ? source->text() : std::string_view(transformed); }
+};
+
+// Prepares the dependency graph of a module on a thread pool: static imports, and
+// for CommonJS the require("...") calls a lexer-level scan finds. Modules are
+// evaluated as they are reached (see ModuleSystem), so by the time an import or
+// require() runs its file is usually already in memory, scanned and transformed.
+class ModulePrefetcher {
+public:
+    explicit ModulePrefetcher(ModuleResolver& resolver, size_t thread_count = 0);
+    ~ModulePrefetcher(); // Drops queued work; waits for files being read
+
+    ModulePrefetcher(const ModulePrefetcher&) = delete;
+    ModulePrefetcher& operator=(const ModulePrefetcher&) = delete;
+
+    // Starts preparing path and then, recursively, everything it statically imports.
+    // Paths already requested are skipped.
+    void prefetch(const std::string& path);
+
+    // The prepared module for path, waiting for it if it is in flight. A path is
+    // handed out once; later calls (and paths never prefetched) prepare it on the
+    // calling thread.
+    std::unique_ptr<PreparedModule> take(const std::string& path);
+
+    // Reads, scans and transforms one file and resolves its static imports
+    static std::unique_ptr<PreparedModule> prepare(const std::string& path, ModuleResolver& resolver);
+
+    size_t prefetched() const;
+
+private:
+    enum class State { Pending, Ready, Taken };
+
+    struct Entry {
+        State state = State::Pending;
+        std::unique_ptr<PreparedModule> module;
+    };
+
+    void run(const std::string& path);
+
+    ModuleResolver& resolver_;
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    std::unordered_map<std::string, Entry> entries_;
+    bool cancelled_ = false;
+    size_t prefetched_ = 0; // Modules prepared on the pool
+    ThreadPool pool_;       // Last, so it is joined before the rest is destroyed
+};
+
+} // namespace jpm::js
+
+#endif // JPM_MODULE_PREFETCHER_H
@@ -0,0 +1,178 @@
+#include "js/module_resolver.h"
+#include "parsing/json_parser.h"
+#include "utils/file_utils.h"
+#include "jpm_config.h"
+#include <iostream>
+
+namespace jpm::js {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+bool is_relative_request(const std::string& request) {
+    return request.compare(0, 2, "./") == 0 || request.compare(0, 3, "../") == 0 ||
+           request == "." || request == "..";
+}
+
+} // namespace
+
+ModuleResolver::ModuleResolver(const fs::path& working_dir) {
+    // The nearest project with a manifest; jpm writes one on every install
+    for (fs::path dir = working_dir;; dir = dir.parent_path()) {
+        manifest_ = ResolutionManifest::open(dir);
+        if (manifest_ || dir == dir.parent_path()) {
+            break;
+        }
+    }
+}
+
+ModuleResolver::Kind ModuleResolver::stat(const fs::path& path) {
+    auto [it, inserted] = stat_cache_.try_emplace(path.string(), Kind::Missing);
+    if (inserted) {
+        ++stats_.stat_calls;
+        std::error_code ec;
+        fs::file_status status = fs::status(path, ec);
+        if (!ec) {
+            if (fs::is_regular_file(status)) {
+                it->second = Kind::File;
+            } else if (fs::is_directory(status)) {
+                it->second = Kind::Directory;
+            }
+        }
+    }
+    return it->second;
+}
+
+ModuleResolver::Stats ModuleResolver::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+const std::string* ModuleResolver::resolve(const fs::path& from_dir, const std::string& request) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.lookups;
+    std::string key = from_dir.string();
+    key.push_back('\0');
+    key.append(request);
+
+    auto it = resolution_cache_.find(key);
+    if (it != resolution_cache_.end()) {
+        ++stats_.cache_hits;
+    } else {
+        std::string resolved;
+        if (std::optional<fs::path> file = resolve_uncached(from_dir, request)) {
+            resolved = canonical(*file);
+        }
+        it = resolution_cache_.emplace(std::move(key), std::move(resolved)).first;
+    }
+    return it->second.empty() ? nullptr : &it->second;
+}
+
+std::string ModuleResolver::canonical(const fs::path& file) {
+    // One identity per file, however it was reached ("./a", "./a.js", via a symlink).
+    // Directories are canonicalized once each, so a file costs one lstat, not one per component.
+    std::error_code ec;
+    if (fs::is_symlink(fs::symlink_status(file, ec))) {
+        fs::path target = fs::canonical(file, ec);
+        return ec ? file.lexically_normal().string() : target.string();
+    }
+    fs::path parent = file.parent_path();
+    auto [it, inserted] = canonical_dirs_.try_emplace(parent.string());
+    if (inserted) {
+        fs::path dir = fs::canonical(parent, ec);
+        it->second = ec ? parent.lexically_normal().string() : dir.string();
+    }
+    return (fs::path(it->second) / file.filename()).string();
+}
+
+std::optional<fs::path> ModuleResolver::resolve_uncached(const fs::path& from_dir, const std::string& request) {
+    if (request.empty()) {
+        return std::nullopt;
+    }
+    if (is_relative_request(request) || fs::path(request).is_absolute()) {
+        fs::path base = (from_dir / request).lexically_normal();
+        if (std::optional<fs::path> file = load_as_file(base)) {
+            return file;
+        }
+        return load_as_directory(base);
+    }
+    return load_from_node_modules(from_dir, request);
+}
+
+std::optional<fs::path> ModuleResolver::load_as_file(const fs::path& base) {
+    if (!base.has_filename()) {
+        return std::nullopt; // "./dir/" names a directory
+    }
+    if (stat(base) == Kind::File) {
+        return base;
+    }
+    for (const char* extension : {".js", ".json"}) {
+        fs::path with_extension = base;
+        with_extension += extension;
+        if (stat(with_extension) == Kind::File) {
+            return with_extension;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<fs::path> ModuleResolver::load_as_directory(const fs::path& dir) {
+    fs::path normalized = dir.has_filename() ? dir : dir.parent_path();
+    if (stat(normalized) != Kind::Directory) {
+        return std::nullopt;
+    }
+    fs::path package_json = normalized / "package.json";
+    if (stat(package_json) == Kind::File) {
+        std::optional<std::string> content = FileUtils::read_file(package_json.string());
+        JsonData manifest = content ? JsonParser::try_parse(*content) : JsonData();
+        if (manifest.is_object() && manifest.contains("main") && manifest["main"].is_string()) {
+            fs::path main = (normalized / manifest["main"].get<std::string>()).lexically_normal();
+            if (std::optional<fs::path> file = load_as_file(main)) {
+                return file;
+            }
+            if (stat(main) == Kind::Directory && stat(main / "index.js") == Kind::File) {
+                return main / "index.js";
+            }
+        }
+    }
+    fs::path index = normalized / "index.js";
+    if (stat(index) == Kind::File) {
+        return index;
+    }
+    return std::nullopt;
+}
+
+std::optional<fs::path> ModuleResolver::load_from_node_modules(const fs::path& from_dir, const std::string& request) {
+    if (manifest_) {
+        if (std::optional<fs::path> entry = manifest_->resolve(from_dir, request)) {
+            ++stats_.manifest_hits;
+            return entry;
+        }
+    }
+
+    // "pkg/sub" only exists if node_modules/pkg does, which is the cheaper stat to repeat
+    size_t name_end = request.find('/', request[0] == '@' ? request.find('/') + 1 : 0);
+    std::string package_name = request.substr(0, name_end);
+
+    for (fs::path dir = from_dir;; dir = dir.parent_path()) {
+        if (dir.filename() != "node_modules") {
+            fs::path node_modules = dir / "node_modules";
+            if (stat(node_modules / package_name) == Kind::Directory) {
+                fs::path base = node_modules / request;
+                if (std::optional<fs::path> file = load_as_file(base)) {
+                    return file;
+                }
+                if (std::optional<fs::path> file = load_as_directory(base)) {
+                    return file;
+                }
+            }
+        }
+        if (dir == dir.parent_path()) {
+            break;
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace jpm::js
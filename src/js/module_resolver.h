@@ -0,0 +1,70 @@
+#ifndef JPM_MODULE_RESOLVER_H
+#define JPM_MODULE_RESOLVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include "package/resolution_manifest.h"
+
+namespace jpm::js {
+
+// Maps require() requests to files, the way Node does for CommonJS:
+//   "./x", "../x", "/x"   x, x.js, x.json, then x as a directory (package.json main, index.js)
+//   "pkg", "pkg/sub"      the same under node_modules of from_dir and each ancestor
+// Packages jpm installed are answered from node_modules/.jpm-resolution first.
+//
+// Everything is memoized for the life of the resolver (one script run): every stat
+// result, and every (directory, request) answer including "not found". Files that
+// appear or disappear while a script runs are therefore not noticed, as with Node's
+// own module cache.
+//
+// resolve() may be called from several threads (the module prefetcher resolves
+// imports on its workers); calls are serialized.
+class ModuleResolver {
+public:
+    struct Stats {
+        size_t lookups = 0;        // resolve() calls
+        size_t cache_hits = 0;     // answered from the resolution cache
+        size_t manifest_hits = 0;  // answered from .jpm-resolution
+        size_t stat_calls = 0;     // stats that reached the filesystem
+    };
+
+    // Opens the resolution manifest of the nearest project enclosing working_dir
+    explicit ModuleResolver(const std::filesystem::path& working_dir);
+
+    // Canonical absolute path of the file require(request) loads from a module in
+    // from_dir, or nullptr if there is none. The pointer stays valid as long as the resolver.
+    const std::string* resolve(const std::filesystem::path& from_dir, const std::string& request);
+
+    Stats stats() const;
+
+private:
+    enum class Kind : uint8_t { Missing, File, Directory };
+
+    mutable std::mutex mutex_;
+
+    std::unique_ptr<ResolutionManifest> manifest_;
+    std::unordered_map<std::string, Kind> stat_cache_;
+    // from_dir + '\0' + request -> canonical path, "" when not found
+    std::unordered_map<std::string, std::string> resolution_cache_;
+    std::unordered_map<std::string, std::string> canonical_dirs_;
+    Stats stats_;
+
+    Kind stat(const std::filesystem::path& path);
+    std::string canonical(const std::filesystem::path& file);
+    std::optional<std::filesystem::path> resolve_uncached(const std::filesystem::path& from_dir,
+                                                          const std::string& request);
+    std::optional<std::filesystem::path> load_as_file(const std::filesystem::path& base);
+    std::optional<std::filesystem::path> load_as_directory(const std::filesystem::path& dir);
+    std::optional<std::filesystem::path> load_from_node_modules(const std::filesystem::path& from_dir,
+                                                                const std::string& request);
+};
+
+} // namespace jpm::js
+
+#endif // JPM_MODULE_RESOLVER_H
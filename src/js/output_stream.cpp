@@ -0,0 +1,152 @@
+#include "js/output_stream.h"
+#include "js/text_codec.h"
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace jpm::js {
+
+namespace {
+
+bool same_file(int first, int second) {
+    struct stat a;
+    struct stat b;
+    return fstat(first, &a) == 0 && fstat(second, &b) == 0 && a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+}
+
+struct StandardStreams {
+    OutputStream out{STDOUT_FILENO};
+    OutputStream err{STDERR_FILENO};
+
+    StandardStreams() {
+        if (same_file(STDOUT_FILENO, STDERR_FILENO)) {
+            out.share_file_with(err);
+        }
+    }
+};
+
+StandardStreams& standard_streams() {
+    static StandardStreams streams;
+    return streams;
+}
+
+} // namespace
+
+OutputStream& OutputStream::for_stdout() {
+    return standard_streams().out;
+}
+
+OutputStream& OutputStream::for_stderr() {
+    return standard_streams().err;
+}
+
+void OutputStream::flush_all() {
+    StandardStreams& streams = standard_streams();
+    // At most one of them holds bytes when they share a file (see before_write())
+    streams.out.flush();
+    streams.err.flush();
+}
+
+OutputStream::OutputStream(int fd) : fd_(fd), line_buffered_(isatty(fd) == 1) {
+    buffer_.reserve(kCapacity);
+}
+
+OutputStream::~OutputStream() {
+    flush();
+}
+
+void OutputStream::share_file_with(OutputStream& other) {
+    shared_ = &other;
+    other.shared_ = this;
+}
+
+void OutputStream::write(const char* data, size_t size) {
+    before_write();
+    if (size >= kCapacity) {
+        // Big enough to go out on its own: no copy, one writev() with what is buffered
+        write_fully(buffer_.data(), buffer_.size(), data, size);
+        buffer_.clear();
+        return;
+    }
+    const size_t start = buffer_.size();
+    buffer_.append(data, size);
+    written(start);
+}
+
+void OutputStream::write_utf16(const uint16_t* text, size_t length) {
+    before_write();
+    const size_t start = buffer_.size();
+    const size_t bound = utf8_length(text, length);
+    buffer_.resize(start + bound);
+    encode_text(text, length, TextEncoding::Utf8, &buffer_[start], bound);
+    written(start);
+}
+
+void OutputStream::flush() {
+    if (buffer_.empty()) {
+        return;
+    }
+    write_fully(buffer_.data(), buffer_.size(), nullptr, 0);
+    buffer_.clear();
+    if (buffer_.capacity() > 4 * kCapacity) {
+        // One huge string should not pin its size for the rest of the run
+        std::string().swap(buffer_);
+        buffer_.reserve(kCapacity);
+    }
+}
+
+void OutputStream::before_write() {
+    if (shared_ && !shared_->buffer_.empty()) {
+        shared_->flush();
+    }
+}
+
+void OutputStream::written(size_t start) {
+    if (line_buffered_ && std::memchr(buffer_.data() + start, '\n', buffer_.size() - start)) {
+        flush();
+    } else if (buffer_.size() >= kCapacity) {
+        flush();
+    }
+}
+
+void OutputStream::write_fully(const char* first, size_t first_size, const char* second, size_t second_size) {
+    struct iovec chunks[2];
+    int count = 0;
+    if (first_size > 0) {
+        chunks[count++] = {const_cast<char*>(first), first_size};
+    }
+    if (second_size > 0) {
+        chunks[count++] = {const_cast<char*>(second), second_size};
+    }
+    struct iovec* next = chunks;
+    while (count > 0) {
+        ssize_t n = writev(fd_, next, count);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // A non-blocking descriptor inherited from the parent; wait until it drains
+                struct pollfd writable = {fd_, POLLOUT, 0};
+                poll(&writable, 1, -1);
+                continue;
+            }
+            return;
+        }
+        size_t left = static_cast<size_t>(n);
+        while (count > 0 && left >= next->iov_len) {
+            left -= next->iov_len;
+            ++next;
+            --count;
+        }
+        if (count > 0) {
+            next->iov_base = static_cast<char*>(next->iov_base) + left;
+            next->iov_len -= left;
+        }
+    }
+}
+
+} // namespace jpm::js
@@ -0,0 +1,62 @@
+#ifndef JPM_OUTPUT_STREAM_H
+#define JPM_OUTPUT_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace jpm::js {
+
+// Buffered output to a file descriptor, behind process.stdout, process.stderr and
+// console. Writes are appended to one buffer that is reused for the life of the
+// stream; strings are transcoded from UTF-16 straight into it. The buffer goes out
+// in a single write() once it holds kCapacity bytes, and a large write is sent
+// together with what is buffered in one writev(), without being copied.
+//
+// When the descriptor is a TTY the stream is line-buffered: a write containing a
+// newline flushes it. Pipes and files are flushed only when the buffer fills, when
+// the event loop is about to block, before stdin is read, and on exit,
+// process.exit() and uncaught exceptions (flush_all()).
+//
+// Loop thread only. No JavaScriptCore here.
+class OutputStream {
+public:
+    static constexpr size_t kCapacity = 64 * 1024;
+
+    static OutputStream& for_stdout();
+    static OutputStream& for_stderr();
+    // Writes out whatever stdout and stderr hold
+    static void flush_all();
+
+    explicit OutputStream(int fd);
+    ~OutputStream();
+    OutputStream(const OutputStream&) = delete;
+    OutputStream& operator=(const OutputStream&) = delete;
+
+    void write(const char* data, size_t size);
+    // Encodes text as UTF-8; lone surrogates become U+FFFD
+    void write_utf16(const uint16_t* text, size_t length);
+    void flush();
+
+    bool is_tty() const { return line_buffered_; }
+
+    // The two streams write to the same file (2>&1): before either writes, the
+    // other's buffered bytes go out, so their output keeps its order.
+    void share_file_with(OutputStream& other);
+
+private:
+    // Flushes once a line is complete on a TTY, or once the buffer is full
+    void written(size_t start);
+    // Writes both chunks, retrying short writes; errors (EPIPE, ...) drop the output
+    void write_fully(const char* first, size_t first_size, const char* second, size_t second_size);
+    void before_write();
+
+    const int fd_;
+    const bool line_buffered_;
+    std::string buffer_;
+    OutputStream* shared_ = nullptr;
+};
+
+} // namespace jpm::js
+
+#endif // JPM_OUTPUT_STREAM_H
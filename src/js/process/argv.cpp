@@ -8,16 +8,19 @@ namespace jpm {
 namespace js {
 namespace process {
 
-void setup_argv(JSContextRef ctx, JSObjectRef process_obj, const std::string& script_path) {
-    // Create process.argv = ["node", "<script_path>"]
-    JSValueRef argv_values[2];
-    JSStringRef node_str = JSStringCreateWithUTF8CString("node");
-    JSStringRef file_str = JSStringCreateWithUTF8CString(script_path.c_str());
-    argv_values[0] = JSValueMakeString(ctx, node_str);
-    argv_values[1] = JSValueMakeString(ctx, file_str);
-    JSObjectRef argv_array = JSObjectMakeArray(ctx, 2, argv_values, nullptr);
-    JSStringRelease(node_str);
-    JSStringRelease(file_str);
+void setup_argv(JSContextRef ctx, JSObjectRef process_obj, const std::string& script_path,
+                const std::vector<std::string>& script_args) {
+    // Create process.argv = ["node", "<script_path>", ...script_args]
+    std::vector<std::string> entries = {"node", script_path};
+    entries.insert(entries.end(), script_args.begin(), script_args.end());
+    std::vector<JSValueRef> argv_values;
+    argv_values.reserve(entries.size());
+    for (const auto& entry : entries) {
+        JSStringRef entry_str = JSStringCreateWithUTF8CString(entry.c_str());
+        argv_values.push_back(JSValueMakeString(ctx, entry_str));
+        JSStringRelease(entry_str);
+    }
+    JSObjectRef argv_array = JSObjectMakeArray(ctx, argv_values.size(), argv_values.data(), nullptr);
 
     JSStringRef argv_name = JSStringCreateWithUTF8CString("argv");
     JSObjectSetProperty(ctx, process_obj, argv_name, argv_array, kJSPropertyAttributeNone, nullptr);
@@ -4,14 +4,16 @@
 #ifdef USE_JAVASCRIPTCORE
 #include <JavaScriptCore/JavaScript.h>
 #include <string>
+#include <vector>
 
 namespace jpm {
 namespace js {
 namespace process {
 
 // Sets up process.argv in the given JavaScript context
-// process.argv will be initialized as ["node", "<script_path>"]
-void setup_argv(JSContextRef ctx, JSObjectRef process_obj, const std::string& script_path);
+// process.argv will be initialized as ["node", "<script_path>", ...script_args]
+void setup_argv(JSContextRef ctx, JSObjectRef process_obj, const std::string& script_path,
+                const std::vector<std::string>& script_args = {});
 
 } // namespace process
 } // namespace js
@@ -2,12 +2,12 @@
 
 #ifdef USE_JAVASCRIPTCORE
 #include "jpm_config.h"
+#include "js/event_loop.h"
+#include "js/output_stream.h"
+#include "js/process/exit.h"
+#include "js/timers.h"
 #include <iostream>
 #include <chrono>
-#include <thread>
-#include <queue>
-#include <mutex>
-#include <condition_variable>
 #include <algorithm>
 #include <cstring>
 
@@ -20,23 +20,17 @@ struct EventListener {
     JSObjectRef callback;
 };
 
-struct NextTickItem {
-    JSContextRef ctx;
-    JSObjectRef callback;
-    std::vector<JSValueRef> args;
-};
-
-static std::queue<NextTickItem> next_tick_queue;
-static std::mutex next_tick_mutex;
-static bool next_tick_processing = false;
-
 ProcessEventEmitter& ProcessEventEmitter::getInstance() {
     static ProcessEventEmitter instance;
     return instance;
 }
 
 void ProcessEventEmitter::on(const std::string& event_name, JSContextRef ctx, JSObjectRef callback) {
-    listeners[event_name].push_back({ctx, callback});
+    // Only the emitter may still reference the callback, and the loop can run GC long
+    // before the event fires
+    JSGlobalContextRef global_ctx = JSContextGetGlobalContext(ctx);
+    JSValueProtect(global_ctx, callback);
+    listeners[event_name].push_back({global_ctx, callback});
     if (g_verbose_output) {
         std::cout << "Added listener for event: " << event_name << std::endl;
     }
@@ -47,11 +41,25 @@ void ProcessEventEmitter::removeListener(const std::string& event_name, JSObject
     event_listeners.erase(
         std::remove_if(event_listeners.begin(), event_listeners.end(),
                        [callback](const EventListener& listener) {
-                           return listener.callback == callback;
+                           if (listener.callback != callback) {
+                               return false;
+                           }
+                           JSValueUnprotect(listener.ctx, listener.callback);
+                           return true;
                        }),
         event_listeners.end());
 }
 
+void ProcessEventEmitter::removeAllListeners() {
+    for (auto& [event_name, event_listeners] : listeners) {
+        (void)event_name;
+        for (const auto& listener : event_listeners) {
+            JSValueUnprotect(listener.ctx, listener.callback);
+        }
+    }
+    listeners.clear();
+}
+
 void ProcessEventEmitter::emit(const std::string& event_name, JSContextRef ctx,
                                const std::vector<JSValueRef>& args) {
     if (g_verbose_output) {
@@ -60,7 +68,9 @@ void ProcessEventEmitter::emit(const std::string& event_name, JSContextRef ctx,
 
     auto it = listeners.find(event_name);
     if (it != listeners.end()) {
-        for (const auto& listener : it->second) {
+        // A copy: listeners may add listeners for the event being emitted
+        const std::vector<EventListener> event_listeners = it->second;
+        for (const auto& listener : event_listeners) {
             JSValueRef exception = nullptr;
             JSObjectCallAsFunction(listener.ctx, listener.callback, nullptr,
                                    args.size(), args.data(), &exception);
@@ -84,33 +94,29 @@ bool ProcessEventEmitter::hasListeners(const std::string& event_name) const {
     return it != listeners.end() && !it->second.empty();
 }
 
-static void process_next_tick_queue() {
-    while (true) {
-        NextTickItem item;
-        {
-            std::lock_guard<std::mutex> lock(next_tick_mutex);
-            if (next_tick_queue.empty()) {
-                next_tick_processing = false;
-                break;
-            }
-            item = next_tick_queue.front();
-            next_tick_queue.pop();
-        }
+void handle_uncaught_exception(JSContextRef ctx, JSValueRef exception) {
+    ProcessEventEmitter& emitter = ProcessEventEmitter::getInstance();
+    if (emitter.hasListeners("uncaughtException")) {
+        emitter.emit("uncaughtException", ctx, {exception});
+        return;
+    }
 
-        JSValueRef exception = nullptr;
-        JSObjectCallAsFunction(item.ctx, item.callback, nullptr,
-                               item.args.size(), item.args.data(), &exception);
-
-        if (exception) {
-            JSStringRef error_str = JSValueToStringCopy(item.ctx, exception, nullptr);
-            size_t len = JSStringGetMaximumUTF8CStringSize(error_str);
-            std::string error_msg(len, '\0');
-            JSStringGetUTF8CString(error_str, &error_msg[0], len);
-            error_msg.resize(strlen(error_msg.c_str()));
-            std::cerr << "Error in nextTick callback: " << error_msg << std::endl;
-            JSStringRelease(error_str);
-        }
+    JSStringRef error_str = JSValueToStringCopy(ctx, exception, nullptr);
+    std::string error_msg;
+    if (error_str) {
+        size_t len = JSStringGetMaximumUTF8CStringSize(error_str);
+        error_msg.assign(len, '\0');
+        JSStringGetUTF8CString(error_str, &error_msg[0], len);
+        error_msg.resize(strlen(error_msg.c_str()));
+        JSStringRelease(error_str);
     }
+    // What the script wrote before it failed comes first
+    OutputStream::flush_all();
+    std::cerr << "JavaScript Error: " << error_msg << std::endl;
+
+    mark_uncaught_exception();
+    emitter.emit("exit", ctx, {JSValueMakeNumber(ctx, 1)});
+    EventLoop::getInstance().stop();
 }
 
 void setup_events(JSContextRef ctx, JSObjectRef process_obj) {
@@ -141,18 +147,8 @@ void setup_events(JSContextRef ctx, JSObjectRef process_obj) {
             if (argc < 1 || !JSValueIsObject(ctx_inner, args[0]))
                 return JSValueMakeUndefined(ctx_inner);
 
-            std::vector<JSValueRef> callback_args;
-            if (argc > 1)
-                callback_args.assign(args + 1, args + argc);
-
-            {
-                std::lock_guard<std::mutex> lock(next_tick_mutex);
-                next_tick_queue.push({ctx_inner, (JSObjectRef)args[0], callback_args});
-                if (!next_tick_processing) {
-                    next_tick_processing = true;
-                    std::thread(process_next_tick_queue).detach();
-                }
-            }
+            // Runs on the event loop thread once the current callback returns
+            queue_next_tick(ctx_inner, (JSObjectRef)args[0], argc - 1, args + 1);
 
             return JSValueMakeUndefined(ctx_inner);
         });
@@ -23,6 +23,9 @@ public:
     // Remove event listener
     void removeListener(const std::string& event_name, JSObjectRef callback);
 
+    // Drops every listener; call before the context they belong to is released
+    void removeAllListeners();
+
     // Emit event
     void emit(const std::string& event_name, JSContextRef ctx, const std::vector<JSValueRef>& args = {});
 
@@ -36,8 +39,8 @@ private:
     ProcessEventEmitter& operator=(const ProcessEventEmitter&) = delete;
 
     struct EventListener {
-        JSContextRef ctx;
-        JSObjectRef callback;
+        JSGlobalContextRef ctx;
+        JSObjectRef callback; // Protected while listed
     };
 
     std::map<std::string, std::vector<EventListener>> listeners;
@@ -57,6 +60,12 @@ private:
 // - 'warning' - when a warning occurs
 void setup_events(JSContextRef ctx, JSObjectRef process_obj);
 
+// Reports an exception no JS code caught (from the entry script or a loop callback).
+// With 'uncaughtException' listeners they get the error and the loop goes on;
+// otherwise the error is printed, 'exit' is emitted with code 1, the loop stops and
+// the run's exit status becomes 1.
+void handle_uncaught_exception(JSContextRef ctx, JSValueRef exception);
+
 // High-resolution time functionality
 // Sets up:
 // - process.hrtime([time]) - returns [seconds, nanoseconds]
@@ -2,20 +2,51 @@
 
 #ifdef USE_JAVASCRIPTCORE
 #include "jpm_config.h"
+#include "js/output_stream.h"
 #include <iostream>
+#include <cmath>
 #include <cstdlib>
 
 namespace jpm {
 namespace js {
 namespace process {
 
+namespace {
+
+bool g_uncaught_exception = false;
+
+// process.exitCode as an integer; numeric strings count, like in Node
+int exit_code_property(JSContextRef ctx, JSObjectRef process_obj) {
+    if (!process_obj) {
+        return 0;
+    }
+    JSStringRef name = JSStringCreateWithUTF8CString("exitCode");
+    JSValueRef value = JSObjectGetProperty(ctx, process_obj, name, nullptr);
+    JSStringRelease(name);
+    if (!value || !(JSValueIsNumber(ctx, value) || JSValueIsString(ctx, value))) {
+        return 0;
+    }
+    double code = JSValueToNumber(ctx, value, nullptr);
+    return std::isfinite(code) ? static_cast<int>(code) : 0;
+}
+
+} // namespace
+
+void mark_uncaught_exception() {
+    g_uncaught_exception = true;
+}
+
+int exit_status(JSContextRef ctx, JSObjectRef process_obj) {
+    return g_uncaught_exception ? 1 : exit_code_property(ctx, process_obj);
+}
+
 void setup_exit(JSContextRef ctx, JSObjectRef process_obj) {
     // Create process.exit function
     JSStringRef exit_function_name = JSStringCreateWithUTF8CString("exit");
     JSObjectRef exit_function = JSObjectMakeFunctionWithCallback(ctx, exit_function_name,
         [](JSContextRef ctx_inner, JSObjectRef function, JSObjectRef thisObject,
            size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) -> JSValueRef {
-            int exit_code = 0;
+            int exit_code = exit_code_property(ctx_inner, thisObject);
             if (argumentCount > 0 && JSValueIsNumber(ctx_inner, arguments[0])) {
                 exit_code = (int)JSValueToNumber(ctx_inner, arguments[0], nullptr);
             }
@@ -24,6 +55,8 @@ void setup_exit(JSContextRef ctx, JSObjectRef process_obj) {
                 std::cout << "process.exit called with code: " << exit_code << std::endl;
             }
 
+            // exit() skips the rest of the run, so buffered output goes out here
+            OutputStream::flush_all();
             exit(exit_code);
             return JSValueMakeUndefined(ctx_inner); // Never reached due to exit()
         });
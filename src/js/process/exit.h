@@ -10,9 +10,16 @@ namespace process {
 
 // Sets up process.exit() in the given JavaScript context
 // process.exit([code]) will terminate the program with the given exit code
-// If no code is provided, exits with 0
+// If no code is provided, exits with process.exitCode, or 0 when that is not set
 void setup_exit(JSContextRef ctx, JSObjectRef process_obj);
 
+// Records an exception nothing handled; the run's exit status is then 1
+void mark_uncaught_exception();
+
+// Exit status of a run that ends without process.exit(): 1 after an unhandled
+// exception, otherwise process.exitCode when it is set, otherwise 0
+int exit_status(JSContextRef ctx, JSObjectRef process_obj);
+
 } // namespace process
 } // namespace js
 } // namespace jpm
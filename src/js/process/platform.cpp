@@ -2,6 +2,7 @@
 
 #ifdef USE_JAVASCRIPTCORE
 #include "jpm_config.h"
+#include "utils/platform_utils.h"
 #include <iostream>
 #include <chrono>
 #include <cstring>
@@ -43,21 +44,6 @@ namespace {
         JSObjectSetProperty(ctx, obj, name_str, value_ref, kJSPropertyAttributeNone, nullptr);
         JSStringRelease(name_str);
     }
-
-    // Get architecture string
-    const char* get_arch() {
-        #if defined(__x86_64__) || defined(_M_X64)
-            return "x64";
-        #elif defined(__aarch64__) || defined(_M_ARM64)
-            return "arm64";
-        #elif defined(__arm__) || defined(_M_ARM)
-            return "arm";
-        #elif defined(__i386__) || defined(_M_IX86)
-            return "x86";
-        #else
-            return "unknown";
-        #endif
-    }
 }
 
 void setup_platform(JSContextRef ctx, JSObjectRef process_obj) {
@@ -99,17 +85,11 @@ void setup_platform(JSContextRef ctx, JSObjectRef process_obj) {
     JSObjectSetProperty(ctx, process_obj, memory_usage_name, memory_usage_func, kJSPropertyAttributeNone, nullptr);
     JSStringRelease(memory_usage_name);
 
-    // Set platform
-    #ifdef _WIN32
-        set_string_property(ctx, process_obj, "platform", "win32");
-    #elif defined(__APPLE__)
-        set_string_property(ctx, process_obj, "platform", "darwin");
-    #else
-        set_string_property(ctx, process_obj, "platform", "linux");
-    #endif
+    // Set platform (shared with the package installer so os/cpu filtering agrees with what scripts see)
+    set_string_property(ctx, process_obj, "platform", PlatformUtils::host_os());
 
     // Set architecture
-    set_string_property(ctx, process_obj, "arch", get_arch());
+    set_string_property(ctx, process_obj, "arch", PlatformUtils::host_cpu());
 
     // Set version (using PROJECT_VERSION from CMake)
     set_string_property(ctx, process_obj, "version", PROJECT_VERSION);
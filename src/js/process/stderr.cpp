@@ -2,8 +2,9 @@
 
 #ifdef USE_JAVASCRIPTCORE
 #include "jpm_config.h"
+#include "js/buffer.h"
+#include "js/output_stream.h"
 #include <iostream>
-#include <cstring>
 
 namespace jpm {
 namespace js {
@@ -18,20 +19,25 @@ void setup_stderr(JSContextRef ctx, JSObjectRef process_obj) {
     JSObjectRef write_function = JSObjectMakeFunctionWithCallback(ctx, write_function_name,
         [](JSContextRef ctx_inner, JSObjectRef function, JSObjectRef thisObject,
            size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) -> JSValueRef {
-            if (argumentCount > 0) {
+            OutputStream& stream = OutputStream::for_stderr();
+            char* data = nullptr;
+            size_t size = 0;
+            if (argumentCount > 0 && get_buffer_bytes(ctx_inner, arguments[0], data, size)) {
+                // Buffers and other typed arrays go out as their bytes
+                stream.write(data, size);
+            } else if (argumentCount > 0) {
                 JSStringRef str_ref = JSValueToStringCopy(ctx_inner, arguments[0], nullptr);
-                size_t max_size = JSStringGetMaximumUTF8CStringSize(str_ref);
-                std::string output;
-                output.resize(max_size);
-                JSStringGetUTF8CString(str_ref, output.data(), max_size);
-                size_t len = strlen(output.c_str());
-                std::cerr << output.substr(0, len) << std::flush;
+                if (!str_ref) {
+                    return JSValueMakeUndefined(ctx_inner);
+                }
+                size = JSStringGetLength(str_ref);
+                stream.write_utf16(reinterpret_cast<const uint16_t*>(JSStringGetCharactersPtr(str_ref)), size);
                 JSStringRelease(str_ref);
+            }
 
-                if (g_verbose_output) {
-                    std::cout << std::endl << "[verbose] process.stderr.write called with length: " 
-                              << len << std::endl;
-                }
+            if (g_verbose_output && argumentCount > 0) {
+                std::cout << std::endl << "[verbose] process.stderr.write called with length: "
+                          << size << std::endl;
             }
             return JSValueMakeUndefined(ctx_inner);
         });
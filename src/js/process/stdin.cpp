@@ -2,90 +2,354 @@
 
 #ifdef USE_JAVASCRIPTCORE
 #include "jpm_config.h"
+#include "js/buffer.h"
+#include "js/fs_operations.h"
+#include "js/process/events.h"
+#include "js/stdin_reader.h"
+#include "js/text_codec.h"
 #include <iostream>
+#include <optional>
 #include <string>
-#include <cstring>
+#include <unistd.h>
 
 namespace jpm {
 namespace js {
 namespace process {
 
+namespace {
+
+// The JS side of process.stdin: a paused/flowing readable with its own listener
+// list. native.push() and native.end() are how chunks get to it; data is emitted
+// while the stream flows and buffered while it is paused.
+constexpr const char* kStdinFactory = R"JS((function (native) {
+'use strict';
+const listeners = new Map();
+const buffered = [];
+let flowing = null; // null until something reads: a 'data' listener, resume() or an iterator
+let ended = false;
+let endEmitted = false;
+
+function emit(name, args) {
+  const list = listeners.get(name);
+  if (!list || list.length === 0) return false;
+  for (const entry of list.slice()) {
+    if (entry.once) removeListener(name, entry.listener);
+    entry.listener.apply(stdin, args);
+  }
+  return true;
+}
+
+function addListener(name, listener, once) {
+  if (typeof listener !== 'function') throw new TypeError('The "listener" argument must be of type function');
+  if (!listeners.has(name)) listeners.set(name, []);
+  listeners.get(name).push({ listener, once });
+  if (name === 'data' && flowing !== false) stdin.resume();
+  return stdin;
+}
+
+function removeListener(name, listener) {
+  const list = listeners.get(name);
+  if (list) {
+    const index = list.findIndex(entry => entry.listener === listener);
+    if (index >= 0) list.splice(index, 1);
+  }
+  return stdin;
+}
+
+function flush() {
+  while (flowing && buffered.length > 0) emit('data', [buffered.shift()]);
+  if (flowing && ended && buffered.length === 0 && !endEmitted) {
+    endEmitted = true;
+    emit('end', []);
+    emit('close', []);
+  }
+}
+
+const stdin = {
+  fd: 0,
+  isTTY: native.isTTY,
+  get readableFlowing() { return flowing; },
+  get readableEnded() { return endEmitted; },
+  on(name, listener) { return addListener(name, listener, false); },
+  once(name, listener) { return addListener(name, listener, true); },
+  off(name, listener) { return removeListener(name, listener); },
+  removeAllListeners(name) {
+    if (name === undefined) listeners.clear(); else listeners.delete(name);
+    return stdin;
+  },
+  emit(name, ...args) { return emit(name, args); },
+  listenerCount(name) { return (listeners.get(name) || []).length; },
+  pause() {
+    if (flowing !== false) {
+      flowing = false;
+      native.pause();
+    }
+    return stdin;
+  },
+  resume() {
+    if (!flowing) {
+      flowing = true;
+      native.resume();
+      Promise.resolve().then(flush);
+    }
+    return stdin;
+  },
+  isPaused() { return flowing === false; },
+  setEncoding(encoding) {
+    native.setEncoding(encoding);
+    return stdin;
+  },
+  // Chunks as they arrive; reading pauses while more than a few wait to be consumed
+  [Symbol.asyncIterator]() {
+    const queue = [];
+    let done = false;
+    let failure = null;
+    let wake = null;
+    const notify = () => {
+      if (wake) {
+        const resolve = wake;
+        wake = null;
+        resolve();
+      }
+    };
+    const onData = chunk => {
+      queue.push(chunk);
+      if (queue.length >= 4) stdin.pause();
+      notify();
+    };
+    const onEnd = () => { done = true; notify(); };
+    const onError = error => { failure = error; notify(); };
+    const cleanup = () => {
+      removeListener('data', onData);
+      removeListener('end', onEnd);
+      removeListener('error', onError);
+    };
+    stdin.on('end', onEnd).on('error', onError);
+    stdin.on('data', onData).resume();
+    return {
+      async next() {
+        for (;;) {
+          if (queue.length > 0) {
+            const value = queue.shift();
+            if (queue.length === 0 && flowing === false && !done) stdin.resume();
+            return { value, done: false };
+          }
+          if (failure) {
+            cleanup();
+            throw failure;
+          }
+          if (done) {
+            cleanup();
+            return { value: undefined, done: true };
+          }
+          await new Promise(resolve => { wake = resolve; });
+        }
+      },
+      async return() {
+        cleanup();
+        stdin.pause();
+        return { value: undefined, done: true };
+      },
+      [Symbol.asyncIterator]() { return this; }
+    };
+  }
+};
+stdin.addListener = stdin.on;
+stdin.removeListener = stdin.off;
+
+native.push = chunk => {
+  if (flowing && buffered.length === 0) emit('data', [chunk]);
+  else buffered.push(chunk);
+};
+native.end = (code, message) => {
+  ended = true;
+  if (code) {
+    const error = new Error(message);
+    error.code = code;
+    error.syscall = 'read';
+    if (!emit('error', [error])) throw error;
+    return;
+  }
+  flush();
+};
+return stdin;
+}))JS";
+
+// The context and JS callbacks chunks are delivered to, and the decoder state
+// after setEncoding()
+struct StdinState {
+    JSGlobalContextRef context = nullptr;
+    JSObjectRef push = nullptr;
+    JSObjectRef end = nullptr;
+    std::optional<TextEncoding> encoding;
+    std::string carry; // Bytes of a character cut at the end of the last chunk
+};
+
+StdinState state;
+
+JSValueRef make_string(JSContextRef ctx, const std::string& text) {
+    JSStringRef str = JSStringCreateWithUTF8CString(text.c_str());
+    JSValueRef value = JSValueMakeString(ctx, str);
+    JSStringRelease(str);
+    return value;
+}
+
+JSValueRef get_property(JSContextRef ctx, JSObjectRef object, const char* name) {
+    JSStringRef key = JSStringCreateWithUTF8CString(name);
+    JSValueRef value = JSObjectGetProperty(ctx, object, key, nullptr);
+    JSStringRelease(key);
+    return value;
+}
+
+void set_function(JSContextRef ctx, JSObjectRef object, const char* name, JSObjectCallAsFunctionCallback callback) {
+    JSStringRef key = JSStringCreateWithUTF8CString(name);
+    JSObjectSetProperty(ctx, object, key, JSObjectMakeFunctionWithCallback(ctx, key, callback),
+                        kJSPropertyAttributeNone, nullptr);
+    JSStringRelease(key);
+}
+
+JSObjectRef protected_function(JSContextRef ctx, JSObjectRef object, const char* name) {
+    JSValueRef value = get_property(ctx, object, name);
+    if (!JSValueIsObject(ctx, value)) {
+        return nullptr;
+    }
+    JSObjectRef function = JSValueToObject(ctx, value, nullptr);
+    JSValueProtect(ctx, function);
+    return function;
+}
+
+void call(JSObjectRef function, size_t argumentCount, const JSValueRef arguments[]) {
+    if (!function) {
+        return;
+    }
+    JSValueRef exception = nullptr;
+    JSObjectCallAsFunction(state.context, function, nullptr, argumentCount, arguments, &exception);
+    if (exception) {
+        handle_uncaught_exception(state.context, exception);
+    }
+}
+
+// The whole characters received so far, as a string; the rest waits for the next chunk
+JSValueRef decode_chunk(std::string chunk, bool last) {
+    if (state.carry.empty()) {
+        state.carry.swap(chunk);
+    } else {
+        state.carry.append(chunk);
+    }
+    const size_t whole = last ? state.carry.size() : complete_length(state.carry.data(), state.carry.size(), *state.encoding);
+    JSValueRef text = decode_text(state.context, state.carry.data(), whole, *state.encoding);
+    state.carry.erase(0, whole);
+    return text;
+}
+
+void on_data(std::string chunk) {
+    JSValueRef value;
+    if (state.encoding) {
+        value = decode_chunk(std::move(chunk), false);
+    } else {
+        // 64 KB chunks are past the pooling limit, so the Buffer adopts the bytes read
+        JSObjectRef buffer = make_buffer(state.context, std::move(chunk));
+        if (!buffer) {
+            return;
+        }
+        value = buffer;
+    }
+    call(state.push, 1, &value);
+}
+
+void on_end(int error) {
+    if (state.encoding && !state.carry.empty()) {
+        JSValueRef rest = decode_chunk(std::string(), true);
+        call(state.push, 1, &rest);
+    }
+    if (error == 0) {
+        call(state.end, 0, nullptr);
+        return;
+    }
+    JSValueRef arguments[] = {make_string(state.context, error_code_name(error)),
+                              make_string(state.context, std::string(error_code_name(error)) + ": " +
+                                                             error_description(error) + ", read")};
+    call(state.end, 2, arguments);
+}
+
+JSValueRef native_resume(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t, const JSValueRef[], JSValueRef*) {
+    StdinReader::getInstance().resume();
+    return JSValueMakeUndefined(ctx);
+}
+
+JSValueRef native_pause(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t, const JSValueRef[], JSValueRef*) {
+    StdinReader::getInstance().pause();
+    return JSValueMakeUndefined(ctx);
+}
+
+JSValueRef native_set_encoding(JSContextRef ctx, JSObjectRef, JSObjectRef,
+                               size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) {
+    if (argumentCount == 0 || JSValueIsUndefined(ctx, arguments[0]) || JSValueIsNull(ctx, arguments[0])) {
+        state.encoding = TextEncoding::Utf8;
+        return JSValueMakeUndefined(ctx);
+    }
+    JSStringRef name_ref = JSValueToStringCopy(ctx, arguments[0], nullptr);
+    std::string name;
+    if (name_ref) {
+        size_t max_size = JSStringGetMaximumUTF8CStringSize(name_ref);
+        name.resize(max_size);
+        name.resize(JSStringGetUTF8CString(name_ref, &name[0], max_size) - 1);
+        JSStringRelease(name_ref);
+    }
+    TextEncoding encoding;
+    if (!parse_text_encoding(name, encoding)) {
+        JSValueRef message = make_string(ctx, "Unknown encoding: " + name);
+        *exception = JSObjectMakeError(ctx, 1, &message, nullptr);
+        return JSValueMakeUndefined(ctx);
+    }
+    state.encoding = encoding;
+    return JSValueMakeUndefined(ctx);
+}
+
+} // namespace
+
 void setup_stdin(JSContextRef ctx, JSObjectRef process_obj) {
-    // Create process.stdin object
-    JSObjectRef stdin_obj = JSObjectMake(ctx, nullptr, nullptr);
-
-    // Create stdin.on function for event handling
-    JSStringRef on_function_name = JSStringCreateWithUTF8CString("on");
-    JSObjectRef on_function = JSObjectMakeFunctionWithCallback(ctx, on_function_name,
-        [](JSContextRef ctx_inner, JSObjectRef function, JSObjectRef thisObject,
-           size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) -> JSValueRef {
-            // Expect: arguments[0] = event name (string), arguments[1] = callback (function)
-            if (argumentCount >= 2 && JSValueIsString(ctx_inner, arguments[0]) && 
-                JSValueIsObject(ctx_inner, arguments[1])) {
-                
-                // Get the event name
-                JSStringRef event_str_ref = JSValueToStringCopy(ctx_inner, arguments[0], nullptr);
-                size_t max_size = JSStringGetMaximumUTF8CStringSize(event_str_ref);
-                std::string event_name;
-                event_name.resize(max_size);
-                JSStringGetUTF8CString(event_str_ref, event_name.data(), max_size);
-                size_t len = strlen(event_name.c_str());
-                event_name = event_name.substr(0, len);
-                JSStringRelease(event_str_ref);
-
-                if (event_name == "data") {
-                    if (g_verbose_output) {
-                        std::cout << "process.stdin.on('data') registered" << std::endl;
-                    }
-
-                    // Read one line from stdin synchronously
-                    std::string line;
-                    if (!std::getline(std::cin, line)) {
-                        line.clear();
-                        if (g_verbose_output) {
-                            std::cout << "Failed to read from stdin" << std::endl;
-                        }
-                    }
-
-                    // Convert the line to a JS string and call the callback
-                    JSStringRef js_line = JSStringCreateWithUTF8CString(line.c_str());
-                    JSValueRef js_value = JSValueMakeString(ctx_inner, js_line);
-                    JSStringRelease(js_line);
-
-                    JSObjectRef callback = (JSObjectRef)arguments[1];
-                    JSValueRef callback_exception = nullptr;
-                    JSObjectCallAsFunction(ctx_inner, callback, nullptr, 1, &js_value, &callback_exception);
-
-                    if (callback_exception) {
-                        JSStringRef exc_str = JSValueToStringCopy(ctx_inner, callback_exception, nullptr);
-                        size_t exc_size = JSStringGetMaximumUTF8CStringSize(exc_str);
-                        std::string error_msg;
-                        error_msg.resize(exc_size);
-                        JSStringGetUTF8CString(exc_str, error_msg.data(), exc_size);
-                        size_t exc_len = strlen(error_msg.c_str());
-                        std::cerr << "Error in process.stdin.on callback: " 
-                                 << error_msg.substr(0, exc_len) << std::endl;
-                        JSStringRelease(exc_str);
-                    }
-                } else if (g_verbose_output) {
-                    std::cout << "Ignoring unsupported stdin event: " << event_name << std::endl;
-                }
-            }
-            return JSValueMakeUndefined(ctx_inner);
-        });
-
-    JSObjectSetProperty(ctx, stdin_obj, on_function_name, on_function, 
-                       kJSPropertyAttributeNone, nullptr);
-    JSStringRelease(on_function_name);
+    if (state.push) {
+        JSValueUnprotect(state.context, state.push);
+    }
+    if (state.end) {
+        JSValueUnprotect(state.context, state.end);
+    }
+    state = StdinState();
+    state.context = JSContextGetGlobalContext(ctx);
+
+    JSObjectRef natives = JSObjectMake(ctx, nullptr, nullptr);
+    set_function(ctx, natives, "resume", native_resume);
+    set_function(ctx, natives, "pause", native_pause);
+    set_function(ctx, natives, "setEncoding", native_set_encoding);
+    JSStringRef tty_name = JSStringCreateWithUTF8CString("isTTY");
+    JSObjectSetProperty(ctx, natives, tty_name, JSValueMakeBoolean(ctx, isatty(STDIN_FILENO) == 1),
+                        kJSPropertyAttributeNone, nullptr);
+    JSStringRelease(tty_name);
+
+    JSStringRef factory_source = JSStringCreateWithUTF8CString(kStdinFactory);
+    JSValueRef factory = JSEvaluateScript(ctx, factory_source, nullptr, nullptr, 1, nullptr);
+    JSStringRelease(factory_source);
+    if (!factory || !JSValueIsObject(ctx, factory)) {
+        return;
+    }
+    JSValueRef argument = natives;
+    JSValueRef stdin_obj = JSObjectCallAsFunction(ctx, JSValueToObject(ctx, factory, nullptr), nullptr, 1, &argument, nullptr);
+    if (!stdin_obj || !JSValueIsObject(ctx, stdin_obj)) {
+        return;
+    }
+    state.push = protected_function(ctx, natives, "push");
+    state.end = protected_function(ctx, natives, "end");
+    StdinReader::getInstance().set_callbacks(on_data, on_end);
 
     // Set stdin object on process
     JSStringRef stdin_name = JSStringCreateWithUTF8CString("stdin");
-    JSObjectSetProperty(ctx, process_obj, stdin_name, stdin_obj, 
+    JSObjectSetProperty(ctx, process_obj, stdin_name, stdin_obj,
                        kJSPropertyAttributeNone, nullptr);
     JSStringRelease(stdin_name);
 
     if (g_verbose_output) {
-        std::cout << "Setup process.stdin object and on() function" << std::endl;
+        std::cout << "Setup process.stdin stream" << std::endl;
     }
 }
 
@@ -93,4 +357,4 @@ void setup_stdin(JSContextRef ctx, JSObjectRef process_obj) {
 } // namespace js
 } // namespace jpm
 
-#endif // USE_JAVASCRIPTCORE
\ No newline at end of file
+#endif // USE_JAVASCRIPTCORE
@@ -9,8 +9,9 @@ namespace js {
 namespace process {
 
 // Sets up process.stdin in the given JavaScript context
-// Implements process.stdin.on('data', callback) for reading from standard input
-// Currently implements a synchronous read when 'data' event is registered
+// A readable stream fed by StdinReader: 'data' events with Buffers (strings after
+// setEncoding()), then 'end' and 'close'; pause()/resume() stop and restart the
+// reading, and for await yields the chunks
 void setup_stdin(JSContextRef ctx, JSObjectRef process_obj);
 
 } // namespace process
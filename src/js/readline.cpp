@@ -0,0 +1,318 @@
+#include "js/readline.h"
+#include "js/buffer.h"
+#include "js/module.h"
+#include <cstring>
+#include <string>
+
+namespace jpm::js {
+
+namespace {
+
+// Interface keeps the unfinished line of a Buffer stream as a view of the chunk it
+// came from; native.splitLines() reports where that tail starts as restStart, -1
+// when the chunk had no newline at all.
+constexpr const char* kReadlineFactory = R"JS((function (native) {
+'use strict';
+
+class LineIterator {
+  constructor(rl) {
+    this.rl = rl;
+    this.batches = [];
+    this.batch = null;
+    this.index = 0;
+    this.done = false;
+    this.paused = false;
+    this.wake = null;
+  }
+
+  add(lines) {
+    this.batches.push(lines);
+    // Stop reading while the consumer is this far behind
+    if (this.batches.length >= 8 && !this.paused) {
+      this.paused = true;
+      this.rl.input.pause();
+    }
+    this.notify();
+  }
+
+  finish() {
+    this.done = true;
+    this.notify();
+  }
+
+  notify() {
+    if (this.wake) {
+      const wake = this.wake;
+      this.wake = null;
+      wake();
+    }
+  }
+
+  next() {
+    for (;;) {
+      if (this.batch && this.index < this.batch.length) {
+        return Promise.resolve({ value: this.batch[this.index++], done: false });
+      }
+      if (this.batches.length > 0) {
+        this.batch = this.batches.shift();
+        this.index = 0;
+        if (this.paused && this.batches.length === 0 && !this.rl.closed) {
+          this.paused = false;
+          this.rl.input.resume();
+        }
+        continue;
+      }
+      if (this.done) return Promise.resolve({ value: undefined, done: true });
+      return new Promise(resolve => { this.wake = () => resolve(this.next()); });
+    }
+  }
+
+  return() {
+    this.rl.close();
+    this.batches = [];
+    this.batch = null;
+    return Promise.resolve({ value: undefined, done: true });
+  }
+
+  [Symbol.asyncIterator]() { return this; }
+}
+
+class Interface {
+  constructor(input, output) {
+    this.input = input;
+    this.output = output;
+    this.terminal = false;
+    this.closed = false;
+    this._listeners = new Map();
+    this._prompt = '> ';
+    this._rest = null;     // Bytes of the unfinished line, from a Buffer stream
+    this._text = '';       // Or its text, from a stream with an encoding set
+    this._answer = null;   // question()'s callback, which gets the next line
+    this._iterator = null;
+    this._onData = chunk => this._push(chunk);
+    this._onEnd = () => this._finish();
+    input.on('data', this._onData);
+    input.on('end', this._onEnd);
+  }
+
+  on(name, listener) {
+    if (!this._listeners.has(name)) this._listeners.set(name, []);
+    this._listeners.get(name).push({ listener, once: false });
+    return this;
+  }
+
+  once(name, listener) {
+    this.on(name, listener);
+    const list = this._listeners.get(name);
+    list[list.length - 1].once = true;
+    return this;
+  }
+
+  off(name, listener) {
+    const list = this._listeners.get(name);
+    if (list) {
+      const index = list.findIndex(entry => entry.listener === listener);
+      if (index >= 0) list.splice(index, 1);
+    }
+    return this;
+  }
+
+  emit(name, ...args) {
+    const list = this._listeners.get(name);
+    if (!list || list.length === 0) return false;
+    for (const entry of list.slice()) {
+      if (entry.once) this.off(name, entry.listener);
+      entry.listener.apply(this, args);
+    }
+    return true;
+  }
+
+  setPrompt(prompt) { this._prompt = String(prompt); }
+  getPrompt() { return this._prompt; }
+
+  prompt() {
+    if (this.output) this.output.write(this._prompt);
+    if (this.input.isPaused && this.input.isPaused()) this.input.resume();
+  }
+
+  question(query, callback) {
+    if (this.closed) throw new Error('readline was closed');
+    if (this.output) this.output.write(String(query));
+    this._answer = callback;
+  }
+
+  pause() { this.input.pause(); this.emit('pause'); return this; }
+  resume() { this.input.resume(); this.emit('resume'); return this; }
+
+  close() {
+    if (this.closed) return;
+    this.closed = true;
+    this.input.off('data', this._onData);
+    this.input.off('end', this._onEnd);
+    this.input.pause();
+    if (this._iterator) this._iterator.finish();
+    this.emit('close');
+  }
+
+  [Symbol.asyncIterator]() {
+    if (!this._iterator) {
+      this._iterator = new LineIterator(this);
+      if (this.closed) this._iterator.finish();
+    }
+    return this._iterator;
+  }
+
+  _push(chunk) {
+    let lines;
+    if (typeof chunk === 'string') {
+      lines = (this._text + chunk).split('\n');
+      this._text = lines.pop();
+      for (let i = 0; i < lines.length; ++i) {
+        if (lines[i].endsWith('\r')) lines[i] = lines[i].slice(0, -1);
+      }
+    } else {
+      lines = native.splitLines(this._rest, chunk);
+      const start = lines.restStart;
+      if (start < 0) this._rest = this._rest ? Buffer.concat([this._rest, chunk]) : chunk;
+      else this._rest = start < chunk.length ? chunk.subarray(start) : null;
+    }
+    if (lines.length > 0) this._lines(lines);
+  }
+
+  _finish() {
+    let last = null;
+    if (this._rest && this._rest.length > 0) last = native.lastLine(this._rest);
+    else if (this._text.length > 0) last = this._text;
+    this._rest = null;
+    this._text = '';
+    if (last !== null) this._lines([last]);
+    this.close();
+  }
+
+  _lines(lines) {
+    if (this._iterator) this._iterator.add(lines);
+    if (this._answer === null && !this._listeners.has('line')) return;
+    for (let i = 0; i < lines.length && !this.closed; ++i) {
+      if (this._answer !== null) {
+        const answer = this._answer;
+        this._answer = null;
+        answer(lines[i]);
+      } else {
+        this.emit('line', lines[i]);
+      }
+    }
+  }
+}
+
+function createInterface(input, output) {
+  if (input && typeof input.on !== 'function' && input.input !== undefined) {
+    output = input.output;
+    input = input.input;
+  }
+  if (!input || typeof input.on !== 'function') {
+    throw new TypeError('The "input" argument must be a readable stream');
+  }
+  return new Interface(input, output);
+}
+
+return { createInterface, Interface };
+}))JS";
+
+void set_property(JSContextRef ctx, JSObjectRef object, const char* name, JSValueRef value) {
+    JSStringRef key = JSStringCreateWithUTF8CString(name);
+    JSObjectSetProperty(ctx, object, key, value, kJSPropertyAttributeNone, nullptr);
+    JSStringRelease(key);
+}
+
+void set_function(JSContextRef ctx, JSObjectRef object, const char* name, JSObjectCallAsFunctionCallback callback) {
+    JSStringRef key = JSStringCreateWithUTF8CString(name);
+    JSObjectSetProperty(ctx, object, key, JSObjectMakeFunctionWithCallback(ctx, key, callback),
+                        kJSPropertyAttributeNone, nullptr);
+    JSStringRelease(key);
+}
+
+JSValueRef make_line(JSContextRef ctx, const char* data, size_t size) {
+    if (size > 0 && data[size - 1] == '\r') {
+        --size;
+    }
+    return decode_text(ctx, data, size, TextEncoding::Utf8);
+}
+
+JSValueRef chunk_error(JSContextRef ctx, JSValueRef* exception) {
+    JSStringRef message = JSStringCreateWithUTF8CString("The \"chunk\" argument must be a Buffer");
+    JSValueRef argument = JSValueMakeString(ctx, message);
+    JSStringRelease(message);
+    *exception = JSObjectMakeError(ctx, 1, &argument, nullptr);
+    return JSValueMakeUndefined(ctx);
+}
+
+// splitLines(rest, chunk): the complete lines in chunk as strings, the first
+// prefixed by rest (the unfinished line so far)
+JSValueRef native_split_lines(JSContextRef ctx, JSObjectRef, JSObjectRef,
+                              size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) {
+    char* data = nullptr;
+    size_t size = 0;
+    if (argumentCount < 2 || !get_buffer_bytes(ctx, arguments[1], data, size)) {
+        return chunk_error(ctx, exception);
+    }
+    char* rest = nullptr;
+    size_t restSize = 0;
+    if (!JSValueIsUndefined(ctx, arguments[0]) && !JSValueIsNull(ctx, arguments[0])) {
+        get_buffer_bytes(ctx, arguments[0], rest, restSize);
+    }
+
+    // Lines are stored as they are made, so each is reachable before the next allocates
+    JSObjectRef lines = JSObjectMakeArray(ctx, 0, nullptr, nullptr);
+    const char* const end = data + size;
+    const char* start = data;
+    const char* newline = static_cast<const char*>(std::memchr(start, '\n', size));
+    unsigned index = 0;
+    if (newline && restSize > 0) {
+        std::string first(rest, restSize);
+        first.append(start, newline);
+        JSObjectSetPropertyAtIndex(ctx, lines, index++, make_line(ctx, first.data(), first.size()), nullptr);
+        start = newline + 1;
+        newline = static_cast<const char*>(std::memchr(start, '\n', static_cast<size_t>(end - start)));
+    }
+    while (newline) {
+        JSObjectSetPropertyAtIndex(ctx, lines, index++, make_line(ctx, start, static_cast<size_t>(newline - start)), nullptr);
+        start = newline + 1;
+        newline = static_cast<const char*>(std::memchr(start, '\n', static_cast<size_t>(end - start)));
+    }
+    const bool found = index > 0;
+    set_property(ctx, lines, "restStart", JSValueMakeNumber(ctx, found ? static_cast<double>(start - data) : -1));
+    return lines;
+}
+
+// lastLine(rest): the unfinished line at the end of the input
+JSValueRef native_last_line(JSContextRef ctx, JSObjectRef, JSObjectRef,
+                            size_t argumentCount, const JSValueRef arguments[], JSValueRef* exception) {
+    char* data = nullptr;
+    size_t size = 0;
+    if (argumentCount < 1 || !get_buffer_bytes(ctx, arguments[0], data, size)) {
+        return chunk_error(ctx, exception);
+    }
+    return make_line(ctx, data, size);
+}
+
+} // namespace
+
+void setup_readline(JSContextRef ctx) {
+    JSObjectRef natives = JSObjectMake(ctx, nullptr, nullptr);
+    set_function(ctx, natives, "splitLines", native_split_lines);
+    set_function(ctx, natives, "lastLine", native_last_line);
+
+    JSStringRef factorySource = JSStringCreateWithUTF8CString(kReadlineFactory);
+    JSValueRef factory = JSEvaluateScript(ctx, factorySource, nullptr, nullptr, 1, nullptr);
+    JSStringRelease(factorySource);
+    if (!factory || !JSValueIsObject(ctx, factory)) {
+        return;
+    }
+    JSValueRef argument = natives;
+    JSValueRef readline = JSObjectCallAsFunction(ctx, JSValueToObject(ctx, factory, nullptr), nullptr, 1, &argument, nullptr);
+    if (readline && JSValueIsObject(ctx, readline)) {
+        ModuleSystem::getInstance().registerBuiltinModule("readline", JSValueToObject(ctx, readline, nullptr));
+    }
+}
+
+} // namespace jpm::js
@@ -0,0 +1,19 @@
+#ifndef JPM_READLINE_H
+#define JPM_READLINE_H
+
+#include <JavaScriptCore/JavaScript.h>
+
+namespace jpm::js {
+
+// Registers the built-in "readline" module: createInterface({input, output}) over
+// process.stdin or any stream with 'data' and 'end' events, with 'line' and
+// 'close' events, question(), prompt() and for await over the lines.
+//
+// Buffer chunks are split natively with memchr(), which glibc vectorizes, and the
+// lines of a chunk go to the async iterator as one batch. Lines end at "\n", and a
+// "\r" before it is dropped; a lone "\r" does not end a line.
+void setup_readline(JSContextRef ctx);
+
+} // namespace jpm::js
+
+#endif // JPM_READLINE_H
@@ -0,0 +1,218 @@
+#include "js/source_loader.h"
+#include "utils/file_utils.h"
+#include "jpm_config.h"
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#if defined(__has_include)
+#if __has_include(<JavaScriptCore/JSStringRefPrivate.h>)
+#include <JavaScriptCore/JSStringRefPrivate.h>
+#define JPM_HAVE_JSSTRING_NOCOPY 1
+#endif
+#endif
+
+namespace jpm::js {
+
+namespace {
+
+// No byte >= 0x80 and no NUL, eight bytes at a time
+bool scan_ascii(std::string_view text) {
+    constexpr uint64_t kHigh = 0x8080808080808080ULL;
+    constexpr uint64_t kOnes = 0x0101010101010101ULL;
+    const char* p = text.data();
+    const char* end = p + text.size();
+    for (; end - p >= 8; p += 8) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        if ((word & kHigh) || ((word - kOnes) & ~word & kHigh)) {
+            return false;
+        }
+    }
+    for (; p < end; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == 0 || c >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Decodes UTF-8 into out, which must hold text.size() units (UTF-16 never needs more).
+// Malformed sequences become U+FFFD. Returns the number of units written.
+size_t utf8_to_utf16(std::string_view text, JSChar* out) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(text.data());
+    const unsigned char* end = p + text.size();
+    JSChar* start = out;
+    while (p < end) {
+        // Runs of ASCII are the common case even in non-ASCII files
+        while (p < end && *p < 0x80) {
+            *out++ = *p++;
+        }
+        if (p == end) {
+            break;
+        }
+        unsigned char lead = *p;
+        size_t length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC2 ? 2 : 0;
+        uint32_t code_point = 0;
+        bool valid = length != 0 && static_cast<size_t>(end - p) >= length;
+        if (valid) {
+            code_point = lead & (0xFF >> (length + 1));
+            for (size_t i = 1; i < length; ++i) {
+                if ((p[i] & 0xC0) != 0x80) {
+                    valid = false;
+                    break;
+                }
+                code_point = (code_point << 6) | (p[i] & 0x3F);
+            }
+        }
+        // Overlong forms, surrogates and values past U+10FFFF are not valid UTF-8
+        if (valid && ((length == 3 && (code_point < 0x800 || (code_point >= 0xD800 && code_point <= 0xDFFF))) ||
+                      (length == 4 && (code_point < 0x10000 || code_point > 0x10FFFF)))) {
+            valid = false;
+        }
+        if (!valid) {
+            *out++ = 0xFFFD;
+            ++p;
+            continue;
+        }
+        if (code_point >= 0x10000) {
+            code_point -= 0x10000;
+            *out++ = static_cast<JSChar>(0xD800 + (code_point >> 10));
+            *out++ = static_cast<JSChar>(0xDC00 + (code_point & 0x3FF));
+        } else {
+            *out++ = static_cast<JSChar>(code_point);
+        }
+        p += length;
+    }
+    return static_cast<size_t>(out - start);
+}
+
+#ifdef JPM_HAVE_JSSTRING_NOCOPY
+// Buffers adopted by JSC. Compiled code keeps referring to its source for as long
+// as the context lives, so they are kept for the rest of the process.
+void keep_alive(std::unique_ptr<JSChar[]> buffer) {
+    static std::mutex mutex;
+    static std::vector<std::unique_ptr<JSChar[]>> buffers;
+    std::lock_guard<std::mutex> lock(mutex);
+    buffers.push_back(std::move(buffer));
+}
+#endif
+
+JSStringRef create_utf16_string(std::string_view prefix, std::string_view text, std::string_view suffix) {
+    std::unique_ptr<JSChar[]> buffer(new JSChar[prefix.size() + text.size() + suffix.size()]);
+    JSChar* out = buffer.get();
+    for (char c : prefix) *out++ = static_cast<unsigned char>(c);
+    out += utf8_to_utf16(text, out);
+    for (char c : suffix) *out++ = static_cast<unsigned char>(c);
+    size_t length = static_cast<size_t>(out - buffer.get());
+#ifdef JPM_HAVE_JSSTRING_NOCOPY
+    JSStringRef string = JSStringCreateWithCharactersNoCopy(buffer.get(), length);
+    keep_alive(std::move(buffer));
+    return string;
+#else
+    return JSStringCreateWithCharacters(buffer.get(), length);
+#endif
+}
+
+} // namespace
+
+SourceFile::~SourceFile() {
+#ifndef _WIN32
+    if (mapping_) {
+        munmap(mapping_, mapped_size_);
+    }
+#endif
+}
+
+std::unique_ptr<SourceFile> SourceFile::open(const std::string& path) {
+    std::unique_ptr<SourceFile> source(new SourceFile());
+    char* data = nullptr;
+    size_t size = 0;
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return nullptr;
+    }
+    if (st.st_size > 0) {
+        // Private and writable so the shebang can be blanked; only that page gets copied
+        void* mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            source->mapping_ = mapping;
+            source->mapped_size_ = static_cast<size_t>(st.st_size);
+            data = static_cast<char*>(mapping);
+            size = source->mapped_size_;
+            // The rest of a partially used last page reads as zeros
+            long page_size = sysconf(_SC_PAGESIZE);
+            source->nul_terminated_ = page_size > 0 && size % static_cast<size_t>(page_size) != 0;
+        }
+    }
+    close(fd);
+#endif
+    if (!data) {
+        std::optional<std::string> content = FileUtils::read_file(path);
+        if (!content) {
+            return nullptr;
+        }
+        source->owned_ = std::move(*content);
+        data = source->owned_.data();
+        size = source->owned_.size();
+        source->nul_terminated_ = true;
+    }
+
+    if (size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        data += 3;
+        size -= 3;
+    }
+    if (size >= 2 && data[0] == '#' && data[1] == '!') {
+        data[0] = '/';
+        data[1] = '/';
+    }
+    source->text_ = std::string_view(data, size);
+    source->ascii_ = scan_ascii(source->text_);
+    return source;
+}
+
+JSStringRef create_source_string(const SourceFile& source, std::string_view prefix, std::string_view suffix) {
+    std::string_view text = source.text();
+    if (source.is_ascii()) {
+        if (prefix.empty() && suffix.empty() && source.nul_terminated()) {
+            return JSStringCreateWithUTF8CString(text.data());
+        }
+        std::string joined;
+        joined.reserve(prefix.size() + text.size() + suffix.size());
+        joined.append(prefix).append(text).append(suffix);
+        return JSStringCreateWithUTF8CString(joined.c_str());
+    }
+    return create_utf16_string(prefix, text, suffix);
+}
+
+JSStringRef create_source_string(std::string_view text) {
+    if (scan_ascii(text)) {
+        return JSStringCreateWithUTF8CString(std::string(text).c_str());
+    }
+    return create_utf16_string({}, text, {});
+}
+
+JSStringRef create_string(std::string_view text) {
+    if (scan_ascii(text)) {
+        return JSStringCreateWithUTF8CString(std::string(text).c_str());
+    }
+    std::unique_ptr<JSChar[]> buffer(new JSChar[text.size()]);
+    size_t length = utf8_to_utf16(text, buffer.get());
+    return JSStringCreateWithCharacters(buffer.get(), length);
+}
+
+} // namespace jpm::js
@@ -0,0 +1,64 @@
+#ifndef JPM_SOURCE_LOADER_H
+#define JPM_SOURCE_LOADER_H
+
+#include <JavaScriptCore/JavaScript.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace jpm::js {
+
+// A JavaScript source file, mapped read-only (copy-on-write) where mmap is available,
+// so loading it costs no copy and its pages are dropped again once it is released.
+class SourceFile {
+public:
+    ~SourceFile();
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    // Returns nullptr if the file cannot be opened or read
+    static std::unique_ptr<SourceFile> open(const std::string& path);
+
+    // The file without a UTF-8 byte order mark. A leading "#!" line has its "#!"
+    // replaced by "//" so JSC parses it as a comment and line numbers are kept.
+    std::string_view text() const { return text_; }
+
+    // True when text() has no bytes >= 0x80 and no NUL bytes
+    bool is_ascii() const { return ascii_; }
+
+    // True when the byte after text() is readable and is NUL, so text() can be
+    // passed where a C string is expected
+    bool nul_terminated() const { return nul_terminated_; }
+
+private:
+    SourceFile() = default;
+
+    void* mapping_ = nullptr;
+    size_t mapped_size_ = 0;
+    std::string owned_; // File contents when it is empty or cannot be mapped
+    std::string_view text_;
+    bool ascii_ = true;
+    bool nul_terminated_ = false;
+};
+
+// Creates the string JSC compiles from prefix + source text + suffix, where prefix
+// and suffix are ASCII. jpm copies the source at most once:
+//  - ASCII source, no prefix/suffix, NUL-terminated mapping: handed to JSC as-is
+//  - ASCII source otherwise: one contiguous buffer; JSC keeps it as an 8-bit string
+//  - any other source: transcoded from UTF-8 to UTF-16 in one pass; where the
+//    private JSStringCreateWithCharactersNoCopy is available JSC adopts that buffer
+// The caller releases the result with JSStringRelease.
+JSStringRef create_source_string(const SourceFile& source, std::string_view prefix = {}, std::string_view suffix = {});
+
+// The same for UTF-8 source that is not a file, such as a transformed module
+JSStringRef create_source_string(std::string_view text);
+
+// A string from UTF-8 data such as file contents or Buffer text. Unlike source
+// strings it is always copied, so the caller's bytes can go away; malformed
+// sequences become U+FFFD.
+JSStringRef create_string(std::string_view text);
+
+} // namespace jpm::js
+
+#endif // JPM_SOURCE_LOADER_H
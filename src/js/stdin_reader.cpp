@@ -0,0 +1,156 @@
+#include "js/stdin_reader.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace jpm::js {
+
+StdinReader::StdinReader(EventLoop& loop, int fd) : loop_(loop), fd_(fd) {}
+
+StdinReader::~StdinReader() {
+    shutdown();
+}
+
+void StdinReader::set_callbacks(DataCallback on_data, EndCallback on_end) {
+    on_data_ = std::move(on_data);
+    on_end_ = std::move(on_end);
+}
+
+void StdinReader::resume() {
+    if (ended_) {
+        return;
+    }
+    set_ref(true);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flowing_ = true;
+    }
+    wake_.notify_one();
+    if (!thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = false;
+            in_flight_ = 0;
+        }
+        int fds[2];
+        if (pipe(fds) == 0) {
+            stop_read_ = fds[0];
+            stop_write_ = fds[1];
+            fcntl(stop_read_, F_SETFD, FD_CLOEXEC);
+            fcntl(stop_write_, F_SETFD, FD_CLOEXEC);
+        }
+        thread_ = std::thread(&StdinReader::run, this);
+    }
+}
+
+void StdinReader::pause() {
+    set_ref(false);
+    std::lock_guard<std::mutex> lock(mutex_);
+    flowing_ = false;
+}
+
+void StdinReader::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    if (stop_write_ >= 0) {
+        char byte = 0;
+        while (write(stop_write_, &byte, 1) < 0 && errno == EINTR) {
+        }
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (stop_read_ >= 0) {
+        close(stop_read_);
+        close(stop_write_);
+        stop_read_ = stop_write_ = -1;
+    }
+    set_ref(false);
+    on_data_ = nullptr;
+    on_end_ = nullptr;
+}
+
+void StdinReader::set_ref(bool ref) {
+    if (ref == ref_) {
+        return;
+    }
+    ref_ = ref;
+    if (ref) {
+        loop_.add_ref();
+    } else {
+        loop_.remove_ref();
+    }
+}
+
+void StdinReader::run() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stopping_ || (flowing_ && in_flight_ < kMaxInFlight); });
+            if (stopping_) {
+                return;
+            }
+        }
+        // Wait for input without the lock held, so pause() never waits on a read
+        struct pollfd fds[2] = {{fd_, POLLIN, 0}, {stop_read_, POLLIN, 0}};
+        const nfds_t count = stop_read_ >= 0 ? 2 : 1;
+        if (poll(fds, count, -1) < 0 && errno != EINTR) {
+            const int error = errno;
+            loop_.post([this, error]() { finish(error); });
+            return;
+        }
+        if (count == 2 && fds[1].revents != 0) {
+            return; // shutdown()
+        }
+        if (fds[0].revents == 0) {
+            continue;
+        }
+        std::string chunk(kChunkSize, '\0');
+        ssize_t n = read(fd_, &chunk[0], kChunkSize);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+                continue;
+            }
+            const int error = errno;
+            loop_.post([this, error]() { finish(error); });
+            return;
+        }
+        if (n == 0) {
+            loop_.post([this]() { finish(0); });
+            return;
+        }
+        chunk.resize(static_cast<size_t>(n));
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++in_flight_;
+        }
+        loop_.post([this, chunk = std::move(chunk)]() mutable { deliver(std::move(chunk)); });
+    }
+}
+
+void StdinReader::deliver(std::string chunk) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --in_flight_;
+    }
+    wake_.notify_one();
+    if (on_data_) {
+        on_data_(std::move(chunk));
+    }
+}
+
+void StdinReader::finish(int error) {
+    ended_ = true;
+    set_ref(false);
+    if (on_end_) {
+        EndCallback on_end = std::move(on_end_);
+        on_end_ = nullptr;
+        on_end(error);
+    }
+}
+
+} // namespace jpm::js
@@ -0,0 +1,78 @@
+#ifndef JPM_STDIN_READER_H
+#define JPM_STDIN_READER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "js/event_loop.h"
+
+namespace jpm::js {
+
+// Reads standard input on its own thread, kChunkSize bytes at a time, and hands
+// each chunk to the event loop. Reading stops while the stream is paused and while
+// kMaxInFlight chunks are waiting for the loop thread, so a slow consumer bounds
+// how far ahead of it the reader gets. The loop stays alive while the stream
+// flows and has not ended; a paused stream does not keep the process running.
+//
+// No JavaScriptCore here; js/process/stdin binds it to process.stdin.
+class StdinReader {
+public:
+    static constexpr size_t kChunkSize = 64 * 1024;
+    static constexpr size_t kMaxInFlight = 4;
+
+    // Loop thread. on_data gets each chunk; on_end runs once, with 0 at end of
+    // input or the errno read() failed with.
+    using DataCallback = std::function<void(std::string chunk)>;
+    using EndCallback = std::function<void(int error)>;
+
+    static StdinReader& getInstance() {
+        static StdinReader instance(EventLoop::getInstance());
+        return instance;
+    }
+
+    explicit StdinReader(EventLoop& loop, int fd = 0);
+    ~StdinReader();
+    StdinReader(const StdinReader&) = delete;
+    StdinReader& operator=(const StdinReader&) = delete;
+
+    // Loop thread only
+    void set_callbacks(DataCallback on_data, EndCallback on_end);
+    // Starts the reader thread on first use
+    void resume();
+    // Chunks already read are still delivered
+    void pause();
+    bool ended() const { return ended_; }
+
+    // Stops the thread and drops the callbacks and the chunks not yet delivered.
+    // Call before the JS context the callbacks refer to is released.
+    void shutdown();
+
+private:
+    void run(); // Reader thread
+    void deliver(std::string chunk);
+    void finish(int error);
+    void set_ref(bool ref);
+
+    EventLoop& loop_;
+    const int fd_;
+    DataCallback on_data_;
+    EndCallback on_end_;
+    bool ended_ = false;
+    bool ref_ = false;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool flowing_ = false;    // Guarded by mutex_
+    bool stopping_ = false;   // Guarded by mutex_
+    size_t in_flight_ = 0;    // Chunks posted and not yet delivered; guarded by mutex_
+    int stop_read_ = -1;      // Self-pipe: shutdown() writes a byte so a blocked poll() returns
+    int stop_write_ = -1;
+    std::thread thread_;
+};
+
+} // namespace jpm::js
+
+#endif // JPM_STDIN_READER_H
@@ -0,0 +1,342 @@
+#include "js/text_codec.h"
+#include <cctype>
+#include <string>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace jpm::js {
+
+namespace {
+
+constexpr char kBase64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+constexpr char kBase64url[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+constexpr char kHex[] = "0123456789abcdef";
+
+bool is_high_surrogate(uint16_t unit) { return unit >= 0xD800 && unit <= 0xDBFF; }
+bool is_low_surrogate(uint16_t unit) { return unit >= 0xDC00 && unit <= 0xDFFF; }
+
+// Value of a base64 character in either alphabet, -1 for anything else. As with
+// hex, Node only looks at the low byte of each code unit.
+int base64_value(uint8_t c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+' || c == '-') return 62;
+    if (c == '/' || c == '_') return 63;
+    return -1;
+}
+
+int hex_value(uint16_t unit) {
+    const uint8_t c = static_cast<uint8_t>(unit);
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+#if defined(__SSE2__)
+// Eight code units at once; all of them ASCII when no bit above 0x7F is set
+inline __m128i load_units(const uint16_t* text) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(text));
+}
+
+inline bool all_ascii(__m128i units) {
+    const __m128i high = _mm_and_si128(units, _mm_set1_epi16(static_cast<short>(0xFF80)));
+    return _mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) == 0xFFFF;
+}
+#endif
+
+size_t encode_utf8(const uint16_t* text, size_t length, char* out, size_t capacity) {
+    unsigned char* p = reinterpret_cast<unsigned char*>(out);
+    unsigned char* const end = p + capacity;
+    for (size_t i = 0; i < length; ++i) {
+#if defined(__SSE2__)
+        // Runs of ASCII are narrowed 8 units per store
+        while (i + 8 <= length && end - p >= 8) {
+            const __m128i units = load_units(text + i);
+            if (!all_ascii(units)) {
+                break;
+            }
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packus_epi16(units, units));
+            p += 8;
+            i += 8;
+        }
+        if (i == length) {
+            break;
+        }
+#endif
+        uint32_t c = text[i];
+        if (c < 0x80) {
+            if (p == end) break;
+            *p++ = static_cast<unsigned char>(c);
+            continue;
+        }
+        if (c < 0x800) {
+            if (end - p < 2) break;
+            *p++ = static_cast<unsigned char>(0xC0 | (c >> 6));
+            *p++ = static_cast<unsigned char>(0x80 | (c & 0x3F));
+            continue;
+        }
+        if (is_high_surrogate(static_cast<uint16_t>(c)) && i + 1 < length && is_low_surrogate(text[i + 1])) {
+            if (end - p < 4) break;
+            c = 0x10000 + ((c - 0xD800) << 10) + (text[i + 1] - 0xDC00);
+            ++i;
+            *p++ = static_cast<unsigned char>(0xF0 | (c >> 18));
+            *p++ = static_cast<unsigned char>(0x80 | ((c >> 12) & 0x3F));
+            *p++ = static_cast<unsigned char>(0x80 | ((c >> 6) & 0x3F));
+            *p++ = static_cast<unsigned char>(0x80 | (c & 0x3F));
+            continue;
+        }
+        if (is_high_surrogate(static_cast<uint16_t>(c)) || is_low_surrogate(static_cast<uint16_t>(c))) {
+            c = 0xFFFD;
+        }
+        if (end - p < 3) break;
+        *p++ = static_cast<unsigned char>(0xE0 | (c >> 12));
+        *p++ = static_cast<unsigned char>(0x80 | ((c >> 6) & 0x3F));
+        *p++ = static_cast<unsigned char>(0x80 | (c & 0x3F));
+    }
+    return static_cast<size_t>(p - reinterpret_cast<unsigned char*>(out));
+}
+
+size_t decode_base64(const uint16_t* text, size_t length, char* out, size_t capacity) {
+    size_t written = 0;
+    uint32_t bits = 0;
+    int count = 0;
+    for (size_t i = 0; i < length && written < capacity; ++i) {
+        const uint8_t c = static_cast<uint8_t>(text[i]);
+        if (c == '=') {
+            break;
+        }
+        int value = base64_value(c);
+        if (value < 0) {
+            continue;
+        }
+        bits = (bits << 6) | static_cast<uint32_t>(value);
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            out[written++] = static_cast<char>((bits >> count) & 0xFF);
+        }
+    }
+    return written;
+}
+
+size_t decode_hex(const uint16_t* text, size_t length, char* out, size_t capacity) {
+    size_t written = 0;
+    for (size_t i = 0; i + 1 < length && written < capacity; i += 2) {
+        int high = hex_value(text[i]);
+        int low = hex_value(text[i + 1]);
+        if (high < 0 || low < 0) {
+            break;
+        }
+        out[written++] = static_cast<char>((high << 4) | low);
+    }
+    return written;
+}
+
+} // namespace
+
+bool parse_text_encoding(std::string_view name, TextEncoding& encoding) {
+    std::string lower(name);
+    for (char& c : lower) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    if (lower == "utf8" || lower == "utf-8") {
+        encoding = TextEncoding::Utf8;
+    } else if (lower == "ucs2" || lower == "ucs-2" || lower == "utf16le" || lower == "utf-16le") {
+        encoding = TextEncoding::Utf16le;
+    } else if (lower == "latin1" || lower == "binary") {
+        encoding = TextEncoding::Latin1;
+    } else if (lower == "ascii") {
+        encoding = TextEncoding::Ascii;
+    } else if (lower == "base64") {
+        encoding = TextEncoding::Base64;
+    } else if (lower == "base64url") {
+        encoding = TextEncoding::Base64url;
+    } else if (lower == "hex") {
+        encoding = TextEncoding::Hex;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+size_t utf8_length(const uint16_t* text, size_t length) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < length; ++i) {
+#if defined(__SSE2__)
+        while (i + 8 <= length && all_ascii(load_units(text + i))) {
+            bytes += 8;
+            i += 8;
+        }
+        if (i == length) {
+            break;
+        }
+#endif
+        uint16_t c = text[i];
+        if (c < 0x80) {
+            bytes += 1;
+        } else if (c < 0x800) {
+            bytes += 2;
+        } else if (is_high_surrogate(c) && i + 1 < length && is_low_surrogate(text[i + 1])) {
+            bytes += 4;
+            ++i;
+        } else {
+            bytes += 3;
+        }
+    }
+    return bytes;
+}
+
+size_t encoded_length(const uint16_t* text, size_t length, TextEncoding encoding) {
+    switch (encoding) {
+    case TextEncoding::Utf8:
+        return utf8_length(text, length);
+    case TextEncoding::Utf16le:
+        return length * 2;
+    case TextEncoding::Latin1:
+    case TextEncoding::Ascii:
+        return length;
+    case TextEncoding::Base64:
+    case TextEncoding::Base64url:
+        while (length > 0 && text[length - 1] == '=') {
+            --length;
+        }
+        return length * 3 / 4;
+    case TextEncoding::Hex:
+        return length / 2;
+    }
+    return 0;
+}
+
+size_t encode_text(const uint16_t* text, size_t length, TextEncoding encoding, char* out, size_t capacity) {
+    switch (encoding) {
+    case TextEncoding::Utf8:
+        return encode_utf8(text, length, out, capacity);
+    case TextEncoding::Utf16le: {
+        size_t units = length < capacity / 2 ? length : capacity / 2;
+        for (size_t i = 0; i < units; ++i) {
+            out[2 * i] = static_cast<char>(text[i] & 0xFF);
+            out[2 * i + 1] = static_cast<char>(text[i] >> 8);
+        }
+        return units * 2;
+    }
+    case TextEncoding::Latin1:
+    case TextEncoding::Ascii: {
+        size_t count = length < capacity ? length : capacity;
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = static_cast<char>(text[i] & 0xFF);
+        }
+        return count;
+    }
+    case TextEncoding::Base64:
+    case TextEncoding::Base64url:
+        return decode_base64(text, length, out, capacity);
+    case TextEncoding::Hex:
+        return decode_hex(text, length, out, capacity);
+    }
+    return 0;
+}
+
+size_t utf16_length(size_t size, TextEncoding encoding) {
+    return encoding == TextEncoding::Utf16le ? size / 2 : size;
+}
+
+void decode_to_utf16(const char* data, size_t size, TextEncoding encoding, uint16_t* out) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    if (encoding == TextEncoding::Utf16le) {
+        for (size_t i = 0; i + 1 < size; i += 2) {
+            *out++ = static_cast<uint16_t>(bytes[i] | (bytes[i + 1] << 8));
+        }
+        return;
+    }
+    const unsigned char mask = encoding == TextEncoding::Ascii ? 0x7F : 0xFF;
+    for (size_t i = 0; i < size; ++i) {
+        out[i] = bytes[i] & mask;
+    }
+}
+
+size_t complete_length(const char* data, size_t size, TextEncoding encoding) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    switch (encoding) {
+    case TextEncoding::Utf8: {
+        // Look back at most three bytes for the lead byte of the last sequence
+        size_t lead = size;
+        while (lead > 0 && size - lead < 4 && (bytes[lead - 1] & 0xC0) == 0x80) {
+            --lead;
+        }
+        if (lead == 0) {
+            return size;
+        }
+        const unsigned char c = bytes[lead - 1];
+        const size_t needed = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+        return size - (lead - 1) < needed && needed > 1 ? lead - 1 : size;
+    }
+    case TextEncoding::Utf16le: {
+        size_t whole = size & ~static_cast<size_t>(1);
+        if (whole >= 2 && is_high_surrogate(static_cast<uint16_t>(bytes[whole - 2] | (bytes[whole - 1] << 8)))) {
+            whole -= 2;
+        }
+        return whole;
+    }
+    case TextEncoding::Base64:
+    case TextEncoding::Base64url:
+        return size - size % 3;
+    default:
+        return size;
+    }
+}
+
+size_t ascii_length(size_t size, TextEncoding encoding) {
+    switch (encoding) {
+    case TextEncoding::Base64:
+        return (size + 2) / 3 * 4;
+    case TextEncoding::Base64url:
+        return size / 3 * 4 + (size % 3 == 0 ? 0 : size % 3 + 1);
+    case TextEncoding::Hex:
+        return size * 2;
+    default:
+        return 0;
+    }
+}
+
+void encode_ascii(const char* data, size_t size, TextEncoding encoding, char* out) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    if (encoding == TextEncoding::Hex) {
+        for (size_t i = 0; i < size; ++i) {
+            *out++ = kHex[bytes[i] >> 4];
+            *out++ = kHex[bytes[i] & 0x0F];
+        }
+        return;
+    }
+    const char* alphabet = encoding == TextEncoding::Base64url ? kBase64url : kBase64;
+    const bool pad = encoding == TextEncoding::Base64;
+    size_t i = 0;
+    for (; i + 3 <= size; i += 3) {
+        uint32_t group = (bytes[i] << 16) | (bytes[i + 1] << 8) | bytes[i + 2];
+        *out++ = alphabet[(group >> 18) & 0x3F];
+        *out++ = alphabet[(group >> 12) & 0x3F];
+        *out++ = alphabet[(group >> 6) & 0x3F];
+        *out++ = alphabet[group & 0x3F];
+    }
+    if (size - i == 1) {
+        uint32_t group = bytes[i] << 16;
+        *out++ = alphabet[(group >> 18) & 0x3F];
+        *out++ = alphabet[(group >> 12) & 0x3F];
+        if (pad) {
+            *out++ = '=';
+            *out++ = '=';
+        }
+    } else if (size - i == 2) {
+        uint32_t group = (bytes[i] << 16) | (bytes[i + 1] << 8);
+        *out++ = alphabet[(group >> 18) & 0x3F];
+        *out++ = alphabet[(group >> 12) & 0x3F];
+        *out++ = alphabet[(group >> 6) & 0x3F];
+        if (pad) {
+            *out++ = '=';
+        }
+    }
+}
+
+} // namespace jpm::js
@@ -0,0 +1,46 @@
+#ifndef JPM_TEXT_CODEC_H
+#define JPM_TEXT_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace jpm::js {
+
+// Conversions between JS strings (UTF-16 code units) and the bytes Node's
+// encodings produce. No JavaScriptCore here; js/buffer binds them to Buffer.
+enum class TextEncoding { Utf8, Utf16le, Latin1, Ascii, Base64, Base64url, Hex };
+
+// Node's names, any case: "utf8"/"utf-8", "ucs2"/"utf16le", "latin1"/"binary", ...
+bool parse_text_encoding(std::string_view name, TextEncoding& encoding);
+
+// Bytes encoding a string of length units takes. Exact, except for base64 and hex,
+// where it is an upper bound (invalid input decodes to fewer bytes).
+size_t encoded_length(const uint16_t* text, size_t length, TextEncoding encoding);
+
+// Encodes text into out, which holds capacity bytes, and returns the bytes written.
+// UTF-8 stops before a character that does not fit, and lone surrogates become
+// U+FFFD. Base64 accepts both alphabets and skips characters outside them; hex
+// stops at the first pair that is not hex, as Node does.
+size_t encode_text(const uint16_t* text, size_t length, TextEncoding encoding, char* out, size_t capacity);
+
+// UTF-16 units decoding size bytes takes, for the encodings that produce UTF-16
+// (UTF-16LE, Latin-1, ASCII). decode_to_utf16 fills exactly that many.
+size_t utf16_length(size_t size, TextEncoding encoding);
+void decode_to_utf16(const char* data, size_t size, TextEncoding encoding, uint16_t* out);
+
+// Characters base64/base64url/hex take for size bytes; encode_ascii fills them
+size_t ascii_length(size_t size, TextEncoding encoding);
+void encode_ascii(const char* data, size_t size, TextEncoding encoding, char* out);
+
+// How many of size bytes decode to whole characters in encoding; a stream decoder
+// keeps the rest for the next chunk. A UTF-8 sequence or UTF-16 surrogate pair
+// cut at the end, an odd UTF-16 byte and a partial base64 group are held back.
+size_t complete_length(const char* data, size_t size, TextEncoding encoding);
+
+// UTF-8 length of UTF-16 text, with lone surrogates counted as U+FFFD
+size_t utf8_length(const uint16_t* text, size_t length);
+
+} // namespace jpm::js
+
+#endif // JPM_TEXT_CODEC_H
@@ -0,0 +1,260 @@
+#include "js/timer_wheel.h"
+#include <algorithm>
+
+namespace jpm::js {
+
+namespace {
+
+constexpr uint32_t kGenerationMask = (uint32_t{1} << 21) - 1; // index (32 bits) + generation < 2^53
+
+uint64_t rotl(uint64_t value, int shift) {
+    shift &= 63;
+    return shift ? (value << shift) | (value >> (64 - shift)) : value;
+}
+
+uint64_t rotr(uint64_t value, int shift) {
+    shift &= 63;
+    return shift ? (value >> shift) | (value << (64 - shift)) : value;
+}
+
+// 1-based index of the highest set bit; value must be nonzero
+int fls(uint64_t value) {
+    return 64 - __builtin_clzll(value);
+}
+
+int ctz(uint64_t value) {
+    return __builtin_ctzll(value);
+}
+
+} // namespace
+
+TimerWheel::TimerWheel() = default;
+TimerWheel::~TimerWheel() = default;
+
+TimerWheel::Node* TimerWheel::allocate() {
+    if (!free_) {
+        std::unique_ptr<Node[]> chunk(new Node[kChunkSize]);
+        for (uint32_t i = kChunkSize; i-- > 0;) {
+            chunk[i].index = allocated_ + i;
+            chunk[i].next = free_;
+            free_ = &chunk[i];
+        }
+        allocated_ += kChunkSize;
+        chunks_.push_back(std::move(chunk));
+    }
+    Node* node = free_;
+    free_ = node->next;
+    node->prev = node->next = nullptr;
+    ++active_;
+    return node;
+}
+
+void TimerWheel::release(Node* node) {
+    node->callback = nullptr;
+    node->list = kNoList;
+    node->generation = node->generation == kGenerationMask ? 1 : node->generation + 1;
+    node->prev = nullptr;
+    node->next = free_;
+    free_ = node;
+    --active_;
+}
+
+uint64_t TimerWheel::id_of(const Node* node) const {
+    return (static_cast<uint64_t>(node->generation) << 32) | node->index;
+}
+
+TimerWheel::Node* TimerWheel::lookup(uint64_t id) const {
+    uint32_t index = static_cast<uint32_t>(id);
+    uint64_t generation = id >> 32;
+    if (index >= allocated_ || generation > kGenerationMask) {
+        return nullptr;
+    }
+    Node* node = &chunks_[index / kChunkSize][index % kChunkSize];
+    return node->generation == generation && node->list != kNoList ? node : nullptr;
+}
+
+void TimerWheel::insert(Node* node) {
+    if (node->expires <= current_) {
+        node->list = kExpiredList;
+        expired_.emplace_back(node, node->generation);
+        return;
+    }
+    // The coarsest wheel whose slot width the remaining time needs
+    uint64_t remaining = node->expires - current_;
+    int wheel = (fls(std::max(remaining, kWheelMask)) - 1) / kWheelBits;
+    // Higher wheels use the slot before the expiry's, so the timer is cascaded down
+    // while the time left still fits the wheels below
+    uint64_t slot = kWheelMask & ((node->expires >> (wheel * kWheelBits)) - (wheel ? 1 : 0));
+    uint16_t list = static_cast<uint16_t>(static_cast<uint64_t>(wheel) * kWheelLength + slot);
+
+    node->list = list;
+    node->next = nullptr;
+    node->prev = tails_[list];
+    if (tails_[list]) {
+        tails_[list]->next = node;
+    } else {
+        heads_[list] = node;
+    }
+    tails_[list] = node;
+    pending_[wheel] |= uint64_t{1} << slot;
+}
+
+void TimerWheel::unlink(Node* node) {
+    uint16_t list = node->list;
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        heads_[list] = node->next;
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    } else {
+        tails_[list] = node->prev;
+    }
+    if (!heads_[list]) {
+        pending_[list / kWheelLength] &= ~(uint64_t{1} << (list % kWheelLength));
+    }
+    node->prev = node->next = nullptr;
+}
+
+uint64_t TimerWheel::schedule(uint64_t expires, uint64_t repeat, Callback callback) {
+    Node* node = allocate();
+    node->expires = expires;
+    node->repeat = repeat;
+    node->sequence = ++sequence_;
+    node->callback = std::move(callback);
+    insert(node);
+    return id_of(node);
+}
+
+bool TimerWheel::cancel(uint64_t id) {
+    Node* node = lookup(id);
+    if (!node) {
+        return false;
+    }
+    if (node->list != kExpiredList) {
+        unlink(node);
+    }
+    release(node); // An expired_ entry goes stale with the generation
+    return true;
+}
+
+void TimerWheel::advance(uint64_t now) {
+    if (now <= current_) {
+        return;
+    }
+    // Collect every slot the clock passes on each wheel; a wheel is only looked at
+    // if the one below it wrapped around
+    uint64_t elapsed = now - current_;
+    for (int wheel = 0; wheel < kWheelCount; ++wheel) {
+        const int shift = wheel * kWheelBits;
+        uint64_t slots;
+        if ((elapsed >> shift) > kWheelMask) {
+            slots = ~uint64_t{0};
+        } else {
+            int steps = static_cast<int>(kWheelMask & (elapsed >> shift));
+            int old_slot = static_cast<int>(kWheelMask & (current_ >> shift));
+            int new_slot = static_cast<int>(kWheelMask & (now >> shift));
+            uint64_t run = (uint64_t{1} << steps) - 1;
+            slots = rotl(run, old_slot) | rotr(rotl(run, new_slot), steps) | (uint64_t{1} << new_slot);
+        }
+        while (uint64_t due = slots & pending_[wheel]) {
+            uint16_t list = static_cast<uint16_t>(static_cast<uint64_t>(wheel) * kWheelLength + static_cast<uint64_t>(ctz(due)));
+            for (Node* node = heads_[list]; node; node = node->next) {
+                todo_.push_back(node);
+            }
+            heads_[list] = tails_[list] = nullptr;
+            pending_[wheel] &= ~(uint64_t{1} << ctz(due));
+        }
+        if (!(slots & 1)) {
+            break;
+        }
+        elapsed = std::max(elapsed, kWheelLength << shift);
+    }
+    current_ = now;
+
+    // Due timers join the expired queue in order; the rest cascade to finer wheels
+    if (expired_next_ == expired_.size()) {
+        expired_.clear();
+        expired_next_ = 0;
+    }
+    const size_t first_new = expired_.size();
+    for (Node* node : todo_) {
+        insert(node);
+    }
+    todo_.clear();
+    auto by_expiry = [](const std::pair<Node*, uint32_t>& a, const std::pair<Node*, uint32_t>& b) {
+        return a.first->expires != b.first->expires ? a.first->expires < b.first->expires
+                                                    : a.first->sequence < b.first->sequence;
+    };
+    std::sort(expired_.begin() + static_cast<std::ptrdiff_t>(first_new), expired_.end(), by_expiry);
+    if (first_new > expired_next_) {
+        // Stale entries (cancelled) compare by whatever their node holds now; order among them does not matter
+        std::inplace_merge(expired_.begin() + static_cast<std::ptrdiff_t>(expired_next_),
+                           expired_.begin() + static_cast<std::ptrdiff_t>(first_new), expired_.end(), by_expiry);
+    }
+}
+
+bool TimerWheel::pop_expired(uint64_t now, Callback& callback) {
+    while (expired_next_ < expired_.size()) {
+        auto [node, generation] = expired_[expired_next_++];
+        if (node->generation != generation || node->list != kExpiredList) {
+            continue; // Cancelled after it expired
+        }
+        if (node->repeat > 0) {
+            callback = node->callback;
+            node->expires = now + node->repeat;
+            node->sequence = ++sequence_;
+            insert(node);
+        } else {
+            callback = std::move(node->callback);
+            release(node);
+        }
+        return true;
+    }
+    expired_.clear();
+    expired_next_ = 0;
+    return false;
+}
+
+int64_t TimerWheel::next_timeout(uint64_t now) const {
+    if (expired_next_ < expired_.size()) {
+        return 0;
+    }
+    if (active_ == 0) {
+        return -1;
+    }
+    // Per wheel, the time until the clock reaches its next occupied slot; for higher
+    // wheels that is a lower bound, where the timers cascade rather than fire
+    uint64_t timeout = ~uint64_t{0};
+    uint64_t relative_mask = 0;
+    for (int wheel = 0; wheel < kWheelCount; ++wheel) {
+        const int shift = wheel * kWheelBits;
+        if (pending_[wheel]) {
+            int slot = static_cast<int>(kWheelMask & (current_ >> shift));
+            uint64_t wheel_timeout = static_cast<uint64_t>(ctz(rotr(pending_[wheel], slot)) + (wheel ? 1 : 0)) << shift;
+            wheel_timeout -= relative_mask & current_;
+            timeout = std::min(timeout, wheel_timeout);
+        }
+        relative_mask = (relative_mask << kWheelBits) | kWheelMask;
+    }
+    uint64_t passed = now > current_ ? now - current_ : 0;
+    return timeout > passed ? static_cast<int64_t>(timeout - passed) : 0;
+}
+
+void TimerWheel::clear() {
+    for (auto& chunk : chunks_) {
+        for (uint32_t i = 0; i < kChunkSize; ++i) {
+            if (chunk[i].list != kNoList) {
+                release(&chunk[i]);
+            }
+        }
+    }
+    std::fill(std::begin(heads_), std::end(heads_), nullptr);
+    std::fill(std::begin(tails_), std::end(tails_), nullptr);
+    std::fill(std::begin(pending_), std::end(pending_), 0);
+    expired_.clear();
+    expired_next_ = 0;
+}
+
+} // namespace jpm::js
@@ -0,0 +1,98 @@
+#ifndef JPM_TIMER_WHEEL_H
+#define JPM_TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace jpm::js {
+
+// Hierarchical timing wheel (after William Ahern's timeout.c): 6 wheels of 64
+// slots at 1 ms resolution, so expiries up to 2^36 ms ahead are placed in O(1)
+// and cancelled in O(1). A timer sits in the wheel whose span covers its
+// remaining time and moves to finer wheels as time reaches its slot; expired
+// timers are handed out in expiry order.
+//
+// Timer nodes come from a pool that grows in chunks and is never returned to the
+// allocator, so steady create/cancel traffic allocates nothing. Ids carry the
+// node index and a generation, so a stale id never cancels a reused node.
+// Times are plain millisecond counts; EventLoop maps them to its clock.
+class TimerWheel {
+public:
+    using Callback = std::function<void()>;
+
+    TimerWheel();
+    ~TimerWheel();
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // Schedules callback at expires (ms), then every repeat ms if repeat > 0.
+    // Returns an id below 2^53, so it survives a round trip through a JS number.
+    uint64_t schedule(uint64_t expires, uint64_t repeat, Callback callback);
+    // False if the id is not a pending timer
+    bool cancel(uint64_t id);
+
+    // Moves everything due at or before now to the expired queue
+    void advance(uint64_t now);
+    // Takes the next expired timer's callback. A repeating timer is scheduled
+    // again at now + repeat and keeps its id; any other is released.
+    bool pop_expired(uint64_t now, Callback& callback);
+
+    // Milliseconds from now until advance() can have something to do: 0 when
+    // timers are already expired, -1 when there are no timers
+    int64_t next_timeout(uint64_t now) const;
+
+    size_t size() const { return active_; }
+    void clear();
+
+private:
+    static constexpr int kWheelBits = 6;
+    static constexpr int kWheelCount = 6;
+    static constexpr uint64_t kWheelLength = uint64_t{1} << kWheelBits;
+    static constexpr uint64_t kWheelMask = kWheelLength - 1;
+    static constexpr uint32_t kChunkSize = 1024;
+    static constexpr uint16_t kNoList = 0xFFFF;
+    static constexpr uint16_t kExpiredList = 0xFFFE;
+
+    struct Node {
+        uint64_t expires = 0;
+        uint64_t repeat = 0;
+        uint64_t sequence = 0;   // Orders timers with the same expiry by creation
+        Node* prev = nullptr;
+        Node* next = nullptr;
+        Callback callback;
+        uint32_t index = 0;
+        uint32_t generation = 1;
+        uint16_t list = kNoList; // wheel * 64 + slot, kExpiredList, or kNoList when free
+    };
+
+    Node* allocate();
+    void release(Node* node);
+    Node* lookup(uint64_t id) const;
+    uint64_t id_of(const Node* node) const;
+    void insert(Node* node);
+    void unlink(Node* node);
+
+    std::vector<std::unique_ptr<Node[]>> chunks_;
+    Node* free_ = nullptr; // Free nodes, linked through next
+    uint32_t allocated_ = 0;
+
+    Node* heads_[kWheelCount * kWheelLength] = {};
+    Node* tails_[kWheelCount * kWheelLength] = {};
+    uint64_t pending_[kWheelCount] = {}; // Bit per non-empty slot
+    uint64_t current_ = 0;               // Time of the last advance()
+    // Due timers sorted by (expires, sequence), consumed from expired_next_. The
+    // generation tells whether the entry was cancelled (and the node maybe reused).
+    std::vector<std::pair<Node*, uint32_t>> expired_;
+    size_t expired_next_ = 0;
+    std::vector<Node*> todo_; // Scratch for advance()
+    uint64_t sequence_ = 0;
+    size_t active_ = 0;
+};
+
+} // namespace jpm::js
+
+#endif // JPM_TIMER_WHEEL_H
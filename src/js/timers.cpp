@@ -0,0 +1,180 @@
+#include "js/timers.h"
+#include "js/event_loop.h"
+#include "js/process/events.h"
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace jpm::js {
+
+namespace {
+
+// A JS function and its arguments, protected from GC until the last copy of the
+// loop callback that owns it is gone
+class ScheduledCall {
+public:
+    ScheduledCall(JSContextRef ctx, JSObjectRef function, size_t argumentCount, const JSValueRef arguments[])
+        : context_(JSContextGetGlobalContext(ctx)), function_(function), arguments_(arguments, arguments + argumentCount) {
+        JSValueProtect(context_, function_);
+        for (JSValueRef argument : arguments_) {
+            JSValueProtect(context_, argument);
+        }
+    }
+
+    ~ScheduledCall() {
+        JSValueUnprotect(context_, function_);
+        for (JSValueRef argument : arguments_) {
+            JSValueUnprotect(context_, argument);
+        }
+    }
+
+    ScheduledCall(const ScheduledCall&) = delete;
+    ScheduledCall& operator=(const ScheduledCall&) = delete;
+
+    void operator()() const {
+        JSValueRef exception = nullptr;
+        JSObjectCallAsFunction(context_, function_, nullptr, arguments_.size(), arguments_.data(), &exception);
+        if (exception) {
+            process::handle_uncaught_exception(context_, exception);
+        }
+    }
+
+private:
+    JSGlobalContextRef context_;
+    JSObjectRef function_;
+    std::vector<JSValueRef> arguments_;
+};
+
+EventLoop::Callback make_callback(JSContextRef ctx, JSObjectRef function, size_t argumentCount, const JSValueRef arguments[]) {
+    auto call = std::make_shared<ScheduledCall>(ctx, function, argumentCount, arguments);
+    return [call]() { (*call)(); };
+}
+
+JSObjectRef make_type_error(JSContextRef ctx, const char* message) {
+    JSStringRef text = JSStringCreateWithUTF8CString(message);
+    JSValueRef argument = JSValueMakeString(ctx, text);
+    JSStringRelease(text);
+    JSObjectRef error = JSObjectMakeError(ctx, 1, &argument, nullptr);
+    JSStringRef name = JSStringCreateWithUTF8CString("name");
+    JSStringRef typeError = JSStringCreateWithUTF8CString("TypeError");
+    JSObjectSetProperty(ctx, error, name, JSValueMakeString(ctx, typeError), kJSPropertyAttributeDontEnum, nullptr);
+    JSStringRelease(typeError);
+    JSStringRelease(name);
+    return error;
+}
+
+bool is_function(JSContextRef ctx, JSValueRef value) {
+    return JSValueIsObject(ctx, value) && JSObjectIsFunction(ctx, JSValueToObject(ctx, value, nullptr));
+}
+
+std::chrono::milliseconds timer_delay(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[]) {
+    double delay = argumentCount > 1 ? JSValueToNumber(ctx, arguments[1], nullptr) : 0;
+    if (std::isnan(delay) || delay < 1 || delay > 2147483647.0) {
+        delay = 1;
+    }
+    return std::chrono::milliseconds(static_cast<int64_t>(delay));
+}
+
+uint64_t timer_id(JSContextRef ctx, size_t argumentCount, const JSValueRef arguments[]) {
+    if (argumentCount < 1 || !JSValueIsNumber(ctx, arguments[0])) {
+        return 0;
+    }
+    double id = JSValueToNumber(ctx, arguments[0], nullptr);
+    return id >= 1 ? static_cast<uint64_t>(id) : 0;
+}
+
+template <bool Repeat>
+JSValueRef set_timer(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t argumentCount,
+                     const JSValueRef arguments[], JSValueRef* exception) {
+    if (argumentCount < 1 || !is_function(ctx, arguments[0])) {
+        *exception = make_type_error(ctx, "The \"callback\" argument must be of type function");
+        return JSValueMakeUndefined(ctx);
+    }
+    std::chrono::milliseconds delay = timer_delay(ctx, argumentCount, arguments);
+    size_t extra = argumentCount > 2 ? argumentCount - 2 : 0;
+    uint64_t id = EventLoop::getInstance().add_timer(
+        delay, Repeat ? delay : std::chrono::milliseconds(0),
+        make_callback(ctx, JSValueToObject(ctx, arguments[0], nullptr), extra, arguments + 2));
+    return JSValueMakeNumber(ctx, static_cast<double>(id));
+}
+
+JSValueRef clear_timer(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t argumentCount,
+                       const JSValueRef arguments[], JSValueRef*) {
+    if (uint64_t id = timer_id(ctx, argumentCount, arguments)) {
+        EventLoop::getInstance().cancel_timer(id);
+    }
+    return JSValueMakeUndefined(ctx);
+}
+
+JSValueRef set_immediate(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t argumentCount,
+                         const JSValueRef arguments[], JSValueRef* exception) {
+    if (argumentCount < 1 || !is_function(ctx, arguments[0])) {
+        *exception = make_type_error(ctx, "The \"callback\" argument must be of type function");
+        return JSValueMakeUndefined(ctx);
+    }
+    uint64_t id = EventLoop::getInstance().add_immediate(
+        make_callback(ctx, JSValueToObject(ctx, arguments[0], nullptr), argumentCount - 1, arguments + 1));
+    return JSValueMakeNumber(ctx, static_cast<double>(id));
+}
+
+JSValueRef clear_immediate(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t argumentCount,
+                           const JSValueRef arguments[], JSValueRef*) {
+    if (uint64_t id = timer_id(ctx, argumentCount, arguments)) {
+        EventLoop::getInstance().cancel_immediate(id);
+    }
+    return JSValueMakeUndefined(ctx);
+}
+
+JSValueRef report_microtask_error(JSContextRef ctx, JSObjectRef, JSObjectRef, size_t argumentCount,
+                                  const JSValueRef arguments[], JSValueRef*) {
+    if (argumentCount > 0) {
+        process::handle_uncaught_exception(ctx, arguments[0]);
+    }
+    return JSValueMakeUndefined(ctx);
+}
+
+// JSC has no C API for its microtask queue, so queueMicrotask goes through a
+// resolved promise; errors are reported like any uncaught exception
+constexpr const char* kQueueMicrotaskFactory =
+    "(function (report) { return function queueMicrotask(callback) {"
+    " if (typeof callback !== 'function') throw new TypeError('The \"callback\" argument must be of type function');"
+    " Promise.resolve().then(function () { try { callback(); } catch (error) { report(error); } });"
+    " }; })";
+
+void set_function(JSContextRef ctx, JSObjectRef object, const char* name, JSObjectCallAsFunctionCallback callback) {
+    JSStringRef key = JSStringCreateWithUTF8CString(name);
+    JSObjectSetProperty(ctx, object, key, JSObjectMakeFunctionWithCallback(ctx, key, callback),
+                        kJSPropertyAttributeDontEnum, nullptr);
+    JSStringRelease(key);
+}
+
+} // namespace
+
+void setup_timers(JSContextRef ctx, JSObjectRef globalObject) {
+    set_function(ctx, globalObject, "setTimeout", set_timer<false>);
+    set_function(ctx, globalObject, "setInterval", set_timer<true>);
+    set_function(ctx, globalObject, "clearTimeout", clear_timer);
+    set_function(ctx, globalObject, "clearInterval", clear_timer);
+    set_function(ctx, globalObject, "setImmediate", set_immediate);
+    set_function(ctx, globalObject, "clearImmediate", clear_immediate);
+
+    JSStringRef factorySource = JSStringCreateWithUTF8CString(kQueueMicrotaskFactory);
+    JSValueRef factory = JSEvaluateScript(ctx, factorySource, nullptr, nullptr, 1, nullptr);
+    JSStringRelease(factorySource);
+    if (factory && JSValueIsObject(ctx, factory)) {
+        JSValueRef report = JSObjectMakeFunctionWithCallback(ctx, nullptr, report_microtask_error);
+        JSValueRef queueMicrotask = JSObjectCallAsFunction(ctx, JSValueToObject(ctx, factory, nullptr), nullptr, 1, &report, nullptr);
+        if (queueMicrotask) {
+            JSStringRef key = JSStringCreateWithUTF8CString("queueMicrotask");
+            JSObjectSetProperty(ctx, globalObject, key, queueMicrotask, kJSPropertyAttributeDontEnum, nullptr);
+            JSStringRelease(key);
+        }
+    }
+}
+
+void queue_next_tick(JSContextRef ctx, JSObjectRef callback, size_t argumentCount, const JSValueRef arguments[]) {
+    EventLoop::getInstance().next_tick(make_callback(ctx, callback, argumentCount, arguments));
+}
+
+} // namespace jpm::js
@@ -0,0 +1,21 @@
+#ifndef JPM_TIMERS_H
+#define JPM_TIMERS_H
+
+#include <JavaScriptCore/JavaScript.h>
+
+namespace jpm::js {
+
+// Installs the timer globals on the event loop:
+// - setTimeout(callback, delay, ...args) / clearTimeout(id)
+// - setInterval(callback, delay, ...args) / clearInterval(id)
+// - setImmediate(callback, ...args) / clearImmediate(id)
+// - queueMicrotask(callback), on JSC's own microtask queue
+// Ids are numbers. Delays below 1 ms or above 2^31-1 ms become 1 ms, as in Node.
+void setup_timers(JSContextRef ctx, JSObjectRef globalObject);
+
+// Queues callback(...args) on the loop's nextTick queue (process.nextTick)
+void queue_next_tick(JSContextRef ctx, JSObjectRef callback, size_t argumentCount, const JSValueRef arguments[]);
+
+} // namespace jpm::js
+
+#endif // JPM_TIMERS_H
@@ -2,12 +2,20 @@
 #include <vector>
 #include <string>
 #include <algorithm> // For std::remove
+#include <cstdlib>
 #include "install/install.h"
+#include "fetch/fetch.h"
+#include "mirror/pack_mirror.h"
+#include "registry/registry.h"
+#include "exec/exec.h"
+#include "cache/cache_command.h"
 #include "js/js.h" // Include the new JSCommand header
 #include "jpm_config.h"      // For g_verbose_output
 
 // Define the global verbosity flag
 bool g_verbose_output = false;
+bool g_offline_mode = false;
+std::string g_registry_url = JPM_DEFAULT_REGISTRY_URL;
 
 int main(int argc, char* argv[]) {
     std::vector<std::string> args;
@@ -15,38 +23,39 @@ int main(int argc, char* argv[]) {
         args.push_back(argv[i]);
     }
 
-    // Check for verbosity flag and remove it from args if present
-    auto verbose_it = std::find_if(args.begin(), args.end(), [](const std::string& s) {
-        return s == "-v" || s == "--verbose";
-    });
-
-    if (verbose_it != args.end()) {
-        g_verbose_output = true;
-        args.erase(verbose_it);
-        // If there was another verbose flag (e.g., -v --verbose), remove it too.
-        // This is a simple approach; a proper CLI parser would handle this better.
-        auto verbose_it2 = std::find_if(args.begin(), args.end(), [](const std::string& s) {
-            return s == "-v" || s == "--verbose";
-        });
-        if (verbose_it2 != args.end()) {
-             args.erase(verbose_it2);
+    // Options before the command word are jpm's own; everything after it belongs to the
+    // command or the script it runs, so `jpm x tsc --version` runs `tsc --version`.
+    // Registry base URL: --registry <url> wins over $JPM_REGISTRY.
+    if (const char* env_registry = std::getenv("JPM_REGISTRY"); env_registry && *env_registry) {
+        g_registry_url = env_registry;
+    }
+    size_t command_index = 0;
+    for (; command_index < args.size() && args[command_index].compare(0, 1, "-") == 0; ++command_index) {
+        const std::string& option = args[command_index];
+        if (option == "-v" || option == "--verbose") {
+            g_verbose_output = true;
+        } else if (option == "--version") {
+            std::cout << "jpm version " << PROJECT_VERSION << std::endl;
+            return 0;
+        } else if (option == "--registry") {
+            if (command_index + 1 == args.size() || args[command_index + 1].empty()) {
+                std::cerr << "--registry needs a URL" << std::endl;
+                return 1;
+            }
+            g_registry_url = args[++command_index];
+        } else {
+            break; // Reported as an unknown command below
         }
     }
-
-    // Check for version flag and print version if present
-    auto version_it = std::find_if(args.begin(), args.end(), [](const std::string& s) {
-        return s == "--version";
-    });
-
-    if (version_it != args.end()) {
-        std::cout << "jpm version " << PROJECT_VERSION << std::endl;
-        return 0;
+    args.erase(args.begin(), args.begin() + static_cast<long>(command_index));
+    if (!g_registry_url.empty() && g_registry_url.back() != '/') {
+        g_registry_url += '/';
     }
 
     if (args.empty()) {
-        std::cerr << "Usage: jpm [-v|--verbose] <command> [args...]\\n";
+        std::cerr << "Usage: jpm [-v|--verbose] [--registry <url>] <command> [args...]\\n";
         std::cerr << "       jpm [-v|--verbose] <js_file> [args...]\\n";
-        std::cerr << "Available commands:\n  install <package_name>[@<version>]...\n  run <js_file>\n"; // Restored run command usage
+        std::cerr << "Available commands:\n  install [--production] [--offline] [--ignore-scripts] [--mirror <file>] [<package_name>[@<version>]...]\n  fetch [--all-platforms] [<lockfile>]\n  pack-mirror <file> [<lockfile>]\n  registry serve [--host <addr>] [--port <n>] [--upstream <url>]\n  x [--package <spec>] <spec|bin> [args...]\n  cache gc [--max-size <size>]\n  run <js_file>\n"; // Restored run command usage
         return 1;
     }
 
@@ -57,13 +66,29 @@ int main(int argc, char* argv[]) {
     }
 
     if (command == "install") {
-        if (command_args.empty()) {
-            std::cerr << "Usage: jpm [-v|--verbose] install <package_name>[@<version>]..." << std::endl;
-            std::cerr << "Please specify at least one package to install." << std::endl;
-            return 1;
-        }
+        // With no package arguments the project's package.json is installed
         jpm::InstallCommand install_command;
-        install_command.execute(command_args);
+        return install_command.execute(command_args) ? 0 : 1;
+    } else if (command == "fetch") {
+        // Download everything in the lockfile into the cache; node_modules is left alone
+        jpm::FetchCommand fetch_command;
+        return fetch_command.execute(command_args) ? 0 : 1;
+    } else if (command == "pack-mirror") {
+        // Bundle the lockfile's packuments and tarballs into one archive for `install --mirror`
+        jpm::PackMirrorCommand pack_mirror_command;
+        return pack_mirror_command.execute(command_args) ? 0 : 1;
+    } else if (command == "x") {
+        // Run a package's bin from the jpm x cache, installing it there on first use
+        jpm::ExecCommand exec_command;
+        return exec_command.execute(command_args);
+    } else if (command == "cache") {
+        // Evict least-recently-used cache entries down to a size budget
+        jpm::CacheCommand cache_command;
+        return cache_command.execute(command_args) ? 0 : 1;
+    } else if (command == "registry") {
+        // Caching registry proxy for other machines on the network
+        jpm::RegistryCommand registry_command;
+        return registry_command.execute(command_args) ? 0 : 1;
     } else if (command == "run") { // Handle the explicit 'run' command
         if (command_args.empty()) {
             std::cerr << "Usage: jpm [-v|--verbose] run <js_file>" << std::endl;
@@ -72,9 +97,7 @@ int main(int argc, char* argv[]) {
         }
 #ifdef USE_JAVASCRIPTCORE
         jpm::JSCommand js_command;
-        js_command.execute({command_args[0]}); // Pass the first argument as the file path
-        // Note: Any args after the file path are currently ignored by JSCommand::execute.
-        // This might need adjustment if you need to pass arguments to the JS script.
+        return js_command.execute(command_args); // File path, then the script's own arguments
 #else
         std::cerr << "Error: JavaScriptCore support is not enabled in this build." << std::endl;
         return 1;
@@ -86,9 +109,7 @@ int main(int argc, char* argv[]) {
             std::cout << "Detected .js file argument. Running script: " << command << std::endl;
         }
         jpm::JSCommand js_command;
-        js_command.execute({command}); // Pass the .js file path as the argument
-        // Note: Any args after the file path are currently ignored by JSCommand::execute.
-        // This might need adjustment if you need to pass arguments to the JS script.
+        return js_command.execute(args); // The .js file path, then the script's own arguments
 #else
         std::cerr << "Error: JavaScriptCore support is not enabled in this build." << std::endl;
         return 1;
@@ -101,9 +122,9 @@ int main(int argc, char* argv[]) {
             std::cout << "jpm (Jam Package Manager)" << std::endl;
         }
         std::cerr << "Unknown command or file: " << command << std::endl;
-        std::cerr << "Usage: jpm [-v|--verbose] <command> [args...]\\n";
+        std::cerr << "Usage: jpm [-v|--verbose] [--registry <url>] <command> [args...]\\n";
         std::cerr << "       jpm [-v|--verbose] <js_file> [args...]\\n";
-        std::cerr << "Available commands:\n  install <package_name>[@<version>]...\n  run <js_file>\n"; // Restored run command usage
+        std::cerr << "Available commands:\n  install [--production] [--offline] [--ignore-scripts] [--mirror <file>] [<package_name>[@<version>]...]\n  fetch [--all-platforms] [<lockfile>]\n  pack-mirror <file> [<lockfile>]\n  registry serve [--host <addr>] [--port <n>] [--upstream <url>]\n  x [--package <spec>] <spec|bin> [args...]\n  cache gc [--max-size <size>]\n  run <js_file>\n"; // Restored run command usage
         return 1;
     }
 
@@ -0,0 +1,102 @@
+#include "mirror/pack_mirror.h"
+#include "cache/mirror_archive.h"
+#include "package/lockfile.h"
+#include "parsing/json_parser.h"
+#include "utils/file_utils.h"
+#include "jpm_config.h"
+#include <iostream>
+#include <set>
+#include <sys/stat.h>
+
+namespace jpm {
+
+namespace {
+
+// Only the fields the resolver reads; full registry documents are mostly
+// readme, maintainers and other metadata an install never looks at.
+std::string abbreviate_packument(const JsonData& full) {
+    static const char* const kKeptFields[] = {
+        "name", "version", "dependencies", "optionalDependencies", "os", "cpu", "libc", "bin",
+    };
+    JsonData abbreviated = JsonData::object();
+    for (const char* field : kKeptFields) {
+        if (full.contains(field)) {
+            abbreviated[field] = full[field];
+        }
+    }
+    if (full.contains("dist") && full["dist"].is_object()) {
+        for (const char* field : {"tarball", "integrity", "shasum"}) {
+            if (full["dist"].contains(field)) {
+                abbreviated["dist"][field] = full["dist"][field];
+            }
+        }
+    }
+    return abbreviated.dump();
+}
+
+} // namespace
+
+PackMirrorCommand::PackMirrorCommand() {
+    if (g_verbose_output) {
+        std::cout << "PackMirrorCommand initialized." << std::endl;
+    }
+}
+
+bool PackMirrorCommand::execute(const std::vector<std::string>& args) {
+    if (args.empty()) {
+        std::cerr << "Usage: jpm [-v|--verbose] pack-mirror <archive> [<lockfile>]" << std::endl;
+        return false;
+    }
+    const std::string& archive_path = args[0];
+    std::string lockfile_path = args.size() > 1 ? args[1] : Lockfile::kFileName;
+
+    std::optional<ResolutionResult> locked = Lockfile::load(lockfile_path);
+    if (!locked) {
+        std::cerr << "Could not read lockfile " << lockfile_path << ". Run `jpm install` first to create it." << std::endl;
+        return false;
+    }
+
+    // Everything the archive needs must be in the shared cache first. The archive holds
+    // the optional variants of every platform, so it installs on any host.
+    if (!fetch_command_.execute({"--all-platforms", lockfile_path})) {
+        return false;
+    }
+
+    std::vector<MirrorArchive::Item> items;
+    std::set<std::string> packed;
+    for (const auto& info : locked->packages_to_install) {
+        if (!packed.insert(info.name + "@" + info.resolved_version).second) {
+            continue;
+        }
+
+        std::optional<std::string> packument = FileUtils::read_file(cache_.packument_path(info.name, info.resolved_version));
+        JsonData full = packument ? JsonParser::try_parse(*packument) : JsonData();
+        if (!full.is_object()) {
+            std::cerr << "Cached packument for " << info.name << "@" << info.resolved_version << " is missing or invalid." << std::endl;
+            return false;
+        }
+        // Same path the resolver requests from the registry
+        items.push_back({"/" + info.name + "/" + info.resolved_version, abbreviate_packument(full), std::string()});
+
+        std::string tarball = cache_.tarball_path(info.name, info.resolved_version);
+        if (!FileUtils::path_exists(tarball)) {
+            std::cerr << "Cached tarball for " << info.name << "@" << info.resolved_version << " is missing." << std::endl;
+            return false;
+        }
+        // Stored as published (already gzip-compressed) and streamed from the cache file
+        items.push_back({MirrorArchive::key_for_url(info.tarball_url), std::string(), tarball});
+    }
+
+    if (!MirrorArchive::write(archive_path, items)) {
+        std::cerr << "Failed to write mirror archive " << archive_path << std::endl;
+        return false;
+    }
+
+    struct stat st {};
+    stat(archive_path.c_str(), &st);
+    std::cout << "Packed " << packed.size() << " packages into " << archive_path
+              << " (" << st.st_size << " bytes)" << std::endl;
+    return true;
+}
+
+} // namespace jpm
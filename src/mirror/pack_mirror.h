@@ -0,0 +1,27 @@
+#ifndef JPM_PACK_MIRROR_COMMAND_H
+#define JPM_PACK_MIRROR_COMMAND_H
+
+#include <string>
+#include <vector>
+#include "fetch/fetch.h"
+#include "cache/cache_store.h"
+
+namespace jpm {
+
+// `jpm pack-mirror <archive> [<lockfile>]`: fetches everything in the lockfile and
+// writes it into one mirror archive (see MirrorArchive) that `jpm install --mirror`
+// can install from on a machine with no network access.
+class PackMirrorCommand {
+public:
+    PackMirrorCommand();
+    // Returns true if the archive was written with every locked package
+    bool execute(const std::vector<std::string>& args);
+
+private:
+    FetchCommand fetch_command_;
+    CacheStore cache_;
+};
+
+} // namespace jpm
+
+#endif // JPM_PACK_MIRROR_COMMAND_H
@@ -1,5 +1,6 @@
 // src/network/http_client.cpp
 #include "network/http_client.h"
+#include "cache/mirror_archive.h"
 #include "jpm_config.h"
 
 #include <curl/curl.h>
@@ -9,9 +10,69 @@
 #include <sstream>
 #include <string>
 #include <sys/stat.h>
+#include <mutex>
+#include <future>
+#include <vector>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 namespace {
 
+/*========  shared connection state  ========*/
+// One share handle for the whole process: DNS results and TLS sessions are reused
+// by every request on every thread, so a new connection skips the lookup and
+// resumes the TLS session instead of paying for a full handshake. The connection
+// cache is deliberately not shared: libcurl does not support that between easy
+// handles running concurrently on different threads.
+std::mutex g_share_locks[CURL_LOCK_DATA_LAST];
+
+void share_lock(CURL*, curl_lock_data data, curl_lock_access, void*)
+{
+    g_share_locks[data].lock();
+}
+
+void share_unlock(CURL*, curl_lock_data data, void*)
+{
+    g_share_locks[data].unlock();
+}
+
+CURLSH* shared_handle()
+{
+    static CURLSH* share = []() {
+        CURLSH* handle = curl_share_init();
+        if (handle) {
+            curl_share_setopt(handle, CURLSHOPT_LOCKFUNC, share_lock);
+            curl_share_setopt(handle, CURLSHOPT_UNLOCKFUNC, share_unlock);
+            curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+            curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        }
+        return handle;
+    }();
+    return share;
+}
+
+// Options every request gets: shared DNS and TLS sessions, HTTP/2 over TLS when the
+// server offers it, and no Nagle delay on small registry requests.
+void apply_common_options(CURL* curl)
+{
+    if (CURLSH* share = shared_handle())
+        curl_easy_setopt(curl, CURLOPT_SHARE, share);
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+    curl_easy_setopt(curl, CURLOPT_TCP_NODELAY, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L); // follow redirects
+}
+
+/*========  mirror  ========*/
+// Installed once by `install --mirror` before any worker threads start, then only read
+std::shared_ptr<const jpm::MirrorArchive> g_mirror;
+
 /*========  helpers  ========*/
 size_t write_to_string(void* contents, size_t size, size_t nmemb, void* userp)
 {
@@ -29,6 +90,210 @@ size_t write_to_stream(void* contents, size_t size, size_t nmemb, void* userp)
     return out->good() ? realSize : 0;        // abort transfer if write fails
 }
 
+/*========  downloads  ========*/
+// Files at least this large are split into parallel Range requests when the
+// server advertises "Accept-Ranges: bytes"
+constexpr curl_off_t kRangedDownloadThreshold = 4 * 1024 * 1024;
+constexpr curl_off_t kMinRangeChunk = 1024 * 1024;
+constexpr int kMaxRangeConnections = 6;
+
+struct DownloadProbe {
+    CURL* curl = nullptr;
+    std::ostream* out = nullptr;
+    curl_off_t content_length = -1;
+    bool accept_ranges = false;
+    bool checked = false;
+    bool switch_to_ranges = false;
+    std::string effective_url;
+};
+
+size_t probe_header(char* buffer, size_t size, size_t nitems, void* userp)
+{
+    const size_t length = size * nitems;
+    auto* probe = static_cast<DownloadProbe*>(userp);
+    std::string line(buffer, length);
+    std::string lower = line;
+    for (auto& c : lower)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+
+    if (lower.compare(0, 5, "http/") == 0) {          // new response (e.g. after a redirect)
+        probe->content_length = -1;
+        probe->accept_ranges  = false;
+    } else if (lower.compare(0, 15, "content-length:") == 0) {
+        probe->content_length = std::strtoll(line.c_str() + 15, nullptr, 10);
+    } else if (lower.compare(0, 14, "accept-ranges:") == 0) {
+        probe->accept_ranges = lower.find("bytes", 14) != std::string::npos;
+    }
+    return length;
+}
+
+size_t write_or_switch(void* contents, size_t size, size_t nmemb, void* userp)
+{
+    auto* probe = static_cast<DownloadProbe*>(userp);
+    if (!probe->checked) {
+        probe->checked   = true;
+        long status_code = 0;
+        curl_easy_getinfo(probe->curl, CURLINFO_RESPONSE_CODE, &status_code);
+        if (status_code == 200 && probe->accept_ranges &&
+            probe->content_length >= kRangedDownloadThreshold) {
+            char* effective = nullptr;
+            curl_easy_getinfo(probe->curl, CURLINFO_EFFECTIVE_URL, &effective);
+            probe->effective_url    = effective ? effective : "";
+            probe->switch_to_ranges = !probe->effective_url.empty();
+            if (probe->switch_to_ranges)
+                return 0;                              // abort this stream; ranges take over
+        }
+    }
+    return write_to_stream(contents, size, nmemb, probe->out);
+}
+
+// One GET into output_path. With a probe, may stop after the headers and set
+// probe->switch_to_ranges instead of finishing the body.
+bool download_stream(const std::string& url, const std::string& output_path, DownloadProbe* probe)
+{
+    std::ofstream out(output_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "  Cannot open " << output_path << " for writing.\n";
+        return false;
+    }
+
+    CURL* curl = curl_easy_init();
+    if (!curl) {
+        std::cerr << "curl_easy_init() failed" << std::endl;
+        return false;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    if (probe) {
+        probe->curl = curl;
+        probe->out  = &out;
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, probe_header);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, probe);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_or_switch);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, probe);
+    } else {
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_to_stream);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &out);
+    }
+    apply_common_options(curl);
+
+    CURLcode res          = curl_easy_perform(curl);
+    long     status_code  = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status_code);
+
+    curl_easy_cleanup(curl);
+    out.close();
+
+    if (probe && probe->switch_to_ranges) {
+        if (g_verbose_output)
+            std::cout << "  " << probe->content_length << " bytes with Accept-Ranges; switching to parallel ranges"
+                      << std::endl;
+        return false;
+    }
+
+    if (res == CURLE_OK && status_code == 200) {
+        if (g_verbose_output) {
+            struct stat st {};
+            if (stat(output_path.c_str(), &st) == 0)
+                std::cout << "  Downloaded " << st.st_size << " bytes.\n";
+        }
+        return true;
+    }
+
+    std::cerr << "HttpClient::download_file failed (" << res << ", status "
+              << status_code << "): " << curl_easy_strerror(res) << std::endl;
+    std::remove(output_path.c_str());
+    return false;
+}
+
+#ifndef _WIN32
+struct RangeTarget {
+    int        fd;
+    curl_off_t offset;   // next file offset to write
+    curl_off_t end;      // one past the last byte of this range
+};
+
+size_t write_at_offset(void* contents, size_t size, size_t nmemb, void* userp)
+{
+    const size_t realSize = size * nmemb;
+    auto* target = static_cast<RangeTarget*>(userp);
+    if (target->offset + static_cast<curl_off_t>(realSize) > target->end)
+        return 0;                                      // server sent more than asked for
+    const char* data = static_cast<const char*>(contents);
+    size_t written   = 0;
+    while (written < realSize) {
+        ssize_t n = ::pwrite(target->fd, data + written, realSize - written,
+                             static_cast<off_t>(target->offset + static_cast<curl_off_t>(written)));
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return 0;
+        }
+        written += static_cast<size_t>(n);
+    }
+    target->offset += static_cast<curl_off_t>(realSize);
+    return realSize;
+}
+
+bool download_range(const std::string& url, int fd, curl_off_t begin, curl_off_t end)
+{
+    CURL* curl = curl_easy_init();
+    if (!curl)
+        return false;
+
+    RangeTarget target{fd, begin, end};
+    std::string range = std::to_string(begin) + "-" + std::to_string(end - 1);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_at_offset);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &target);
+    apply_common_options(curl);
+
+    CURLcode res         = curl_easy_perform(curl);
+    long     status_code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status_code);
+    curl_easy_cleanup(curl);
+
+    // 206 and exactly the requested bytes; a 200 would be the whole file
+    return res == CURLE_OK && status_code == 206 && target.offset == end;
+}
+#endif
+
+// Fetches [0, length) as concurrent Range requests written in place with pwrite
+bool download_ranges(const std::string& url, const std::string& output_path, curl_off_t length)
+{
+#ifdef _WIN32
+    (void)url; (void)output_path; (void)length;
+    return false;
+#else
+    int fd = ::open(output_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return false;
+    if (::ftruncate(fd, static_cast<off_t>(length)) != 0) {   // preallocate: chunks land anywhere
+        ::close(fd);
+        return false;
+    }
+
+    const curl_off_t chunks = std::min<curl_off_t>(kMaxRangeConnections,
+                                                   std::max<curl_off_t>(1, length / kMinRangeChunk));
+    const curl_off_t chunk_size = (length + chunks - 1) / chunks;
+    std::vector<std::future<bool>> parts;
+    for (curl_off_t begin = 0; begin < length; begin += chunk_size) {
+        curl_off_t end = std::min(length, begin + chunk_size);
+        parts.push_back(std::async(std::launch::async, download_range, url, fd, begin, end));
+    }
+
+    bool ok = true;
+    for (auto& part : parts)
+        ok = part.get() && ok;
+    ok = ::close(fd) == 0 && ok;
+
+    if (g_verbose_output && ok)
+        std::cout << "  Downloaded " << length << " bytes in " << parts.size() << " ranges.\n";
+    return ok;
+#endif
+}
+
 } // namespace
 
 namespace jpm {
@@ -42,6 +307,20 @@ HttpClient::HttpClient()
 
 HttpClient::~HttpClient() { curl_global_cleanup(); }
 
+void HttpClient::use_mirror(std::shared_ptr<const MirrorArchive> mirror)
+{
+    g_mirror = std::move(mirror);
+}
+
+bool HttpClient::has_mirror() { return g_mirror != nullptr; }
+
+std::optional<std::string_view> HttpClient::mirror_view(const std::string& url)
+{
+    if (!g_mirror)
+        return std::nullopt;
+    return g_mirror->find(MirrorArchive::key_for_url(url));
+}
+
 /*---------------------------------------------------------
  | GET (returns body or std::nullopt on failure)
  *--------------------------------------------------------*/
@@ -50,6 +329,18 @@ std::optional<std::string> HttpClient::get(const std::string& url)
     if (g_verbose_output)
         std::cout << "HttpClient::get fetching " << url << std::endl;
 
+    if (g_mirror) {
+        if (std::optional<std::string_view> body = mirror_view(url))
+            return std::string(*body);
+        std::cerr << "HttpClient::get: " << url << " is not in the mirror archive" << std::endl;
+        return std::nullopt;
+    }
+
+    if (g_offline_mode) {
+        std::cerr << "HttpClient::get refused in offline mode: " << url << std::endl;
+        return std::nullopt;
+    }
+
     CURL* curl = curl_easy_init();
     if (!curl) {
         std::cerr << "curl_easy_init() failed" << std::endl;
@@ -60,7 +351,8 @@ std::optional<std::string> HttpClient::get(const std::string& url)
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_to_string);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buffer);
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L); // follow redirects
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, ""); // packuments compress very well
+    apply_common_options(curl);
 
     CURLcode res           = curl_easy_perform(curl);
     long      status_code  = 0;
@@ -88,43 +380,34 @@ bool HttpClient::download_file(const std::string& url, const std::string& output
         std::cout << "HttpClient::download_file " << url << " → " << output_path
                   << std::endl;
 
-    std::ofstream out(output_path, std::ios::binary);
-    if (!out) {
-        std::cerr << "  Cannot open " << output_path << " for writing.\n";
-        return false;
+    if (g_mirror) {
+        std::optional<std::string_view> body = mirror_view(url);
+        if (!body) {
+            std::cerr << "HttpClient::download_file: " << url << " is not in the mirror archive" << std::endl;
+            return false;
+        }
+        std::ofstream mirrored(output_path, std::ios::binary);
+        mirrored.write(body->data(), static_cast<std::streamsize>(body->size()));
+        return static_cast<bool>(mirrored);
     }
 
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        std::cerr << "curl_easy_init() failed" << std::endl;
+    if (g_offline_mode) {
+        std::cerr << "HttpClient::download_file refused in offline mode: " << url << std::endl;
         return false;
     }
 
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_to_stream);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &out);
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    // The first response's headers decide whether the file is big enough to fetch
+    // in parallel ranges; small files just continue on the same stream.
+    DownloadProbe probe;
+    bool ok = download_stream(url, output_path, &probe);
+    if (!probe.switch_to_ranges)
+        return ok;
 
-    CURLcode res          = curl_easy_perform(curl);
-    long     status_code  = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status_code);
-
-    curl_easy_cleanup(curl);
-    out.close();
-
-    if (res == CURLE_OK && status_code == 200) {
-        if (g_verbose_output) {
-            struct stat st {};
-            if (stat(output_path.c_str(), &st) == 0)
-                std::cout << "  Downloaded " << st.st_size << " bytes.\n";
-        }
+    if (download_ranges(probe.effective_url, output_path, probe.content_length))
         return true;
-    }
-
-    std::cerr << "HttpClient::download_file failed (" << res << ", status "
-              << status_code << "): " << curl_easy_strerror(res) << std::endl;
-    std::remove(output_path.c_str());
-    return false;
+    if (g_verbose_output)
+        std::cout << "  Ranged download failed; retrying as a single stream" << std::endl;
+    return download_stream(url, output_path, nullptr);
 }
 
 } // namespace jpm
@@ -2,10 +2,14 @@
 #define JPM_HTTP_CLIENT_H
 
 #include <string>
+#include <string_view>
+#include <memory>
 #include <optional> // C++17
 
 namespace jpm {
 
+class MirrorArchive;
+
 class HttpClient {
 public:
     HttpClient();
@@ -18,6 +22,15 @@ public:
     // Downloads a file to the specified path
     // Returns true on success, false on error
     bool download_file(const std::string& url, const std::string& output_path);
+
+    // Serves every request of every client from a mirror archive instead of the
+    // network (`install --mirror`). Set before any requests are made.
+    static void use_mirror(std::shared_ptr<const MirrorArchive> mirror);
+    static bool has_mirror();
+
+    // Mirror bytes for url without copying, valid for the life of the process.
+    // Returns std::nullopt when no mirror is active or it has no such entry.
+    static std::optional<std::string_view> mirror_view(const std::string& url);
 };
 
 } // namespace jpm
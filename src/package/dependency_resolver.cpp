@@ -1,13 +1,40 @@
 #include "package/dependency_resolver.h"
+#include "utils/platform_utils.h"
+#include "utils/file_utils.h"
 #include "jpm_config.h"
 #include <iostream>
 #include <future>
 #include <thread>
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <cctype>
 
 namespace jpm {
 
+namespace {
+
+// "os", "cpu" and "libc" are normally arrays, but a bare string is accepted too
+std::vector<std::string> read_string_list(const JsonData& data, const char* key) {
+    std::vector<std::string> values;
+    if (!data.contains(key)) {
+        return values;
+    }
+    const JsonData& field = data[key];
+    if (field.is_string()) {
+        values.push_back(field.get<std::string>());
+    } else if (field.is_array()) {
+        for (const auto& entry : field) {
+            if (entry.is_string()) {
+                values.push_back(entry.get<std::string>());
+            }
+        }
+    }
+    return values;
+}
+
+} // namespace
+
 DependencyResolver::DependencyResolver() {
     if (g_verbose_output) {
         std::cout << "DependencyResolver initialized." << std::endl;
@@ -24,11 +51,13 @@ ResolutionResult DependencyResolver::resolve(const PackageSpec& initial_package_
     std::map<std::string, PackageInfo> packages_to_install_map;
     std::set<std::string> visited_on_path;
 
-    if (resolve_recursive(initial_package_spec, packages_to_install_map, visited_on_path, result.error_message)) {
+    if (resolve_recursive(initial_package_spec, "", packages_to_install_map, result.dependency_edges,
+                          visited_on_path, result.error_message)) {
         result.success = true;
         for (const auto& pair : packages_to_install_map) {
             result.packages_to_install.push_back(pair.second);
         }
+        mark_optional_packages(result);
         if (g_verbose_output) {
             std::cout << "Successfully resolved all dependencies for: " << initial_package_spec.to_string() << std::endl;
         }
@@ -42,9 +71,60 @@ ResolutionResult DependencyResolver::resolve(const PackageSpec& initial_package_
     return result;
 }
 
+ResolutionResult DependencyResolver::resolve(const std::vector<PackageSpec>& root_specs) {
+    if (g_verbose_output) {
+        std::cout << "Top-level resolve initiated for " << root_specs.size() << " root packages" << std::endl;
+    }
+    ResolutionResult result;
+    result.requested_packages = root_specs;
+
+    std::map<std::string, PackageInfo> packages_to_install_map;
+
+    // Every root shares the same install map, so a package reachable from several
+    // roots is fetched and resolved only once.
+    std::vector<std::future<bool>> root_futures;
+    for (const auto& root_spec : root_specs) {
+        root_futures.push_back(
+            std::async(std::launch::async,
+                [this, root_spec, &packages_to_install_map, &result]() {
+                    return this->resolve_recursive(root_spec, "", packages_to_install_map, result.dependency_edges,
+                                                   {}, result.error_message);
+                }
+            )
+        );
+    }
+
+    bool all_roots_resolved = true;
+    for (auto& root_future : root_futures) {
+        if (!root_future.get()) {
+            all_roots_resolved = false;
+        }
+    }
+
+    if (all_roots_resolved) {
+        result.success = true;
+        for (const auto& pair : packages_to_install_map) {
+            result.packages_to_install.push_back(pair.second);
+        }
+        mark_optional_packages(result);
+        if (g_verbose_output) {
+            std::cout << "Successfully resolved " << result.packages_to_install.size()
+                      << " packages for " << root_specs.size() << " roots" << std::endl;
+        }
+    } else {
+        if (result.error_message.empty()) {
+            result.error_message = "Unknown error during resolution of project dependencies";
+        }
+        std::cerr << "Resolution failed. Error: " << result.error_message << std::endl;
+    }
+    return result;
+}
+
 bool DependencyResolver::resolve_recursive(
     const PackageSpec& current_spec,
+    const std::string& parent_key,
     std::map<std::string, PackageInfo>& shared_packages_to_install_map,
+    DependencyEdges& shared_edges,
     std::set<std::string> visited_on_current_path,
     std::string& shared_error_accumulator) {
 
@@ -59,6 +139,12 @@ bool DependencyResolver::resolve_recursive(
             for(const auto& p : visited_on_current_path) { std::cout << p << " -> "; }
             std::cout << current_spec_id << " ]" << std::endl;
         }
+        // The edge still matters to the layout planner; the manifest is already cached
+        PackageInfo cycle_info = fetch_and_parse_package_info(current_spec);
+        if (!cycle_info.resolved_version.empty()) {
+            std::lock_guard<std::mutex> lock(resolver_mutex_);
+            shared_edges[parent_key][cycle_info.name] = cycle_info.name + "@" + cycle_info.resolved_version;
+        }
         return true;
     }
     visited_on_current_path.insert(current_spec_id);
@@ -82,6 +168,7 @@ bool DependencyResolver::resolve_recursive(
 
     {
         std::lock_guard<std::mutex> lock(resolver_mutex_);
+        shared_edges[parent_key][package_info.name] = resolved_package_key;
         if (shared_packages_to_install_map.count(resolved_package_key)) {
             if (g_verbose_output) {
                 std::cout << "[Thread " << std::this_thread::get_id() << "] Package " << resolved_package_key
@@ -96,11 +183,13 @@ bool DependencyResolver::resolve_recursive(
         }
     }
 
-    if (!package_info.dependencies.empty()) {
+    if (!package_info.dependencies.empty() || !package_info.optional_dependencies.empty()) {
         std::vector<std::future<bool>> dependency_futures;
+        std::vector<std::future<bool>> optional_futures;
         if (g_verbose_output) {
             std::cout << "[Thread " << std::this_thread::get_id() << "] Queueing " << package_info.dependencies.size()
-                      << " dependencies for " << resolved_package_key << std::endl;
+                      << " dependencies and " << package_info.optional_dependencies.size()
+                      << " optional dependencies for " << resolved_package_key << std::endl;
         }
 
         for (const auto& dep_pair : package_info.dependencies) {
@@ -109,10 +198,13 @@ bool DependencyResolver::resolve_recursive(
             dependency_futures.push_back(
                 std::async(std::launch::async,
                     [this, captured_spec = spec_for_async, path_copy = visited_on_current_path,
-                     &map_ref = shared_packages_to_install_map, &err_ref = shared_error_accumulator]() mutable {
+                     &parent_ref = resolved_package_key, &map_ref = shared_packages_to_install_map,
+                     &edges_ref = shared_edges, &err_ref = shared_error_accumulator]() mutable {
                         return this->resolve_recursive(
                             captured_spec,
+                            parent_ref,
                             map_ref,
+                            edges_ref,
                             path_copy,
                             err_ref
                         );
@@ -121,12 +213,62 @@ bool DependencyResolver::resolve_recursive(
             );
         }
 
+        // Optional dependencies: variants for every os/cpu/libc are resolved, so the graph
+        // and the lockfile made from it fit any host; filter_for_host() picks this host's
+        // at install time, before anything is downloaded. Each is resolved into a scratch
+        // graph that joins the shared one only if its whole subtree resolved, so a failure
+        // below an optional dependency drops that dependency instead of failing the parent.
+        for (const auto& dep_pair : package_info.optional_dependencies) {
+            PackageSpec spec_for_async(dep_pair.first, dep_pair.second);
+
+            optional_futures.push_back(
+                std::async(std::launch::async,
+                    [this, captured_spec = spec_for_async, path_copy = visited_on_current_path,
+                     &parent_ref = resolved_package_key, &map_ref = shared_packages_to_install_map,
+                     &edges_ref = shared_edges]() mutable {
+                        PackageInfo optional_info = this->fetch_and_parse_package_info(captured_spec);
+                        if (optional_info.resolved_version.empty() || optional_info.tarball_url.empty()) {
+                            if (g_verbose_output) {
+                                std::cout << "[Thread " << std::this_thread::get_id() << "] Skipping optional dependency "
+                                          << captured_spec.to_string() << " (metadata unavailable)" << std::endl;
+                            }
+                            return false;
+                        }
+                        std::map<std::string, PackageInfo> optional_packages;
+                        DependencyEdges optional_edges;
+                        std::string optional_errors;
+                        if (!this->resolve_recursive(captured_spec, parent_ref, optional_packages, optional_edges,
+                                                     path_copy, optional_errors)) {
+                            if (g_verbose_output) {
+                                std::cout << "[Thread " << std::this_thread::get_id() << "] Skipping optional dependency "
+                                          << captured_spec.to_string() << ": " << optional_errors << std::endl;
+                            }
+                            return false;
+                        }
+                        std::lock_guard<std::mutex> lock(resolver_mutex_);
+                        for (auto& [key, info] : optional_packages) {
+                            map_ref.emplace(key, std::move(info));
+                        }
+                        for (const auto& [key, dependencies] : optional_edges) {
+                            for (const auto& [dep_name, dep_key] : dependencies) {
+                                edges_ref[key][dep_name] = dep_key;
+                            }
+                        }
+                        return true;
+                    }
+                )
+            );
+        }
+
         bool all_deps_resolved = true;
         for (size_t i = 0; i < dependency_futures.size(); ++i) {
             if (!dependency_futures[i].get()) {
                 all_deps_resolved = false;
             }
         }
+        for (auto& optional_future : optional_futures) {
+            optional_future.get();
+        }
 
         if (!all_deps_resolved) {
             if (g_verbose_output) {
@@ -143,6 +285,88 @@ bool DependencyResolver::resolve_recursive(
     return true;
 }
 
+bool DependencyResolver::is_platform_compatible(const PackageInfo& info) {
+    return PlatformUtils::matches_host(info.os, info.cpu, info.libc);
+}
+
+void DependencyResolver::mark_optional_packages(ResolutionResult& result) {
+    std::map<std::string, PackageInfo*> packages_by_key;
+    for (auto& info : result.packages_to_install) {
+        info.optional = true;
+        packages_by_key[info.name + "@" + info.resolved_version] = &info;
+    }
+
+    // Walk from the roots along required edges; whatever this does not reach is optional
+    std::vector<std::string> pending{""};
+    std::set<std::string> required;
+    while (!pending.empty()) {
+        std::string key = std::move(pending.back());
+        pending.pop_back();
+        auto edges_it = result.dependency_edges.find(key);
+        if (edges_it == result.dependency_edges.end()) {
+            continue;
+        }
+        auto parent_it = packages_by_key.find(key);
+        for (const auto& [dep_name, dep_key] : edges_it->second) {
+            if (parent_it != packages_by_key.end() && parent_it->second->optional_dependencies.count(dep_name)) {
+                continue;
+            }
+            auto dep_it = packages_by_key.find(dep_key);
+            if (dep_it != packages_by_key.end() && required.insert(dep_key).second) {
+                dep_it->second->optional = false;
+                pending.push_back(dep_key);
+            }
+        }
+    }
+}
+
+ResolutionResult DependencyResolver::filter_for_host(const ResolutionResult& result) {
+    std::map<std::string, const PackageInfo*> packages_by_key;
+    for (const auto& info : result.packages_to_install) {
+        if (!info.optional || is_platform_compatible(info)) {
+            packages_by_key[info.name + "@" + info.resolved_version] = &info;
+        } else if (g_verbose_output) {
+            std::cout << "Skipping optional dependency " << info.name << "@" << info.resolved_version
+                      << " (not built for " << PlatformUtils::host_os() << "/" << PlatformUtils::host_cpu()
+                      << ")" << std::endl;
+        }
+    }
+
+    ResolutionResult filtered;
+    filtered.requested_package = result.requested_package;
+    filtered.requested_packages = result.requested_packages;
+    filtered.success = result.success;
+    filtered.error_message = result.error_message;
+
+    // Keep what the roots still reach once the skipped packages are gone
+    std::vector<std::string> pending{""};
+    std::set<std::string> reached{""};
+    while (!pending.empty()) {
+        std::string key = std::move(pending.back());
+        pending.pop_back();
+        auto edges_it = result.dependency_edges.find(key);
+        if (edges_it == result.dependency_edges.end()) {
+            continue;
+        }
+        std::map<std::string, std::string>& kept_edges = filtered.dependency_edges[key];
+        for (const auto& [dep_name, dep_key] : edges_it->second) {
+            if (!packages_by_key.count(dep_key)) {
+                continue;
+            }
+            kept_edges[dep_name] = dep_key;
+            if (reached.insert(dep_key).second) {
+                pending.push_back(dep_key);
+            }
+        }
+    }
+    for (const auto& info : result.packages_to_install) {
+        if (reached.count(info.name + "@" + info.resolved_version)) {
+            filtered.packages_to_install.push_back(info);
+        }
+    }
+    return filtered;
+}
+
 PackageInfo DependencyResolver::fetch_and_parse_package_info(const PackageSpec& spec) {
     std::string version_to_fetch = spec.version_requirement;
     if (version_to_fetch.empty()) {
@@ -161,7 +385,7 @@ PackageInfo DependencyResolver::fetch_and_parse_package_info(const PackageSpec&
         version_to_fetch = "latest";
     }
 
-    std::string registry_url = "https://registry.npmjs.org/" + spec.name + "/" + version_to_fetch;
+    std::string registry_url = g_registry_url + spec.name + "/" + version_to_fetch;
     if (g_verbose_output) {
         std::cout << "[Thread " << std::this_thread::get_id() << "] Fetching package metadata from: " << registry_url << std::endl;
     }
@@ -177,7 +401,24 @@ PackageInfo DependencyResolver::fetch_and_parse_package_info(const PackageSpec&
         }
     }
 
-    std::optional<std::string> response_opt = http_client_.get(registry_url);
+    std::optional<std::string> response_opt;
+    if (HttpClient::has_mirror()) {
+        // Everything comes from the mapped mirror archive; nothing is written to the cache
+        response_opt = http_client_.get(registry_url);
+    } else {
+        // Shared on-disk cache: exact versions never change, tags like "latest" are refreshed
+        // after a short time. Concurrent jpm processes wait for one download of each packument.
+        std::optional<std::string> cached_path = cache_.get_or_create(
+            cache_.packument_path(spec.name, version_to_fetch),
+            [this, &registry_url](const std::string& temp_path) {
+                std::optional<std::string> body = http_client_.get(registry_url);
+                return body && FileUtils::write_file(temp_path, *body);
+            },
+            CacheStore::packument_max_age(version_to_fetch));
+        if (cached_path) {
+            response_opt = FileUtils::read_file(*cached_path);
+        }
+    }
 
     if (!response_opt) {
         std::cerr << "[Thread " << std::this_thread::get_id() << "] HTTP client failed to fetch package data for " << spec.to_string() << " from " << registry_url << std::endl;
@@ -218,6 +459,20 @@ PackageInfo DependencyResolver::fetch_and_parse_package_info(const PackageSpec&
         }
     }
 
+    if (data.contains("optionalDependencies") && data["optionalDependencies"].is_object()) {
+        for (auto& [dep_name, dep_ver_req_json] : data["optionalDependencies"].items()) {
+            if (dep_ver_req_json.is_string()) {
+                info.optional_dependencies[dep_name] = dep_ver_req_json.get<std::string>();
+                // npm also lists optional dependencies under "dependencies"; the optional entry wins
+                info.dependencies.erase(dep_name);
+            }
+        }
+    }
+
+    info.os = read_string_list(data, "os");
+    info.cpu = read_string_list(data, "cpu");
+    info.libc = read_string_list(data, "libc");
+
     if (info.resolved_version.empty() || info.tarball_url.empty()){
         std::cerr << "[Thread " << std::this_thread::get_id() << "] Could not extract all required fields (version, tarball URL) for " << spec.to_string()
                   << " from JSON. Name: '" << info.name << "', Resolved: '" << info.resolved_version
@@ -10,13 +10,20 @@
 #include "package/package_info.h"
 #include "network/http_client.h"
 #include "parsing/json_parser.h"
+#include "cache/cache_store.h"
 #include <mutex>
 
 namespace jpm {
 
+// Resolved dependency graph: "name@version" -> dependency name -> resolved "name@version".
+// Root packages are listed under the empty key.
+using DependencyEdges = std::map<std::string, std::map<std::string, std::string>>;
+
 struct ResolutionResult {
     PackageSpec requested_package;
+    std::vector<PackageSpec> requested_packages; // All roots when resolving a whole project
     std::vector<PackageInfo> packages_to_install;
+    DependencyEdges dependency_edges;
     bool success = false;
     std::string error_message;
 };
@@ -27,19 +34,40 @@ public:
 
     ResolutionResult resolve(const PackageSpec& initial_package_spec);
 
+    // Resolves several root specs concurrently into one deduplicated graph,
+    // e.g. every dependency listed in a project's package.json
+    ResolutionResult resolve(const std::vector<PackageSpec>& root_specs);
+
+    // Fetches one version manifest (through the in-process and shared caches) without
+    // following dependencies. Returns an empty PackageInfo on failure.
+    PackageInfo fetch_and_parse_package_info(const PackageSpec& spec);
+
+    // The part of a resolved graph to install on this host: optional packages whose
+    // os/cpu/libc exclude it are dropped, and so is everything the roots no longer
+    // reach. Resolution and the lockfile keep every platform's variants.
+    static ResolutionResult filter_for_host(const ResolutionResult& result);
+
 private:
     HttpClient http_client_;
+    CacheStore cache_; // Shared with other jpm processes
     std::mutex resolver_mutex_;
-    std::unordered_map<std::string, PackageInfo> package_cache_;
+    std::unordered_map<std::string, PackageInfo> package_cache_; // Per-process, in front of cache_
 
     bool resolve_recursive(
         const PackageSpec& current_spec,
+        const std::string& parent_key, // "name@version" of the dependent, "" for roots
         std::map<std::string, PackageInfo>& packages_to_install_map,
+        DependencyEdges& edges,
         std::set<std::string> visited_on_current_path,
         std::string& error_accumulator
     );
 
-    PackageInfo fetch_and_parse_package_info(const PackageSpec& spec);
+    // Checks the package's os/cpu/libc fields against the host
+    static bool is_platform_compatible(const PackageInfo& info);
+
+    // Sets PackageInfo::optional on every package the roots reach only through
+    // optionalDependencies edges
+    static void mark_optional_packages(ResolutionResult& result);
 };
 
 } // namespace jpm
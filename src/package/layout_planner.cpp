@@ -0,0 +1,232 @@
+#include "package/layout_planner.h"
+#include "jpm_config.h"
+#include <iostream>
+#include <deque>
+#include <set>
+#include <limits>
+#include <functional>
+
+namespace jpm {
+
+LayoutPlanner::LayoutPlanner() {
+    if (g_verbose_output) {
+        std::cout << "LayoutPlanner initialized." << std::endl;
+    }
+}
+
+InstallLayout LayoutPlanner::plan(const ResolutionResult& result, const std::string& root_node_modules) {
+    nodes_.clear();
+    root_preference_.clear();
+
+    InstallLayout layout;
+    std::map<std::string, PackageInfo> packages_by_key;
+    for (const auto& info : result.packages_to_install) {
+        packages_by_key[info.name + "@" + info.resolved_version] = info;
+    }
+    layout.stats.unique_packages = packages_by_key.size();
+
+    Node root;
+    root.modules_dir = root_node_modules;
+    nodes_.push_back(root);
+    choose_root_preferences(result);
+
+    // Breadth-first, so every package is placed before anything that depends on it
+    // can be nested below it, and shallower requirements claim slots first.
+    std::set<std::string> placed_keys;
+    std::deque<size_t> queue{0};
+    while (!queue.empty()) {
+        size_t node_index = queue.front();
+        queue.pop_front();
+
+        auto edges_it = result.dependency_edges.find(nodes_[node_index].key);
+        if (edges_it == result.dependency_edges.end()) {
+            continue;
+        }
+        for (const auto& [dep_name, dep_key] : edges_it->second) {
+            size_t new_node = place(node_index, dep_name, dep_key, packages_by_key, layout);
+            if (new_node != kNone) {
+                placed_keys.insert(dep_key);
+                queue.push_back(new_node);
+            }
+        }
+    }
+
+    // Packages the edge list does not reach (should not happen) still get a top-level slot if free
+    for (const auto& [key, info] : packages_by_key) {
+        if (placed_keys.count(key)) {
+            continue;
+        }
+        size_t new_node = place(0, info.name, key, packages_by_key, layout);
+        if (new_node == kNone && g_verbose_output) {
+            std::cout << "LayoutPlanner: no slot for unreachable package " << key << std::endl;
+        }
+    }
+
+    layout.stats.planned_copies = layout.packages.size();
+    layout.stats.nested_copies = count_nested_copies(result.dependency_edges);
+
+    if (g_verbose_output) {
+        std::cout << "LayoutPlanner: " << layout.stats.unique_packages << " unique packages, "
+                  << layout.stats.planned_copies << " copies on disk (" << layout.stats.conflicts
+                  << " nested), " << layout.stats.nested_copies << " without hoisting" << std::endl;
+    }
+    return layout;
+}
+
+std::vector<size_t> LayoutPlanner::chain_to(size_t node_index) const {
+    std::vector<size_t> chain;
+    for (size_t current = node_index; current != kNone; current = nodes_[current].parent) {
+        chain.push_back(current);
+    }
+    return std::vector<size_t>(chain.rbegin(), chain.rend()); // root first
+}
+
+size_t LayoutPlanner::place(size_t requester, const std::string& name, const std::string& key,
+                            const std::map<std::string, PackageInfo>& packages_by_key, InstallLayout& layout) {
+    auto info_it = packages_by_key.find(key);
+    if (info_it == packages_by_key.end()) {
+        return kNone; // Not installed, e.g. a skipped optional dependency
+    }
+
+    // Node resolution walks from the requester up to the root, so a different version
+    // anywhere on that path shadows everything above it: only slots below the deepest
+    // conflict are visible to the requester.
+    std::vector<size_t> chain = chain_to(requester);
+    size_t first_visible = 0;
+    for (size_t i = 0; i < chain.size(); ++i) {
+        auto existing = nodes_[chain[i]].children.find(name);
+        if (existing != nodes_[chain[i]].children.end() && existing->second != key) {
+            first_visible = i + 1;
+        }
+    }
+
+    size_t target = chain.size();
+    bool reused = false;
+    for (size_t i = first_visible; i < chain.size(); ++i) {
+        const Node& candidate = nodes_[chain[i]];
+        if (candidate.children.count(name)) {
+            target = i; // Same version already visible from here
+            reused = true;
+            break;
+        }
+        // Placing here would shadow a version that packages below already resolve through this level
+        auto through = candidate.passthrough.find(name);
+        if (through != candidate.passthrough.end() && through->second != key) {
+            continue;
+        }
+        if (i == 0) {
+            auto preferred = root_preference_.find(name);
+            if (preferred != root_preference_.end() && preferred->second != key) {
+                continue; // Keep the top-level slot for the most shared version
+            }
+        }
+        target = i;
+        break;
+    }
+
+    if (target == chain.size()) {
+        // Nothing above fits: nest directly under the requester
+        target = chain.size() - 1;
+        if (nodes_[chain[target]].children.count(name)) {
+            return kNone;
+        }
+    }
+
+    for (size_t i = target + 1; i < chain.size(); ++i) {
+        nodes_[chain[i]].passthrough[name] = key;
+    }
+    if (reused) {
+        return kNone;
+    }
+
+    size_t host_index = chain[target];
+    nodes_[host_index].children[name] = key;
+
+    PlannedPackage planned;
+    planned.info = info_it->second;
+    planned.parent_directory = nodes_[host_index].modules_dir;
+    planned.install_path = planned.parent_directory + "/" + name;
+    planned.depth = target;
+    if (planned.depth > 0) {
+        ++layout.stats.conflicts;
+        if (g_verbose_output) {
+            std::cout << "LayoutPlanner: nesting " << key << " at " << planned.install_path << std::endl;
+        }
+    }
+
+    Node child;
+    child.key = key;
+    child.parent = host_index;
+    child.modules_dir = planned.install_path + "/node_modules";
+    layout.packages.push_back(std::move(planned));
+    nodes_.push_back(std::move(child));
+    return nodes_.size() - 1;
+}
+
+void LayoutPlanner::choose_root_preferences(const ResolutionResult& result) {
+    // Direct dependencies of the project always own their top-level slot
+    auto roots_it = result.dependency_edges.find("");
+    if (roots_it != result.dependency_edges.end()) {
+        root_preference_ = roots_it->second;
+    }
+
+    // Otherwise the version with the most dependents gets it (ties broken by key for determinism)
+    std::map<std::string, std::map<std::string, size_t>> dependents; // name -> key -> count
+    for (const auto& [parent_key, deps] : result.dependency_edges) {
+        if (parent_key.empty()) {
+            continue;
+        }
+        for (const auto& [dep_name, dep_key] : deps) {
+            ++dependents[dep_name][dep_key];
+        }
+    }
+    for (const auto& [name, counts] : dependents) {
+        if (root_preference_.count(name)) {
+            continue;
+        }
+        const std::string* best_key = nullptr;
+        size_t best_count = 0;
+        for (const auto& [key, count] : counts) {
+            if (count > best_count) {
+                best_key = &key;
+                best_count = count;
+            }
+        }
+        if (best_key) {
+            root_preference_[name] = *best_key;
+        }
+    }
+}
+
+size_t LayoutPlanner::count_nested_copies(const DependencyEdges& edges) const {
+    // Every edge is a separate directory in a fully nested tree; a dependency on an
+    // ancestor (cycle) resolves to the existing copy. Saturates instead of overflowing.
+    constexpr size_t kMax = std::numeric_limits<size_t>::max();
+    std::map<std::string, size_t> memo;
+    std::set<std::string> in_progress;
+
+    std::function<size_t(const std::string&)> subtree = [&](const std::string& key) -> size_t {
+        auto memo_it = memo.find(key);
+        if (memo_it != memo.end()) {
+            return memo_it->second;
+        }
+        if (!in_progress.insert(key).second) {
+            return 0;
+        }
+        size_t total = 0;
+        auto edges_it = edges.find(key);
+        if (edges_it != edges.end()) {
+            for (const auto& dep : edges_it->second) {
+                size_t child = subtree(dep.second);
+                size_t with_self = child == kMax ? kMax : child + 1;
+                total = (kMax - total < with_self) ? kMax : total + with_self;
+            }
+        }
+        in_progress.erase(key);
+        memo[key] = total;
+        return total;
+    };
+    return subtree("");
+}
+
+} // namespace jpm
@@ -0,0 +1,69 @@
+#ifndef JPM_LAYOUT_PLANNER_H
+#define JPM_LAYOUT_PLANNER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstddef>
+#include <cstdint>
+#include "package/package_info.h"
+#include "package/dependency_resolver.h"
+
+namespace jpm {
+
+// One copy of a package on disk
+struct PlannedPackage {
+    PackageInfo info;
+    std::string parent_directory; // node_modules directory it is extracted into
+    std::string install_path;     // parent_directory + "/" + name
+    size_t depth = 0;             // 0 = hoisted to the top-level node_modules
+};
+
+struct LayoutStats {
+    size_t unique_packages = 0; // distinct name@version in the graph
+    size_t planned_copies = 0;  // package directories in the hoisted layout
+    size_t nested_copies = 0;   // package directories a fully nested (unhoisted) tree would need
+    size_t conflicts = 0;       // copies nested below the top level because of a version conflict
+};
+
+struct InstallLayout {
+    std::vector<PlannedPackage> packages; // Parents always precede their nested children
+    LayoutStats stats;
+};
+
+// Computes a hoisted, deduplicated node_modules tree from a resolved graph.
+// Every package is placed as high as possible; only a conflicting version is
+// nested under node_modules/<parent>/node_modules. For names that several
+// versions compete for, the most depended-upon version claims the top level,
+// which keeps the number of copies on disk low.
+class LayoutPlanner {
+public:
+    LayoutPlanner();
+
+    InstallLayout plan(const ResolutionResult& result, const std::string& root_node_modules);
+
+private:
+    static constexpr size_t kNone = SIZE_MAX; // No node: the root's parent, or nothing placed
+
+    // A node_modules directory: the project root or a placed package
+    struct Node {
+        std::string key;            // "name@version" of the owning package, "" for the root
+        size_t parent = kNone;
+        std::string modules_dir;    // path of this node's node_modules directory
+        std::map<std::string, std::string> children;    // name -> key installed in modules_dir
+        std::map<std::string, std::string> passthrough; // name -> key that descendants resolve above this node
+    };
+
+    std::vector<Node> nodes_;
+    std::map<std::string, std::string> root_preference_; // name -> key that should own the top-level slot
+
+    std::vector<size_t> chain_to(size_t node_index) const;
+    size_t place(size_t parent_node, const std::string& name, const std::string& key,
+                 const std::map<std::string, PackageInfo>& packages_by_key, InstallLayout& layout);
+    void choose_root_preferences(const ResolutionResult& result);
+    size_t count_nested_copies(const DependencyEdges& edges) const;
+};
+
+} // namespace jpm
+
+#endif // JPM_LAYOUT_PLANNER_H
@@ -0,0 +1,168 @@
+#include "package/lockfile.h"
+#include "parsing/json_parser.h"
+#include "utils/file_utils.h"
+#include "cache/cache_store.h"
+#include "jpm_config.h"
+#include <iostream>
+#include <map>
+
+namespace jpm {
+
+namespace {
+constexpr int kLockfileVersion = 2;
+
+std::vector<std::string> read_string_list(const JsonData& entry, const char* key) {
+    std::vector<std::string> values;
+    if (entry.contains(key) && entry[key].is_array()) {
+        for (const auto& value : entry[key]) {
+            if (value.is_string()) {
+                values.push_back(value.get<std::string>());
+            }
+        }
+    }
+    return values;
+}
+
+void write_string_list(JsonData& entry, const char* key, const std::vector<std::string>& values) {
+    if (!values.empty()) {
+        entry[key] = values;
+    }
+}
+} // namespace
+
+std::optional<ResolutionResult> Lockfile::load(const std::string& path) {
+    std::optional<std::string> content = FileUtils::read_file(path);
+    if (!content) {
+        return std::nullopt;
+    }
+    JsonData data = JsonParser::try_parse(*content);
+    if (!data.is_object() || !data.contains("packages") || !data["packages"].is_object()) {
+        std::cerr << "Ignoring malformed lockfile: " << path << std::endl;
+        return std::nullopt;
+    }
+    if (!data.contains("lockfileVersion") || data["lockfileVersion"] != kLockfileVersion) {
+        std::cerr << "Ignoring lockfile with unsupported version: " << path << std::endl;
+        return std::nullopt;
+    }
+
+    ResolutionResult result;
+    if (data.contains("requested") && data["requested"].is_object()) {
+        for (auto& [name, range] : data["requested"].items()) {
+            if (range.is_string()) {
+                result.requested_packages.emplace_back(name, range.get<std::string>());
+            }
+        }
+    }
+    if (data.contains("roots") && data["roots"].is_object()) {
+        for (auto& [name, key] : data["roots"].items()) {
+            if (key.is_string()) {
+                result.dependency_edges[""][name] = key.get<std::string>();
+            }
+        }
+    }
+
+    for (auto& [key, entry] : data["packages"].items()) {
+        if (!entry.is_object() || !entry.contains("name") || !entry.contains("version") ||
+            !entry.contains("resolved") || !entry["name"].is_string() ||
+            !entry["version"].is_string() || !entry["resolved"].is_string()) {
+            std::cerr << "Ignoring lockfile with incomplete entry \"" << key << "\": " << path << std::endl;
+            return std::nullopt;
+        }
+        PackageInfo info;
+        info.name = entry["name"].get<std::string>();
+        info.resolved_version = entry["version"].get<std::string>();
+        info.tarball_url = entry["resolved"].get<std::string>();
+        auto read_edges = [&](const char* field, std::map<std::string, std::string>& requirements) {
+            if (!entry.contains(field) || !entry[field].is_object()) {
+                return;
+            }
+            for (auto& [dep_name, dep_key] : entry[field].items()) {
+                if (!dep_key.is_string()) continue;
+                std::string resolved_key = dep_key.get<std::string>();
+                result.dependency_edges[key][dep_name] = resolved_key;
+                requirements[dep_name] = resolved_key.substr(resolved_key.rfind('@') + 1);
+            }
+        };
+        read_edges("dependencies", info.dependencies);
+        read_edges("optionalDependencies", info.optional_dependencies);
+        info.optional = entry.contains("optional") && entry["optional"].is_boolean() && entry["optional"].get<bool>();
+        info.os = read_string_list(entry, "os");
+        info.cpu = read_string_list(entry, "cpu");
+        info.libc = read_string_list(entry, "libc");
+        result.packages_to_install.push_back(std::move(info));
+    }
+
+    result.success = true;
+    if (g_verbose_output) {
+        std::cout << "Loaded lockfile " << path << " with " << result.packages_to_install.size() << " packages" << std::endl;
+    }
+    return result;
+}
+
+bool Lockfile::save(const std::string& path, const ResolutionResult& result) {
+    JsonData data = JsonData::object();
+    data["lockfileVersion"] = kLockfileVersion;
+
+    data["requested"] = JsonData::object();
+    for (const auto& spec : result.requested_packages) {
+        data["requested"][spec.name] = spec.version_requirement;
+    }
+
+    data["roots"] = JsonData::object();
+    auto roots_it = result.dependency_edges.find("");
+    if (roots_it != result.dependency_edges.end()) {
+        for (const auto& [name, key] : roots_it->second) {
+            data["roots"][name] = key;
+        }
+    }
+
+    data["packages"] = JsonData::object();
+    for (const auto& info : result.packages_to_install) {
+        std::string key = info.name + "@" + info.resolved_version;
+        JsonData entry = JsonData::object();
+        entry["name"] = info.name;
+        entry["version"] = info.resolved_version;
+        entry["resolved"] = info.tarball_url;
+        entry["dependencies"] = JsonData::object();
+        auto edges_it = result.dependency_edges.find(key);
+        if (edges_it != result.dependency_edges.end()) {
+            for (const auto& [dep_name, dep_key] : edges_it->second) {
+                const char* field = info.optional_dependencies.count(dep_name) ? "optionalDependencies" : "dependencies";
+                entry[field][dep_name] = dep_key;
+            }
+        }
+        if (info.optional) {
+            entry["optional"] = true;
+        }
+        write_string_list(entry, "os", info.os);
+        write_string_list(entry, "cpu", info.cpu);
+        write_string_list(entry, "libc", info.libc);
+        data["packages"][key] = std::move(entry);
+    }
+
+    // nlohmann::json objects are sorted, so the file is stable across runs
+    if (!CacheStore::write_atomic(path, data.dump(2) + "\n")) {
+        std::cerr << "Failed to write lockfile " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Lockfile::matches_roots(const ResolutionResult& locked, const std::vector<PackageSpec>& roots) {
+    if (locked.requested_packages.size() != roots.size()) {
+        return false;
+    }
+    std::map<std::string, std::string> locked_requested;
+    for (const auto& spec : locked.requested_packages) {
+        locked_requested[spec.name] = spec.version_requirement;
+    }
+    for (const auto& spec : roots) {
+        auto it = locked_requested.find(spec.name);
+        if (it == locked_requested.end() || it->second != spec.version_requirement) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace jpm
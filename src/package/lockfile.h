@@ -0,0 +1,47 @@
+#ifndef JPM_LOCKFILE_H
+#define JPM_LOCKFILE_H
+
+#include <string>
+#include <vector>
+#include <optional>
+#include "package/package_spec.h"
+#include "package/dependency_resolver.h"
+
+namespace jpm {
+
+// jpm-lock.json: the fully resolved graph of a project, so later installs and
+// `jpm fetch` can skip resolution entirely.
+//
+// {
+//   "lockfileVersion": 2,
+//   "requested": { "<name>": "<range from package.json>" },
+//   "roots": { "<name>": "<name>@<version>" },
+//   "packages": {
+//     "<name>@<version>": { "name", "version", "resolved": "<tarball url>",
+//                           "dependencies": { "<name>": "<name>@<version>" },
+//                           "optionalDependencies": { "<name>": "<name>@<version>" },
+//                           "optional": true, "os": [...], "cpu": [...], "libc": [...] }
+//   }
+// }
+//
+// The graph holds the optional variants of every platform, each with its os/cpu/libc
+// constraints, so one lockfile serves every host; DependencyResolver::filter_for_host()
+// picks the variants at install time. "optional" and the constraint lists are written
+// only when set. Version 1 files were filtered for the host that wrote them and are
+// resolved again.
+class Lockfile {
+public:
+    static constexpr const char* kFileName = "jpm-lock.json";
+
+    // Returns std::nullopt if the file is missing or malformed
+    static std::optional<ResolutionResult> load(const std::string& path);
+
+    static bool save(const std::string& path, const ResolutionResult& result);
+
+    // True when the lockfile was produced for exactly these root specs
+    static bool matches_roots(const ResolutionResult& locked, const std::vector<PackageSpec>& roots);
+};
+
+} // namespace jpm
+
+#endif // JPM_LOCKFILE_H
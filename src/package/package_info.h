@@ -14,6 +14,14 @@ struct PackageInfo {
     std::string resolved_version;
     std::string tarball_url;
     std::map<std::string, std::string> dependencies; // name -> version_requirement string
+    std::map<std::string, std::string> optional_dependencies; // name -> version_requirement string
+    // Platform constraints from package.json ("os", "cpu", "libc"); empty means any
+    std::vector<std::string> os;
+    std::vector<std::string> cpu;
+    std::vector<std::string> libc;
+    // Reachable only through optionalDependencies; skipped at install time when the
+    // constraints above exclude the host
+    bool optional = false;
     // std::map<std::string, std::string> dev_dependencies;
     // ... other fields like description, license, etc.
 
@@ -16,8 +16,19 @@ struct PackageSpec {
     PackageSpec(std::string n, std::string v_req = "latest")
         : name(std::move(n)), version_requirement(std::move(v_req)) {}
 
-    // TODO: Add a static factory method to parse "name@version_req" string
-    // static PackageSpec from_string(const std::string& spec_string);
+    // Parses "name", "name@version_req", "@scope/name" or "@scope/name@version_req".
+    // The leading '@' of a scoped name is not treated as the version separator.
+    static PackageSpec from_string(const std::string& spec_string) {
+        size_t at = spec_string.rfind('@');
+        if (at == std::string::npos || at == 0) {
+            return PackageSpec(spec_string);
+        }
+        std::string version_requirement = spec_string.substr(at + 1);
+        if (version_requirement.empty()) {
+            version_requirement = "latest";
+        }
+        return PackageSpec(spec_string.substr(0, at), version_requirement);
+    }
 
     std::string to_string() const {
         if (version_requirement.empty() || version_requirement == "latest") {
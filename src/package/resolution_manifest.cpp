@@ -0,0 +1,154 @@
+#include "package/resolution_manifest.h"
+#include "parsing/json_parser.h"
+#include "utils/file_utils.h"
+#include "jpm_config.h"
+#include <iostream>
+#include <map>
+
+namespace jpm {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+bool is_file(const fs::path& path) {
+    std::error_code ec;
+    return fs::is_regular_file(path, ec);
+}
+
+// "name" or "@scope/name"; anything with a subpath is not a package name
+bool is_package_name(std::string_view name) {
+    if (name.empty() || name[0] == '.' || name[0] == '/') {
+        return false;
+    }
+    size_t slash = name.find('/');
+    if (name[0] == '@') {
+        return slash != std::string_view::npos && slash > 1 && slash + 1 < name.size() &&
+               name.find('/', slash + 1) == std::string_view::npos;
+    }
+    return slash == std::string_view::npos;
+}
+
+} // namespace
+
+std::optional<std::string> ResolutionManifest::entry_point(const std::string& package_dir) {
+    const fs::path dir(package_dir);
+    if (std::optional<std::string> content = FileUtils::read_file((dir / "package.json").string())) {
+        JsonData manifest = JsonParser::try_parse(*content);
+        if (manifest.is_object() && manifest.contains("main") && manifest["main"].is_string()) {
+            fs::path main = fs::path(manifest["main"].get<std::string>()).lexically_normal();
+            for (const fs::path& candidate : {main, fs::path(main.string() + ".js"),
+                                              fs::path(main.string() + ".json"), main / "index.js"}) {
+                if (!candidate.empty() && is_file(dir / candidate)) {
+                    return candidate.lexically_normal().generic_string();
+                }
+            }
+        }
+    }
+    if (is_file(dir / "index.js")) {
+        return std::string("index.js");
+    }
+    return std::nullopt;
+}
+
+bool ResolutionManifest::write(const std::string& node_modules_dir, const std::vector<Entry>& entries) {
+    std::vector<MirrorArchive::Item> items;
+    items.reserve(entries.size());
+    for (const Entry& entry : entries) {
+        items.push_back({entry.package_path, entry.entry_file, ""});
+    }
+    const std::string path = (fs::path(node_modules_dir) / kFileName).string();
+    if (!MirrorArchive::write(path, items)) {
+        std::cerr << "Warning: could not write " << path << "; require() will search node_modules instead" << std::endl;
+        return false;
+    }
+    if (g_verbose_output) {
+        std::cout << "Wrote " << entries.size() << " module entry points to " << path << std::endl;
+    }
+    return true;
+}
+
+bool ResolutionManifest::merge(const std::string& node_modules_dir, const std::vector<Entry>& entries) {
+    const fs::path project_root = fs::path(node_modules_dir).parent_path();
+    std::unique_ptr<MirrorArchive> existing = MirrorArchive::open((fs::path(node_modules_dir) / kFileName).string());
+    if (!existing) {
+        return false;
+    }
+    std::map<std::string, std::string> merged; // package_path -> entry_file
+    existing->for_each([&](std::string_view package_path, std::string_view entry_file) {
+        if (is_file(project_root / fs::path(std::string(entry_file)))) {
+            merged.emplace(package_path, entry_file);
+        }
+    });
+    existing.reset();
+    for (const Entry& entry : entries) {
+        merged[entry.package_path] = entry.entry_file;
+    }
+
+    std::vector<Entry> all;
+    all.reserve(merged.size());
+    for (auto& [package_path, entry_file] : merged) {
+        all.push_back({package_path, entry_file});
+    }
+    return write(node_modules_dir, all);
+}
+
+std::unique_ptr<ResolutionManifest> ResolutionManifest::open(const fs::path& project_root) {
+    const fs::path path = project_root / "node_modules" / kFileName;
+    if (!is_file(path)) {
+        return nullptr;
+    }
+    std::unique_ptr<MirrorArchive> archive = MirrorArchive::open(path.string());
+    if (!archive) {
+        return nullptr;
+    }
+    std::unique_ptr<ResolutionManifest> manifest(new ResolutionManifest());
+    manifest->archive_ = std::move(archive);
+    std::error_code ec;
+    manifest->root_ = fs::absolute(project_root, ec).lexically_normal();
+    if (g_verbose_output) {
+        std::cout << "Using " << path.string() << " (" << manifest->archive_->entry_count() << " packages)" << std::endl;
+    }
+    return manifest;
+}
+
+std::optional<fs::path> ResolutionManifest::resolve(const fs::path& from_dir, std::string_view name) const {
+    if (!is_package_name(name)) {
+        return std::nullopt;
+    }
+    fs::path relative = from_dir.lexically_normal().lexically_relative(root_);
+    if (relative.empty() || *relative.begin() == "..") {
+        return std::nullopt; // Outside this project
+    }
+
+    std::vector<std::string> segments;
+    for (const fs::path& segment : relative) {
+        if (segment != "." && !segment.empty()) {
+            segments.push_back(segment.string());
+        }
+    }
+
+    // Same order as a node_modules walk: the nearest enclosing node_modules first
+    std::string key;
+    for (size_t depth = segments.size() + 1; depth-- > 0;) {
+        if (depth > 0 && segments[depth - 1] == "node_modules") {
+            continue; // node_modules/node_modules is never searched
+        }
+        key.clear();
+        for (size_t i = 0; i < depth; ++i) {
+            key.append(segments[i]).push_back('/');
+        }
+        key.append("node_modules/").append(name);
+        if (std::optional<std::string_view> entry = archive_->find(key)) {
+            // Removed or replaced by something other than jpm: the walk finds what is there now
+            fs::path entry_file = root_ / fs::path(std::string(*entry));
+            if (!is_file(entry_file)) {
+                return std::nullopt;
+            }
+            return entry_file;
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace jpm
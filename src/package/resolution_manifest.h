@@ -0,0 +1,64 @@
+#ifndef JPM_RESOLUTION_MANIFEST_H
+#define JPM_RESOLUTION_MANIFEST_H
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "cache/mirror_archive.h"
+
+namespace jpm {
+
+// node_modules/.jpm-resolution: where every package jpm installed lives and which
+// file require("<name>") loads from it, so the runtime never has to probe
+// node_modules directories or parse package.json files.
+//
+// It uses the MirrorArchive file format. Keys are package directories relative to
+// the project root ("node_modules/a", "node_modules/a/node_modules/b"), payloads the
+// entry file relative to the project root ("node_modules/a/lib/index.js").
+class ResolutionManifest {
+public:
+    static constexpr const char* kFileName = ".jpm-resolution";
+
+    struct Entry {
+        std::string package_path; // Relative to the project root
+        std::string entry_file;   // Relative to the project root
+    };
+
+    // The file require() loads from an installed package directory: package.json "main"
+    // (tried as-is, with .js/.json and as a directory with index.js), else index.js.
+    // Returned relative to package_dir; std::nullopt if the package has no entry file.
+    static std::optional<std::string> entry_point(const std::string& package_dir);
+
+    // Replaces node_modules_dir/.jpm-resolution. Returns false on I/O error.
+    static bool write(const std::string& node_modules_dir, const std::vector<Entry>& entries);
+
+    // Adds entries to node_modules_dir/.jpm-resolution for an install that did not lay out
+    // the whole of node_modules. Existing entries are kept while their entry file is on
+    // disk, unless entries replace them. Without an existing manifest the other packages
+    // in node_modules are unknown, so none is written. Returns false if none was written.
+    static bool merge(const std::string& node_modules_dir, const std::vector<Entry>& entries);
+
+    // Maps project_root/node_modules/.jpm-resolution. Returns nullptr if there is none.
+    static std::unique_ptr<ResolutionManifest> open(const std::filesystem::path& project_root);
+
+    // Entry file of the package that require(name) finds from from_dir, following the
+    // node_modules lookup order, or std::nullopt if jpm did not install it there or its
+    // entry file has since been removed; the caller then searches node_modules itself.
+    // Only whole package names are answered; "pkg/sub/path" requests always miss.
+    std::optional<std::filesystem::path> resolve(const std::filesystem::path& from_dir, std::string_view name) const;
+
+    const std::filesystem::path& root() const { return root_; }
+
+private:
+    ResolutionManifest() = default;
+
+    std::unique_ptr<MirrorArchive> archive_;
+    std::filesystem::path root_; // Absolute, lexically normal
+};
+
+} // namespace jpm
+
+#endif // JPM_RESOLUTION_MANIFEST_H
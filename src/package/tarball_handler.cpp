@@ -6,11 +6,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#ifndef _WIN32
-#include <unistd.h> // For mkstemp, close on non-Windows
-#else
-#include <windows.h> // For GetTempPath/FileName (alternative to _tempnam)
-#endif
+#include <cerrno>
 
 namespace jpm {
 
@@ -31,51 +27,61 @@ bool TarballHandler::download_and_extract(
         std::cout << "  Base Destination: " << base_destination_path << std::endl;
     }
 
-    std::string local_tarball_path;
-
-#ifdef _WIN32
-    char tmp_filename_buffer[MAX_PATH + 1];
-    char temp_path[MAX_PATH + 1];
-    // Use GetTempPath and GetTempFileName on Windows for a robust temporary file name
-    if (GetTempPathA(MAX_PATH, temp_path) == 0) {
-        std::cerr << "Error: Could not get temporary path on Windows." << std::endl;
+    std::optional<TarballLocation> tarball = fetch(tarball_url, package_name, package_version);
+    if (!tarball) {
         return false;
     }
-    if (GetTempFileNameA(temp_path, "jpm", 0, tmp_filename_buffer) == 0) {
-         std::cerr << "Error: Could not generate temporary filename on Windows." << std::endl;
-         return false;
-    }
-    local_tarball_path = tmp_filename_buffer;
-    local_tarball_path += ".tar.gz"; // Append .tar.gz as GetTempFileName might not
-#else // Non-Windows (Linux, macOS, etc.)
-    // mkstemp modifies the buffer, so it needs to be writable
-    char tmp_filename_template[] = "/tmp/jpm-tmp-XXXXXX";
-    int fd = mkstemp(tmp_filename_template);
-    if (fd == -1) {
-        std::cerr << "Error: Could not generate temporary filename for download." << std::endl;
+    if (!extract(*tarball, package_name, base_destination_path)) {
         return false;
     }
-    close(fd); // Close the file descriptor, we just needed the unique name
-    local_tarball_path = tmp_filename_template; // mkstemp writes the unique name into the buffer
-    local_tarball_path += ".tar.gz";
-#endif
 
     if (g_verbose_output) {
-        std::cout << "  Temporary download path: " << local_tarball_path << std::endl;
+        std::cout << "  Successfully downloaded and extracted " << package_name << "@" << package_version << std::endl;
     }
+    return true;
+}
 
-    if (g_verbose_output) {
-        std::cout << "  Downloading..." << std::endl;
-    }
-    bool downloaded = http_client_.download_file(tarball_url, local_tarball_path);
-    if (!downloaded) {
-        std::cerr << "  Failed to download tarball from " << tarball_url << std::endl;
-        return false;
+std::optional<TarballLocation> TarballHandler::fetch(
+    const std::string& tarball_url,
+    const std::string& package_name,
+    const std::string& package_version) {
+    if (HttpClient::has_mirror()) {
+        std::optional<std::string_view> mirrored = HttpClient::mirror_view(tarball_url);
+        if (!mirrored) {
+            std::cerr << "  Mirror archive has no tarball for " << package_name << "@" << package_version << std::endl;
+            return std::nullopt;
+        }
+        return TarballLocation{std::string(), *mirrored};
+    }
+
+    // Tarballs live in the shared cache; if another jpm process (or thread) is already
+    // downloading this one, wait for it instead of fetching it again.
+    std::optional<std::string> cached_tarball = cache_.get_or_create(
+        cache_.tarball_path(package_name, package_version),
+        [this, &tarball_url](const std::string& temp_path) {
+            if (g_verbose_output) {
+                std::cout << "  Downloading " << tarball_url << " to " << temp_path << std::endl;
+            }
+            return http_client_.download_file(tarball_url, temp_path);
+        });
+    if (!cached_tarball) {
+        if (g_offline_mode) {
+            std::cerr << "  No cached tarball for " << package_name << "@" << package_version << " (offline)" << std::endl;
+        } else {
+            std::cerr << "  Failed to download tarball from " << tarball_url << std::endl;
+        }
+        return std::nullopt;
     }
     if (g_verbose_output) {
-        std::cout << "  Download successful to " << local_tarball_path << std::endl;
+        std::cout << "  Tarball available at " << *cached_tarball << std::endl;
     }
+    return TarballLocation{*cached_tarball, std::string_view()};
+}
 
+bool TarballHandler::extract(
+    const TarballLocation& tarball,
+    const std::string& package_name,
+    const std::string& base_destination_path) {
     std::string extract_to_path_final = base_destination_path + "/" + package_name;
     if (g_verbose_output) {
         std::cout << "  Ensuring extraction directory exists: " << extract_to_path_final << std::endl;
@@ -83,31 +89,28 @@ bool TarballHandler::download_and_extract(
     if (!FileUtils::path_exists(extract_to_path_final)) {
         if (!FileUtils::create_directory_recursively(extract_to_path_final)) {
             std::cerr << "  Failed to create extraction directory: " << extract_to_path_final << std::endl;
-            std::remove(local_tarball_path.c_str());
             return false;
         }
     }
 
-    if (g_verbose_output) {
-        std::cout << "  Extracting " << local_tarball_path << " to " << extract_to_path_final << "..." << std::endl;
+    if (tarball.path.empty()) {
+        if (g_verbose_output) {
+            std::cout << "  Extracting " << tarball.bytes.size() << " mirrored bytes to " << extract_to_path_final << "..." << std::endl;
+        }
+        if (!extract_tarball_bytes(tarball.bytes, extract_to_path_final)) {
+            std::cerr << "  Failed to extract mirrored tarball for " << package_name << std::endl;
+            return false;
+        }
+        return true;
     }
-    bool extracted = extract_tarball(local_tarball_path, extract_to_path_final);
 
     if (g_verbose_output) {
-        std::cout << "  Cleaning up temporary file: " << local_tarball_path << std::endl;
-    }
-    if (std::remove(local_tarball_path.c_str()) != 0) {
-        std::cerr << "  Warning: Failed to remove temporary tarball: " << local_tarball_path << std::endl;
+        std::cout << "  Extracting " << tarball.path << " to " << extract_to_path_final << "..." << std::endl;
     }
-
-    if (!extracted) {
-        std::cerr << "  Failed to extract tarball " << local_tarball_path << std::endl;
+    if (!extract_tarball(tarball.path, extract_to_path_final)) {
+        std::cerr << "  Failed to extract tarball " << tarball.path << std::endl;
         return false;
     }
-
-    if (g_verbose_output) {
-        std::cout << "  Successfully downloaded and extracted " << package_name << "@" << package_version << std::endl;
-    }
     return true;
 }
 
@@ -153,4 +156,32 @@ bool TarballHandler::extract_tarball(
     return true;
 }
 
+bool TarballHandler::extract_tarball_bytes(
+    std::string_view tarball_bytes,
+    const std::string& extract_to_path) {
+#ifdef _WIN32
+    (void)tarball_bytes;
+    std::cerr << "  Extracting from a mirror archive is not supported on Windows (" << extract_to_path << ")." << std::endl;
+    return false;
+#else
+    std::string command = "tar -xzf - -C \"" + extract_to_path + "\" --strip-components=1";
+    if (g_verbose_output) {
+        std::cout << "  Piping tarball into: " << command << std::endl;
+    }
+
+    FILE* pipe = popen(command.c_str(), "w");
+    if (!pipe) {
+        std::cerr << "  Could not start tar: " << strerror(errno) << std::endl;
+        return false;
+    }
+    size_t written = fwrite(tarball_bytes.data(), 1, tarball_bytes.size(), pipe);
+    int result = pclose(pipe);
+    if (written != tarball_bytes.size() || result != 0) {
+        std::cerr << "  Tar extraction from pipe failed with exit code: " << result << std::endl;
+        return false;
+    }
+    return true;
+#endif
+}
+
 } // namespace jpm
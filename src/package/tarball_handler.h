@@ -2,30 +2,64 @@
 #define JPM_TARBALL_HANDLER_H
 
 #include <string>
+#include <string_view>
+#include <optional>
 #include "network/http_client.h"
+#include "cache/cache_store.h"
 
 namespace jpm {
 
+// Where a fetched tarball's bytes are: a file in the shared cache, or (with a
+// mirror archive) a view into the mapped archive that is piped straight to tar.
+struct TarballLocation {
+    std::string path;        // Cached tarball; empty when the bytes are in memory
+    std::string_view bytes;  // Mirror archive bytes when path is empty
+};
+
 class TarballHandler {
 public:
     TarballHandler();
 
-    // Downloads and extracts a tarball to a specified directory
+    // Fetch phase: makes sure the tarball is in the shared cache, downloading it if needed,
+    // or finds it in the active mirror archive. Returns where its bytes are, or std::nullopt
+    // on error. Never touches the project tree.
+    std::optional<TarballLocation> fetch(
+        const std::string& tarball_url,
+        const std::string& package_name,
+        const std::string& package_version
+    );
+
+    // Extraction phase: unpacks a fetched tarball into base_destination_path/package_name.
+    // Returns true on success, false on error.
+    bool extract(
+        const TarballLocation& tarball,
+        const std::string& package_name,
+        const std::string& base_destination_path
+    );
+
+    // fetch() followed by extract()
     // Returns true on success, false on error.
     bool download_and_extract(
         const std::string& tarball_url,
         const std::string& package_name, // For creating a subdirectory, e.g. node_modules/lodash
         const std::string& package_version, // For versioned paths or cache keys
-        const std::string& base_destination_path // e.g., "./node_modules" or a global cache path
+        const std::string& base_destination_path // e.g., "./node_modules", "./node_modules/foo/node_modules" or a global cache path
     );
 
 private:
     HttpClient http_client_;
+    CacheStore cache_;
 
     bool extract_tarball(
         const std::string& local_tarball_path,
         const std::string& extract_to_path
     );
+
+    // Streams in-memory tarball bytes into tar's stdin; no temporary file is written
+    bool extract_tarball_bytes(
+        std::string_view tarball_bytes,
+        const std::string& extract_to_path
+    );
 };
 
 } // namespace jpm
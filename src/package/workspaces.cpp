@@ -0,0 +1,102 @@
+#include "package/workspaces.h"
+#include "utils/file_utils.h"
+#include "jpm_config.h"
+#include <iostream>
+#include <filesystem>
+#include <set>
+
+namespace jpm {
+
+std::vector<WorkspacePackage> Workspaces::discover(const std::string& root_dir, const JsonData& root_manifest) {
+    std::vector<WorkspacePackage> workspaces;
+    if (!root_manifest.is_object() || !root_manifest.contains("workspaces")) {
+        return workspaces;
+    }
+    const JsonData& declared = root_manifest["workspaces"];
+    const JsonData& patterns = declared.is_object() && declared.contains("packages") ? declared["packages"] : declared;
+    if (!patterns.is_array()) {
+        std::cerr << "Ignoring \"workspaces\": expected an array of globs." << std::endl;
+        return workspaces;
+    }
+
+    std::set<std::string> seen_directories;
+    std::set<std::string> seen_names;
+    for (const auto& pattern : patterns) {
+        if (!pattern.is_string()) {
+            continue;
+        }
+        for (const auto& directory : FileUtils::glob_directories(root_dir, pattern.get<std::string>())) {
+            if (!seen_directories.insert(directory).second) {
+                continue;
+            }
+            std::optional<std::string> content = FileUtils::read_file(root_dir + "/" + directory + "/package.json");
+            if (!content) {
+                continue; // Globs like "packages/*" also match directories that aren't packages
+            }
+            JsonData manifest = JsonParser::try_parse(*content);
+            if (!manifest.is_object() || !manifest.contains("name") || !manifest["name"].is_string()) {
+                std::cerr << "Skipping workspace " << directory << ": package.json has no name." << std::endl;
+                continue;
+            }
+            WorkspacePackage workspace;
+            workspace.name = manifest["name"].get<std::string>();
+            workspace.version = manifest.value("version", "0.0.0");
+            workspace.directory = directory;
+            workspace.manifest = std::move(manifest);
+            if (!seen_names.insert(workspace.name).second) {
+                std::cerr << "Skipping workspace " << directory << ": another workspace is already named "
+                          << workspace.name << "." << std::endl;
+                continue;
+            }
+            workspaces.push_back(std::move(workspace));
+        }
+    }
+
+    if (g_verbose_output) {
+        std::cout << "Found " << workspaces.size() << " workspace packages" << std::endl;
+        for (const auto& workspace : workspaces) {
+            std::cout << "  " << workspace.name << "@" << workspace.version << " in " << workspace.directory << std::endl;
+        }
+    }
+    return workspaces;
+}
+
+bool Workspaces::link(const std::vector<WorkspacePackage>& workspaces,
+                      const std::string& root_dir,
+                      const std::string& node_modules_dir) {
+    namespace fs = std::filesystem;
+    bool all_ok = true;
+    for (const auto& workspace : workspaces) {
+        fs::path link_path = fs::path(node_modules_dir) / workspace.name; // "@scope/name" nests under @scope
+        std::error_code ec;
+        fs::create_directories(link_path.parent_path(), ec);
+
+        // Relative, so the checkout can be moved without breaking links
+        fs::path target = fs::relative(fs::absolute(fs::path(root_dir) / workspace.directory, ec),
+                                       fs::absolute(link_path.parent_path(), ec), ec);
+        if (ec || target.empty()) {
+            target = fs::absolute(fs::path(root_dir) / workspace.directory);
+        }
+
+        std::error_code remove_ec;
+        if (fs::is_symlink(fs::symlink_status(link_path, remove_ec))) {
+            if (fs::read_symlink(link_path, remove_ec) == target) {
+                continue; // Already linked
+            }
+        }
+        fs::remove_all(link_path, remove_ec);
+
+        std::error_code link_ec;
+        fs::create_directory_symlink(target, link_path, link_ec);
+        if (link_ec) {
+            std::cerr << "Failed to link workspace " << workspace.name << " at " << link_path.string()
+                      << ": " << link_ec.message() << std::endl;
+            all_ok = false;
+        } else if (g_verbose_output) {
+            std::cout << "Linked " << link_path.string() << " -> " << target.string() << std::endl;
+        }
+    }
+    return all_ok;
+}
+
+} // namespace jpm
@@ -0,0 +1,36 @@
+#ifndef JPM_WORKSPACES_H
+#define JPM_WORKSPACES_H
+
+#include <string>
+#include <vector>
+#include "parsing/json_parser.h"
+
+namespace jpm {
+
+// A package of a monorepo, listed by the root package.json "workspaces" globs
+struct WorkspacePackage {
+    std::string name;
+    std::string version;
+    std::string directory; // Relative to the project root
+    JsonData manifest;     // Its package.json
+};
+
+// Workspace discovery and linking. All workspaces are installed as one project:
+// their external dependencies join the root's in a single resolution and a single
+// hoisted node_modules, and the workspaces themselves are symlinked into it.
+class Workspaces {
+public:
+    // Reads "workspaces" (an array of globs, or {"packages": [...]}) from the root
+    // manifest and returns every matching directory that has a package.json with a name
+    static std::vector<WorkspacePackage> discover(const std::string& root_dir, const JsonData& root_manifest);
+
+    // Points node_modules/<name> at each workspace directory, replacing whatever was there.
+    // Returns false if any link could not be created.
+    static bool link(const std::vector<WorkspacePackage>& workspaces,
+                     const std::string& root_dir,
+                     const std::string& node_modules_dir);
+};
+
+} // namespace jpm
+
+#endif // JPM_WORKSPACES_H
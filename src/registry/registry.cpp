@@ -0,0 +1,56 @@
+#include "registry/registry.h"
+#include "registry/registry_server.h"
+#include "jpm_config.h"
+#include <iostream>
+
+namespace jpm {
+
+namespace {
+
+void print_usage() {
+    std::cerr << "Usage: jpm [-v|--verbose] registry serve [--host <addr>] [--port <n>] [--upstream <url>]" << std::endl;
+}
+
+} // namespace
+
+RegistryCommand::RegistryCommand() {
+    if (g_verbose_output) {
+        std::cout << "RegistryCommand initialized." << std::endl;
+    }
+}
+
+bool RegistryCommand::execute(const std::vector<std::string>& args) {
+    if (args.empty() || args[0] != "serve") {
+        print_usage();
+        return false;
+    }
+
+    RegistryServerOptions options;
+    for (size_t i = 1; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (i + 1 >= args.size()) {
+            print_usage();
+            return false;
+        }
+        if (arg == "--host") {
+            options.host = args[++i];
+        } else if (arg == "--port") {
+            try {
+                options.port = std::stoi(args[++i]);
+            } catch (const std::exception&) {
+                std::cerr << "Invalid port: " << args[i] << std::endl;
+                return false;
+            }
+        } else if (arg == "--upstream") {
+            options.upstream_url = args[++i];
+        } else {
+            print_usage();
+            return false;
+        }
+    }
+
+    RegistryServer server(options);
+    return server.serve();
+}
+
+} // namespace jpm
@@ -0,0 +1,21 @@
+#ifndef JPM_REGISTRY_COMMAND_H
+#define JPM_REGISTRY_COMMAND_H
+
+#include <string>
+#include <vector>
+
+namespace jpm {
+
+// `jpm registry serve [--host <addr>] [--port <n>] [--upstream <url>]`: runs a
+// caching registry proxy (see RegistryServer) that other machines point
+// `--registry` / $JPM_REGISTRY at.
+class RegistryCommand {
+public:
+    RegistryCommand();
+    // Returns false on bad arguments or if the server cannot start
+    bool execute(const std::vector<std::string>& args);
+};
+
+} // namespace jpm
+
+#endif // JPM_REGISTRY_COMMAND_H
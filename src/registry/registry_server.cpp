@@ -0,0 +1,427 @@
+#include "registry/registry_server.h"
+#include "parsing/json_parser.h"
+#include "utils/thread_pool.h"
+#include "utils/file_utils.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#elif defined(__APPLE__)
+#include <sys/uio.h>
+#endif
+#endif
+
+namespace jpm {
+
+namespace {
+
+constexpr size_t kMaxHeaderBytes = 16 * 1024;
+constexpr int kIdleTimeoutSeconds = 30;
+// Cache key for a package's full registry document, which has no version of its own
+constexpr const char* kFullDocumentVersion = "_document";
+
+struct HttpRequest {
+    std::string method;
+    std::string path; // Without the query string
+    std::string host;
+    bool keep_alive = true;
+};
+
+std::string lowercase(std::string text) {
+    for (auto& c : text) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return text;
+}
+
+// Decodes the escapes registries use in package names ("@scope%2fname")
+std::string percent_decode(const std::string& text) {
+    std::string decoded;
+    decoded.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '%' && i + 2 < text.size() && std::isxdigit(static_cast<unsigned char>(text[i + 1]))
+            && std::isxdigit(static_cast<unsigned char>(text[i + 2]))) {
+            decoded.push_back(static_cast<char>(std::stoi(text.substr(i + 1, 2), nullptr, 16)));
+            i += 2;
+        } else {
+            decoded.push_back(text[i]);
+        }
+    }
+    return decoded;
+}
+
+std::vector<std::string> split_path(const std::string& path) {
+    std::vector<std::string> segments;
+    std::stringstream stream(percent_decode(path));
+    std::string segment;
+    while (std::getline(stream, segment, '/')) {
+        if (!segment.empty()) segments.push_back(segment);
+    }
+    return segments;
+}
+
+std::string replace_all(std::string text, const std::string& from, const std::string& to) {
+    if (from.empty()) return text;
+    for (size_t pos = text.find(from); pos != std::string::npos; pos = text.find(from, pos + to.size())) {
+        text.replace(pos, from.size(), to);
+    }
+    return text;
+}
+
+#ifndef _WIN32
+bool send_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = ::send(fd, data, size, 0);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool send_response(int fd, int status, const char* reason, const std::string& content_type,
+                   const std::string& body, bool head_only, bool keep_alive) {
+    std::string header = "HTTP/1.1 " + std::to_string(status) + " " + reason + "\r\n"
+                         "Content-Type: " + content_type + "\r\n"
+                         "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                         "Connection: " + (keep_alive ? "keep-alive" : "close") + "\r\n\r\n";
+    if (!head_only) {
+        header += body; // One send for small responses
+    }
+    return send_all(fd, header.data(), header.size());
+}
+
+// Copies a file to the socket inside the kernel where the platform allows it
+bool send_file_contents(int fd, int file_fd, off_t size) {
+#if defined(__linux__)
+    off_t offset = 0;
+    while (offset < size) {
+        ssize_t sent = ::sendfile(fd, file_fd, &offset, static_cast<size_t>(size - offset));
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+    }
+    return true;
+#elif defined(__APPLE__)
+    off_t offset = 0;
+    while (offset < size) {
+        off_t length = size - offset;
+        int rc = ::sendfile(file_fd, fd, offset, &length, nullptr, 0);
+        offset += length;
+        if (rc != 0 && errno != EINTR && errno != EAGAIN) return false;
+        if (rc != 0 && length == 0 && errno != EINTR) return false;
+    }
+    return true;
+#else
+    char buffer[64 * 1024];
+    off_t remaining = size;
+    while (remaining > 0) {
+        ssize_t n = ::read(file_fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0 || !send_all(fd, buffer, static_cast<size_t>(n))) return false;
+        remaining -= n;
+    }
+    return true;
+#endif
+}
+
+// Reads one request head from fd, keeping any bytes that follow in pending.
+// Returns false when the connection is closed, idle too long or malformed.
+bool read_request(int fd, std::string& pending, HttpRequest& request) {
+    size_t header_end;
+    while ((header_end = pending.find("\r\n\r\n")) == std::string::npos) {
+        if (pending.size() > kMaxHeaderBytes) return false;
+        char buffer[4096];
+        ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        pending.append(buffer, static_cast<size_t>(received));
+    }
+    std::string head = pending.substr(0, header_end);
+    pending.erase(0, header_end + 4);
+
+    std::istringstream lines(head);
+    std::string request_line;
+    std::getline(lines, request_line);
+    std::istringstream parts(request_line);
+    std::string target, version;
+    if (!(parts >> request.method >> target >> version)) return false;
+    request.path = target.substr(0, target.find_first_of("?#"));
+    request.keep_alive = version == "HTTP/1.1";
+
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string name = lowercase(line.substr(0, colon));
+        std::string value = line.substr(line.find_first_not_of(' ', colon + 1) == std::string::npos
+                                            ? line.size() : line.find_first_not_of(' ', colon + 1));
+        if (name == "host") {
+            request.host = value;
+        } else if (name == "connection") {
+            // A comma-separated token list, e.g. "keep-alive, Upgrade"
+            std::string tokens = lowercase(value);
+            if (tokens.find("close") != std::string::npos) {
+                request.keep_alive = false;
+            } else if (tokens.find("keep-alive") != std::string::npos) {
+                request.keep_alive = true;
+            }
+        }
+    }
+    return true;
+}
+#endif // _WIN32
+
+} // namespace
+
+RegistryServer::RegistryServer(RegistryServerOptions options) : options_(std::move(options)) {
+    if (options_.upstream_url.empty() || options_.upstream_url.back() != '/') {
+        options_.upstream_url += '/';
+    }
+    if (g_verbose_output) {
+        std::cout << "RegistryServer initialized (upstream " << options_.upstream_url << ")." << std::endl;
+    }
+}
+
+#ifdef _WIN32
+
+bool RegistryServer::serve() {
+    std::cerr << "jpm registry serve is not supported on Windows." << std::endl;
+    return false;
+}
+
+void RegistryServer::handle_connection(int) {}
+bool RegistryServer::serve_packument(int, const std::string&, const std::string&, const std::string&, bool, bool) { return false; }
+bool RegistryServer::serve_tarball(int, const std::string&, const std::string&, const std::string&, bool, bool) { return false; }
+bool RegistryServer::serve_stats(int, bool, bool) { return false; }
+std::optional<std::string> RegistryServer::cached_from_upstream(const std::string&, const std::string&,
+                                                                std::chrono::seconds, bool&) { return std::nullopt; }
+
+#else
+
+bool RegistryServer::serve() {
+    // A client hanging up mid-response must not kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        std::cerr << "registry: socket() failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(options_.port));
+    if (inet_pton(AF_INET, options_.host.c_str(), &address.sin_addr) != 1) {
+        std::cerr << "registry: invalid listen address " << options_.host << std::endl;
+        ::close(listen_fd);
+        return false;
+    }
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listen_fd, SOMAXCONN) != 0) {
+        std::cerr << "registry: cannot listen on " << options_.host << ":" << options_.port << ": "
+                  << strerror(errno) << std::endl;
+        ::close(listen_fd);
+        return false;
+    }
+
+    std::cout << "jpm registry listening on http://" << options_.host << ":" << options_.port
+              << " (upstream " << options_.upstream_url << ", cache " << cache_.root() << ")" << std::endl;
+
+    ThreadPool workers(options_.worker_count);
+    while (true) {
+        int client_fd = ::accept(listen_fd, nullptr, nullptr);
+        if (client_fd < 0) {
+            if (errno != EINTR) {
+                std::cerr << "registry: accept() failed: " << strerror(errno) << std::endl;
+            }
+            continue;
+        }
+        timeval idle {kIdleTimeoutSeconds, 0};
+        setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &idle, sizeof(idle));
+        int no_delay = 1;
+        setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+        // Shed load instead of queueing without bound when every worker is busy
+        if (open_connections_.load() >= options_.worker_count + options_.max_queued) {
+            ++stats_.rejected_connections;
+            send_response(client_fd, 503, "Service Unavailable", "text/plain", "Server busy, retry later\n",
+                          false, false);
+            ::close(client_fd);
+            continue;
+        }
+        ++open_connections_;
+        workers.submit([this, client_fd]() {
+            handle_connection(client_fd);
+            ::close(client_fd);
+            --open_connections_;
+        });
+    }
+}
+
+void RegistryServer::handle_connection(int client_fd) {
+    std::string pending;
+    HttpRequest request;
+    while (read_request(client_fd, pending, request)) {
+        ++stats_.requests;
+        bool head_only = request.method == "HEAD";
+        if (g_verbose_output) {
+            std::cout << "registry: " << request.method << " " << request.path << std::endl;
+        }
+
+        bool ok;
+        std::vector<std::string> segments = split_path(request.path);
+        if (request.method != "GET" && !head_only) {
+            ok = send_response(client_fd, 405, "Method Not Allowed", "text/plain", "Only GET and HEAD are supported\n",
+                               false, request.keep_alive);
+        } else if (segments.size() == 3 && segments[0] == "-" && segments[1] == "jpm" && segments[2] == "stats") {
+            ok = serve_stats(client_fd, head_only, request.keep_alive);
+        } else if (segments.empty() || segments[0] == "-") {
+            ok = send_response(client_fd, 404, "Not Found", "text/plain", "Not found\n", head_only, request.keep_alive);
+        } else {
+            // "@scope/name" spans two segments
+            size_t name_parts = segments[0][0] == '@' && segments.size() > 1 ? 2 : 1;
+            std::string name = name_parts == 2 ? segments[0] + "/" + segments[1] : segments[0];
+            std::vector<std::string> rest(segments.begin() + static_cast<long>(name_parts), segments.end());
+            std::string public_base = "http://" + (request.host.empty()
+                ? options_.host + ":" + std::to_string(options_.port) : request.host) + "/";
+
+            if (rest.empty()) {
+                ok = serve_packument(client_fd, name, kFullDocumentVersion, public_base, head_only,
+                                     request.keep_alive);
+            } else if (rest.size() == 1) {
+                ok = serve_packument(client_fd, name, rest[0], public_base, head_only, request.keep_alive);
+            } else if (rest.size() == 2 && rest[0] == "-") {
+                ok = serve_tarball(client_fd, name, rest[1], request.path, head_only, request.keep_alive);
+            } else {
+                ok = send_response(client_fd, 404, "Not Found", "text/plain", "Not found\n", head_only, request.keep_alive);
+            }
+        }
+        if (!ok || !request.keep_alive) {
+            return;
+        }
+    }
+}
+
+std::optional<std::string> RegistryServer::cached_from_upstream(const std::string& entry_path, const std::string& url,
+                                                                std::chrono::seconds max_age, bool& hit) {
+    hit = true;
+    std::optional<std::string> cached = cache_.get_or_create(
+        entry_path,
+        [this, &url, &hit](const std::string& temp_path) {
+            hit = false;
+            return http_client_.download_file(url, temp_path);
+        },
+        max_age);
+    if (!cached) {
+        ++stats_.upstream_failures;
+    }
+    return cached;
+}
+
+bool RegistryServer::serve_packument(int client_fd, const std::string& name, const std::string& version,
+                                     const std::string& public_base, bool head_only, bool keep_alive) {
+    bool full_document = version == kFullDocumentVersion;
+    std::string url = options_.upstream_url + name + (full_document ? "" : "/" + version);
+    std::chrono::seconds max_age = CacheStore::packument_max_age(full_document ? std::string() : version);
+
+    bool hit = false;
+    std::optional<std::string> cached = cached_from_upstream(cache_.packument_path(name, version), url, max_age, hit);
+    ++(hit ? stats_.packument_hits : stats_.packument_misses);
+
+    std::optional<std::string> body = cached ? FileUtils::read_file(*cached) : std::nullopt;
+    if (!body) {
+        return send_response(client_fd, 502, "Bad Gateway", "text/plain",
+                             "Could not fetch " + url + "\n", head_only, keep_alive);
+    }
+    // The cache holds upstream documents (shared with local installs), so tarball
+    // links are pointed at this server per response rather than on disk.
+    std::string rewritten = replace_all(std::move(*body), options_.upstream_url, public_base);
+    stats_.bytes_sent += rewritten.size();
+    return send_response(client_fd, 200, "OK", "application/json", rewritten, head_only, keep_alive);
+}
+
+bool RegistryServer::serve_tarball(int client_fd, const std::string& name, const std::string& file_name,
+                                   const std::string& url_path, bool head_only, bool keep_alive) {
+    // "<name>-<version>.tgz", where <name> is unscoped; fall back to the file name as the key
+    std::string base_name = name.substr(name.find('/') == std::string::npos ? 0 : name.find('/') + 1);
+    std::string version = file_name;
+    if (version.size() > 4 && version.compare(version.size() - 4, 4, ".tgz") == 0) {
+        version.resize(version.size() - 4);
+    }
+    if (version.compare(0, base_name.size() + 1, base_name + "-") == 0) {
+        version.erase(0, base_name.size() + 1);
+    }
+
+    bool hit = false;
+    std::optional<std::string> cached = cached_from_upstream(cache_.tarball_path(name, version),
+                                                             options_.upstream_url + url_path.substr(1),
+                                                             std::chrono::seconds(0), hit);
+    ++(hit ? stats_.tarball_hits : stats_.tarball_misses);
+    if (!cached) {
+        return send_response(client_fd, 502, "Bad Gateway", "text/plain",
+                             "Could not fetch " + url_path + "\n", head_only, keep_alive);
+    }
+
+    int file_fd = ::open(cached->c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st {};
+    if (file_fd < 0 || fstat(file_fd, &st) != 0) {
+        if (file_fd >= 0) ::close(file_fd);
+        return send_response(client_fd, 500, "Internal Server Error", "text/plain", "Cache read failed\n", head_only,
+                             keep_alive);
+    }
+    std::string header = "HTTP/1.1 200 OK\r\n"
+                         "Content-Type: application/octet-stream\r\n"
+                         "Content-Length: " + std::to_string(st.st_size) + "\r\n"
+                         "Accept-Ranges: none\r\n"
+                         "Connection: " + std::string(keep_alive ? "keep-alive" : "close") + "\r\n\r\n";
+    bool ok = send_all(client_fd, header.data(), header.size());
+    if (ok && !head_only) {
+        ok = send_file_contents(client_fd, file_fd, st.st_size);
+        if (ok) stats_.bytes_sent += static_cast<uint64_t>(st.st_size);
+    }
+    ::close(file_fd);
+    return ok;
+}
+
+bool RegistryServer::serve_stats(int client_fd, bool head_only, bool keep_alive) {
+    auto rate = [](uint64_t hits, uint64_t misses) {
+        return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(hits + misses);
+    };
+    uint64_t packument_hits = stats_.packument_hits, packument_misses = stats_.packument_misses;
+    uint64_t tarball_hits = stats_.tarball_hits, tarball_misses = stats_.tarball_misses;
+
+    JsonData stats;
+    stats["requests"] = stats_.requests.load();
+    stats["packuments"] = {{"hits", packument_hits}, {"misses", packument_misses},
+                           {"hitRate", rate(packument_hits, packument_misses)}};
+    stats["tarballs"] = {{"hits", tarball_hits}, {"misses", tarball_misses},
+                         {"hitRate", rate(tarball_hits, tarball_misses)}};
+    stats["hitRate"] = rate(packument_hits + tarball_hits, packument_misses + tarball_misses);
+    stats["upstreamFailures"] = stats_.upstream_failures.load();
+    stats["bytesSent"] = stats_.bytes_sent.load();
+    stats["rejectedConnections"] = stats_.rejected_connections.load();
+    stats["upstream"] = options_.upstream_url;
+    return send_response(client_fd, 200, "OK", "application/json", stats.dump(2) + "\n", head_only, keep_alive);
+}
+
+#endif // _WIN32
+
+} // namespace jpm
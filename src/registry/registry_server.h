@@ -0,0 +1,80 @@
+#ifndef JPM_REGISTRY_SERVER_H
+#define JPM_REGISTRY_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include "cache/cache_store.h"
+#include "network/http_client.h"
+#include "jpm_config.h"
+
+namespace jpm {
+
+struct RegistryServerOptions {
+    std::string host = "0.0.0.0";
+    int port = 4873;
+    std::string upstream_url = JPM_DEFAULT_REGISTRY_URL; // Always ends in "/"
+    size_t worker_count = 64;                            // Connections served at once
+    size_t max_queued = 256;                             // Accepted connections waiting for a worker;
+                                                         // more are turned away with 503
+};
+
+// Pull-through caching registry for a LAN. Packuments and tarballs are served
+// out of the same CacheStore that `jpm install` uses on this host; misses are
+// fetched from the upstream registry once (concurrent requests for the same
+// entry wait on the cache entry lock) and tarballs are sent with sendfile.
+// Connections are kept alive unless the request says otherwise (HTTP/1.0 or
+// "Connection: close"). Once worker_count + max_queued connections are open,
+// new ones get a 503 and are closed instead of waiting in an unbounded queue.
+//
+// Routes:
+//   GET /<name>/<version>          packument, dist.tarball rewritten to this server
+//   GET /<name>                    full packument document, rewritten the same way
+//   GET /<name>/-/<file>.tgz       tarball
+//   GET /-/jpm/stats               hit/miss counters as JSON
+class RegistryServer {
+public:
+    explicit RegistryServer(RegistryServerOptions options);
+
+    // Binds and serves until the process is stopped. Returns false if it cannot listen.
+    bool serve();
+
+private:
+    struct Stats {
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> packument_hits{0};
+        std::atomic<uint64_t> packument_misses{0};
+        std::atomic<uint64_t> tarball_hits{0};
+        std::atomic<uint64_t> tarball_misses{0};
+        std::atomic<uint64_t> upstream_failures{0};
+        std::atomic<uint64_t> bytes_sent{0};
+        std::atomic<uint64_t> rejected_connections{0};
+    };
+
+    RegistryServerOptions options_;
+    CacheStore cache_;
+    HttpClient http_client_;
+    Stats stats_;
+    std::atomic<size_t> open_connections_{0}; // Being served or waiting for a worker
+
+    // Serves requests on one keep-alive connection until the client closes it
+    void handle_connection(int client_fd);
+
+    // keep_alive is what the request asked for; the response's Connection header says the same
+    bool serve_packument(int client_fd, const std::string& name, const std::string& version,
+                         const std::string& public_base, bool head_only, bool keep_alive);
+    bool serve_tarball(int client_fd, const std::string& name, const std::string& file_name,
+                       const std::string& url_path, bool head_only, bool keep_alive);
+    bool serve_stats(int client_fd, bool head_only, bool keep_alive);
+
+    // Fetches url from the upstream registry into the cache entry unless it is already there.
+    // hit is set to whether the entry was served without contacting upstream.
+    std::optional<std::string> cached_from_upstream(const std::string& entry_path, const std::string& url,
+                                                    std::chrono::seconds max_age, bool& hit);
+};
+
+} // namespace jpm
+
+#endif // JPM_REGISTRY_SERVER_H
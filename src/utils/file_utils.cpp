@@ -1,6 +1,10 @@
 #include "utils/file_utils.h"
 #include "jpm_config.h" // For g_verbose_output
 #include <iostream> 
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
 #include <sys/stat.h> 
 #include <cerrno>     
 #include <cstring>    
@@ -9,11 +13,96 @@
 namespace jpm {
 namespace FileUtils {
 
+namespace {
+
+bool wildcard_match(const char* pattern, const char* text) {
+    for (; *pattern; ++pattern, ++text) {
+        if (*pattern == '*') {
+            for (const char* rest = text;; ++rest) {
+                if (wildcard_match(pattern + 1, rest)) return true;
+                if (!*rest) return false;
+            }
+        }
+        if (!*text || (*pattern != '?' && *pattern != *text)) return false;
+    }
+    return !*text;
+}
+
+void glob_step(const std::filesystem::path& base, const std::string& relative,
+               const std::vector<std::string>& segments, size_t index, std::vector<std::string>& matches) {
+    if (index == segments.size()) {
+        matches.push_back(relative);
+        return;
+    }
+    const std::string& segment = segments[index];
+    std::filesystem::path directory = relative.empty() ? base : base / relative;
+    if (segment == "**") {
+        glob_step(base, relative, segments, index + 1, matches); // Zero segments
+    } else if (segment.find_first_of("*?") == std::string::npos) {
+        std::error_code ec;
+        if (std::filesystem::is_directory(directory / segment, ec)) {
+            glob_step(base, relative.empty() ? segment : relative + "/" + segment, segments, index + 1, matches);
+        }
+        return;
+    }
+
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code entry_ec;
+        std::string name = it->path().filename().string();
+        if (!it->is_directory(entry_ec) || name == "node_modules" || name[0] == '.') {
+            continue;
+        }
+        std::string child = relative.empty() ? name : relative + "/" + name;
+        if (segment == "**") {
+            glob_step(base, child, segments, index, matches); // One more segment, still inside **
+        } else if (wildcard_match(segment.c_str(), name.c_str())) {
+            glob_step(base, child, segments, index + 1, matches);
+        }
+    }
+}
+
+} // namespace
+
 bool path_exists(const std::string& path) {
     struct stat buffer;
     return (stat(path.c_str(), &buffer) == 0);
 }
 
+std::optional<std::string> read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return std::nullopt;
+    }
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+bool write_file(const std::string& path, const std::string& data) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    return file.good();
+}
+
+DirectoryStats directory_stats(const std::string& path) {
+    DirectoryStats stats;
+    std::error_code ec;
+    std::filesystem::recursive_directory_iterator it(
+        path, std::filesystem::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        std::error_code entry_ec;
+        if (it->is_regular_file(entry_ec) && !it->is_symlink(entry_ec)) {
+            ++stats.file_count;
+            stats.total_bytes += it->file_size(entry_ec);
+        }
+    }
+    return stats;
+}
+
 bool create_directory_recursively(const std::string& path) {
     if (path.empty()) {
         return false;
@@ -63,5 +152,20 @@ bool create_directory_recursively(const std::string& path) {
     return true;
 }
 
+std::vector<std::string> glob_directories(const std::string& base, const std::string& pattern) {
+    std::vector<std::string> segments;
+    std::stringstream stream(pattern);
+    std::string segment;
+    while (std::getline(stream, segment, '/')) {
+        if (!segment.empty() && segment != ".") segments.push_back(segment);
+    }
+
+    std::vector<std::string> matches;
+    glob_step(base, "", segments, 0, matches);
+    std::sort(matches.begin(), matches.end());
+    matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+    return matches;
+}
+
 } // namespace FileUtils
 } // namespace jpm
@@ -3,13 +3,30 @@
 
 #include <string>
 #include <vector>
+#include <optional>
+#include <cstdint>
 
 namespace jpm {
 namespace FileUtils {
 
+struct DirectoryStats {
+    uint64_t file_count = 0;
+    uint64_t total_bytes = 0;
+};
+
 bool create_directory_recursively(const std::string& path);
 bool path_exists(const std::string& path);
-// Add more utilities as needed: delete_directory, read_file, write_file etc.
+// Returns the whole file contents, or std::nullopt if it cannot be opened
+std::optional<std::string> read_file(const std::string& path);
+// Creates or truncates the file and writes data to it
+bool write_file(const std::string& path, const std::string& data);
+// Recursively counts regular files and their sizes (symlinks are not followed)
+DirectoryStats directory_stats(const std::string& path);
+// Directories under base matching a glob such as "packages/*" or "apps/**", as paths
+// relative to base, sorted. "*" and "?" match within one path segment, "**" matches
+// any number of segments. node_modules and hidden directories are never matched.
+std::vector<std::string> glob_directories(const std::string& base, const std::string& pattern);
+// Add more utilities as needed: delete_directory etc.
 
 } // namespace FileUtils
 } // namespace jpm
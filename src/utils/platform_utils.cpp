@@ -0,0 +1,74 @@
+#include "utils/platform_utils.h"
+
+namespace jpm {
+namespace PlatformUtils {
+
+const char* host_os() {
+#ifdef _WIN32
+    return "win32";
+#elif defined(__APPLE__)
+    return "darwin";
+#else
+    return "linux";
+#endif
+}
+
+const char* host_cpu() {
+#if defined(__x86_64__) || defined(_M_X64)
+    return "x64";
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    return "arm64";
+#elif defined(__arm__) || defined(_M_ARM)
+    return "arm";
+#elif defined(__i386__) || defined(_M_IX86)
+    return "ia32";
+#else
+    return "unknown";
+#endif
+}
+
+const char* host_libc() {
+#if defined(__linux__) && defined(__GLIBC__)
+    return "glibc";
+#elif defined(__linux__)
+    return "musl";
+#else
+    return "";
+#endif
+}
+
+bool matches_constraint(const std::vector<std::string>& constraint, const std::string& host_value) {
+    if (constraint.empty()) {
+        return true;
+    }
+
+    bool has_positive = false;
+    bool listed = false;
+    for (const auto& entry : constraint) {
+        if (!entry.empty() && entry[0] == '!') {
+            if (entry.compare(1, std::string::npos, host_value) == 0) {
+                return false; // Explicitly blocked
+            }
+        } else {
+            has_positive = true;
+            if (entry == host_value || entry == "any") {
+                listed = true;
+            }
+        }
+    }
+    return !has_positive || listed;
+}
+
+bool matches_host(const std::vector<std::string>& os,
+                  const std::vector<std::string>& cpu,
+                  const std::vector<std::string>& libc) {
+    if (!matches_constraint(os, host_os()) || !matches_constraint(cpu, host_cpu())) {
+        return false;
+    }
+    // "libc" only has meaning on Linux; npm ignores it elsewhere.
+    std::string libc_value = host_libc();
+    return libc_value.empty() || matches_constraint(libc, libc_value);
+}
+
+} // namespace PlatformUtils
+} // namespace jpm
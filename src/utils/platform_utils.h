@@ -0,0 +1,29 @@
+#ifndef JPM_PLATFORM_UTILS_H
+#define JPM_PLATFORM_UTILS_H
+
+#include <string>
+#include <vector>
+
+namespace jpm {
+namespace PlatformUtils {
+
+// Host identifiers using the same vocabulary as Node's process.platform /
+// process.arch, which is also what package.json "os"/"cpu" fields use.
+const char* host_os();   // "linux", "darwin", "win32"
+const char* host_cpu();  // "x64", "arm64", "arm", "ia32"
+const char* host_libc(); // "glibc", "musl", or "" when not applicable (non-Linux)
+
+// Checks a package.json-style constraint list against a host value.
+// An empty list allows everything. Entries prefixed with "!" block a value;
+// if any non-negated entry is present the host value must be listed.
+bool matches_constraint(const std::vector<std::string>& constraint, const std::string& host_value);
+
+// True when the os/cpu/libc constraints of a package allow installing it on this host.
+bool matches_host(const std::vector<std::string>& os,
+                  const std::vector<std::string>& cpu,
+                  const std::vector<std::string>& libc);
+
+} // namespace PlatformUtils
+} // namespace jpm
+
+#endif // JPM_PLATFORM_UTILS_H